@@ -82,6 +82,9 @@
 //---- DEFINED IF GCP IS ENABLED.
 #cmakedefine HAVE_GCP
 
+//---- DEFINED IF MIXED-PRECISION MTTKRP IS AVAILABLE (DOUBLE BUILDS ONLY).
+#cmakedefine HAVE_MIXED_PRECISION
+
 #include <cstddef>
 
 // Floating-point type
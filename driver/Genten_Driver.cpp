@@ -41,7 +41,9 @@
 #include "Genten_Driver.hpp"
 #include "Genten_SystemTimer.hpp"
 #include "Genten_IOtext.hpp"
+#include "Genten_IObinary.hpp"
 #include "Genten_FacTestSetGenerator.hpp"
+#include "Genten_SptensorCompact.hpp"
 
 void usage(char **argv)
 {
@@ -51,9 +53,13 @@ void usage(char **argv)
   std::cout << "  --dims <array>     random tensor dimensions" << std::endl;
   std::cout << "  --nnz <int>        approximate number of random tensor nonzeros" << std::endl;
   std::cout << "  --index-base <int> starting index for tensor nonzeros" << std::endl;
+  std::cout << "  --input-format <string> format of input sptensor file: text, binary" << std::endl;
   std::cout << "  --gz               read tensor in gzip compressed format" << std::endl;
   std::cout << "  --sparse           whether tensor is sparse or dense" << std::endl;
   std::cout << "  --save-tensor <string> filename to save the tensor (leave blank for no save)" << std::endl;
+  std::cout << "  --save-format <string> format for saving sptensor: text, binary" << std::endl;
+  std::cout << "  --save-index-map <string> filename to save the map from compacted to original indices (leave blank for no save)" << std::endl;
+  std::cout << "  --expand-output    expand the Ktensor of a compacted tensor to the original size before saving (default), or --compact-output to save it compacted" << std::endl;
   std::cout << "  --init <string>  file name for reading Ktensor initial guess (leave blank for random initial guess)" << std::endl;
   std::cout << "  --output <string>  output file name for saving Ktensor" << std::endl;
   std::cout << "  --vtune            connect to vtune for Intel-based profiling (assumes vtune profiling tool, amplxe-cl, is in your path)" << std::endl;
@@ -90,6 +96,8 @@ int main(int argc, char* argv[])
       Genten::parse_string(args, "--init", "");
     ttb_indx index_base =
       Genten::parse_ttb_indx(args, "--index-base", 0, 0, INT_MAX);
+    std::string input_format =
+      Genten::parse_string(args, "--input-format", "text");
     ttb_bool gz =
       Genten::parse_ttb_bool(args, "--gz", "--no-gz", false);
     ttb_bool vtune =
@@ -107,10 +115,18 @@ int main(int argc, char* argv[])
       Genten::parse_ttb_indx(args, "--nnz", 1 * 1000 * 1000, 1, INT_MAX);
     std::string tensor_outputfilename =
       Genten::parse_string(args, "--save-tensor", "");
+    std::string save_format =
+      Genten::parse_string(args, "--save-format", "text");
+    std::string index_map_filename =
+      Genten::parse_string(args, "--save-index-map", "");
+    ttb_bool expand_output =
+      Genten::parse_ttb_bool(args, "--expand-output", "--compact-output",
+                             true);
 
     // Everything else
     Genten::AlgParams algParams;
     algParams.parse(args);
+    const ttb_bool compact = algParams.compact;
 
     // Check for unrecognized arguments
     if (Genten::check_and_print_unused_args(args, std::cout)) {
@@ -118,6 +134,16 @@ int main(int argc, char* argv[])
       // Use throw instead of exit for proper Kokkos shutdown
       throw std::string("Invalid command line arguments.");
     }
+    if (input_format != "text" && input_format != "binary")
+      throw std::string("Invalid input format:  " + input_format);
+    if (save_format != "text" && save_format != "binary")
+      throw std::string("Invalid save format:  " + save_format);
+    if (input_format == "binary" && (gz || !sparse))
+      throw std::string("Binary input format requires an uncompressed sparse tensor.");
+    if ((compact || index_map_filename != "") && !sparse)
+      throw std::string("Compaction requires a sparse tensor.");
+    if (index_map_filename != "" && !compact)
+      throw std::string("--save-index-map requires --compact.");
 
     if (algParams.debug) {
       std::cout << "Driver options:" << std::endl;
@@ -135,12 +161,18 @@ int main(int argc, char* argv[])
       }
       if (initfilename != "")
         std::cout << "  init = " << initfilename << std::endl;
-      if (tensor_outputfilename != "")
+      if (tensor_outputfilename != "") {
         std::cout << "  save_tensor = " << tensor_outputfilename << std::endl;
+        std::cout << "  save_format = " << save_format << std::endl;
+      }
       std::cout << "  output = " << outputfilename << std::endl;
       std::cout << "  sparse = " << (sparse ? "true" : "false") << std::endl;
       std::cout << "  index_base = " << index_base << std::endl;
+      std::cout << "  input_format = " << input_format << std::endl;
       std::cout << "  gz = " << (gz ? "true" : "false") << std::endl;
+      if (index_map_filename != "")
+        std::cout << "  save_index_map = " << index_map_filename << std::endl;
+      std::cout << "  expand_output = " << (expand_output ? "true" : "false") << std::endl;
       std::cout << "  vtune = " << (vtune ? "true" : "false") << std::endl;
       algParams.print(std::cout);
     }
@@ -148,7 +180,7 @@ int main(int argc, char* argv[])
     if (vtune)
       Genten::connect_vtune();
 
-    Genten::SystemTimer timer(2);
+    Genten::SystemTimer timer(3);
 
     typedef Genten::DefaultExecutionSpace Space;
     typedef Genten::SptensorT<Space> Sptensor_type;
@@ -160,21 +192,25 @@ int main(int argc, char* argv[])
 
     // Read in initial guess if provided
     Ktensor_type u_init;
+    Ktensor_host_type u_init_host;
     if (initfilename != "") {
-      Ktensor_host_type u_init_host;
       Genten::import_ktensor(initfilename, u_init_host);
       u_init = create_mirror_view(Space(), u_init_host);
       deep_copy(u_init, u_init_host);
     }
 
     Ktensor_type u;
+    Genten::SptensorIndexMap index_map;
     if (sparse) {
       // Read in tensor data
       Sptensor_host_type x_host;
       Sptensor_type x;
       if (inputfilename != "") {
         timer.start(0);
-        Genten::import_sptensor(inputfilename, x_host, index_base, gz, true);
+        if (input_format == "binary")
+          Genten::import_sptensor_binary(inputfilename, x_host, true);
+        else
+          Genten::import_sptensor(inputfilename, x_host, index_base, gz, true);
         x = create_mirror_view( Space(), x_host );
         deep_copy( x, x_host );
         timer.stop(0);
@@ -209,6 +245,31 @@ int main(int argc, char* argv[])
         printf ("Data generation took %6.3f seconds\n", timer.getTotalTime(0));
         std::cout << "  Actual nnz  = " << x_host.nnz() << "\n";
       }
+
+      // Drop the empty slices of each mode here rather than in the driver,
+      // to keep the index map
+      if (compact) {
+        algParams.compact = false;
+        timer.start(2);
+        index_map = Genten::compact_sptensor(x_host);
+        x = create_mirror_view( Space(), x_host );
+        deep_copy( x, x_host );
+        if (initfilename != "") {
+          u_init_host = Genten::compact_ktensor(u_init_host, index_map);
+          u_init = create_mirror_view(Space(), u_init_host);
+          deep_copy(u_init, u_init_host);
+        }
+        timer.stop(2);
+        std::cout << "Compacted tensor from size [ ";
+        for (ttb_indx n=0; n<x_host.ndims(); ++n)
+          std::cout << index_map.orig_size(n) << ' ';
+        std::cout << "] to [ ";
+        for (ttb_indx n=0; n<x_host.ndims(); ++n)
+          std::cout << x_host.size(n) << ' ';
+        std::cout << "] in " << timer.getTotalTime(2) << " seconds\n";
+        if (index_map_filename != "")
+          Genten::export_index_map(index_map_filename, index_map, index_base);
+      }
       if (algParams.debug) Genten::print_sptensor(x_host, std::cout, "tensor");
 
       // Compute decomposition
@@ -216,7 +277,10 @@ int main(int argc, char* argv[])
 
       if (tensor_outputfilename != "") {
         timer.start(1);
-        Genten::export_sptensor(tensor_outputfilename, x_host, index_base == 0);
+        if (save_format == "binary")
+          Genten::export_sptensor_binary(tensor_outputfilename, x_host);
+        else
+          Genten::export_sptensor(tensor_outputfilename, x_host, index_base == 0);
         timer.stop(1);
         printf("Sptensor export took %6.3f seconds\n", timer.getTotalTime(1));
       }
@@ -266,6 +330,8 @@ int main(int argc, char* argv[])
       Ktensor_host_type u_host =
         create_mirror_view(Genten::DefaultHostExecutionSpace(), u);
       deep_copy( u_host, u );
+      if (!index_map.empty() && expand_output)
+        u_host = Genten::expand_ktensor(u_host, index_map);
       Genten::export_ktensor(outputfilename, u_host);
       timer.stop(1);
       printf("Ktensor export took %6.3f seconds\n", timer.getTotalTime(1));
@@ -82,7 +82,7 @@ DLL_EXPORT_SYM void mexFunction(int nlhs, mxArray *plhs[],
 
     if (algParams.mttkrp_method == Genten::MTTKRP_Method::Perm &&
         !X.havePerm()) {
-      X.createPermutation();
+      X.createPermutation(algParams.mttkrp_perm_row_ptrs);
     }
 
     // Perform MTTKRP
@@ -157,6 +157,27 @@ int run_cpals(const Genten::IndxArray& cFacDims_host,
   cout << "  Max iters = " << algParams.maxiters << "\n";
   cout << "  Stop tol  = " << algParams.tol << "\n";
 
+  if (algParams.num_starts > 1)
+  {
+    // Run all starts together and report the final state of each
+    cout << "  Starts    = " << algParams.num_starts << "\n";
+    Genten::CpAlsPerfInfo *  startInfo =
+      new Genten::CpAlsPerfInfo[algParams.num_starts];
+    cResult = cInitialGuess;
+    Genten::cpals_multistart (cData, cResult, algParams, nItersCompleted,
+                              dResNorm, startInfo, std::cout);
+    printf ("Performance information per start:\n");
+    for (ttb_indx  i = 0; i < algParams.num_starts; i++)
+    {
+      printf (" %2d: iters = %d, fit = %.6e, resnorm = %.2e, time = %.3f secs\n",
+              (int) i, startInfo[i].nIter, startInfo[i].dFit,
+              startInfo[i].dResNorm, startInfo[i].dCumTime);
+    }
+    delete[] startInfo;
+    printf ("  Final residual norm = %10.3e\n", dResNorm);
+    return 0;
+  }
+
   // Request performance information on every iteration.
   // Allocation adds two more for start and stop states of the algorithm.
   ttb_indx  nMaxPerfSize = 2 + algParams.maxiters;
@@ -205,6 +226,10 @@ void usage(char **argv)
   }
   std::cout << std::endl;
   std::cout << "  --mttkrp-tile-size <int> tile size for mttkrp algorithm" << std::endl;
+  std::cout << "  --mttkrp-mixed-precision use float values and factor matrices with double accumulation" << std::endl;
+  std::cout << "  --numa-replicate     replicate factor matrices on each NUMA node" << std::endl;
+  std::cout << "  --line-search        extrapolate iterates with a line search" << std::endl;
+  std::cout << "  --starts <int>       number of starts computed together" << std::endl;
   std::cout << "  --vtune              connect to vtune for Intel-based profiling (assumes vtune profiling tool, amplxe-cl, is in your path)" << std::endl;
 }
 
@@ -271,6 +296,17 @@ int main(int argc, char* argv[])
                      Genten::MTTKRP_Method::names);
     ttb_indx mttkrp_tile_size =
       Genten::parse_ttb_indx(args, "--mttkrp-tile-size", 0, 0, INT_MAX);
+    ttb_bool mttkrp_mixed_precision =
+      Genten::parse_ttb_bool(args, "--mttkrp-mixed-precision",
+                             "--mttkrp-full-precision", false);
+    ttb_bool numa_replicate =
+      Genten::parse_ttb_bool(args, "--numa-replicate",
+                             "--no-numa-replicate", false);
+    ttb_bool line_search =
+      Genten::parse_ttb_bool(args, "--line-search",
+                             "--no-line-search", false);
+    ttb_indx num_starts =
+      Genten::parse_ttb_indx(args, "--starts", 1, 1, INT_MAX);
 
     // Check for unrecognized arguments
     if (Genten::check_and_print_unused_args(args, std::cout)) {
@@ -288,6 +324,10 @@ int main(int argc, char* argv[])
     algParams.tol = dStopTol;
     algParams.mttkrp_method = mttkrp_method;
     algParams.mttkrp_duplicated_factor_matrix_tile_size = mttkrp_tile_size;
+    algParams.mttkrp_mixed_precision = mttkrp_mixed_precision;
+    algParams.numa_replicate = numa_replicate;
+    algParams.line_search = line_search;
+    algParams.num_starts = num_starts;
 
     ret = run_cpals< Genten::DefaultExecutionSpace >(
         cFacDims, nMaxNonzeroes, algParams);
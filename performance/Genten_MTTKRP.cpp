@@ -44,6 +44,7 @@
   @brief Main program that factorizes synthetic data using the CP-ALS algorithm.
 */
 
+#include <algorithm>
 #include <iostream>
 #include <stdio.h>
 
@@ -52,10 +53,19 @@
 #include "Genten_IOtext.hpp"
 #include "Genten_Ktensor.hpp"
 #include "Genten_Sptensor.hpp"
+#include "Genten_SptensorCSF.hpp"
+#include "Genten_SptensorHiCOO.hpp"
+#include "Genten_SptensorALTO.hpp"
+#include "Genten_SptensorHybrid.hpp"
+#include "Genten_SptensorDimTree.hpp"
+#include "Genten_SptensorNarrow.hpp"
+#include "Genten_KtensorNarrow.hpp"
 #include "Genten_Tensor.hpp"
 #include "Genten_SystemTimer.hpp"
 #include "Genten_AlgParams.hpp"
 #include "Genten_MixedFormatOps.hpp"
+#include "Genten_MTTKRP_Tune.hpp"
+#include "Genten_NUMA.hpp"
 
 #include "Kokkos_UniqueToken.hpp"
 
@@ -136,7 +146,7 @@ int run_sparse_mttkrp(const std::string& inputfilename,
     std::cout << "  Actual nnz  = " << cData_host.nnz() << "\n";
   }
 
-  Genten::SystemTimer timer(1+nDims);
+  Genten::SystemTimer timer(2+nDims);
 
   // Set a random input Ktensor, matching the Matlab code.
   Ktensor_host_type  cInput_host(nNumComponents, nDims, cFacDims_host);
@@ -158,6 +168,17 @@ int run_sparse_mttkrp(const std::string& inputfilename,
   // Fixup algorithmic choices
   algParams.fixup<Space>(std::cout);
 
+  // Benchmark the MTTKRP methods if requested
+  Genten::tune_mttkrp(cData, nNumComponents, algParams, std::cout);
+
+  // Place the tensor and factor matrices by NUMA node if requested
+  if (algParams.numa_first_touch) {
+    Genten::numa_first_touch(cData, algParams);
+    Genten::numa_first_touch(cInput);
+  }
+  if (algParams.numa_first_touch || algParams.numa_replicate)
+    Genten::print_numa_placement(algParams, std::cout);
+
   // Do a pass through the mttkrp to warm up and make sure the tensor
   // is copied to the device before generating any timings.  Use
   // Sptensor mttkrp and do this before createPermutation() so that
@@ -174,10 +195,135 @@ int run_sparse_mttkrp(const std::string& inputfilename,
   // Perform any post-processing (e.g., permutation and row ptr generation)
   timer.start(0);
   if (algParams.mttkrp_method == Genten::MTTKRP_Method::Perm)
-    cData.createPermutation();
+    cData.createPermutation(algParams.mttkrp_perm_row_ptrs);
   timer.stop(0);
   std::printf("  (createPermutation() took %6.3f seconds)\n", timer.getTotalTime(0));
 
+  // Build CSF trees, HiCOO blocks, ALTO keys, hot-row maps or the dimension
+  // tree once, outside of the timed MTTKRPs
+  Genten::SptensorCSFT<Genten::DefaultExecutionSpace> cData_csf;
+  Genten::SptensorHiCOOT<Genten::DefaultExecutionSpace> cData_hicoo;
+  Genten::SptensorALTOT<Genten::DefaultExecutionSpace> cData_alto;
+  Genten::SptensorHybridT<Genten::DefaultExecutionSpace> cData_hybrid;
+  Genten::SptensorDimTreeT<Genten::DefaultExecutionSpace> cData_dimtree;
+  const bool use_csf =
+    algParams.mttkrp_method == Genten::MTTKRP_Method::CSF;
+  const bool use_hicoo =
+    algParams.mttkrp_method == Genten::MTTKRP_Method::HiCOO;
+  const bool use_alto =
+    algParams.mttkrp_method == Genten::MTTKRP_Method::ALTO;
+  const bool use_hybrid =
+    algParams.mttkrp_method == Genten::MTTKRP_Method::Hybrid;
+  const bool use_dimtree =
+    algParams.mttkrp_method == Genten::MTTKRP_Method::DimTree;
+  if (use_csf) {
+    timer.start(1+nDims);
+    cData_csf = Genten::SptensorCSFT<Genten::DefaultExecutionSpace>(
+      cData, algParams);
+    Kokkos::fence();
+    timer.stop(1+nDims);
+    std::printf("  (CSF construction took %6.3f seconds, %.3f MB)\n",
+                timer.getTotalTime(1+nDims), cData_csf.memory()/(1024.0*1024.0));
+  }
+  // Copy subscripts to the narrowest type that fits
+  Genten::SptensorNarrowT<Genten::DefaultExecutionSpace,uint16_t> cData_16;
+  Genten::SptensorNarrowT<Genten::DefaultExecutionSpace,uint32_t> cData_32;
+  unsigned index_bytes = sizeof(ttb_indx);
+  if (algParams.mttkrp_narrow_indices &&
+      (algParams.mttkrp_method == Genten::MTTKRP_Method::Single ||
+       algParams.mttkrp_method == Genten::MTTKRP_Method::Atomic ||
+       algParams.mttkrp_method == Genten::MTTKRP_Method::Duplicated ||
+       algParams.mttkrp_method == Genten::MTTKRP_Method::Prefetch)) {
+    index_bytes = Genten::narrow_index_bytes(cFacDims_host);
+    if (index_bytes == 2)
+      cData_16 = Genten::SptensorNarrowT<Genten::DefaultExecutionSpace,uint16_t>(cData);
+    else if (index_bytes == 4)
+      cData_32 = Genten::SptensorNarrowT<Genten::DefaultExecutionSpace,uint32_t>(cData);
+    std::printf("  (using %u-byte subscripts)\n", index_bytes);
+  }
+  // Copy values and factor matrices to float for mixed precision
+  const bool use_mixed = algParams.mttkrp_mixed_precision &&
+    (algParams.mttkrp_method == Genten::MTTKRP_Method::Single ||
+     algParams.mttkrp_method == Genten::MTTKRP_Method::Atomic ||
+     algParams.mttkrp_method == Genten::MTTKRP_Method::Duplicated ||
+     algParams.mttkrp_method == Genten::MTTKRP_Method::Prefetch);
+#ifdef HAVE_MIXED_PRECISION
+  Genten::SptensorNarrowT<Genten::DefaultExecutionSpace,uint32_t,float> cData_32f;
+  Genten::SptensorNarrowT<Genten::DefaultExecutionSpace,uint64_t,float> cData_64f;
+  Genten::KtensorNarrowT<Genten::DefaultExecutionSpace,float> cInput_f;
+  if (use_mixed) {
+    if (index_bytes <= 4) {
+      index_bytes = 4;
+      cData_32f = Genten::SptensorNarrowT<Genten::DefaultExecutionSpace,uint32_t,float>(cData);
+    }
+    else
+      cData_64f = Genten::SptensorNarrowT<Genten::DefaultExecutionSpace,uint64_t,float>(cData);
+    cInput_f = Genten::KtensorNarrowT<Genten::DefaultExecutionSpace,float>(cInput);
+    std::printf("  (using mixed precision, %.3f MB of float factor matrices)\n",
+                cInput_f.memory()/(1024.0*1024.0));
+  }
+#else
+  if (use_mixed)
+    Genten::error("Mixed-precision MTTKRP requires GENTEN_FLOAT_TYPE=double");
+#endif
+  // Replicate factor matrices on each NUMA node
+  const bool use_replicated = algParams.numa_replicate && !use_mixed &&
+    (algParams.mttkrp_method == Genten::MTTKRP_Method::Single ||
+     algParams.mttkrp_method == Genten::MTTKRP_Method::Atomic ||
+     algParams.mttkrp_method == Genten::MTTKRP_Method::Duplicated ||
+     algParams.mttkrp_method == Genten::MTTKRP_Method::Prefetch);
+  Genten::KtensorReplicatedT<Genten::DefaultExecutionSpace> cInput_rep;
+  if (use_replicated) {
+    cInput_rep =
+      Genten::KtensorReplicatedT<Genten::DefaultExecutionSpace>(cInput);
+    std::printf("  (using %u factor matrix replicas)\n",
+                unsigned(cInput_rep.nreplicas()));
+  }
+  if (use_hicoo) {
+    timer.start(1+nDims);
+    cData_hicoo = Genten::SptensorHiCOOT<Genten::DefaultExecutionSpace>(
+      cData, algParams);
+    Kokkos::fence();
+    timer.stop(1+nDims);
+    std::printf("  (HiCOO construction took %6.3f seconds, %d blocks, %.3f MB)\n",
+                timer.getTotalTime(1+nDims), int(cData_hicoo.nblocks()),
+                cData_hicoo.memory()/(1024.0*1024.0));
+  }
+  if (use_alto) {
+    timer.start(1+nDims);
+    cData_alto = Genten::SptensorALTOT<Genten::DefaultExecutionSpace>(cData);
+    Kokkos::fence();
+    timer.stop(1+nDims);
+    std::printf("  (ALTO construction took %6.3f seconds, %u-word keys, %.3f MB)\n",
+                timer.getTotalTime(1+nDims), cData_alto.nwords(),
+                cData_alto.memory()/(1024.0*1024.0));
+  }
+  if (use_hybrid) {
+    timer.start(1+nDims);
+    cData_hybrid = Genten::SptensorHybridT<Genten::DefaultExecutionSpace>(
+      cData, algParams);
+    Kokkos::fence();
+    timer.stop(1+nDims);
+    std::printf("  (hybrid construction took %6.3f seconds, %.3f MB)\n",
+                timer.getTotalTime(1+nDims),
+                cData_hybrid.memory()/(1024.0*1024.0));
+    for (ttb_indx n=0; n<nDims; ++n)
+      std::printf("  (mode %d: %d of %d rows hot, %.3f MB of thread buffers)\n",
+                  int(n), int(cData_hybrid.nhot(n)), int(cFacDims_host[n]),
+                  cData_hybrid.bufferMemory(n,nNumComponents)/(1024.0*1024.0));
+  }
+  if (use_dimtree) {
+    timer.start(1+nDims);
+    cData_dimtree = Genten::SptensorDimTreeT<Genten::DefaultExecutionSpace>(
+      cData, algParams);
+    Kokkos::fence();
+    timer.stop(1+nDims);
+    std::printf("  (dimension tree construction took %6.3f seconds, %.3f MB, %.3f MB cached)\n",
+                timer.getTotalTime(1+nDims),
+                cData_dimtree.memory()/(1024.0*1024.0),
+                cData_dimtree.cacheMemory(nNumComponents)/(1024.0*1024.0));
+  }
+
   // Perform nIters iterations of MTTKRP on each mode, timing performance
   // We do each mode sequentially as this is more representative of CpALS
   // (as opposed to running all nIters iterations on each mode before moving
@@ -187,7 +333,37 @@ int run_sparse_mttkrp(const std::string& inputfilename,
   for (ttb_indx iter=0; iter<nIters; ++iter) {
     for (ttb_indx n=0; n<nDims; ++n) {
       timer.start(1+n);
-      Genten::mttkrp(cData, cInput, n, cResult[n], algParams);
+      if (use_csf)
+        Genten::mttkrp(cData_csf, cInput, n, cResult[n], algParams);
+      else if (use_hicoo)
+        Genten::mttkrp(cData_hicoo, cInput, n, cResult[n], algParams);
+      else if (use_alto)
+        Genten::mttkrp(cData_alto, cInput, n, cResult[n], algParams);
+      else if (use_hybrid)
+        Genten::mttkrp(cData_hybrid, cInput, n, cResult[n], algParams);
+      else if (use_dimtree) {
+        // Invalidate as if cInput[n] were updated, as in CpALS
+        Genten::mttkrp(cData_dimtree, cInput, n, cResult[n], algParams);
+        cData_dimtree.factorUpdated(n);
+      }
+#ifdef HAVE_MIXED_PRECISION
+      else if (use_mixed && index_bytes == 4)
+        Genten::mttkrp(cData_32f, cInput_f, n, cResult[n], algParams);
+      else if (use_mixed)
+        Genten::mttkrp(cData_64f, cInput_f, n, cResult[n], algParams);
+#endif
+      else if (use_replicated && index_bytes == 2)
+        Genten::mttkrp(cData_16, cInput_rep, n, cResult[n], algParams);
+      else if (use_replicated && index_bytes == 4)
+        Genten::mttkrp(cData_32, cInput_rep, n, cResult[n], algParams);
+      else if (use_replicated)
+        Genten::mttkrp(cData, cInput_rep, n, cResult[n], algParams);
+      else if (index_bytes == 2)
+        Genten::mttkrp(cData_16, cInput, n, cResult[n], algParams);
+      else if (index_bytes == 4)
+        Genten::mttkrp(cData_32, cInput, n, cResult[n], algParams);
+      else
+        Genten::mttkrp(cData, cInput, n, cResult[n], algParams);
       Kokkos::fence();
       timer.stop(1+n);
     }
@@ -211,6 +387,21 @@ int run_sparse_mttkrp(const std::string& inputfilename,
     "\tTotal:  average time = %.3f seconds, throughput = %.3f GFLOP/s\n",
       mttkrp_total_time, mttkrp_total_throughput);
 
+  // Report the balance of work across threads
+  const std::vector<double>& thread_times = Genten::mttkrp_thread_times();
+  if (!thread_times.empty()) {
+    double tmin = thread_times[0], tmax = thread_times[0], tavg = 0.0;
+    for (const double t : thread_times) {
+      tmin = std::min(tmin, t);
+      tmax = std::max(tmax, t);
+      tavg += t;
+    }
+    tavg /= thread_times.size();
+    std::printf(
+      "\tThreads: min/avg/max time = %.3f/%.3f/%.3f seconds, max/avg = %.2f\n",
+      tmin, tavg, tmax, tavg > 0.0 ? tmax/tavg : 1.0);
+  }
+
   bool success = true;
   if (check != 0) {
     // Check the results using a simple MTTKRP algorithm executed on the host
@@ -235,8 +426,10 @@ int run_sparse_mttkrp(const std::string& inputfilename,
       }
     });
 
-    // Compare cResult with cAnswer
-    const ttb_real tol = MACHINE_EPSILON * 1000;
+    // Compare cResult with cAnswer.  Mixed precision rounds the inputs to
+    // float, so it is compared with a float tolerance.
+    const ttb_real tol =
+      use_mixed ? FLT_EPSILON * 1000 : MACHINE_EPSILON * 1000;
     ttb_indx num_failures = 0;
     for (ttb_indx n=0; n<nDims; ++n) {
       const ttb_indx nRows = cFacDims_host[n];
@@ -255,6 +448,22 @@ int run_sparse_mttkrp(const std::string& inputfilename,
       },num_failures_n);
       num_failures += num_failures_n;
     }
+    if (use_mixed) {
+      ttb_real max_diff = 0.0;
+      for (ttb_indx n=0; n<nDims; ++n) {
+        const ttb_indx nRows = cFacDims_host[n];
+        for (ttb_indx i=0; i<nRows; ++i) {
+          for (ttb_indx j=0; j<nNumComponents; ++j) {
+            const ttb_real v1 = cResult_host[n].entry(i,j);
+            const ttb_real v2 = cAnswer_host[n].entry(i,j);
+            const ttb_real d = std::max(std::abs(v1),std::abs(v2));
+            if (d > 0.0)
+              max_diff = std::max(max_diff, std::abs(v1-v2)/d);
+          }
+        }
+      }
+      std::printf("\tMax. rel. diff. = %.3e\n", max_diff);
+    }
     if (num_failures == 0)
       std::cout << "\tSuccess!" << std::endl;
     else {
@@ -532,6 +741,21 @@ void usage(char **argv)
   }
   std::cout << std::endl;
   std::cout << "  --mttkrp-tile-size <int> tile size for mttkrp algorithm" << std::endl;
+  std::cout << "  --mttkrp-csf-all-modes build a CSF tree rooted at each mode for csf mttkrp algorithm" << std::endl;
+  std::cout << "  --mttkrp-hicoo-block-bits <int> log2 of the block size for hicoo mttkrp algorithm" << std::endl;
+  std::cout << "  --mttkrp-narrow-indices store subscripts in 16 or 32 bits when they fit" << std::endl;
+  std::cout << "  --mttkrp-mixed-precision use float values and factor matrices with double accumulation" << std::endl;
+  std::cout << "  --mttkrp-rank-batch <int> number of components at which nonzero tiles are loaded into scratch once for all column blocks (0 disables)" << std::endl;
+  std::cout << "  --mttkrp-prefetch-distance <int> number of nonzeros ahead to prefetch factor rows for prefetch mttkrp algorithm" << std::endl;
+  std::cout << "  --numa-first-touch place the tensor and factor matrices on the NUMA node of the thread that uses them" << std::endl;
+  std::cout << "  --numa-replicate     replicate factor matrices on each NUMA node" << std::endl;
+  std::cout << "  --mttkrp-perm-row-ptrs use row pointers for deterministic perm mttkrp algorithm" << std::endl;
+  std::cout << "  --mttkrp-heavy-row-tiles <int> split rows with more than this many tiles across threads with row pointers" << std::endl;
+  std::cout << "  --mttkrp-thread-timing report per-thread kernel times with row pointers" << std::endl;
+  std::cout << "  --mttkrp-hybrid-threshold <float> nonzeros per thread for a row to be privatized in hybrid mttkrp algorithm" << std::endl;
+  std::cout << "  --mttkrp-dimtree-memory <float> MB of cached partial products in dimtree mttkrp algorithm (-1 for no limit)" << std::endl;
+  std::cout << "  --mttkrp-tune-iters <int> sweeps timed per candidate in auto mttkrp algorithm" << std::endl;
+  std::cout << "  --mttkrp-tune-cache <string> tuning cache file for auto mttkrp algorithm (\"\" to disable)" << std::endl;
   std::cout << "  --vtune              connect to vtune for Intel-based profiling (assumes vtune profiling tool, amplxe-cl, is in your path)" << std::endl;
 }
 
@@ -599,6 +823,47 @@ int main(int argc, char* argv[])
                      Genten::MTTKRP_Method::names);
     ttb_indx mttkrp_tile_size =
       Genten::parse_ttb_indx(args, "--mttkrp-tile-size", 0, 0, INT_MAX);
+    ttb_bool mttkrp_csf_all_modes =
+      Genten::parse_ttb_bool(args, "--mttkrp-csf-all-modes",
+                             "--mttkrp-csf-one-mode", false);
+    ttb_indx mttkrp_hicoo_block_bits =
+      Genten::parse_ttb_indx(args, "--mttkrp-hicoo-block-bits", 7, 1, 8);
+    ttb_bool mttkrp_narrow_indices =
+      Genten::parse_ttb_bool(args, "--mttkrp-narrow-indices",
+                             "--mttkrp-full-indices", true);
+    ttb_bool mttkrp_mixed_precision =
+      Genten::parse_ttb_bool(args, "--mttkrp-mixed-precision",
+                             "--mttkrp-full-precision", false);
+    ttb_indx mttkrp_rank_batch =
+      Genten::parse_ttb_indx(args, "--mttkrp-rank-batch", 256, 0, INT_MAX);
+    ttb_indx mttkrp_prefetch_distance =
+      Genten::parse_ttb_indx(args, "--mttkrp-prefetch-distance", 16, 0,
+                             INT_MAX);
+    ttb_bool numa_first_touch =
+      Genten::parse_ttb_bool(args, "--numa-first-touch",
+                             "--no-numa-first-touch", false);
+    ttb_bool numa_replicate =
+      Genten::parse_ttb_bool(args, "--numa-replicate",
+                             "--no-numa-replicate", false);
+    ttb_bool mttkrp_perm_row_ptrs =
+      Genten::parse_ttb_bool(args, "--mttkrp-perm-row-ptrs",
+                             "--mttkrp-perm-tiles", false);
+    ttb_indx mttkrp_heavy_row_tiles =
+      Genten::parse_ttb_indx(args, "--mttkrp-heavy-row-tiles", 0, 0, INT_MAX);
+    ttb_bool mttkrp_thread_timing =
+      Genten::parse_ttb_bool(args, "--mttkrp-thread-timing",
+                             "--mttkrp-no-thread-timing", false);
+    ttb_real mttkrp_hybrid_threshold =
+      Genten::parse_ttb_real(args, "--mttkrp-hybrid-threshold", 1.0, 0.0,
+                             DOUBLE_MAX);
+    ttb_real mttkrp_dimtree_memory =
+      Genten::parse_ttb_real(args, "--mttkrp-dimtree-memory", -1.0, -1.0,
+                             DOUBLE_MAX);
+    ttb_indx mttkrp_tune_iters =
+      Genten::parse_ttb_indx(args, "--mttkrp-tune-iters", 3, 1, INT_MAX);
+    std::string mttkrp_tune_cache =
+      Genten::parse_string(args, "--mttkrp-tune-cache",
+                           "genten_mttkrp_tune.txt");
 
     // Check for unrecognized arguments
     if (Genten::check_and_print_unused_args(args, std::cout)) {
@@ -610,6 +875,21 @@ int main(int argc, char* argv[])
     Genten::AlgParams algParams;
     algParams.mttkrp_method = mttkrp_method;
     algParams.mttkrp_duplicated_factor_matrix_tile_size = mttkrp_tile_size;
+    algParams.mttkrp_csf_all_modes = mttkrp_csf_all_modes;
+    algParams.mttkrp_hicoo_block_bits = mttkrp_hicoo_block_bits;
+    algParams.mttkrp_narrow_indices = mttkrp_narrow_indices;
+    algParams.mttkrp_mixed_precision = mttkrp_mixed_precision;
+    algParams.mttkrp_rank_batch = mttkrp_rank_batch;
+    algParams.mttkrp_prefetch_distance = mttkrp_prefetch_distance;
+    algParams.numa_first_touch = numa_first_touch;
+    algParams.numa_replicate = numa_replicate;
+    algParams.mttkrp_perm_row_ptrs = mttkrp_perm_row_ptrs;
+    algParams.mttkrp_heavy_row_tiles = mttkrp_heavy_row_tiles;
+    algParams.mttkrp_thread_timing = mttkrp_thread_timing;
+    algParams.mttkrp_hybrid_threshold = mttkrp_hybrid_threshold;
+    algParams.mttkrp_dimtree_memory = mttkrp_dimtree_memory;
+    algParams.mttkrp_tune_iters = mttkrp_tune_iters;
+    algParams.mttkrp_tune_cache = mttkrp_tune_cache;
 
     if (sparse)
       ret = run_sparse_mttkrp< Genten::DefaultExecutionSpace >(
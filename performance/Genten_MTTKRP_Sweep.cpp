@@ -45,6 +45,7 @@
 */
 
 #include <iostream>
+#include <vector>
 #include <stdio.h>
 
 #include "Genten_FacTestSetGenerator.hpp"
@@ -67,6 +68,7 @@ void run_mttkrp(const std::string& inputfilename,
                 const ttb_indx  nMaxNonzeroes,
                 const unsigned long  nRNGseed,
                 const ttb_indx  nIters,
+                const Genten::IndxArray& prefetch_distances,
                 Genten::AlgParams& algParams)
 {
   typedef Genten::SptensorT<Space> Sptensor_type;
@@ -156,9 +158,24 @@ void run_mttkrp(const std::string& inputfilename,
   // We do each mode sequentially as this is more representative of CpALS
   // (as opposed to running all nIters iterations on each mode before moving
   // to the next one).
+  // For the prefetch method, also sweep over the prefetch distance
+  const bool sweep_prefetch =
+    algParams.mttkrp_method == Genten::MTTKRP_Method::Prefetch;
+  std::vector<ttb_indx> distances;
+  if (sweep_prefetch)
+    for (ttb_indx i=0; i<prefetch_distances.size(); ++i)
+      distances.push_back(prefetch_distances[i]);
+  else
+    distances.push_back(algParams.mttkrp_prefetch_distance);
   std::cout << "Performing " << nIters << " iterations of MTTKRP" << std::endl;
-  std::cout << "\t R \tMTTKRP GFLOP/s" << std::endl;
-  std::cout << "\t===\t==============" << std::endl;
+  if (sweep_prefetch) {
+    std::cout << "\t R \tdist\tMTTKRP GFLOP/s" << std::endl;
+    std::cout << "\t===\t====\t==============" << std::endl;
+  }
+  else {
+    std::cout << "\t R \tMTTKRP GFLOP/s" << std::endl;
+    std::cout << "\t===\t==============" << std::endl;
+  }
   for (ttb_indx R=nNumComponentsMin; R<=nNumComponentsMax; R+=nNumComponentsStep)
   {
     Ktensor_host_type  cInput_host2(R, nDims, cFacDims_host);
@@ -176,21 +193,28 @@ void run_mttkrp(const std::string& inputfilename,
     deep_copy( cInput2, cInput_host2 );
     Ktensor_type cResult(R, nDims, cFacDims);
 
-    Genten::SystemTimer timer(1);
-    timer.start(0);
-    for (ttb_indx iter=0; iter<nIters; ++iter) {
-      for (ttb_indx n=0; n<nDims; ++n) {
-        Genten::mttkrp(cData, cInput2, n, cResult[n], algParams);
+    for (const ttb_indx dist : distances) {
+      algParams.mttkrp_prefetch_distance = dist;
+      Genten::SystemTimer timer(1);
+      timer.start(0);
+      for (ttb_indx iter=0; iter<nIters; ++iter) {
+        for (ttb_indx n=0; n<nDims; ++n) {
+          Genten::mttkrp(cData, cInput2, n, cResult[n], algParams);
+        }
       }
+      timer.stop(0);
+      const double atomic = 1.0; // cost of atomic measured in flops
+      const double mttkrp_flops =
+        cData.nnz()*R*(nDims+atomic)*nIters*nDims;
+      const double mttkrp_total_time = timer.getTotalTime(0);
+      const double mttkrp_total_throughput =
+        ( mttkrp_flops / mttkrp_total_time ) / (1024.0 * 1024.0 * 1024.0);
+      if (sweep_prefetch)
+        std::printf("\t%3d\t%4d\t    %.3f\n", int(R), int(dist),
+                    mttkrp_total_throughput);
+      else
+        std::printf("\t%3d\t    %.3f\n", int(R), mttkrp_total_throughput);
     }
-    timer.stop(0);
-    const double atomic = 1.0; // cost of atomic measured in flops
-    const double mttkrp_flops =
-      cData.nnz()*R*(nDims+atomic)*nIters*nDims;
-    const double mttkrp_total_time = timer.getTotalTime(0);
-    const double mttkrp_total_throughput =
-      ( mttkrp_flops / mttkrp_total_time ) / (1024.0 * 1024.0 * 1024.0);
-    std::printf("\t%3d\t    %.3f\n", int(R), mttkrp_total_throughput);
   }
 }
 
@@ -218,6 +242,8 @@ void usage(char **argv)
   }
   std::cout << std::endl;
   std::cout << "  --mttkrp-tile-size <int> tile size for mttkrp algorithm" << std::endl;
+  std::cout << "  --mttkrp-nnz-tile-size <int> nonzero tile size for mttkrp algorithm" << std::endl;
+  std::cout << "  --prefetch-distances <[d1,d2,...]> prefetch distances to sweep over for prefetch mttkrp algorithm" << std::endl;
   std::cout << "  --vtune              connect to vtune for Intel-based profiling (assumes vtune profiling tool, amplxe-cl, is in your path)" << std::endl;
 }
 
@@ -279,6 +305,12 @@ int main(int argc, char* argv[])
                      Genten::MTTKRP_Method::names);
     ttb_indx mttkrp_tile_size =
       Genten::parse_ttb_indx(args, "--mttkrp-tile-size", 0, 0, INT_MAX);
+    ttb_indx mttkrp_nnz_tile_size =
+      Genten::parse_ttb_indx(args, "--mttkrp-nnz-tile-size", 128, 1, INT_MAX);
+    Genten::IndxArray prefetch_distances = { 0, 4, 8, 16, 32, 64 };
+    prefetch_distances =
+      Genten::parse_ttb_indx_array(args, "--prefetch-distances",
+                                   prefetch_distances, 0, INT_MAX);
 
     // Check for unrecognized arguments
     if (Genten::check_and_print_unused_args(args, std::cout)) {
@@ -290,11 +322,12 @@ int main(int argc, char* argv[])
     Genten::AlgParams algParams;
     algParams.mttkrp_method = mttkrp_method;
     algParams.mttkrp_duplicated_factor_matrix_tile_size = mttkrp_tile_size;
+    algParams.mttkrp_nnz_tile_size = mttkrp_nnz_tile_size;
 
     run_mttkrp< Genten::DefaultExecutionSpace >(
       inputfilename, index_base, gz,
       cFacDims, nNumComponentsMin, nNumComponentsMax, nNumComponentsStep,
-      nMaxNonzeroes, nRNGseed, nIters, algParams);
+      nMaxNonzeroes, nRNGseed, nIters, prefetch_distances, algParams);
 
   }
   catch(std::string sExc)
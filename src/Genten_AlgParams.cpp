@@ -56,12 +56,39 @@ Genten::AlgParams::AlgParams() :
   rank_def_solver(false),
   rcond(1e-8),
   penalty(0.0),
+  compact(false),
+  numa_first_touch(false),
+  numa_replicate(false),
+  line_search(false),
+  line_search_start(5),
+  line_search_fails(4),
+  num_starts(1),
+  rank_sweep_max(0),
+  rank_sweep_step(1),
+  rank_sweep_tol(1e-3),
+  rank_sweep_core_consistency(true),
   mttkrp_method(MTTKRP_Method::default_type),
   mttkrp_all_method(MTTKRP_All_Method::default_type),
   mttkrp_nnz_tile_size(128),
   mttkrp_duplicated_factor_matrix_tile_size(0),
   mttkrp_duplicated_threshold(-1.0),
+  mttkrp_csf_all_modes(false),
+  mttkrp_hicoo_block_bits(7),
+  mttkrp_narrow_indices(false),
+  mttkrp_mixed_precision(false),
+  mttkrp_rank_batch(256),
+  mttkrp_prefetch_distance(16),
+  mttkrp_perm_row_ptrs(false),
+  mttkrp_heavy_row_tiles(0),
+  mttkrp_thread_timing(false),
+  mttkrp_hybrid_threshold(1.0),
+  mttkrp_dimtree_memory(-1.0),
+  mttkrp_tune_iters(3),
+  mttkrp_tune_cache(""),
   ttm_method(TTM_Method::default_type),
+  arls_num_samples(131072),
+  arls_epoch_iters(5),
+  arls_dedup(true),
   loss_function_type(Genten::GCP_LossFunction::default_type),
   loss_eps(1.0e-10),
   gcp_tol(-DOUBLE_MAX),
@@ -84,6 +111,7 @@ Genten::AlgParams::AlgParams() :
   w_g_nz(-1.0),
   w_g_z(-1.0),
   hash(false),
+  alto_lookup(false),
   fuse(false),
   fuse_sa(false),
   compute_fit(false),
@@ -117,6 +145,28 @@ void Genten::AlgParams::parse(std::vector<std::string>& args)
                                    "--no-rank-def-solver", rank_def_solver);
   rcond = parse_ttb_real(args, "--rcond", rcond, 0.0, DOUBLE_MAX);
   penalty = parse_ttb_real(args, "--penalty", penalty, 0.0, DOUBLE_MAX);
+  compact = parse_ttb_bool(args, "--compact", "--no-compact", compact);
+  numa_first_touch = parse_ttb_bool(args, "--numa-first-touch",
+                                    "--no-numa-first-touch", numa_first_touch);
+  numa_replicate = parse_ttb_bool(args, "--numa-replicate",
+                                  "--no-numa-replicate", numa_replicate);
+  line_search = parse_ttb_bool(args, "--line-search", "--no-line-search",
+                               line_search);
+  line_search_start = parse_ttb_indx(args, "--line-search-start",
+                                     line_search_start, 1, INT_MAX);
+  line_search_fails = parse_ttb_indx(args, "--line-search-fails",
+                                     line_search_fails, 1, INT_MAX);
+  num_starts = parse_ttb_indx(args, "--starts", num_starts, 1, INT_MAX);
+  rank_sweep_max = parse_ttb_indx(args, "--rank-sweep-max", rank_sweep_max,
+                                  0, INT_MAX);
+  rank_sweep_step = parse_ttb_indx(args, "--rank-sweep-step", rank_sweep_step,
+                                   1, INT_MAX);
+  rank_sweep_tol = parse_ttb_real(args, "--rank-sweep-tol", rank_sweep_tol,
+                                  0.0, DOUBLE_MAX);
+  rank_sweep_core_consistency =
+    parse_ttb_bool(args, "--rank-sweep-core-consistency",
+                   "--no-rank-sweep-core-consistency",
+                   rank_sweep_core_consistency);
 
   // MTTKRP options
   mttkrp_method = parse_ttb_enum(args, "--mttkrp-method", mttkrp_method,
@@ -137,6 +187,43 @@ void Genten::AlgParams::parse(std::vector<std::string>& args)
    mttkrp_duplicated_threshold =
     parse_ttb_real(args, "--mttkrp-duplicated-threshold",
                    mttkrp_duplicated_factor_matrix_tile_size, -1.0, DOUBLE_MAX);
+  mttkrp_csf_all_modes = parse_ttb_bool(args, "--mttkrp-csf-all-modes",
+                                        "--mttkrp-csf-one-mode",
+                                        mttkrp_csf_all_modes);
+  mttkrp_hicoo_block_bits =
+    parse_ttb_indx(args, "--mttkrp-hicoo-block-bits",
+                   mttkrp_hicoo_block_bits, 1, 8);
+  mttkrp_narrow_indices = parse_ttb_bool(args, "--mttkrp-narrow-indices",
+                                         "--mttkrp-full-indices",
+                                         mttkrp_narrow_indices);
+  mttkrp_mixed_precision = parse_ttb_bool(args, "--mttkrp-mixed-precision",
+                                          "--mttkrp-full-precision",
+                                          mttkrp_mixed_precision);
+  mttkrp_rank_batch =
+    parse_ttb_indx(args, "--mttkrp-rank-batch",
+                   mttkrp_rank_batch, 0, INT_MAX);
+  mttkrp_prefetch_distance =
+    parse_ttb_indx(args, "--mttkrp-prefetch-distance",
+                   mttkrp_prefetch_distance, 0, INT_MAX);
+  mttkrp_perm_row_ptrs = parse_ttb_bool(args, "--mttkrp-perm-row-ptrs",
+                                        "--mttkrp-perm-tiles",
+                                        mttkrp_perm_row_ptrs);
+  mttkrp_heavy_row_tiles =
+    parse_ttb_indx(args, "--mttkrp-heavy-row-tiles",
+                   mttkrp_heavy_row_tiles, 0, INT_MAX);
+  mttkrp_thread_timing = parse_ttb_bool(args, "--mttkrp-thread-timing",
+                                        "--mttkrp-no-thread-timing",
+                                        mttkrp_thread_timing);
+  mttkrp_hybrid_threshold =
+    parse_ttb_real(args, "--mttkrp-hybrid-threshold",
+                   mttkrp_hybrid_threshold, 0.0, DOUBLE_MAX);
+  mttkrp_dimtree_memory =
+    parse_ttb_real(args, "--mttkrp-dimtree-memory",
+                   mttkrp_dimtree_memory, -1.0, DOUBLE_MAX);
+  mttkrp_tune_iters =
+    parse_ttb_indx(args, "--mttkrp-tune-iters", mttkrp_tune_iters, 1, INT_MAX);
+  mttkrp_tune_cache =
+    parse_string(args, "--mttkrp-tune-cache", mttkrp_tune_cache.c_str());
   warmup = parse_ttb_bool(args, "--warmup", "--no-warmup", warmup);
 
   // TTM options
@@ -145,6 +232,14 @@ void Genten::AlgParams::parse(std::vector<std::string>& args)
                                  Genten::TTM_Method::types,
                                  Genten::TTM_Method::names);
 
+  // CP-ARLS-LEV options
+  arls_num_samples =
+    parse_ttb_indx(args, "--arls-samples", arls_num_samples, 1, INT_MAX);
+  arls_epoch_iters =
+    parse_ttb_indx(args, "--arls-epochiters", arls_epoch_iters, 1, INT_MAX);
+  arls_dedup = parse_ttb_bool(args, "--arls-dedup", "--no-arls-dedup",
+                              arls_dedup);
+
   // GCP options
   loss_function_type = parse_ttb_enum(args, "--type", loss_function_type,
                                       Genten::GCP_LossFunction::num_types,
@@ -188,6 +283,8 @@ void Genten::AlgParams::parse(std::vector<std::string>& args)
   w_g_nz = parse_ttb_real(args, "--gnzw", w_g_nz, -1.0, DOUBLE_MAX);
   w_g_z = parse_ttb_real(args, "--gzw", w_g_z, -1.0, DOUBLE_MAX);
   hash = parse_ttb_bool(args, "--hash", "--no-hash", hash);
+  alto_lookup = parse_ttb_bool(args, "--alto-lookup", "--no-alto-lookup",
+                               alto_lookup);
   fuse = parse_ttb_bool(args, "--fuse", "--no-fuse", fuse);
   fuse_sa = parse_ttb_bool(args, "--fuse-sa", "--no-fuse-sa", fuse_sa);
   compute_fit = parse_ttb_bool(args, "--fit", "--no-fit", compute_fit);
@@ -224,6 +321,17 @@ void Genten::AlgParams::print_help(std::ostream& out)
   out << "  --rank-def-solver  use rank-deficient least-squares solver (GELSY) with full-gram formluation (useful when gram matrix is singular)" << std::endl;
   out << "  --rcond <float>    truncation parameter for rank-deficient solver" << std::endl;
   out << "  --penalty <float>  penalty term for regularization (useful if gram matrix is singular)" << std::endl;
+  out << "  --compact          compact each mode of a sparse tensor to its nonempty slices for the decomposition, with zero rows for the empty slices in the result" << std::endl;
+  out << "  --numa-first-touch place sparse tensor and factor matrix pages on the NUMA node of the threads that use them in single, atomic and duplicated mttkrp algorithms, which makes duplicated the default (host only)" << std::endl;
+  out << "  --numa-replicate   replicate factor matrices on each NUMA node for single, atomic and duplicated mttkrp algorithms in CP-ALS (host only)" << std::endl;
+  out << "  --line-search      extrapolate CP-ALS iterates along the change made by each iteration, keeping the result if it improves the fit" << std::endl;
+  out << "  --line-search-start <int> first CP-ALS iteration that extrapolates" << std::endl;
+  out << "  --line-search-fails <int> consecutive rejected extrapolations before taking shorter steps" << std::endl;
+  out << "  --starts <int>     number of CP-ALS starting points computed together, the first from the initial guess and the others random, keeping the best" << std::endl;
+  out << "  --rank-sweep-max <int> run CP-ALS for ranks from --rank up to <int>, each warm-started from the previous one, and keep the last rank that improved the fit enough; 0 for no sweep" << std::endl;
+  out << "  --rank-sweep-step <int> rank increment of the rank sweep" << std::endl;
+  out << "  --rank-sweep-tol <float> smallest fit gain over the previous rank that continues the rank sweep" << std::endl;
+  out << "  --rank-sweep-core-consistency compute the core consistency diagnostic of each rank of the rank sweep, which costs about nnz*rank^ndims operations" << std::endl;
 
   out << std::endl;
   out << "MTTKRP options:" << std::endl;
@@ -245,6 +353,19 @@ void Genten::AlgParams::print_help(std::ostream& out)
       << std::endl;
   out << "  --mttkrp-duplicated-tile-size <int> Factor matrix tile size for duplicated mttkrp algorithm" << std::endl;
   out << "  --mttkrp-duplicated-threshold <float> Theshold for determining when to not use duplicated mttkrp algorithm (set to -1.0 to always use duplicated)" << std::endl;
+  out << "  --mttkrp-csf-all-modes build a CSF tree rooted at each mode for csf mttkrp algorithm (faster but uses more memory than one tree)" << std::endl;
+  out << "  --mttkrp-hicoo-block-bits <int> log2 of the block size for hicoo mttkrp algorithm (1 to 8)" << std::endl;
+  out << "  --mttkrp-narrow-indices also store sparse tensor subscripts in 16 or 32 bits when they fit for single, atomic and duplicated mttkrp algorithms (off by default, since the copy is kept alongside the full subscripts)" << std::endl;
+  out << "  --mttkrp-mixed-precision store tensor values and factor matrices in single precision and accumulate in double for single, atomic and duplicated mttkrp algorithms in CP-ALS" << std::endl;
+  out << "  --mttkrp-rank-batch <int> number of components at which single, atomic and duplicated mttkrp algorithms load each tile of nonzeros into scratch once for all blocks of columns (0 disables; tiles that exceed team scratch use the regular kernel)" << std::endl;
+  out << "  --mttkrp-prefetch-distance <int> number of nonzeros ahead whose factor rows are prefetched in prefetch mttkrp algorithm (0 disables)" << std::endl;
+  out << "  --mttkrp-perm-row-ptrs build row pointers with the permutation and compute perm mttkrp deterministically without atomics" << std::endl;
+  out << "  --mttkrp-heavy-row-tiles <int> split rows with more than this many nonzero tiles across threads in perm mttkrp with row pointers (0 disables)" << std::endl;
+  out << "  --mttkrp-thread-timing record per-thread times in perm mttkrp with row pointers" << std::endl;
+  out << "  --mttkrp-hybrid-threshold <float> rows with at least this many nonzeros per thread are privatized in hybrid mttkrp algorithm" << std::endl;
+  out << "  --mttkrp-dimtree-memory <float> memory in MB for cached partial products in dimtree mttkrp algorithm (set to -1.0 for no limit)" << std::endl;
+  out << "  --mttkrp-tune-iters <int> sweeps over all modes timed for each candidate in auto mttkrp algorithm" << std::endl;
+  out << "  --mttkrp-tune-cache <string> file caching the choices of auto mttkrp algorithm (none by default)" << std::endl;
   out << "  --warmup           do an iteration of mttkrp to warmup (useful for generating accurate timing information)" << std::endl;
 
   out << std::endl;
@@ -256,6 +377,12 @@ void Genten::AlgParams::print_help(std::ostream& out)
       out << ", ";
   } out << std::endl;
 
+  out << std::endl;
+  out << "CP-ARLS-LEV options:" << std::endl;
+  out << "  --arls-samples <int> rows of the Khatri-Rao product sampled by leverage score in each least-squares subproblem" << std::endl;
+  out << "  --arls-epochiters <int> iterations between computations of the exact fit" << std::endl;
+  out << "  --arls-dedup       combine repeated samples into one weighted row" << std::endl;
+
   out << std::endl;
   out << "GCP options:" << std::endl;
   out << "  --type <type>      loss function type for GCP: ";
@@ -299,6 +426,7 @@ void Genten::AlgParams::print_help(std::ostream& out)
   out << "  --gnzw <float>     nonzero sample weight for gradient" << std::endl;
   out << "  --gzw <float>      zero sample weight for gradient" << std::endl;
   out << "  --hash             compute hash map for zero sampling" << std::endl;
+  out << "  --alto-lookup      compute ALTO linearized keys for zero sampling" << std::endl;
   out << "  --bulk-factor <int> factor for bulk zero sampling" << std::endl;
   out << "  --fuse             fuse gradient sampling and MTTKRP" << std::endl;
   out << "  --fuse-sa          fuse with sparse array gradient" << std::endl;
@@ -332,6 +460,17 @@ void Genten::AlgParams::print(std::ostream& out)
   out << "  rank-def-solver = " << (rank_def_solver ? "true" : "false") << std::endl;
   out << "  rcond = " << rcond << std::endl;
   out << "  penalty = " << penalty << std::endl;
+  out << "  compact = " << (compact ? "true" : "false") << std::endl;
+  out << "  numa-first-touch = " << (numa_first_touch ? "true" : "false") << std::endl;
+  out << "  numa-replicate = " << (numa_replicate ? "true" : "false") << std::endl;
+  out << "  line-search = " << (line_search ? "true" : "false") << std::endl;
+  out << "  line-search-start = " << line_search_start << std::endl;
+  out << "  line-search-fails = " << line_search_fails << std::endl;
+  out << "  starts = " << num_starts << std::endl;
+  out << "  rank-sweep-max = " << rank_sweep_max << std::endl;
+  out << "  rank-sweep-step = " << rank_sweep_step << std::endl;
+  out << "  rank-sweep-tol = " << rank_sweep_tol << std::endl;
+  out << "  rank-sweep-core-consistency = " << (rank_sweep_core_consistency ? "true" : "false") << std::endl;
 
   out << std::endl;
   out << "MTTKRP options:" << std::endl;
@@ -342,6 +481,19 @@ void Genten::AlgParams::print(std::ostream& out)
   out << "  mttkrp-nnz-tile-size = " << mttkrp_nnz_tile_size << std::endl;
   out << "  mttkrp-duplicated-tile-size = " << mttkrp_duplicated_factor_matrix_tile_size << std::endl;
   out << "  mttkrp-duplicated-threshold = " << mttkrp_duplicated_threshold << std::endl;
+  out << "  mttkrp-csf-all-modes = " << (mttkrp_csf_all_modes ? "true" : "false") << std::endl;
+  out << "  mttkrp-hicoo-block-bits = " << mttkrp_hicoo_block_bits << std::endl;
+  out << "  mttkrp-narrow-indices = " << (mttkrp_narrow_indices ? "true" : "false") << std::endl;
+  out << "  mttkrp-mixed-precision = " << (mttkrp_mixed_precision ? "true" : "false") << std::endl;
+  out << "  mttkrp-rank-batch = " << mttkrp_rank_batch << std::endl;
+  out << "  mttkrp-prefetch-distance = " << mttkrp_prefetch_distance << std::endl;
+  out << "  mttkrp-perm-row-ptrs = " << (mttkrp_perm_row_ptrs ? "true" : "false") << std::endl;
+  out << "  mttkrp-heavy-row-tiles = " << mttkrp_heavy_row_tiles << std::endl;
+  out << "  mttkrp-thread-timing = " << (mttkrp_thread_timing ? "true" : "false") << std::endl;
+  out << "  mttkrp-hybrid-threshold = " << mttkrp_hybrid_threshold << std::endl;
+  out << "  mttkrp-dimtree-memory = " << mttkrp_dimtree_memory << std::endl;
+  out << "  mttkrp-tune-iters = " << mttkrp_tune_iters << std::endl;
+  out << "  mttkrp-tune-cache = " << mttkrp_tune_cache << std::endl;
   out << "  warmup = " << (warmup ? "true" : "false") << std::endl;
 
   out << std::endl;
@@ -349,6 +501,12 @@ void Genten::AlgParams::print(std::ostream& out)
   out << "  ttm-method = " << Genten::TTM_Method::names[ttm_method]
        << std::endl;
 
+  out << std::endl;
+  out << "CP-ARLS-LEV options:" << std::endl;
+  out << "  arls-samples = " << arls_num_samples << std::endl;
+  out << "  arls-epochiters = " << arls_epoch_iters << std::endl;
+  out << "  arls-dedup = " << (arls_dedup ? "true" : "false") << std::endl;
+
   out << std::endl;
   out << "GCP options:" << std::endl;
   out << "  type = " << Genten::GCP_LossFunction::names[loss_function_type]
@@ -381,6 +539,7 @@ void Genten::AlgParams::print(std::ostream& out)
   out << "  gzw = " << w_g_z << std::endl;
   out << "  bulk-factor = " << bulk_factor << std::endl;
   out << "  hash = " << (hash ? "true" : "false") << std::endl;
+  out << "  alto-lookup = " << (alto_lookup ? "true" : "false") << std::endl;
   out << "  fuse = " << (fuse ? "true" : "false") << std::endl;
   out << "  fuse-sa = " << (fuse_sa ? "true" : "false") << std::endl;
   out << "  fit = " << (compute_fit ? "true" : "false") << std::endl;
@@ -67,6 +67,17 @@ namespace Genten {
     bool rank_def_solver; // Use rank-deficient least-squares solver
     ttb_real rcond;      // Truncation threshold in rank-deficient solver
     ttb_real penalty;    // Regularization penalty
+    bool compact;        // Decompose sparse tensors with empty slices dropped
+    bool numa_first_touch; // Place tensor/factors by kernel partition
+    bool numa_replicate; // Replicate factor matrices on each NUMA node
+    bool line_search;    // Extrapolate CP-ALS iterates with a line search
+    ttb_indx line_search_start; // First iteration that extrapolates
+    ttb_indx line_search_fails; // Rejected steps before shortening steps
+    ttb_indx num_starts; // Number of CP-ALS starts computed together
+    ttb_indx rank_sweep_max; // Largest rank of CP-ALS rank sweep (0 for none)
+    ttb_indx rank_sweep_step; // Rank increment of CP-ALS rank sweep
+    ttb_real rank_sweep_tol; // Smallest fit gain continuing the rank sweep
+    bool rank_sweep_core_consistency; // Core consistency of each swept rank
 
     // MTTKRP options
     MTTKRP_Method::type mttkrp_method; // MTTKRP algorithm
@@ -74,11 +85,29 @@ namespace Genten {
     unsigned mttkrp_nnz_tile_size; // Nonzero tile size (i.e., RowBlockSize)
     unsigned mttkrp_duplicated_factor_matrix_tile_size; // Tile size for MTTKRP
     ttb_real mttkrp_duplicated_threshold;  // Theshold for when dup is used
+    bool mttkrp_csf_all_modes; // Build a CSF tree rooted at each mode
+    ttb_indx mttkrp_hicoo_block_bits; // Log2 of HiCOO block size
+    bool mttkrp_narrow_indices; // Use narrowest subscript type that fits
+    bool mttkrp_mixed_precision; // Float factors/values, ttb_real accumulation
+    ttb_indx mttkrp_rank_batch; // Rank at which nonzero tiles go in scratch
+    ttb_indx mttkrp_prefetch_distance; // Nonzeros ahead to prefetch rows
+    bool mttkrp_perm_row_ptrs; // Build row pointers for deterministic perm
+    ttb_indx mttkrp_heavy_row_tiles; // Tiles in a row before it is split
+    bool mttkrp_thread_timing; // Record per-thread MTTKRP kernel times
+    ttb_real mttkrp_hybrid_threshold; // Nonzeros per thread for a hot row
+    ttb_real mttkrp_dimtree_memory; // MB of cached dimension tree tensors
+    ttb_indx mttkrp_tune_iters; // Sweeps timed per candidate in auto MTTKRP
+    std::string mttkrp_tune_cache; // Tuning cache file for auto MTTKRP
     bool warmup; // Warmup by calling MTTKRP before decompsition
 
     // TTM options
     TTM_Method::type ttm_method; // TTM algorithm
 
+    // CP-ARLS-LEV options
+    ttb_indx arls_num_samples; // Khatri-Rao rows sampled per subproblem
+    ttb_indx arls_epoch_iters; // Iterations between exact fit checks
+    bool arls_dedup;           // Combine repeated samples
+
     // GCP options
     GCP_LossFunction::type loss_function_type; // Loss function for GCP
     ttb_real loss_eps;                         // Perturbation for GCP
@@ -106,6 +135,7 @@ namespace Genten {
     ttb_real w_g_nz;                     // Nonzero sample weight for grad
     ttb_real w_g_z;                      // Zero sample weight for grad
     bool hash;                           // Hash tensor instead of sorting
+    bool alto_lookup;                    // Use ALTO keys instead of sorting
     bool fuse;                           // Fuse sampling and gradient kernels
     bool fuse_sa;                        // Fused with sparse array gradient
     bool compute_fit;                    // Compute fit metric
@@ -235,6 +265,13 @@ namespace Genten {
       else {
         if (method == Solver_Method::GCP_SGD)
           mttkrp_method = MTTKRP_Method::Duplicated;
+        else if (numa_first_touch) {
+          // Perm reads the nonzeros in permuted order, not by the tiles
+          // the first-touch placement follows
+          mttkrp_method = MTTKRP_Method::Duplicated;
+          out << "Using duplicated MTTKRP method instead of perm since "
+              << "first-touch NUMA placement is enabled." << std::endl;
+        }
         else
           mttkrp_method = MTTKRP_Method::Perm;
       }
@@ -278,7 +315,8 @@ namespace Genten {
     //     Cuda
     if (space_prop::is_cuda) {
       if (mttkrp_method == MTTKRP_Method::Single ||
-          mttkrp_method == MTTKRP_Method::Duplicated) {
+          mttkrp_method == MTTKRP_Method::Duplicated ||
+          mttkrp_method == MTTKRP_Method::Prefetch) {
         out << "MTTKRP method " << MTTKRP_Method::names[mttkrp_method]
             << " is invalid for Cuda, changing to ";
         if (space_prop::cuda_arch() >= 600 || sizeof(ttb_real) == 4)
@@ -48,6 +48,9 @@
 #include <iomanip>
 #include <sstream>
 #include <cmath>
+#include <limits>
+#include <vector>
+#include <algorithm>
 
 #include "Genten_Array.hpp"
 #include "Genten_CpAls.hpp"
@@ -55,8 +58,18 @@
 #include "Genten_Ktensor.hpp"
 #include "Genten_MixedFormatOps.hpp"
 #include "Genten_Sptensor.hpp"
+#include "Genten_SptensorCSF.hpp"
+#include "Genten_SptensorHiCOO.hpp"
+#include "Genten_SptensorALTO.hpp"
+#include "Genten_SptensorHybrid.hpp"
+#include "Genten_SptensorDimTree.hpp"
+#include "Genten_SptensorNarrow.hpp"
+#include "Genten_KtensorNarrow.hpp"
+#include "Genten_NUMA.hpp"
 #include "Genten_Tensor.hpp"
+#include "Genten_Kokkos_ScatterView.hpp"
 #include "Genten_SystemTimer.hpp"
+#include "Genten_RandomMT.hpp"
 #include "Genten_Util.hpp"
 
 #ifdef HAVE_CALIPER
@@ -73,40 +86,457 @@ namespace Genten {
                                  const ttb_real  xDotm);
 
 
-  //------------------------------------------------------
-  // PUBLIC FUNCTIONS
-  //------------------------------------------------------
+  namespace Impl {
 
-  /*
-   *  Copied from the header file:
-   *
-   *  @param[in] x          Data tensor to be fit by the model.
-   *  @param[in/out] u      Input contains an initial guess for the factors.
-   *                        The size of each mode must match the corresponding
-   *                        mode of x, and the number of components determines
-   *                        how many will be in the result.
-   *                        Output contains resulting factorization Ktensor.
-   *  @param[in] tol        Stop tolerance for convergence of "fit function".
-   *  @param[in] maxIters   Maximum number of iterations allowed.
-   *  @param[in] maxSecs    Maximum execution time allowed (CP-ALS will finish
-   *                        the current iteration before exiting).
-   *                        If negative, execute without a time limit.
-   *  @param[in] printIter  Print progress every n iterations.
-   *                        If zero, print nothing.
-   *  @param[out] numIters  Number of iterations actually completed.
-   *  @param[out] resNorm   Square root of Frobenius norm of the residual.
-   *  @param[in] perfIter   Add performance information every n iterations.
-   *                        If zero, do not collect info.
-   *  @param[out] perfInfo  Performance information array.  Must allocate
-   *                        (maxIters / perfIter) + 2 elements of type
-   *                        CpAlsPerfInfo.
-   *                        Can be NULL if perfIter is zero.
-   *
-   *  @throws string        if internal linear solve detects singularity,
-   *                        or tensor arguments are incompatible.
-   */
+  // Computes the MTTKRPs within CP-ALS.  Sparse tensors using the CSF,
+  // HiCOO, ALTO, hybrid or dimtree MTTKRP methods build that format once up
+  // front, since the MTTKRP would otherwise rebuild it for every call.  Likewise sparse tensors using
+  // the single, atomic or duplicated methods are copied once to the
+  // narrowest subscript type that fits when requested, or to float values
+  // with float copies of the factor matrices refreshed before each MTTKRP
+  // for mixed precision.  Factor matrices may also be replicated on each
+  // NUMA node for these methods on the host.
+  template <typename TensorT>
+  struct CpAlsMttkrp {
+    const TensorT& x;
+
+    CpAlsMttkrp(const TensorT& x_, const AlgParams&) : x(x_) {}
+
+    template <typename ExecSpace>
+    void operator() (const KtensorT<ExecSpace>& u, const ttb_indx n,
+                     const AlgParams& algParams) const
+    {
+      Genten::mttkrp (x, u, n, algParams);
+    }
+
+    // Called when all factor matrices have been replaced
+    void reset() const {}
+
+    // Bytes per subscript read by the MTTKRP
+    unsigned index_bytes() const { return sizeof(ttb_indx); }
+  };
+
+  template <typename ExecSpace>
+  struct CpAlsMttkrp< SptensorT<ExecSpace> > {
+    const SptensorT<ExecSpace>& x;
+    SptensorCSFT<ExecSpace> x_csf;
+    SptensorHiCOOT<ExecSpace> x_hicoo;
+    SptensorALTOT<ExecSpace> x_alto;
+    SptensorHybridT<ExecSpace> x_hybrid;
+    SptensorDimTreeT<ExecSpace> x_dimtree;
+    SptensorNarrowT<ExecSpace,uint16_t> x_16;
+    SptensorNarrowT<ExecSpace,uint32_t> x_32;
+#ifdef HAVE_MIXED_PRECISION
+    SptensorNarrowT<ExecSpace,uint32_t,float> x_32f;
+    SptensorNarrowT<ExecSpace,uint64_t,float> x_64f;
+    mutable KtensorNarrowT<ExecSpace,float> u_f;
+#endif
+    mutable KtensorReplicatedT<ExecSpace> u_rep;
+    unsigned nbytes;
+    bool mixed;
+    bool replicate;
+
+    CpAlsMttkrp(const SptensorT<ExecSpace>& x_, const AlgParams& algParams) :
+      x(x_), nbytes(sizeof(ttb_indx)), mixed(false), replicate(false)
+    {
+      const MTTKRP_Method::type method = algParams.mttkrp_method;
+      if (method == MTTKRP_Method::CSF)
+        x_csf = SptensorCSFT<ExecSpace>(x, algParams);
+      else if (method == MTTKRP_Method::HiCOO)
+        x_hicoo = SptensorHiCOOT<ExecSpace>(x, algParams);
+      else if (method == MTTKRP_Method::ALTO)
+        x_alto = SptensorALTOT<ExecSpace>(x);
+      else if (method == MTTKRP_Method::Hybrid)
+        x_hybrid = SptensorHybridT<ExecSpace>(x, algParams);
+      else if (method == MTTKRP_Method::DimTree)
+        x_dimtree = SptensorDimTreeT<ExecSpace>(x, algParams);
+      else if (algParams.mttkrp_mixed_precision &&
+               (method == MTTKRP_Method::Single ||
+                method == MTTKRP_Method::Atomic ||
+                method == MTTKRP_Method::Duplicated ||
+                method == MTTKRP_Method::Prefetch)) {
+#ifdef HAVE_MIXED_PRECISION
+        IndxArray sz(x.ndims());
+        for (ttb_indx i=0; i<x.ndims(); ++i)
+          sz[i] = x.size(i);
+        mixed = true;
+        if (algParams.mttkrp_narrow_indices && narrow_index_bytes(sz) <= 4) {
+          nbytes = 4;
+          x_32f = SptensorNarrowT<ExecSpace,uint32_t,float>(x);
+          if (algParams.numa_first_touch)
+            numa_first_touch(x_32f, algParams);
+        }
+        else {
+          nbytes = 8;
+          x_64f = SptensorNarrowT<ExecSpace,uint64_t,float>(x);
+          if (algParams.numa_first_touch)
+            numa_first_touch(x_64f, algParams);
+        }
+#else
+        Genten::error("Genten::cpals_core - mixed-precision MTTKRP requires GENTEN_FLOAT_TYPE=double");
+#endif
+      }
+      else if (algParams.mttkrp_narrow_indices &&
+               (method == MTTKRP_Method::Single ||
+                method == MTTKRP_Method::Atomic ||
+                method == MTTKRP_Method::Duplicated ||
+                method == MTTKRP_Method::Prefetch)) {
+        IndxArray sz(x.ndims());
+        for (ttb_indx i=0; i<x.ndims(); ++i)
+          sz[i] = x.size(i);
+        nbytes = narrow_index_bytes(sz);
+        if (nbytes == 2)
+          x_16 = SptensorNarrowT<ExecSpace,uint16_t>(x);
+        else if (nbytes == 4)
+          x_32 = SptensorNarrowT<ExecSpace,uint32_t>(x);
+
+        // The MTTKRP reads the copy instead of x, so place it like x
+        if (algParams.numa_first_touch && nbytes == 2)
+          numa_first_touch(x_16, algParams);
+        else if (algParams.numa_first_touch && nbytes == 4)
+          numa_first_touch(x_32, algParams);
+      }
+      replicate = algParams.numa_replicate && !mixed &&
+        !Genten::is_cuda_space<ExecSpace>::value &&
+        (method == MTTKRP_Method::Single ||
+         method == MTTKRP_Method::Atomic ||
+         method == MTTKRP_Method::Duplicated ||
+         method == MTTKRP_Method::Prefetch);
+    }
+
+    void operator() (const KtensorT<ExecSpace>& u, const ttb_indx n,
+                     const AlgParams& algParams) const
+    {
+      if (algParams.mttkrp_method == MTTKRP_Method::CSF)
+        Genten::mttkrp (x_csf, u, n, u[n], algParams);
+      else if (algParams.mttkrp_method == MTTKRP_Method::HiCOO)
+        Genten::mttkrp (x_hicoo, u, n, u[n], algParams);
+      else if (algParams.mttkrp_method == MTTKRP_Method::ALTO)
+        Genten::mttkrp (x_alto, u, n, u[n], algParams);
+      else if (algParams.mttkrp_method == MTTKRP_Method::Hybrid)
+        Genten::mttkrp (x_hybrid, u, n, u[n], algParams);
+      else if (algParams.mttkrp_method == MTTKRP_Method::DimTree) {
+        // u[n] is overwritten with the solution next, which invalidates
+        // the cached partial products that depend on it
+        Genten::mttkrp (x_dimtree, u, n, u[n], algParams);
+        x_dimtree.factorUpdated(n);
+      }
+#ifdef HAVE_MIXED_PRECISION
+      else if (mixed) {
+        if (u_f.ndims() == 0)
+          u_f = KtensorNarrowT<ExecSpace,float>(u);
+        u_f.update(u, n);
+        if (nbytes == 4)
+          Genten::mttkrp (x_32f, u_f, n, u[n], algParams);
+        else
+          Genten::mttkrp (x_64f, u_f, n, u[n], algParams);
+      }
+#endif
+      else if (replicate) {
+        if (u_rep.ndims() == 0)
+          u_rep = KtensorReplicatedT<ExecSpace>(u);
+        u_rep.update(u, n);
+        if (nbytes == 2)
+          Genten::mttkrp (x_16, u_rep, n, u[n], algParams);
+        else if (nbytes == 4)
+          Genten::mttkrp (x_32, u_rep, n, u[n], algParams);
+        else
+          Genten::mttkrp (x, u_rep, n, u[n], algParams);
+      }
+      else if (nbytes == 2)
+        Genten::mttkrp (x_16, u, n, u[n], algParams);
+      else if (nbytes == 4)
+        Genten::mttkrp (x_32, u, n, u[n], algParams);
+      else
+        Genten::mttkrp (x, u, n, algParams);
+    }
+
+    // Called when all factor matrices have been replaced or resized, which
+    // invalidates all cached partial products of the dimtree method and the
+    // float or replicated copies of the factor matrices
+    void reset() const
+    {
+      x_dimtree.reset();
+#ifdef HAVE_MIXED_PRECISION
+      u_f = KtensorNarrowT<ExecSpace,float>();
+#endif
+      u_rep = KtensorReplicatedT<ExecSpace>();
+    }
+
+    // Bytes per subscript read by the MTTKRP
+    unsigned index_bytes() const { return nbytes; }
+  };
+
+  // Extrapolate the factor matrix v = a + step*(b - a), where the weights
+  // wa and wb are folded into a and b respectively when fold is true.
+  template <typename ExecSpace>
+  void cpals_extrapolate(const FacMatrixT<ExecSpace>& v,
+                         const FacMatrixT<ExecSpace>& a,
+                         const FacMatrixT<ExecSpace>& b,
+                         const ArrayT<ExecSpace>& wa,
+                         const ArrayT<ExecSpace>& wb,
+                         const ttb_real step,
+                         const bool fold)
+  {
+    const ttb_indx nrow = v.nRows();
+    const unsigned nc = v.nCols();
+    Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(0,nrow),
+                         KOKKOS_LAMBDA(const ttb_indx i)
+    {
+      for (unsigned j=0; j<nc; ++j) {
+        const ttb_real aij = fold ? wa[j]*a.entry(i,j) : a.entry(i,j);
+        const ttb_real bij = fold ? wb[j]*b.entry(i,j) : b.entry(i,j);
+        v.entry(i,j) = aij + step*(bij - aij);
+      }
+    }, "Genten::cpals_extrapolate_kernel");
+  }
+
+  // Copy columns [src_col,src_col+ncol) of src into columns
+  // [dst_col,dst_col+ncol) of dst
+  template <typename ExecSpace>
+  void cpals_copy_columns(const FacMatrixT<ExecSpace>& dst,
+                          const ttb_indx dst_col,
+                          const FacMatrixT<ExecSpace>& src,
+                          const ttb_indx src_col,
+                          const ttb_indx ncol)
+  {
+    const ttb_indx nrow = dst.nRows();
+    Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(0,nrow),
+                         KOKKOS_LAMBDA(const ttb_indx i)
+    {
+      for (ttb_indx j=0; j<ncol; ++j)
+        dst.entry(i,dst_col+j) = src.entry(i,src_col+j);
+    }, "Genten::cpals_copy_columns_kernel");
+  }
+
+  // The factor matrices of several starts are stored side by side in blocks
+  // of nc columns, and small per-start matrices are stored stacked in blocks
+  // of nc rows.  Block a of ups is set to the Hadamard product of the
+  // diagonal blocks a of the Gramians of all modes but n.
+  template <typename ExecSpace>
+  void cpals_block_upsilon(const FacMatrixT<ExecSpace>& ups,
+                           const FacMatArrayT<ExecSpace>& grams,
+                           const ttb_indx n,
+                           const ttb_indx nc)
+  {
+    const ttb_indx nrow = ups.nRows();
+    const ttb_indx nd = grams.size();
+    Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(0,nrow),
+                         KOKKOS_LAMBDA(const ttb_indx i)
+    {
+      const ttb_indx c = (i/nc)*nc;
+      for (ttb_indx j=0; j<nc; ++j) {
+        ttb_real t = 1.0;
+        for (ttb_indx idx=0; idx<nd; ++idx)
+          if (idx != n)
+            t *= grams[idx].entry(i,c+j);
+        ups.entry(i,j) = t;
+      }
+    }, "Genten::cpals_block_upsilon_kernel");
+  }
+
+  // Multiply each block of columns of m by the matching block of rows of b,
+  // i.e., w = m*blockdiag(b), in one pass over the rows
+  template <typename ExecSpace>
+  void cpals_block_times(const FacMatrixT<ExecSpace>& w,
+                         const FacMatrixT<ExecSpace>& m,
+                         const FacMatrixT<ExecSpace>& b,
+                         const ttb_indx nc)
+  {
+    const ttb_indx nrow = w.nRows();
+    const ttb_indx ncol = w.nCols();
+    Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(0,nrow),
+                         KOKKOS_LAMBDA(const ttb_indx i)
+    {
+      for (ttb_indx c=0; c<ncol; c+=nc) {
+        for (ttb_indx j=0; j<nc; ++j) {
+          ttb_real t = 0.0;
+          for (ttb_indx k=0; k<nc; ++k)
+            t += m.entry(i,c+k)*b.entry(c+k,j);
+          w.entry(i,c+j) = t;
+        }
+      }
+    }, "Genten::cpals_block_times_kernel");
+  }
+
+  // Weighted inner product <m_a, v_a diag(lambda_a)> of each block a of
+  // columns, stored in d(a)
+  template <typename ExecSpace>
+  void cpals_block_innerprod(const Kokkos::View<ttb_real*,ExecSpace>& d,
+                             const FacMatrixT<ExecSpace>& m,
+                             const FacMatrixT<ExecSpace>& v,
+                             const ArrayT<ExecSpace>& lambda,
+                             const ttb_indx nc)
+  {
+    const ttb_indx row_block = 128;
+    const ttb_indx nrow = m.nRows();
+    const ttb_indx na = d.extent(0);
+    const ttb_indx nblock = (nrow+row_block-1)/row_block;
+    Kokkos::deep_copy(d, ttb_real(0.0));
+    Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(0,nblock*na),
+                         KOKKOS_LAMBDA(const ttb_indx ib)
+    {
+      const ttb_indx a = ib % na;
+      const ttb_indx i_beg = (ib / na)*row_block;
+      const ttb_indx i_end =
+        i_beg+row_block < nrow ? i_beg+row_block : nrow;
+      ttb_real t = 0.0;
+      for (ttb_indx i=i_beg; i<i_end; ++i)
+        for (ttb_indx j=a*nc; j<(a+1)*nc; ++j)
+          t += m.entry(i,j)*v.entry(i,j)*lambda[j];
+      Kokkos::atomic_add(&d(a), t);
+    }, "Genten::cpals_block_innerprod_kernel");
+  }
+
+  // Nonnegative HALS update of the factor matrix a, which holds the MTTKRP
+  // result m on entry, from the previous factor matrix a_old scaled by the
+  // weights w.  Column r is updated from the columns before it and projected
+  // onto the nonnegative orthant,
+  //   a(:,r) = max(eps, a(:,r) + (m(:,r) - a*v(:,r)) / v(r,r)),
+  // where v is the Hadamard product of the other Gram matrices.  This only
+  // involves row i of a for a(i,r), so one thread updates all columns of a
+  // row, which costs about as much as the product a*v.  Only the upper
+  // triangle of v is read unless full is true.
+  template <typename ExecSpace>
+  void cpals_hals_update(const FacMatrixT<ExecSpace>& a,
+                         const FacMatrixT<ExecSpace>& a_old,
+                         const ArrayT<ExecSpace>& w,
+                         const FacMatrixT<ExecSpace>& v,
+                         const bool full)
+  {
+    const ttb_indx nrow = a.nRows();
+    const unsigned nc = a.nCols();
+    const ttb_real eps = MACHINE_EPSILON;
+    Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(0,nrow),
+                         KOKKOS_LAMBDA(const ttb_indx i)
+    {
+      for (unsigned r=0; r<nc; ++r) {
+        ttb_real s = a.entry(i,r);
+        for (unsigned k=0; k<nc; ++k) {
+          const ttb_real aik = k < r ? a.entry(i,k) : w[k]*a_old.entry(i,k);
+          const ttb_real vkr = (full || k <= r) ? v.entry(k,r) : v.entry(r,k);
+          s -= aik*vkr;
+        }
+        const ttb_real air = w[r]*a_old.entry(i,r) + s/v.entry(r,r);
+        a.entry(i,r) = air > eps ? air : eps;
+      }
+    }, "Genten::cpals_hals_update_kernel");
+  }
+
+  // Core consistency diagnostic (CORCONDIA) of the model u of x in
+  // percent.  The core G = x x_1 pinv(A_1) ... x_d pinv(A_d) of the model's
+  // factor matrices A_n, with the weights folded into A_1, is compared to the
+  // superdiagonal identity:  100*(1 - |G - I|^2/nc).  Each nonzero adds the
+  // outer product of its rows of the pseudo-inverses to the core in one pass
+  // over the tensor, so NaN is returned when nnz times the number of core
+  // entries exceeds 2^32.
+  template <typename ExecSpace>
+  ttb_real cpals_core_consistency(const SptensorT<ExecSpace>& x,
+                                  const KtensorT<ExecSpace>& u,
+                                  const AlgParams& algParams)
+  {
+    const ttb_indx nc = u.ncomponents();
+    const ttb_indx nd = u.ndims();
+
+    // The Gram matrices of an overfactored model are (nearly) singular, so
+    // use the rank-deficient least-squares solver where available
+    AlgParams ap = algParams;
+    ap.rank_def_solver = !Genten::is_cuda_space<ExecSpace>::value;
+
+    // Number of core entries and the stride between its superdiagonal ones
+    const ttb_indx nnz = x.nnz();
+    const ttb_indx max_core = (ttb_indx(1) << 32) / (nnz > 0 ? nnz : 1);
+    ttb_indx ncore = 1;
+    ttb_indx stride = 0;
+    for (ttb_indx n = 0; n < nd; n++)
+    {
+      if (ncore * nc > max_core)
+        return std::numeric_limits<ttb_real>::quiet_NaN();
+      stride += ncore;
+      ncore *= nc;
+    }
+
+    // Transposed pseudo-inverses P_n = A_n (A_n'A_n)^+, where folding the
+    // weights in first lets the solver truncate vanishing components
+    Genten::KtensorT<ExecSpace> p(nc, nd, x.size());
+    Genten::FacMatrixT<ExecSpace> gram(nc, nc);
+    for (ttb_indx n = 0; n < nd; n++)
+    {
+      deep_copy(p[n], u[n]);
+      if (n == 0)
+        p[n].colScale(u.weights(), false);
+      gram.gramian(p[n], true, Upper);
+      p[n].solveTransposeRHS(gram, true, Upper, false, ap);
+    }
+
+    const FacMatArrayT<ExecSpace> pf = p.factors();
+    const auto subs = x.getSubscripts();
+    const auto vals = x.getValues();
+    Kokkos::View<ttb_real*,ExecSpace> g("Genten::cpals_core_consistency::core",
+                                        ncore);
+    auto sg = Kokkos::Experimental::create_scatter_view(g);
+    Kokkos::parallel_for("Genten::cpals_core_consistency_kernel",
+                         Kokkos::RangePolicy<ExecSpace>(0,nnz),
+                         KOKKOS_LAMBDA(const ttb_indx i)
+    {
+      auto ga = sg.access();
+      for (ttb_indx c = 0; c < ncore; c++)
+      {
+        ttb_real v = vals(i);
+        ttb_indx r = c;
+        for (ttb_indx n = 0; n < nd; n++)
+        {
+          v *= pf[n].entry(subs(i,n), r % nc);
+          r /= nc;
+        }
+        ga(c) += v;
+      }
+    });
+    Kokkos::Experimental::contribute(g, sg);
+
+    ttb_real err = 0.0;
+    Kokkos::parallel_reduce("Genten::cpals_core_consistency_error",
+                            Kokkos::RangePolicy<ExecSpace>(0,ncore),
+                            KOKKOS_LAMBDA(const ttb_indx c, ttb_real& e)
+    {
+      const ttb_real d = (c % stride == 0) ? g(c) - ttb_real(1.0) : g(c);
+      e += d*d;
+    }, err);
+
+    return ttb_real(100.0) * (ttb_real(1.0) - err / ttb_real(nc));
+  }
+
+  // Pad the model u of a tensor of size sz to nc components with random
+  // ones drawn like the driver's initial guess, keeping the components of u
+  // first.
+  template <typename ExecSpace>
+  void cpals_pad_ktensor(Genten::KtensorT<ExecSpace>& u, const ttb_indx nc,
+                         const IndxArrayT<ExecSpace>& sz,
+                         Genten::RandomMT& rng)
+  {
+    const ttb_indx nc_old = u.ncomponents();
+    const ttb_indx nd = u.ndims();
+    Genten::KtensorT<ExecSpace> v(nc, nd, sz);
+    Genten::KtensorT<DefaultHostExecutionSpace> v_host =
+      create_mirror_view(DefaultHostExecutionSpace(), v);
+    v_host.setMatricesScatter(false, false, rng);
+    v_host.normalize(Genten::NormTwo);
+    v_host.setWeights(1.0);
+    deep_copy(v, v_host);
+    for (ttb_indx n = 0; n < nd; n++)
+      cpals_copy_columns(v[n], 0, u[n], 0, nc_old);
+    auto w = v.weights().values();
+    auto w_old = u.weights().values();
+    Kokkos::deep_copy(Kokkos::subview(w, std::make_pair(ttb_indx(0), nc_old)),
+                      w_old);
+    u = v;
+  }
+
+  // CP-ALS using the MTTKRP functor x_mttkrp, so that it may be reused
+  // across calls.  See cpals_core() below for the other arguments.
   template<typename TensorT, typename ExecSpace>
   void cpals_core (const TensorT& x,
+                   const CpAlsMttkrp<TensorT>& x_mttkrp,
                    Genten::KtensorT<ExecSpace>& u,
                    const AlgParams& algParams,
                    ttb_indx& numIters,
@@ -130,6 +560,8 @@ namespace Genten {
     const ttb_indx maxIters = algParams.maxiters;
     const ttb_real maxSecs = algParams.maxsecs;
     const ttb_indx printIter = algParams.printitn;
+    const bool lineSearch = algParams.line_search;
+    const bool hals = algParams.method == Solver_Method::CP_HALS;
 
     // Check size compatibility of the arguments.
     if (u.isConsistent() == false)
@@ -141,6 +573,8 @@ namespace Genten {
       if (x.size(i) != u[i].nRows())
         Genten::error("Genten::cpals_core - u and x have different size");
     }
+    if (hals && lineSearch)
+      Genten::error("Genten::cpals_core - line search is not supported by cp-hals");
 
     // Start timer for total execution time of the algorithm.
     const int timer_cpals = 0;
@@ -151,7 +585,8 @@ namespace Genten {
     const int timer_scale = 5;
     const int timer_norm = 6;
     const int timer_arrange = 7;
-    Genten::SystemTimer timer(8, algParams.timings);
+    const int timer_ls = 8;
+    Genten::SystemTimer timer(9, algParams.timings);
 
     timer.start(timer_cpals);
 
@@ -159,14 +594,17 @@ namespace Genten {
     ttb_indx nd = x.ndims();           // number of dimensions
 
     if (printIter > 0) {
-      out << "\nCP-ALS (rank " << nc << ", "
+      out << "\n" << (hals ? "CP-HALS" : "CP-ALS") << " (rank " << nc << ", "
           << Genten::MTTKRP_Method::names[algParams.mttkrp_method]
           << " MTTKRP method, ";
       if (algParams.full_gram)
         out << "full-gram";
       else
         out << "symmetric-gram";
-      out << " formulation):" << std::endl;
+      out << " formulation";
+      if (lineSearch)
+        out << ", line search";
+      out << "):" << std::endl;
     }
 
     // Initialize CpAlsPerfInfo.
@@ -217,6 +655,29 @@ namespace Genten {
     // (Used to compute <x,u> using the trick described by Smith & Karypis)
     Genten::FacMatrixT<ExecSpace> un(u[nd-1].nRows(), nc);
 
+    // Previous iterate, extrapolated factor matrices and their Gram
+    // matrices for the line search.  HALS updates u[n] from the previous
+    // factor matrix, which is saved in u_old before its MTTKRP.
+    Genten::KtensorT<ExecSpace> u_old, u_ls;
+    Genten::ArrayT<ExecSpace> lambda_old, ones;
+    Genten::FacMatArrayT<ExecSpace> gamma_ls;
+    ttb_real ls_pow = 2.0;
+    ttb_indx ls_fails = 0;
+    ttb_indx ls_tries = 0;
+    ttb_indx ls_accepted = 0;
+    if (hals)
+      u_old = Genten::KtensorT<ExecSpace>(nc, nd, x.size());
+    if (lineSearch)
+    {
+      u_old = Genten::KtensorT<ExecSpace>(nc, nd, x.size());
+      u_ls = Genten::KtensorT<ExecSpace>(nc, nd, x.size());
+      lambda_old = Genten::ArrayT<ExecSpace>(nc);
+      ones = Genten::ArrayT<ExecSpace>(nc, (ttb_real) 1.0);
+      gamma_ls = Genten::FacMatArrayT<ExecSpace>(nd);
+      for (ttb_indx n = 0; n < nd; n ++)
+        gamma_ls.set_factor( n, FacMatrixT<ExecSpace>(nc, nc) );
+    }
+
     // Pre-calculate the Frobenius norm of the tensor x.
     ttb_real xNorm = x.norm();
 
@@ -253,13 +714,23 @@ namespace Genten {
     {
       fitold = fit;
 
+      // Save the current iterate as the start of the extrapolation direction
+      if (lineSearch)
+      {
+        deep_copy(u_old, u);
+        deep_copy(lambda_old, lambda);
+      }
+
       // Iterate over all N modes of the tensor
       for (ttb_indx n = 0; n < nd; n++)
       {
+        if (hals)
+          deep_copy(u_old[n], u[n]);
+
         // Update u[n] via MTTKRP with x (Khattri-Rao product).
         // The size of u[n] is dim(n) rows by R columns.
         timer.start(timer_mttkrp);
-        Genten::mttkrp (x, u, n, algParams);
+        x_mttkrp (u, n, algParams);
         Kokkos::fence();
         timer.stop(timer_mttkrp);
 
@@ -280,10 +751,15 @@ namespace Genten {
         // Solve upsilon * X = u[n]' for X, and overwrite u[n]
         // with the result.  Equivalent to the Matlab operation
         //   u[n] = (upsilon \ u[n]')'.
+        // HALS instead updates the columns of the previous u[n], scaled by
+        // lambda, one at a time keeping them nonnegative.
         timer.start(timer_solve);
         if (algParams.penalty != ttb_real(0.0))
           upsilon.diagonalShift(algParams.penalty);
-        spd = u[n].solveTransposeRHS (upsilon, full, uplo, spd, algParams);
+        if (hals)
+          Impl::cpals_hals_update(u[n], u_old[n], lambda, upsilon, full);
+        else
+          spd = u[n].solveTransposeRHS (upsilon, full, uplo, spd, algParams);
         if (algParams.penalty != ttb_real(0.0))
           upsilon.diagonalShift(-algParams.penalty);
         Kokkos::fence();
@@ -341,6 +817,51 @@ namespace Genten {
 
       // Compute the relative fit and change since the last iteration.
       fit = 1 - (resNorm / xNorm);
+
+      // Extrapolate the factor matrices along the change made by this
+      // iteration, with lambda folded into the last mode, and keep the
+      // result if it improves the fit.
+      if (lineSearch && numIters + 1 >= algParams.line_search_start)
+      {
+        timer.start(timer_ls);
+        const ttb_real step = std::pow(ttb_real(numIters + 1), 1.0 / ls_pow);
+        upsilon = 1;
+        for (ttb_indx n = 0; n < nd; n++)
+        {
+          Impl::cpals_extrapolate(u_ls[n], u_old[n], u[n], lambda_old, lambda,
+                                  step, n == nd-1);
+          gamma_ls[n].gramian(u_ls[n], full, uplo);
+          upsilon.times(gamma_ls[n]);
+        }
+        const ttb_real pNorm_ls = sqrt(fabs(upsilon.sum(uplo)));
+        const ttb_real xpip_ls = innerprod (x, u_ls, ones);
+        const ttb_real resNorm_ls = computeResNorm(xNorm, pNorm_ls, xpip_ls);
+        const ttb_real fit_ls = 1 - (resNorm_ls / xNorm);
+        ++ls_tries;
+        if (fit_ls > fit)
+        {
+          for (ttb_indx n = 0; n < nd; n++)
+          {
+            deep_copy(u[n], u_ls[n]);
+            deep_copy(gamma[n], gamma_ls[n]);
+          }
+          lambda = 1.0;
+          x_mttkrp.reset();
+          resNorm = resNorm_ls;
+          fit = fit_ls;
+          ++ls_accepted;
+          ls_fails = 0;
+        }
+        else if (++ls_fails >= algParams.line_search_fails)
+        {
+          // Take shorter steps after repeated failures
+          ls_pow += 1.0;
+          ls_fails = 0;
+        }
+        Kokkos::fence();
+        timer.stop(timer_ls);
+      }
+
       ttb_real fitchange = fabs(fitold - fit);
 
       // Print progress of the current iteration.
@@ -375,6 +896,9 @@ namespace Genten {
     if (printIter > 0)
       out << "Final fit = " << std::setw(13) << std::setprecision(6)
           << std::scientific << fit << std::endl;
+    if (printIter > 0 && lineSearch)
+      out << "Line search accepted " << ls_accepted << " of " << ls_tries
+          << " extrapolations" << std::endl;
 
     // Increment so the count starts from one.
     numIters++;
@@ -399,7 +923,7 @@ namespace Genten {
     const double mttkrp_flops =
       x.nnz()*nc*(nd+atomic);
     const double mttkrp_reads =
-      x.nnz()*((nd*nc+3)*sizeof(ttb_real)+nd*sizeof(ttb_indx));
+      x.nnz()*((nd*nc+3)*sizeof(ttb_real)+nd*x_mttkrp.index_bytes());
     const double mttkrp_tput =
       ( mttkrp_flops / mttkrp_avg_time ) / (1024.0 * 1024.0 * 1024.0);
     const double mttkrp_factor = mttkrp_flops / mttkrp_reads;
@@ -442,11 +966,501 @@ namespace Genten {
       out << "\tArrange total time = " << timer.getTotalTime(timer_arrange)
           << " seconds, average time = " << timer.getAvgTime(timer_arrange)
           << " seconds\n";
+      if (lineSearch)
+        out << "\tLine search total time = " << timer.getTotalTime(timer_ls)
+            << " seconds, average time = " << timer.getAvgTime(timer_ls)
+            << " seconds\n";
     }
 
     return;
   }
 
+  }
+
+  //------------------------------------------------------
+  // PUBLIC FUNCTIONS
+  //------------------------------------------------------
+
+  /*
+   *  Copied from the header file:
+   *
+   *  @param[in] x          Data tensor to be fit by the model.
+   *  @param[in/out] u      Input contains an initial guess for the factors.
+   *                        The size of each mode must match the corresponding
+   *                        mode of x, and the number of components determines
+   *                        how many will be in the result.
+   *                        Output contains resulting factorization Ktensor.
+   *  @param[in] tol        Stop tolerance for convergence of "fit function".
+   *  @param[in] maxIters   Maximum number of iterations allowed.
+   *  @param[in] maxSecs    Maximum execution time allowed (CP-ALS will finish
+   *                        the current iteration before exiting).
+   *                        If negative, execute without a time limit.
+   *  @param[in] printIter  Print progress every n iterations.
+   *                        If zero, print nothing.
+   *  @param[out] numIters  Number of iterations actually completed.
+   *  @param[out] resNorm   Square root of Frobenius norm of the residual.
+   *  @param[in] perfIter   Add performance information every n iterations.
+   *                        If zero, do not collect info.
+   *  @param[out] perfInfo  Performance information array.  Must allocate
+   *                        (maxIters / perfIter) + 2 elements of type
+   *                        CpAlsPerfInfo.
+   *                        Can be NULL if perfIter is zero.
+   *
+   *  @throws string        if internal linear solve detects singularity,
+   *                        or tensor arguments are incompatible.
+   */
+  template<typename TensorT, typename ExecSpace>
+  void cpals_core (const TensorT& x,
+                   Genten::KtensorT<ExecSpace>& u,
+                   const AlgParams& algParams,
+                   ttb_indx& numIters,
+                   ttb_real& resNorm,
+                   const ttb_indx perfIter,
+                   CpAlsPerfInfo perfInfo[],
+                   std::ostream& out)
+  {
+    // MTTKRP functor, which may set up an alternate tensor format
+    const Impl::CpAlsMttkrp<TensorT> x_mttkrp(x, algParams);
+    Impl::cpals_core(x, x_mttkrp, u, algParams, numIters, resNorm, perfIter,
+                     perfInfo, out);
+  }
+
+  template<typename TensorT, typename ExecSpace>
+  void cpals_multistart (const TensorT& x,
+                         Genten::KtensorT<ExecSpace>& u,
+                         const AlgParams& algParams,
+                         ttb_indx& numIters,
+                         ttb_real& resNorm,
+                         CpAlsPerfInfo startInfo[],
+                         std::ostream& out)
+  {
+#ifdef HAVE_CALIPER
+    cali::Function cali_func("Genten::cpals_multistart");
+#endif
+
+    using std::sqrt;
+
+    // Whether to use full or symmetric Gram matrix
+    const bool full = algParams.full_gram;
+    const UploType uplo = Upper;
+
+    const ttb_real tol = algParams.tol;
+    const ttb_indx maxIters = algParams.maxiters;
+    const ttb_real maxSecs = algParams.maxsecs;
+    const ttb_indx printIter = algParams.printitn;
+    const ttb_indx ns = algParams.num_starts;
+
+    // Check size compatibility of the arguments.
+    if (u.isConsistent() == false)
+      Genten::error("Genten::cpals_multistart - ktensor u is not consistent");
+    if (x.ndims() != u.ndims())
+      Genten::error("Genten::cpals_multistart - u and x have different num dims");
+    for (ttb_indx  i = 0; i < x.ndims(); i++)
+    {
+      if (x.size(i) != u[i].nRows())
+        Genten::error("Genten::cpals_multistart - u and x have different size");
+    }
+    if (ns == 0)
+      Genten::error("Genten::cpals_multistart - number of starts must be positive");
+
+    // Start timer for total execution time of the algorithm.
+    const int timer_cpals = 0;
+    const int timer_mttkrp = 1;
+    const int timer_solve = 2;
+    const int timer_pack = 3;
+    const int timer_arrange = 4;
+    Genten::SystemTimer timer(5, algParams.timings);
+
+    timer.start(timer_cpals);
+
+    const ttb_indx nc = u.ncomponents();     // number of components
+    const ttb_indx nd = x.ndims();           // number of dimensions
+
+    // MTTKRP functor shared by all starts
+    const Impl::CpAlsMttkrp<TensorT> x_mttkrp(x, algParams);
+
+    if (printIter > 0) {
+      out << "\nCP-ALS multi-start (" << ns << " starts of rank " << nc << ", "
+          << Genten::MTTKRP_Method::names[algParams.mttkrp_method]
+          << " MTTKRP method, ";
+      if (algParams.full_gram)
+        out << "full-gram";
+      else
+        out << "symmetric-gram";
+      out << " formulation):" << std::endl;
+    }
+
+    // State of each start.  The first start is u and the others are random
+    // guesses drawn like the driver's with seeds following algParams.seed.
+    std::vector< Genten::KtensorT<ExecSpace> > us(ns);
+    std::vector< Genten::ArrayT<ExecSpace> > lambdas(ns);
+    std::vector<bool> spd(ns, true);
+    std::vector<ttb_real> fits(ns, 0.0);
+    std::vector<ttb_real> fitolds(ns, 0.0);
+    std::vector<ttb_real> resNorms(ns, 0.0);
+    std::vector<ttb_indx> iters(ns, 0);
+    std::vector<ttb_real> times(ns, 0.0);
+    for (ttb_indx s = 0; s < ns; s++)
+    {
+      us[s] = Genten::KtensorT<ExecSpace>(nc, nd, x.size());
+      if (s == 0)
+        deep_copy(us[s], u);
+      else
+      {
+        Genten::KtensorT<DefaultHostExecutionSpace> u_host =
+          create_mirror_view(DefaultHostExecutionSpace(), us[s]);
+        Genten::RandomMT rng(algParams.seed + s);
+        u_host.setWeights(1.0);
+        u_host.setMatricesScatter(false, false, rng);
+        deep_copy(us[s], u_host);
+      }
+      us[s].distribute(0);
+      lambdas[s] = Genten::ArrayT<ExecSpace>(nc, (ttb_real) 1.0);
+    }
+
+    // The factor matrices of the active starts side by side, so one MTTKRP
+    // serves all of them, along with the Gramians of the packed factor
+    // matrices, whose diagonal blocks are the Gramians of the starts.  The
+    // solve, normalization and Gramian of all starts are then computed
+    // together on the packed matrices, and only the nc x nc systems are
+    // solved start by start.  Repacked when starts converge.
+    std::vector<ttb_indx> active(ns);
+    for (ttb_indx s = 0; s < ns; s++)
+      active[s] = s;
+    Genten::KtensorT<ExecSpace> w;        // packed factor matrices
+    Genten::KtensorT<ExecSpace> m;        // packed MTTKRP results
+    Genten::FacMatArrayT<ExecSpace> grams;
+    Genten::ArrayT<ExecSpace> lambda_w;
+    Genten::FacMatrixT<ExecSpace> upsilon;  // stacked upsilon of each start
+    Genten::FacMatrixT<ExecSpace> binv;     // stacked inverse of upsilon
+    Kokkos::View<ttb_real*,ExecSpace> xpip;
+    Genten::FacMatrix upsilon_h, binv_h, gram_h;
+    Genten::Array lambda_h;
+    typename Kokkos::View<ttb_real*,ExecSpace>::HostMirror xpip_h;
+    auto pack = [&]()
+    {
+      timer.start(timer_pack);
+      const ttb_indx na = active.size();
+      w = Genten::KtensorT<ExecSpace>(na*nc, nd, x.size());
+      w.setWeights(1.0);
+      m = Genten::KtensorT<ExecSpace>(na*nc, nd, x.size());
+      grams = Genten::FacMatArrayT<ExecSpace>(nd);
+      for (ttb_indx n = 0; n < nd; n++)
+      {
+        for (ttb_indx a = 0; a < na; a++)
+          Impl::cpals_copy_columns(w[n], a*nc, us[active[a]][n], 0, nc);
+        grams.set_factor( n, FacMatrixT<ExecSpace>(na*nc, na*nc) );
+        grams[n].gramian(w[n], full, uplo);
+      }
+      lambda_w = Genten::ArrayT<ExecSpace>(na*nc, (ttb_real) 1.0);
+      upsilon = Genten::FacMatrixT<ExecSpace>(na*nc, nc);
+      binv = Genten::FacMatrixT<ExecSpace>(na*nc, nc);
+      xpip = Kokkos::View<ttb_real*,ExecSpace>("xpip", na);
+      upsilon_h = create_mirror_view(DefaultHostExecutionSpace(), upsilon);
+      binv_h = create_mirror_view(DefaultHostExecutionSpace(), binv);
+      gram_h = create_mirror_view(DefaultHostExecutionSpace(), grams[nd-1]);
+      lambda_h = create_mirror_view(DefaultHostExecutionSpace(), lambda_w);
+      xpip_h = Kokkos::create_mirror_view(xpip);
+      x_mttkrp.reset();
+      Kokkos::fence();
+      timer.stop(timer_pack);
+    };
+    // Copy the packed factor matrices and weights back to the starts
+    auto unpack = [&]()
+    {
+      timer.start(timer_pack);
+      const ttb_indx na = active.size();
+      for (ttb_indx a = 0; a < na; a++)
+      {
+        const ttb_indx s = active[a];
+        for (ttb_indx n = 0; n < nd; n++)
+          Impl::cpals_copy_columns(us[s][n], 0, w[n], a*nc, nc);
+        Kokkos::deep_copy(lambdas[s].values(),
+                          Kokkos::subview(lambda_w.values(),
+                                          std::make_pair(a*nc, (a+1)*nc)));
+      }
+      Kokkos::fence();
+      timer.stop(timer_pack);
+    };
+    pack();
+
+    Genten::FacMatrix upsilon_s(nc,nc);
+    Genten::FacMatrix binv_s(nc,nc);
+
+    // Pre-calculate the Frobenius norm of the tensor x.
+    const ttb_real xNorm = x.norm();
+
+    //--------------------------------------------------
+    // Main algorithm loop.
+    //--------------------------------------------------
+    ttb_indx iter = 0;
+    for (iter = 0; iter < maxIters && !active.empty(); iter++)
+    {
+      const ttb_indx na = active.size();
+      for (ttb_indx n = 0; n < nd; n++)
+      {
+        // MTTKRP for all active starts in one pass over the tensor
+        timer.start(timer_mttkrp);
+        x_mttkrp (w, n, algParams);
+        Kokkos::fence();
+        timer.stop(timer_mttkrp);
+
+        // Solve, normalize and update the Gramian of each start as in
+        // cpals_core
+        timer.start(timer_solve);
+        deep_copy(m[n], w[n]);
+        Impl::cpals_block_upsilon(upsilon, grams, n, nc);
+        deep_copy(upsilon_h, upsilon);
+        for (ttb_indx a = 0; a < na; a++)
+        {
+          const ttb_indx s = active[a];
+          for (ttb_indx i = 0; i < nc; i++)
+            for (ttb_indx j = 0; j < nc; j++)
+              upsilon_s.entry(i,j) = upsilon_h.entry(a*nc+i,j);
+          if (algParams.penalty != ttb_real(0.0))
+            upsilon_s.diagonalShift(algParams.penalty);
+          binv_s = 0.0;
+          binv_s.diagonalShift(1.0);
+          spd[s] = binv_s.solveTransposeRHS (upsilon_s, full, uplo, spd[s],
+                                             algParams);
+          for (ttb_indx i = 0; i < nc; i++)
+            for (ttb_indx j = 0; j < nc; j++)
+              binv_h.entry(a*nc+i,j) = binv_s.entry(i,j);
+        }
+        deep_copy(binv, binv_h);
+        Impl::cpals_block_times(w[n], m[n], binv, nc);
+
+        if (iter == 0)
+          w[n].colNorms(NormTwo, lambda_w, 0.0);
+        else
+          w[n].colNorms(NormInf, lambda_w, 1.0);
+        w[n].colScale(lambda_w, true);
+        grams[n].gramian(w[n], full, uplo);
+
+        // Residual norm and fit of each start using <x,u> = <m,w[nd-1]>
+        if (n == nd-1)
+        {
+          Impl::cpals_block_innerprod(xpip, m[n], w[n], lambda_w, nc);
+          Kokkos::deep_copy(xpip_h, xpip);
+          deep_copy(gram_h, grams[n]);
+          deep_copy(lambda_h, lambda_w);
+          for (ttb_indx a = 0; a < na; a++)
+          {
+            const ttb_indx s = active[a];
+            const ttb_indx c = a*nc;
+            ttb_real pNorm2 = 0.0;
+            for (ttb_indx i = 0; i < nc; i++)
+            {
+              pNorm2 += upsilon_h.entry(c+i,i) * gram_h.entry(c+i,c+i) *
+                lambda_h[c+i] * lambda_h[c+i];
+              for (ttb_indx j = i+1; j < nc; j++)
+                pNorm2 += ttb_real(2.0) * upsilon_h.entry(c+i,j) *
+                  gram_h.entry(c+i,c+j) * lambda_h[c+i] * lambda_h[c+j];
+            }
+            const ttb_real pNorm = sqrt(fabs(pNorm2));
+            resNorms[s] = computeResNorm(xNorm, pNorm, xpip_h(a));
+            fitolds[s] = fits[s];
+            fits[s] = 1 - (resNorms[s] / xNorm);
+            iters[s] = iter + 1;
+          }
+        }
+        Kokkos::fence();
+        timer.stop(timer_solve);
+      }
+
+      // Retire the starts whose fit has converged
+      std::vector<ttb_indx> still_active;
+      for (ttb_indx a = 0; a < na; a++)
+      {
+        const ttb_indx s = active[a];
+        if ((iter > 0) && (fabs(fitolds[s] - fits[s]) < tol))
+          times[s] = timer.getTotalTime(timer_cpals);
+        else
+          still_active.push_back(s);
+      }
+
+      // Print progress of the current iteration.
+      if ((printIter > 0) && (((iter + 1) % printIter) == 0))
+      {
+        const ttb_real best = *std::max_element(fits.begin(), fits.end());
+        out << "Iter " << std::setw(3) << iter + 1 << ": best fit = "
+            << std::setw(13) << std::setprecision(6) << std::scientific << best
+            << " active starts = " << still_active.size() << std::endl;
+      }
+
+      if ((maxSecs >= 0.0) && (timer.getTotalTime(timer_cpals) > maxSecs))
+        break;
+
+      if (still_active.size() != na)
+      {
+        unpack();
+        active = still_active;
+        if (!active.empty())
+          pack();
+      }
+    }
+    unpack();
+    for (ttb_indx a = 0; a < active.size(); a++)
+      times[active[a]] = timer.getTotalTime(timer_cpals);
+
+    // Return the start with the best fit, normalized and incorporating the
+    // final lambda values.
+    ttb_indx best = 0;
+    for (ttb_indx s = 1; s < ns; s++)
+      if (fits[s] > fits[best])
+        best = s;
+    numIters = iters[best];
+    resNorm = resNorms[best];
+    deep_copy(u, us[best]);
+    Genten::ArrayT<ExecSpace> lambda = lambdas[best];
+    u.normalize(Genten::NormTwo);
+    lambda.times(u.weights());
+    u.setWeights(lambda);
+    timer.start(timer_arrange);
+    u.arrange();
+    Kokkos::fence();
+    timer.stop(timer_arrange);
+
+    timer.stop(timer_cpals);
+
+    if (startInfo != nullptr)
+    {
+      for (ttb_indx s = 0; s < ns; s++)
+      {
+        startInfo[s].nIter = (int) iters[s];
+        startInfo[s].dResNorm = resNorms[s];
+        startInfo[s].dFit = fits[s];
+        startInfo[s].dCumTime = times[s];
+        startInfo[s].dmttkrp_gflops = -1.0;
+      }
+    }
+
+    if (printIter > 0)
+    {
+      for (ttb_indx s = 0; s < ns; s++)
+        out << "Start " << std::setw(3) << s << ": fit = "
+            << std::setw(13) << std::setprecision(6) << std::scientific
+            << fits[s] << " after " << iters[s] << " iterations" << std::endl;
+      out << "Best start = " << best << ", final fit = "
+          << std::setw(13) << std::setprecision(6) << std::scientific
+          << fits[best] << std::endl;
+    }
+
+    if (printIter > 0 && algParams.timings)
+    {
+      out.setf(std::ios_base::scientific);
+      out.precision(2);
+      out << "CpAls multi-start completed " << iter << " iterations in "
+          << timer.getTotalTime(timer_cpals) << " seconds\n";
+      out << "\tMTTKRP total time = " << timer.getTotalTime(timer_mttkrp)
+          << " seconds, average time = " << timer.getAvgTime(timer_mttkrp)
+          << " seconds\n";
+      out << "\tSolve total time = " << timer.getTotalTime(timer_solve)
+          << " seconds, average time = " << timer.getAvgTime(timer_solve)
+          << " seconds\n";
+      out << "\tPack total time = " << timer.getTotalTime(timer_pack)
+          << " seconds, average time = " << timer.getAvgTime(timer_pack)
+          << " seconds\n";
+      out << "\tArrange total time = " << timer.getTotalTime(timer_arrange)
+          << " seconds, average time = " << timer.getAvgTime(timer_arrange)
+          << " seconds\n";
+    }
+  }
+
+  template<typename ExecSpace>
+  void cpals_rank_sweep (const SptensorT<ExecSpace>& x,
+                         Genten::KtensorT<ExecSpace>& u,
+                         const AlgParams& algParams,
+                         std::vector<CpAlsRankInfo>& rankInfo,
+                         std::ostream& out)
+  {
+#ifdef HAVE_CALIPER
+    cali::Function cali_func("Genten::cpals_rank_sweep");
+#endif
+
+    const ttb_indx nc_min = u.ncomponents();
+    const ttb_indx nc_max = algParams.rank_sweep_max;
+    const ttb_indx nc_step = algParams.rank_sweep_step;
+    const ttb_real tol = algParams.rank_sweep_tol;
+    const ttb_indx printIter = algParams.printitn;
+    const ttb_indx nd = x.ndims();
+
+    if (nc_max < nc_min)
+      Genten::error("Genten::cpals_rank_sweep - largest rank is smaller than the rank of u");
+    if (nc_step == 0)
+      Genten::error("Genten::cpals_rank_sweep - rank step must be positive");
+
+    // MTTKRP functor shared by all ranks
+    typedef SptensorT<ExecSpace> tensor_type;
+    const Impl::CpAlsMttkrp<tensor_type> x_mttkrp(x, algParams);
+
+    // Random components padding each warm start
+    Genten::RandomMT rng(algParams.seed + 1);
+
+    const ttb_real xNorm = x.norm();
+
+    Genten::SystemTimer timer(1, algParams.timings);
+    Genten::KtensorT<ExecSpace> u_best;
+    rankInfo.clear();
+    for (ttb_indx nc = nc_min; nc <= nc_max; nc += nc_step)
+    {
+      if (nc > nc_min)
+      {
+        Impl::cpals_pad_ktensor(u, nc, x.size(), rng);
+        x_mttkrp.reset();
+      }
+
+      ttb_indx numIters = 0;
+      ttb_real resNorm = 0.0;
+      timer.start(0);
+      Impl::cpals_core(x, x_mttkrp, u, algParams, numIters, resNorm, 0, NULL,
+                       out);
+      Kokkos::fence();
+      timer.stop(0);
+
+      CpAlsRankInfo info;
+      info.nRank = nc;
+      info.nIter = numIters;
+      info.dFit = 1.0 - resNorm / xNorm;
+      info.dTime = timer.getTotalTime(0);
+      info.dCoreConsistency =
+        algParams.rank_sweep_core_consistency ?
+        Impl::cpals_core_consistency(x, u, algParams) :
+        std::numeric_limits<ttb_real>::quiet_NaN();
+      rankInfo.push_back(info);
+      timer.reset(0);
+
+      // Keep the previous rank once the fit gain plateaus
+      const ttb_indx nr = rankInfo.size();
+      if ((nr > 1) && (rankInfo[nr-1].dFit - rankInfo[nr-2].dFit < tol))
+      {
+        u = u_best;
+        break;
+      }
+      u_best = Genten::KtensorT<ExecSpace>(nc, nd, x.size());
+      deep_copy(u_best, u);
+    }
+
+    if (printIter > 0)
+    {
+      out << "\nCP-ALS rank sweep:" << std::endl;
+      out << "  rank  iters            fit      time (s)   core consistency"
+          << std::endl;
+      for (ttb_indx r = 0; r < rankInfo.size(); r++)
+      {
+        out << std::setw(6) << rankInfo[r].nRank
+            << std::setw(7) << rankInfo[r].nIter
+            << std::setw(15) << std::setprecision(6) << std::scientific
+            << rankInfo[r].dFit
+            << std::setw(14) << std::setprecision(2) << rankInfo[r].dTime
+            << std::setw(19) << std::setprecision(2) << std::fixed
+            << rankInfo[r].dCoreConsistency << std::endl;
+      }
+      out.unsetf(std::ios_base::floatfield);
+      out << "Selected rank = " << u.ncomponents() << std::endl;
+    }
+  }
+
   //------------------------------------------------------
   // PRIVATE FUNCTIONS
   //------------------------------------------------------
@@ -520,6 +1534,31 @@ namespace Genten {
     ttb_real& resNorm,                                                  \
     const ttb_indx perfIter,                                            \
     CpAlsPerfInfo perfInfo[],                                           \
+    std::ostream& out);                                                 \
+                                                                        \
+  template void cpals_multistart<SptensorT<SPACE>,SPACE>(               \
+    const SptensorT<SPACE>& x,                                          \
+    KtensorT<SPACE>& u,                                                 \
+    const AlgParams& algParams,                                         \
+    ttb_indx& numIters,                                                 \
+    ttb_real& resNorm,                                                  \
+    CpAlsPerfInfo startInfo[],                                          \
+    std::ostream& out);                                                 \
+                                                                        \
+  template void cpals_multistart<TensorT<SPACE>,SPACE>(                 \
+    const TensorT<SPACE>& x,                                            \
+    KtensorT<SPACE>& u,                                                 \
+    const AlgParams& algParams,                                         \
+    ttb_indx& numIters,                                                 \
+    ttb_real& resNorm,                                                  \
+    CpAlsPerfInfo startInfo[],                                          \
+    std::ostream& out);                                                 \
+                                                                        \
+  template void cpals_rank_sweep<SPACE>(                                \
+    const SptensorT<SPACE>& x,                                          \
+    KtensorT<SPACE>& u,                                                 \
+    const AlgParams& algParams,                                         \
+    std::vector<CpAlsRankInfo>& rankInfo,                               \
     std::ostream& out);
 
 GENTEN_INST(INST_MACRO)
@@ -47,6 +47,7 @@
 #pragma once
 
 #include <ostream>
+#include <vector>
 
 #include "Genten_Sptensor.hpp"
 #include "Genten_Ktensor.hpp"
@@ -82,6 +83,25 @@ namespace Genten {
     ttb_real  dmttkrp_gflops;
   } CpAlsPerfInfo;
 
+  //! Contains CP-ALS results for one rank of a rank sweep.
+  /*!
+   * @param nRank     Number of components of the model.
+   * @param nIter     Number of CP-ALS iterations completed for this rank.
+   * @param dFit      Final fit of the model.
+   * @param dTime     Wall clock time in seconds of CP-ALS for this rank.
+   * @param dCoreConsistency  Core consistency diagnostic (CORCONDIA) of the
+   *                  model in percent, or NaN if the core is too large to
+   *                  compute or the diagnostic is turned off.
+   */
+  typedef struct
+  {
+    ttb_indx  nRank;
+    ttb_indx  nIter;
+    ttb_real  dFit;
+    ttb_real  dTime;
+    ttb_real  dCoreConsistency;
+  } CpAlsRankInfo;
+
 
   //! Compute the CP decomposition of a tensor based on a least squares objective.
   /*!
@@ -102,6 +122,21 @@ namespace Genten {
    *  then the factorization will fail; for example, an initial factor
    *  matrix cannot be all zeroes.
    *
+   *  When algParams.line_search is true, each iteration from
+   *  algParams.line_search_start on extrapolates the factor matrices along
+   *  the change made by the iteration, by a step of it^(1/p) times that
+   *  change for iteration it.  The extrapolated model is kept if it fits
+   *  better, which costs nd Gram matrices and one inner product with X.  The
+   *  exponent p starts at 2 and is increased by one after
+   *  algParams.line_search_fails consecutive rejected steps.
+   *
+   *  When algParams.method is cp-hals, the least squares solve for each
+   *  factor matrix is replaced by a hierarchical ALS (HALS) update, which
+   *  updates its columns one at a time from the previous factor matrix and
+   *  projects them onto the nonnegative orthant.  The MTTKRP, Gram matrices,
+   *  fit and stopping criteria are the same, and the result has nonnegative
+   *  factors.  The line search is not supported with HALS.
+   *
    *  @param[in] x          Data tensor to be fit by the model.
    *  @param[in,out] u      Input contains an initial guess for the factors.
    *                        The size of each mode must match the corresponding
@@ -149,4 +184,68 @@ namespace Genten {
     cpals_core(x,u,algParams,numIters,resNorm,perfIter,perfInfo,std::cout);
   }
 
+  //! Compute CP-ALS from several starting points at once and keep the best.
+  /*!
+   *  Runs algParams.num_starts instances of CP-ALS together.  The first
+   *  starts from u and the others from random guesses generated like the
+   *  driver's with seeds algParams.seed+1, algParams.seed+2, ...  The factor
+   *  matrices of the starts are stored side by side so that each MTTKRP
+   *  computes the products for all of them in one pass over x, followed by
+   *  the Gram matrix and solve of each start.  A start is retired once its
+   *  fit changes by less than algParams.tol, and the remaining ones are
+   *  repacked so later MTTKRPs only compute their columns.
+   *
+   *  @param[in] x          Data tensor to be fit by the model.
+   *  @param[in,out] u      Input contains the initial guess for the first
+   *                        start.  Output contains the factorization with
+   *                        the best fit.
+   *  @param[in] algParams  Algorithm parameters.
+   *  @param[out] numIters  Number of iterations completed by the best start.
+   *  @param[out] resNorm   Residual norm of the best start.
+   *  @param[out] startInfo Final iteration count, residual norm, fit and time
+   *                        of each start.  Must allocate algParams.num_starts
+   *                        elements, or may be NULL.
+   *  @param[in] out        Stream for progress and timing output.
+   *
+   *  @throws string        if internal linear solve detects singularity,
+   *                        or tensor arguments are incompatible.
+   */
+  template<typename TensorT, typename ExecSpace>
+  void cpals_multistart (const TensorT& x,
+                         KtensorT<ExecSpace>& u,
+                         const AlgParams& algParams,
+                         ttb_indx& numIters,
+                         ttb_real& resNorm,
+                         CpAlsPerfInfo startInfo[],
+                         std::ostream& out);
+
+  //! Compute CP-ALS for increasing ranks to select the rank of the model.
+  /*!
+   *  Runs CP-ALS for ranks u.ncomponents(), u.ncomponents() +
+   *  algParams.rank_sweep_step, ... up to algParams.rank_sweep_max.  Each
+   *  rank starts from the solution of the previous rank padded with random
+   *  components drawn with seed algParams.seed+1, and all ranks share the
+   *  alternate tensor format set up for the MTTKRP.  The sweep stops once
+   *  the fit improves by less than algParams.rank_sweep_tol over the
+   *  previous rank, which is then the selected rank.
+   *
+   *  @param[in] x          Data tensor to be fit by the model.
+   *  @param[in,out] u      Input contains the initial guess for the first
+   *                        rank.  Output contains the factorization of the
+   *                        selected rank.
+   *  @param[in] algParams  Algorithm parameters.
+   *  @param[out] rankInfo  Iterations, fit, time and core consistency of
+   *                        each rank computed.
+   *  @param[in] out        Stream for progress and summary output.
+   *
+   *  @throws string        if internal linear solve detects singularity,
+   *                        or tensor arguments are incompatible.
+   */
+  template<typename ExecSpace>
+  void cpals_rank_sweep (const SptensorT<ExecSpace>& x,
+                         KtensorT<ExecSpace>& u,
+                         const AlgParams& algParams,
+                         std::vector<CpAlsRankInfo>& rankInfo,
+                         std::ostream& out);
+
 }
@@ -0,0 +1,648 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+/*!
+  @file Genten_CpArls.cpp
+  @brief Randomized CP-ALS with leverage-score sampling of the Khatri-Rao product.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
+#include "Genten_CpArls.hpp"
+#include "Genten_MixedFormatOps.hpp"
+#include "Genten_RandomPool.hpp"
+#include "Genten_SystemTimer.hpp"
+#include "Genten_Util.hpp"
+
+#ifdef KOKKOS_ENABLE_OPENMP
+#include "parallel_stable_sort.hpp"
+#endif
+
+#ifdef KOKKOS_ENABLE_CUDA
+#include <thrust/sort.h>
+#include <thrust/device_ptr.h>
+#endif
+
+#ifdef HAVE_CALIPER
+#include <caliper/cali.h>
+#endif
+
+namespace Genten {
+
+namespace Impl {
+
+// Sort the indices in [beg,end) using the comparison cmp
+template <typename ExecSpace, typename Compare>
+void arls_sort(ttb_indx* beg, ttb_indx* end, const Compare& cmp)
+{
+#if defined(KOKKOS_ENABLE_CUDA)
+  if (std::is_same<ExecSpace, Kokkos::Cuda>::value) {
+    thrust::stable_sort(thrust::device_ptr<ttb_indx>(beg),
+                        thrust::device_ptr<ttb_indx>(end),
+                        cmp);
+  }
+  else
+#endif
+
+#if defined(KOKKOS_ENABLE_OPENMP)
+    if (std::is_same<ExecSpace, Kokkos::OpenMP>::value) {
+      pss::parallel_stable_sort(beg, end, cmp);
+    }
+    else
+#endif
+      std::stable_sort(beg, end, cmp);
+}
+
+// Permutation of the nonzeros for each mode n that sorts their subscripts
+// lexicographically over the other modes and then mode n, so the nonzeros
+// of each mode-n fiber are a contiguous range of fperm(:,n)
+template <typename ExecSpace>
+Kokkos::View<ttb_indx**,Kokkos::LayoutLeft,ExecSpace>
+arls_fiber_perm(const SptensorT<ExecSpace>& x)
+{
+  typedef Kokkos::View<ttb_indx**,Kokkos::LayoutLeft,ExecSpace> perm_type;
+
+  const ttb_indx nnz = x.nnz();
+  const unsigned nd = x.ndims();
+  const auto subs = x.getSubscripts();
+  perm_type fperm(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                     "Genten::cparls_lev::fiber_perm"),
+                  nnz, nd);
+  for (unsigned n=0; n<nd; ++n) {
+    Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(0,nnz),
+                         KOKKOS_LAMBDA(const ttb_indx i)
+    {
+      fperm(i,n) = i;
+    }, "Genten::cparls_lev::fiber_perm_init_kernel");
+
+    auto cmp = KOKKOS_LAMBDA(const ttb_indx& a, const ttb_indx& b)
+    {
+      for (unsigned k=0; k<nd; ++k)
+        if (k != n && subs(a,k) != subs(b,k))
+          return subs(a,k) < subs(b,k);
+      return subs(a,n) < subs(b,n);
+    };
+    ttb_indx* p = fperm.data() + n*nnz;
+    arls_sort<ExecSpace>(p, p+nnz, cmp);
+  }
+  return fperm;
+}
+
+// Cumulative distribution of the leverage scores of the rows of A,
+// l(i) = A(i,:)*inv(G)*A(i,:)' where G = A'*A, stored in
+// cdf(beg:beg+A.nRows()-1)
+template <typename ExecSpace>
+void arls_leverage_cdf(const FacMatrixT<ExecSpace>& A,
+                       const FacMatrixT<ExecSpace>& G,
+                       const Kokkos::View<ttb_real*,ExecSpace>& cdf,
+                       const ttb_indx beg,
+                       const bool full, const UploType uplo,
+                       const AlgParams& algParams)
+{
+  const ttb_indx nrow = A.nRows();
+  const unsigned nc = A.nCols();
+
+  FacMatrixT<ExecSpace> Q(nrow, nc);
+  deep_copy(Q, A);
+  Q.solveTransposeRHS(G, full, uplo, true, algParams);
+
+  ttb_real total = 0.0;
+  Kokkos::parallel_scan("Genten::cparls_lev::leverage_kernel",
+                        Kokkos::RangePolicy<ExecSpace>(0,nrow),
+                        KOKKOS_LAMBDA(const ttb_indx i, ttb_real& sum,
+                                      const bool final)
+  {
+    ttb_real l = 0.0;
+    for (unsigned j=0; j<nc; ++j)
+      l += Q.entry(i,j)*A.entry(i,j);
+    if (l > ttb_real(0.0))
+      sum += l;
+    if (final)
+      cdf(beg+i) = sum;
+  }, total);
+  if (!(total > ttb_real(0.0)))
+    Genten::error("Genten::cparls_lev - factor matrix has no nonzero leverage scores");
+
+  // Normalize, making sure the last entry is exactly one
+  Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(0,nrow),
+                       KOKKOS_LAMBDA(const ttb_indx i)
+  {
+    cdf(beg+i) = i == nrow-1 ? ttb_real(1.0) : cdf(beg+i)/total;
+  }, "Genten::cparls_lev::leverage_normalize_kernel");
+}
+
+// Draw the row of each factor matrix except n for each sample from the
+// distributions in cdf, and the sample weight 1/(ns*p) for the product p of
+// their probabilities
+template <typename ExecSpace, typename SampView, typename RandomPool>
+void arls_sample(const unsigned n, const SampView& samp,
+                 const Kokkos::View<ttb_real*,ExecSpace>& wgt,
+                 const Kokkos::View<ttb_real*,ExecSpace>& cdf,
+                 const IndxArrayT<ExecSpace>& cdf_begin,
+                 RandomPool& rand_pool)
+{
+  typedef typename RandomPool::generator_type generator_type;
+
+  const ttb_indx ns = samp.extent(0);
+  const unsigned nd = samp.extent(1);
+  Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(0,ns),
+                       KOKKOS_LAMBDA(const ttb_indx s)
+  {
+    generator_type gen = rand_pool.get_state();
+    ttb_real p = 1.0;
+    for (unsigned k=0; k<nd; ++k) {
+      if (k == n) {
+        samp(s,k) = 0;
+        continue;
+      }
+
+      // First row whose cumulative probability exceeds r, which has
+      // nonzero probability since the last entry of cdf is one
+      const ttb_indx beg = cdf_begin[k];
+      const ttb_real r = gen.drand(0.0, 1.0);
+      ttb_indx lo = beg;
+      ttb_indx hi = cdf_begin[k+1]-1;
+      while (lo < hi) {
+        const ttb_indx mid = lo + (hi-lo)/2;
+        if (cdf(mid) > r)
+          hi = mid;
+        else
+          lo = mid+1;
+      }
+      samp(s,k) = lo-beg;
+      p *= cdf(lo) - (lo > beg ? cdf(lo-1) : ttb_real(0.0));
+    }
+    wgt(s) = ttb_real(1.0)/(ns*p);
+    rand_pool.free_state(gen);
+  }, "Genten::cparls_lev::sample_kernel");
+}
+
+// Order the samples so repeated ones are adjacent when dedup is true,
+// returning the number of distinct samples nu.  Distinct sample u is made
+// of samples sperm(ustart(u):ustart(u+1)-1).
+template <typename ExecSpace, typename SampView>
+ttb_indx arls_combine(const unsigned n, const SampView& samp,
+                      const Kokkos::View<ttb_indx*,ExecSpace>& sperm,
+                      const Kokkos::View<ttb_indx*,ExecSpace>& ustart,
+                      const bool dedup)
+{
+  const ttb_indx ns = samp.extent(0);
+  const unsigned nd = samp.extent(1);
+
+  Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(0,ns),
+                       KOKKOS_LAMBDA(const ttb_indx s)
+  {
+    sperm(s) = s;
+  }, "Genten::cparls_lev::combine_init_kernel");
+
+  auto cmp = KOKKOS_LAMBDA(const ttb_indx& a, const ttb_indx& b)
+  {
+    for (unsigned k=0; k<nd; ++k)
+      if (k != n && samp(a,k) != samp(b,k))
+        return samp(a,k) < samp(b,k);
+    return false;
+  };
+  if (dedup)
+    arls_sort<ExecSpace>(sperm.data(), sperm.data()+ns, cmp);
+
+  ttb_indx nu = 0;
+  Kokkos::parallel_scan("Genten::cparls_lev::combine_kernel",
+                        Kokkos::RangePolicy<ExecSpace>(0,ns),
+                        KOKKOS_LAMBDA(const ttb_indx s, ttb_indx& u,
+                                      const bool final)
+  {
+    const bool head =
+      !dedup || s == 0 || cmp(sperm(s-1),sperm(s)) || cmp(sperm(s),sperm(s-1));
+    if (head) {
+      if (final)
+        ustart(u) = s;
+      ++u;
+    }
+    if (final && s == ns-1)
+      ustart(u) = ns;
+  }, nu);
+  return nu;
+}
+
+}
+
+template<typename ExecSpace>
+void cparls_lev (const SptensorT<ExecSpace>& x,
+                 KtensorT<ExecSpace>& u,
+                 const AlgParams& algParams,
+                 ttb_indx& numIters,
+                 ttb_real& resNorm,
+                 std::ostream& out)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::cparls_lev");
+#endif
+
+  using std::sqrt;
+
+  typedef Kokkos::View<ttb_indx**,Kokkos::LayoutRight,ExecSpace> samp_type;
+  typedef Kokkos::View<ttb_indx*,ExecSpace> indx_view_type;
+  typedef Kokkos::View<ttb_real*,ExecSpace> real_view_type;
+
+  // Whether to use full or symmetric Gram matrix
+  const bool full = algParams.full_gram;
+  const UploType uplo = Upper;
+  bool spd = true; // Use SPD solver if possible
+
+  const ttb_real tol = algParams.tol;
+  const ttb_indx maxIters = algParams.maxiters;
+  const ttb_real maxSecs = algParams.maxsecs;
+  const ttb_indx printIter = algParams.printitn;
+  const ttb_indx ns = algParams.arls_num_samples;
+  const ttb_indx epochIters = algParams.arls_epoch_iters;
+  const bool dedup = algParams.arls_dedup;
+
+  // Check size compatibility of the arguments.
+  if (u.isConsistent() == false)
+    Genten::error("Genten::cparls_lev - ktensor u is not consistent");
+  if (x.ndims() != u.ndims())
+    Genten::error("Genten::cparls_lev - u and x have different num dims");
+  for (ttb_indx  i = 0; i < x.ndims(); i++)
+  {
+    if (x.size(i) != u[i].nRows())
+      Genten::error("Genten::cparls_lev - u and x have different size");
+  }
+  if (ns == 0 || epochIters == 0)
+    Genten::error("Genten::cparls_lev - number of samples and iterations per epoch must be positive");
+
+  // Start timer for total execution time of the algorithm.
+  const int timer_arls = 0;
+  const int timer_perm = 1;
+  const int timer_lev = 2;
+  const int timer_sample = 3;
+  const int timer_mttkrp = 4;
+  const int timer_solve = 5;
+  const int timer_fit = 6;
+  const int timer_arrange = 7;
+  Genten::SystemTimer timer(8, algParams.timings);
+
+  timer.start(timer_arls);
+
+  const ttb_indx nc = u.ncomponents();     // number of components
+  const ttb_indx nd = x.ndims();           // number of dimensions
+
+  if (printIter > 0) {
+    out << "\nCP-ARLS-LEV (rank " << nc << ", " << ns << " samples";
+    if (dedup)
+      out << " with repeats combined";
+    out << ", fit computed every " << epochIters << " iterations):"
+        << std::endl;
+  }
+
+  // Sort the nonzeros with each mode last for looking up sampled fibers.
+  // The permutations take as much memory as the subscripts for the whole
+  // solve, but sorting on demand would cost a sort per mode per iteration.
+  timer.start(timer_perm);
+  const auto fperm = Impl::arls_fiber_perm(x);
+  Kokkos::fence();
+  timer.stop(timer_perm);
+
+  RandomPoolT<ExecSpace> rand_pool =
+    create_random_pool<ExecSpace>(algParams.seed);
+
+  // Distribute the initial guess to have weights of one.
+  u.distribute(0);
+  Genten::ArrayT<ExecSpace> lambda(nc, (ttb_real) 1.0);
+
+  // Gramian matrices of the factor matrices, used for the leverage scores
+  // and the norm of the model
+  Genten::FacMatArrayT<ExecSpace> gamma(nd);
+  for (ttb_indx n = 0; n < nd; n ++)
+  {
+    gamma.set_factor( n, FacMatrixT<ExecSpace>(nc, nc) );
+    gamma[n].gramian(u[n], full, uplo);
+  }
+
+  // Cumulative leverage score distribution of each factor matrix, stored
+  // one mode after the other starting at cdf_begin[n]
+  IndxArray cdf_begin_host(nd+1);
+  cdf_begin_host[0] = 0;
+  for (ttb_indx n = 0; n < nd; ++n)
+    cdf_begin_host[n+1] = cdf_begin_host[n] + x.size(n);
+  IndxArrayT<ExecSpace> cdf_begin =
+    create_mirror_view(ExecSpace(), cdf_begin_host);
+  deep_copy(cdf_begin, cdf_begin_host);
+  real_view_type cdf("Genten::cparls_lev::cdf", cdf_begin_host[nd]);
+  timer.start(timer_lev);
+  for (ttb_indx n = 0; n < nd; ++n)
+    Impl::arls_leverage_cdf(u[n], gamma[n], cdf, cdf_begin_host[n],
+                            full, uplo, algParams);
+  Kokkos::fence();
+  timer.stop(timer_lev);
+
+  // Sampled rows and their weights
+  samp_type samp("Genten::cparls_lev::samples", ns, nd);
+  real_view_type wgt("Genten::cparls_lev::weights", ns);
+  indx_view_type sperm("Genten::cparls_lev::sample_perm", ns);
+  indx_view_type ustart("Genten::cparls_lev::sample_start", ns+1);
+  real_view_type sw("Genten::cparls_lev::sqrt_weights", ns);
+
+  Genten::FacMatrixT<ExecSpace> upsilon(nc,nc);
+  Genten::FacMatrixT<ExecSpace> tmpMat(nc,nc);
+
+  // Best factorization found so far
+  Genten::KtensorT<ExecSpace> u_best(nc, nd, x.size());
+  Genten::ArrayT<ExecSpace> lambda_best(nc);
+
+  // Compute the exact fit of the model lambda, u
+  const ttb_real xNorm = x.norm();
+  auto computeFit = [&]() -> ttb_real
+  {
+    timer.start(timer_fit);
+    upsilon = 1;
+    for (ttb_indx n = 0; n < nd; ++n)
+      upsilon.times(gamma[n]);
+    tmpMat.oprod(lambda);
+    upsilon.times(tmpMat);
+    const ttb_real pNorm = sqrt(fabs(upsilon.sum(uplo)));
+    const ttb_real xpip = innerprod(x, u, lambda);
+    const ttb_real d = xNorm*xNorm + pNorm*pNorm - 2.0*xpip;
+    resNorm = d > ttb_real(0.0) ? sqrt(d) : ttb_real(0.0);
+    Kokkos::fence();
+    timer.stop(timer_fit);
+    return 1.0 - resNorm/xNorm;
+  };
+
+  ttb_real fit = computeFit();
+  ttb_real fitold = fit;
+  ttb_real best_fit = fit;
+  ttb_real best_resNorm = resNorm;
+  ttb_indx best_iter = 0;
+  deep_copy(u_best, u);
+  deep_copy(lambda_best, lambda);
+  if (printIter > 0)
+    out << "Initial fit = " << std::setw(13) << std::setprecision(6)
+        << std::scientific << fit << std::endl;
+
+  //--------------------------------------------------
+  // Main algorithm loop.
+  //--------------------------------------------------
+  ttb_indx nsamp_total = 0;
+  ttb_indx nfiber_total = 0;
+  for (numIters = 0; numIters < maxIters; numIters++)
+  {
+    for (ttb_indx n = 0; n < nd; n++)
+    {
+      // Sample rows of the Khatri-Rao product of the other factor matrices
+      timer.start(timer_sample);
+      Impl::arls_sample<ExecSpace>(n, samp, wgt, cdf, cdf_begin, rand_pool);
+      const ttb_indx nu = Impl::arls_combine<ExecSpace>(n, samp, sperm,
+                                                        ustart, dedup);
+      Kokkos::fence();
+      timer.stop(timer_sample);
+      nsamp_total += nu;
+
+      // Form the sampled rows scaled by the square root of their weights,
+      // and the sampled MTTKRP with the nonzeros of the sampled fibers
+      timer.start(timer_mttkrp);
+      Genten::FacMatrixT<ExecSpace> Z(nu, nc);
+      const auto uu = u;
+      const auto vv = u[n];
+      const unsigned nn = n;
+      const unsigned ndim = nd;
+      const unsigned ncomp = nc;
+      Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(0,nu),
+                           KOKKOS_LAMBDA(const ttb_indx i)
+      {
+        ttb_real w = 0.0;
+        for (ttb_indx s=ustart(i); s<ustart(i+1); ++s)
+          w += wgt(sperm(s));
+        const ttb_real sq = sqrt(w);
+        const ttb_indx s0 = sperm(ustart(i));
+        sw(i) = sq;
+        for (unsigned j=0; j<ncomp; ++j) {
+          ttb_real z = sq;
+          for (unsigned k=0; k<ndim; ++k)
+            if (k != nn)
+              z *= uu[k].entry(samp(s0,k),j);
+          Z.entry(i,j) = z;
+        }
+      }, "Genten::cparls_lev::sampled_krp_kernel");
+
+      vv = ttb_real(0.0);
+      const auto subs = x.getSubscripts();
+      const auto vals = x.getValues();
+      const ttb_indx nnz = x.nnz();
+      ttb_indx nfiber = 0;
+      Kokkos::parallel_reduce("Genten::cparls_lev::sampled_mttkrp_kernel",
+                              Kokkos::RangePolicy<ExecSpace>(0,nu),
+                              KOKKOS_LAMBDA(const ttb_indx i, ttb_indx& nf)
+      {
+        // Compare the subscripts of nonzero fperm(p,n) to the sample in
+        // all modes but n
+        const ttb_indx s0 = sperm(ustart(i));
+        auto cmp = [&](const ttb_indx p) -> int
+        {
+          const ttb_indx e = fperm(p,nn);
+          for (unsigned k=0; k<ndim; ++k) {
+            if (k != nn && subs(e,k) != samp(s0,k))
+              return subs(e,k) < samp(s0,k) ? -1 : 1;
+          }
+          return 0;
+        };
+
+        // Binary search for the fiber [beg,end)
+        ttb_indx lo = 0;
+        ttb_indx hi = nnz;
+        while (lo < hi) {
+          const ttb_indx mid = lo + (hi-lo)/2;
+          if (cmp(mid) < 0)
+            lo = mid+1;
+          else
+            hi = mid;
+        }
+        const ttb_indx beg = lo;
+        hi = nnz;
+        while (lo < hi) {
+          const ttb_indx mid = lo + (hi-lo)/2;
+          if (cmp(mid) <= 0)
+            lo = mid+1;
+          else
+            hi = mid;
+        }
+        const ttb_indx end = lo;
+        if (end > beg)
+          ++nf;
+
+        for (ttb_indx p=beg; p<end; ++p) {
+          const ttb_indx e = fperm(p,nn);
+          const ttb_indx row = subs(e,nn);
+          const ttb_real xv = vals(e)*sw(i);
+          for (unsigned j=0; j<ncomp; ++j)
+            Kokkos::atomic_add(&vv.entry(row,j), xv*Z.entry(i,j));
+        }
+      }, nfiber);
+      Kokkos::fence();
+      timer.stop(timer_mttkrp);
+      nfiber_total += nfiber;
+
+      // Solve the sampled normal equations (Z'*Z) * X = u[n]' for X, and
+      // overwrite u[n] with the result.
+      timer.start(timer_solve);
+      upsilon.gramian(Z, full, uplo);
+      if (algParams.penalty != ttb_real(0.0))
+        upsilon.diagonalShift(algParams.penalty);
+      spd = u[n].solveTransposeRHS (upsilon, full, uplo, spd, algParams);
+      Kokkos::fence();
+      timer.stop(timer_solve);
+
+      // Compute lambda and scale u[n] by its inverse
+      if (numIters == 0)
+        u[n].colNorms(NormTwo, lambda, 0.0);
+      else
+        u[n].colNorms(NormInf, lambda, 1.0);
+      u[n].colScale(lambda, true);
+
+      // Update the Gramian matrix and leverage scores of u[n]
+      timer.start(timer_lev);
+      gamma[n].gramian(u[n], full, uplo);
+      Impl::arls_leverage_cdf(u[n], gamma[n], cdf, cdf_begin_host[n],
+                              full, uplo, algParams);
+      Kokkos::fence();
+      timer.stop(timer_lev);
+    }
+
+    // Check the exact fit at the end of each epoch
+    const bool time_out =
+      (maxSecs >= 0.0) && (timer.getTotalTime(timer_arls) > maxSecs);
+    if (((numIters + 1) % epochIters == 0) || (numIters + 1 == maxIters) ||
+        time_out)
+    {
+      fit = computeFit();
+      const ttb_real fitchange = fit - fitold;
+      fitold = fit;
+      if (fit > best_fit) {
+        best_fit = fit;
+        best_resNorm = resNorm;
+        best_iter = numIters + 1;
+        deep_copy(u_best, u);
+        deep_copy(lambda_best, lambda);
+      }
+
+      if (printIter > 0)
+      {
+        out << "Iter " << std::setw(3) << numIters + 1 << ": fit = "
+            << std::setw(13) << std::setprecision(6) << std::scientific << fit
+            << " fitdelta = "
+            << std::setw(8) << std::setprecision(1) << std::scientific
+            << fitchange << std::endl;
+      }
+
+      // Stop when an epoch no longer improves the fit by tol
+      if (fitchange < tol || time_out)
+        break;
+    }
+  }
+
+  // Increment so the count starts from one.
+  if (numIters < maxIters)
+    numIters++;
+
+  // Return the best factorization, normalized and incorporating the final
+  // lambda values.
+  deep_copy(u, u_best);
+  deep_copy(lambda, lambda_best);
+  resNorm = best_resNorm;
+  if (printIter > 0)
+    out << "Final fit = " << std::setw(13) << std::setprecision(6)
+        << std::scientific << best_fit << " (iteration " << best_iter << ")"
+        << std::endl;
+  u.normalize(Genten::NormTwo);
+  lambda.times(u.weights());
+  u.setWeights(lambda);
+  timer.start(timer_arrange);
+  u.arrange();
+  Kokkos::fence();
+  timer.stop(timer_arrange);
+
+  timer.stop(timer_arls);
+
+  if (printIter > 0 && algParams.timings)
+  {
+    const ttb_indx nsolve = std::max(numIters*nd, ttb_indx(1));
+    out.setf(std::ios_base::scientific);
+    out.precision(2);
+    out << "CP-ARLS-LEV completed " << numIters << " iterations in "
+        << timer.getTotalTime(timer_arls) << " seconds\n";
+    out << "\tAverage distinct samples = " << ttb_real(nsamp_total)/nsolve
+        << ", nonempty fibers = " << ttb_real(nfiber_total)/nsolve << "\n";
+    out << "\tFiber sort time = " << timer.getTotalTime(timer_perm)
+        << " seconds\n";
+    out << "\tLeverage score total time = " << timer.getTotalTime(timer_lev)
+        << " seconds, average time = " << timer.getAvgTime(timer_lev)
+        << " seconds\n";
+    out << "\tSampling total time = " << timer.getTotalTime(timer_sample)
+        << " seconds, average time = " << timer.getAvgTime(timer_sample)
+        << " seconds\n";
+    out << "\tSampled MTTKRP total time = " << timer.getTotalTime(timer_mttkrp)
+        << " seconds, average time = " << timer.getAvgTime(timer_mttkrp)
+        << " seconds\n";
+    out << "\tSolve total time = " << timer.getTotalTime(timer_solve)
+        << " seconds, average time = " << timer.getAvgTime(timer_solve)
+        << " seconds\n";
+    out << "\tFit total time = " << timer.getTotalTime(timer_fit)
+        << " seconds, average time = " << timer.getAvgTime(timer_fit)
+        << " seconds\n";
+    out << "\tArrange total time = " << timer.getTotalTime(timer_arrange)
+        << " seconds, average time = " << timer.getAvgTime(timer_arrange)
+        << " seconds\n";
+  }
+}
+
+}
+
+#define INST_MACRO(SPACE)                                               \
+  template void cparls_lev<SPACE>(                                      \
+    const SptensorT<SPACE>& x,                                          \
+    KtensorT<SPACE>& u,                                                 \
+    const AlgParams& algParams,                                         \
+    ttb_indx& numIters,                                                 \
+    ttb_real& resNorm,                                                  \
+    std::ostream& out);
+
+GENTEN_INST(INST_MACRO)
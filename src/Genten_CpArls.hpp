@@ -0,0 +1,95 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+/*!
+  @file Genten_CpArls.hpp
+  @brief Randomized CP-ALS with leverage-score sampling of the Khatri-Rao product.
+*/
+
+#pragma once
+
+#include <ostream>
+
+#include "Genten_Sptensor.hpp"
+#include "Genten_Ktensor.hpp"
+#include "Genten_AlgParams.hpp"
+
+namespace Genten {
+
+  //! Compute the CP decomposition of a sparse tensor using randomized ALS.
+  /*!
+   *  The least-squares subproblem of CP-ALS for mode n has the Khatri-Rao
+   *  product of the other factor matrices as its coefficient matrix.
+   *  CP-ARLS-LEV samples algParams.arls_num_samples of its rows, picking
+   *  the row of each of the other factor matrices independently with
+   *  probability proportional to its leverage score, which bounds the
+   *  leverage scores of the Khatri-Rao product.  The weighted sampled system
+   *  is then solved through its normal equations with
+   *  FacMatrixT::solveTransposeRHS().  Repeated samples are combined when
+   *  algParams.arls_dedup is true, and the nonzeros of the sampled fibers
+   *  are found by binary search in an ordering of the nonzeros sorted with
+   *  mode n last.  Each iteration therefore costs time proportional to the
+   *  number of samples and the nonzeros they hit rather than to nnz(x).
+   *
+   *  Since the sampled fit is not reliable, the exact fit is computed every
+   *  algParams.arls_epoch_iters iterations, and the algorithm stops when it
+   *  improves by less than algParams.tol.  The factorization with the best
+   *  fit is returned.
+   *
+   *  @param[in] x          Data tensor to be fit by the model.
+   *  @param[in,out] u      Input contains an initial guess for the factors.
+   *                        Output contains resulting factorization Ktensor.
+   *  @param[in] algParams  Algorithm parameters.
+   *  @param[out] numIters  Number of iterations actually completed.
+   *  @param[out] resNorm   Square root of Frobenius norm of the residual.
+   *  @param[in] out        Stream for progress and timing output.
+   *
+   *  @throws string        if internal linear solve detects singularity,
+   *                        or tensor arguments are incompatible.
+   */
+  template<typename ExecSpace>
+  void cparls_lev (const SptensorT<ExecSpace>& x,
+                   KtensorT<ExecSpace>& u,
+                   const AlgParams& algParams,
+                   ttb_indx& numIters,
+                   ttb_real& resNorm,
+                   std::ostream& out);
+
+}
@@ -45,8 +45,12 @@
 */
 
 #include "Genten_CpAls.hpp"
+#include "Genten_CpArls.hpp"
 #include "Genten_SystemTimer.hpp"
 #include "Genten_MixedFormatOps.hpp"
+#include "Genten_MTTKRP_Tune.hpp"
+#include "Genten_NUMA.hpp"
+#include "Genten_SptensorCompact.hpp"
 #include "Genten_IOtext.hpp"
 
 #ifdef HAVE_GCP
@@ -80,6 +84,53 @@ driver(SptensorT<ExecSpace>& x,
   out.setf(std::ios_base::scientific);
   out.precision(2);
 
+  // Decompose a copy of x with the empty slices of each mode dropped, and
+  // expand the initial guess and solution back to the size of x
+  if (algParams.compact) {
+    Sptensor_host_type x_host(x.size_host(), x.nnz());
+    deep_copy(x_host.getValues(), x.getValues());
+    deep_copy(x_host.getSubscripts(), x.getSubscripts());
+    timer.start(2);
+    const SptensorIndexMap map = compact_sptensor(x_host);
+    timer.stop(2);
+    if (algParams.timings)
+      out << "Compacting the tensor took " << timer.getTotalTime(2)
+          << " seconds\n";
+    Sptensor_type x_c = create_mirror_view( ExecSpace(), x_host );
+    deep_copy( x_c, x_host );
+
+    Ktensor_type u_init_c;
+    const bool have_init = u_init.ndims() > 0;
+    if (have_init) {
+      Ktensor_host_type u_init_host =
+        create_mirror_view( Genten::DefaultHostExecutionSpace(), u_init );
+      deep_copy( u_init_host, u_init );
+      const Ktensor_host_type u_init_c_host =
+        compact_ktensor(u_init_host, map);
+      u_init_c = create_mirror_view( ExecSpace(), u_init_c_host );
+      deep_copy( u_init_c, u_init_c_host );
+    }
+
+    AlgParams ap = algParams;
+    ap.compact = false;
+    const Ktensor_type u_c = driver(x_c, u_init_c, ap, out);
+    algParams = ap;
+    algParams.compact = true;
+
+    auto expand = [&](const Ktensor_type& v_c) {
+      Ktensor_host_type v_c_host =
+        create_mirror_view( Genten::DefaultHostExecutionSpace(), v_c );
+      deep_copy( v_c_host, v_c );
+      const Ktensor_host_type v_host = expand_ktensor(v_c_host, map);
+      Ktensor_type v = create_mirror_view( ExecSpace(), v_host );
+      deep_copy( v, v_host );
+      return v;
+    };
+    if (!have_init)
+      u_init = expand(u_init_c);
+    return expand(u_c);
+  }
+
   Ktensor_type u(algParams.rank, x.ndims(), x.size());
   Ktensor_host_type u_host =
     create_mirror_view( Genten::DefaultHostExecutionSpace(), u );
@@ -118,6 +169,18 @@ driver(SptensorT<ExecSpace>& x,
   // Fixup algorithmic choices
   algParams.fixup<ExecSpace>(out);
 
+  // Benchmark the MTTKRP methods if requested
+  tune_mttkrp(x, algParams.rank, algParams, out);
+
+  // Place the tensor and factor matrices for the chosen nonzero tiling
+  if (algParams.numa_first_touch || algParams.numa_replicate) {
+    if (algParams.numa_first_touch) {
+      numa_first_touch(x, algParams);
+      numa_first_touch(u);
+    }
+    print_numa_placement(algParams, out);
+  }
+
   if (algParams.warmup)
   {
     // Do a pass through the mttkrp to warm up and make sure the tensor
@@ -134,22 +197,57 @@ driver(SptensorT<ExecSpace>& x,
   // Perform any post-processing (e.g., permutation and row ptr generation)
   if (algParams.mttkrp_method == Genten::MTTKRP_Method::Perm &&
       (algParams.method == Genten::Solver_Method::CP_ALS ||
+       algParams.method == Genten::Solver_Method::CP_HALS ||
        algParams.mttkrp_all_method == Genten::MTTKRP_All_Method::Iterated) &&
       !x.havePerm()) {
     timer.start(1);
-    x.createPermutation();
+    x.createPermutation(algParams.mttkrp_perm_row_ptrs);
     timer.stop(1);
     if (algParams.timings)
       out << "Creating permutation arrays for perm MTTKRP method took " << timer.getTotalTime(1)
           << " seconds\n";
   }
 
-  if (algParams.method == Genten::Solver_Method::CP_ALS) {
+  if ((algParams.method == Genten::Solver_Method::CP_ALS ||
+       algParams.method == Genten::Solver_Method::CP_HALS) &&
+      algParams.rank_sweep_max > 0) {
+    // Run CP-ALS for a range of ranks, keeping the selected one
+    std::vector<CpAlsRankInfo> rankInfo;
+    cpals_rank_sweep(x, u, algParams, rankInfo, out);
+    if (algParams.debug) {
+      u_host = create_mirror_view( Genten::DefaultHostExecutionSpace(), u );
+      deep_copy( u_host, u );
+    }
+  }
+  else if (algParams.method == Genten::Solver_Method::CP_ALS &&
+           algParams.num_starts > 1) {
+    // Run CP-ALS from several starts
+    ttb_indx iter;
+    ttb_real resNorm;
+    cpals_multistart(x, u, algParams, iter, resNorm, NULL, out);
+  }
+  else if (algParams.method == Genten::Solver_Method::CP_HALS &&
+           algParams.num_starts > 1) {
+    Genten::error("Genten::driver - multiple starts are only supported by cp-als");
+  }
+  else if (algParams.method == Genten::Solver_Method::CP_ALS) {
     // Run CP-ALS
     ttb_indx iter;
     ttb_real resNorm;
     cpals_core(x, u, algParams, iter, resNorm, 0, NULL, out);
   }
+  else if (algParams.method == Genten::Solver_Method::CP_HALS) {
+    // Run nonnegative CP-HALS
+    ttb_indx iter;
+    ttb_real resNorm;
+    cpals_core(x, u, algParams, iter, resNorm, 0, NULL, out);
+  }
+  else if (algParams.method == Genten::Solver_Method::CP_ARLS_LEV) {
+    // Run CP-ARLS-LEV
+    ttb_indx iter;
+    ttb_real resNorm;
+    cparls_lev(x, u, algParams, iter, resNorm, out);
+  }
 #ifdef HAVE_GCP
   else if (algParams.method == Genten::Solver_Method::GCP_SGD &&
            !algParams.fuse_sa) {
@@ -247,6 +345,13 @@ driver(TensorT<ExecSpace>& x,
 
   if (algParams.debug) Genten::print_ktensor(u_host, out, "Initial guess");
 
+  // Dense tensors use the GEMM-based MTTKRP by default on the host, which
+  // is also what auto tuning would pick
+  if ((algParams.mttkrp_method == Genten::MTTKRP_Method::Default ||
+       algParams.mttkrp_method == Genten::MTTKRP_Method::Auto) &&
+      !Genten::is_cuda_space<ExecSpace>::value)
+    algParams.mttkrp_method = Genten::MTTKRP_Method::GEMM;
+
   // Fixup algorithmic choices
   algParams.fixup<ExecSpace>(out);
 
@@ -263,12 +368,29 @@ driver(TensorT<ExecSpace>& x,
       Genten::mttkrp(x, u, n, tmp[n], ap);
   }
 
-  if (algParams.method == Genten::Solver_Method::CP_ALS) {
+  if (algParams.method == Genten::Solver_Method::CP_ALS &&
+      algParams.num_starts > 1) {
+    // Run CP-ALS from several starts
+    ttb_indx iter;
+    ttb_real resNorm;
+    cpals_multistart(x, u, algParams, iter, resNorm, NULL, out);
+  }
+  else if (algParams.method == Genten::Solver_Method::CP_HALS &&
+           algParams.num_starts > 1) {
+    Genten::error("Genten::driver - multiple starts are only supported by cp-als");
+  }
+  else if (algParams.method == Genten::Solver_Method::CP_ALS) {
     // Run CP-ALS
     ttb_indx iter;
     ttb_real resNorm;
     cpals_core(x, u, algParams, iter, resNorm, 0, NULL, out);
   }
+  else if (algParams.method == Genten::Solver_Method::CP_HALS) {
+    // Run nonnegative CP-HALS
+    ttb_indx iter;
+    ttb_real resNorm;
+    cpals_core(x, u, algParams, iter, resNorm, 0, NULL, out);
+  }
   else {
     Genten::error(std::string("Unknown decomposition method:  ") +
                   Genten::Solver_Method::names[algParams.method]);
@@ -144,14 +144,26 @@ namespace Genten {
 
         MTTKRP_Method::type method = algParams.mttkrp_method;
 
-        // Compute default MTTKRP method
+        // The default MTTKRP method is normally resolved by
+        // AlgParams::fixup(), so just use Atomic if it was not called
         if (method == MTTKRP_Method::Default)
-          method = MTTKRP_Method::computeDefault<exec_space>();
+          method = MTTKRP_Method::Atomic;
 
         // Check if Perm is selected, that perm is computed
         if (method == MTTKRP_Method::Perm && !X.havePerm())
           Genten::error("Perm MTTKRP method selected, but permutation array not computed!");
 
+        // The gradient tensor changes every iteration, so there is no CSF,
+        // HiCOO, ALTO, hybrid or dimension tree structure to reuse.  Use
+        // Atomic instead, also for the dense-only GEMM method, an untuned
+        // auto method and the prefetch method, which only applies to the
+        // coordinate-format MTTKRP.
+        if (method == MTTKRP_Method::CSF || method == MTTKRP_Method::HiCOO ||
+            method == MTTKRP_Method::ALTO || method == MTTKRP_Method::Hybrid ||
+            method == MTTKRP_Method::DimTree || method == MTTKRP_Method::GEMM ||
+            method == MTTKRP_Method::Auto || method == MTTKRP_Method::Prefetch)
+          method = MTTKRP_Method::Atomic;
+
         // Never use Duplicated or Atomic for Serial, use Single instead
         if (space_prop::is_serial && (method == MTTKRP_Method::Duplicated ||
                                       method == MTTKRP_Method::Atomic))
@@ -425,14 +437,26 @@ namespace Genten {
 
         MTTKRP_Method::type method = algParams.mttkrp_method;
 
-        // Compute default MTTKRP method
+        // The default MTTKRP method is normally resolved by
+        // AlgParams::fixup(), so just use Atomic if it was not called
         if (method == MTTKRP_Method::Default)
-          method = MTTKRP_Method::computeDefault<exec_space>();
+          method = MTTKRP_Method::Atomic;
 
         // Check if Perm is selected, that perm is computed
         if (method == MTTKRP_Method::Perm && !X.havePerm())
           Genten::error("Perm MTTKRP method selected, but permutation array not computed!");
 
+        // The gradient tensor changes every iteration, so there is no CSF,
+        // HiCOO, ALTO, hybrid or dimension tree structure to reuse.  Use
+        // Atomic instead, also for the dense-only GEMM method, an untuned
+        // auto method and the prefetch method, which only applies to the
+        // coordinate-format MTTKRP.
+        if (method == MTTKRP_Method::CSF || method == MTTKRP_Method::HiCOO ||
+            method == MTTKRP_Method::ALTO || method == MTTKRP_Method::Hybrid ||
+            method == MTTKRP_Method::DimTree || method == MTTKRP_Method::GEMM ||
+            method == MTTKRP_Method::Auto || method == MTTKRP_Method::Prefetch)
+          method = MTTKRP_Method::Atomic;
+
         // Never use Duplicated or Atomic for Serial, use Single instead
         if (space_prop::is_serial && (method == MTTKRP_Method::Duplicated ||
                           method == MTTKRP_Method::Atomic))
@@ -110,7 +110,7 @@ namespace Genten {
             timer.start(timer_sample_g_perm);
             if (algParams.mttkrp_method == MTTKRP_Method::Perm &&
                 algParams.mttkrp_all_method == MTTKRP_All_Method::Iterated)
-              X_grad.createPermutation();
+              X_grad.createPermutation(algParams.mttkrp_perm_row_ptrs);
             timer.stop(timer_sample_g_perm);
             timer.stop(timer_sample_g);
           }
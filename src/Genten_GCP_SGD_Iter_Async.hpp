@@ -42,6 +42,7 @@
 
 #include <cmath>
 #include "Genten_GCP_SGD_Iter.hpp"
+#include "Genten_SimdKernel.hpp"
 
 // To do:
 //  * Test on Volta.  Do we need warp sync's?
@@ -50,7 +51,138 @@ namespace Genten {
 
   namespace Impl {
 
-    template <typename ExecSpace, typename LossFunction, typename Stepper>
+    // Asynchronous GCP-SGD kernel for a compile-time tensor order ND > 0.
+    // Each thread keeps the sampled subscripts, and each vector lane the
+    // factor matrix entries of its column, in fixed-size local arrays
+    // rather than staging them in team scratch.
+    template <unsigned ND, typename ExecSpace, typename LossFunction,
+              typename Stepper>
+    void gcp_sgd_iter_async_kernel_local(
+      const SptensorT<ExecSpace>& X,
+      const KtensorT<ExecSpace>& u,
+      const LossFunction& f,
+      const ttb_indx nsz,
+      const ttb_indx nsnz,
+      const ttb_real wz,
+      const ttb_real wnz,
+      Kokkos::Random_XorShift64_Pool<ExecSpace>& rand_pool,
+      const Stepper& stepper,
+      const AlgParams& algParams)
+    {
+      using std::floor;
+      using std::pow;
+      using std::log2;
+      using std::min;
+
+      typedef Kokkos::TeamPolicy<ExecSpace> Policy;
+      typedef typename Policy::member_type TeamMember;
+      typedef Kokkos::Random_XorShift64_Pool<ExecSpace> RandomPool;
+      typedef typename RandomPool::generator_type generator_type;
+      typedef Kokkos::rand<generator_type, ttb_indx> Rand;
+
+      // Only instantiated with ND = 0 for the run-time order fallback,
+      // where it is never called
+      static const unsigned NL = ND > 0 ? ND : 1;
+
+      /*const*/ ttb_indx num_samples = (nsz+nsnz)*algParams.epoch_iters;
+      /*const*/ ttb_indx nnz = X.nnz();
+      /*const*/ unsigned nc = u.ncomponents();
+
+      static const bool is_cuda = Genten::is_cuda_space<ExecSpace>::value;
+      const unsigned RowBlockSize = algParams.mttkrp_nnz_tile_size;
+      const unsigned VectorSize =
+        is_cuda ? min(unsigned(128), unsigned(pow(2.0, floor(log2(nc))))) : 1;
+      const unsigned TeamSize = is_cuda ? 128/VectorSize : 1;
+      const unsigned RowsPerTeam = TeamSize * RowBlockSize;
+      const ttb_indx N = (num_samples+RowsPerTeam-1)/RowsPerTeam;
+
+      Policy policy(N, TeamSize, VectorSize);
+      Kokkos::parallel_for(policy, KOKKOS_LAMBDA(const TeamMember& team)
+      {
+        generator_type gen = rand_pool.get_state();
+        ttb_indx ind[NL];
+
+        for (unsigned ii=0; ii<RowBlockSize; ++ii) {
+
+          // Randomly choose if this is a zero or nonzero sample based
+          // on the fraction of requested zero/nonzero samples
+          ttb_indx idx = 0;
+          Kokkos::single( Kokkos::PerThread( team ), [&] (ttb_indx& i)
+          {
+            i = Rand::draw(gen,0,nsz+nsnz);
+          }, idx);
+          const bool nonzero_sample = idx < nsnz;
+
+          // Generate random tensor index, broadcasting each draw to all
+          // vector lanes
+          ttb_real x_val = 0.0;
+          if (nonzero_sample) {
+            ttb_indx i = 0;
+            Kokkos::single( Kokkos::PerThread( team ), [&] (ttb_indx& k)
+            {
+              k = Rand::draw(gen,0,nnz);
+            }, i);
+            for (unsigned m=0; m<ND; ++m)
+              ind[m] = X.subscript(i,m);
+            x_val = X.value(i);
+          }
+          else {
+            for (unsigned m=0; m<ND; ++m)
+              Kokkos::single( Kokkos::PerThread( team ), [&] (ttb_indx& k)
+              {
+                k = Rand::draw(gen,0,X.size(m));
+              }, ind[m]);
+          }
+
+          // Compute Ktensor value
+          ttb_real m_val = 0.0;
+          Kokkos::parallel_reduce(Kokkos::ThreadVectorRange(team,nc),
+                                  [&] (const unsigned& j, ttb_real& mv)
+          {
+            ttb_real tmp = 1.0;
+            for (unsigned m=0; m<ND; ++m)
+              tmp *= u[m].entry(ind[m],j);
+            mv += tmp;
+          }, m_val);
+
+          // Compute Y value
+          ttb_real y_val;
+          if (nonzero_sample)
+            y_val = wnz * (f.deriv(x_val, m_val) -
+                           f.deriv(ttb_real(0.0), m_val));
+          else
+             y_val = wz * f.deriv(ttb_real(0.0), m_val);
+
+          // Compute gradient contribution.  Each lane reads the entries of
+          // its column in all modes before updating any of them.
+          Kokkos::parallel_for(Kokkos::ThreadVectorRange(team,nc),
+                               [&] (const unsigned& j)
+          {
+            ttb_real ktn[NL];
+            for (unsigned m=0; m<ND; ++m)
+              ktn[m] = u[m].entry(ind[m],j);
+            for (unsigned n=0; n<ND; ++n) {
+              ttb_real tmp = y_val;
+              for (unsigned m=0; m<ND; ++m)
+                if (m != n)
+                  tmp *= ktn[m];
+              stepper.eval_async(n,ind[n],j,tmp,u);
+            }
+          });
+        }
+        stepper.update_async(RowBlockSize, team);
+        rand_pool.free_state(gen);
+      }, "gcp_sgd_iter_asyn_kernel");
+
+      // Fence to make sure kernel is finished before updates to stepper
+      Kokkos::fence();
+    }
+
+    // Tensor order is ND if ND > 0 and u.ndims() otherwise.  Subscripts and
+    // factor matrix rows are staged in team scratch when the order is only
+    // known at run-time.
+    template <unsigned ND, typename ExecSpace, typename LossFunction,
+              typename Stepper>
     void gcp_sgd_iter_async_kernel(
       const SptensorT<ExecSpace>& X,
       const KtensorT<ExecSpace>& u,
@@ -64,6 +196,12 @@ namespace Genten {
       const AlgParams& algParams,
       const ttb_indx total_iters)
     {
+      if (ND > 0) {
+        gcp_sgd_iter_async_kernel_local<ND>(
+          X,u,f,nsz,nsnz,wz,wnz,rand_pool,stepper,algParams);
+        return;
+      }
+
       using std::floor;
       using std::pow;
       using std::log2;
@@ -79,7 +217,7 @@ namespace Genten {
 
       /*const*/ ttb_indx num_samples = (nsz+nsnz)*algParams.epoch_iters;
       /*const*/ ttb_indx nnz = X.nnz();
-      /*const*/ unsigned nd = u.ndims();
+      const Kokkos::Impl::integral_nonzero_constant<unsigned,ND> nd(u.ndims());
       /*const*/ unsigned nc = u.ncomponents();
 
       static const bool is_cuda = Genten::is_cuda_space<ExecSpace>::value;
@@ -90,8 +228,8 @@ namespace Genten {
       const unsigned RowsPerTeam = TeamSize * RowBlockSize;
       const ttb_indx N = (num_samples+RowsPerTeam-1)/RowsPerTeam;
       const size_t bytes =
-        IndScratchSpace::shmem_size(TeamSize,nd) +
-        KtnScratchSpace::shmem_size(TeamSize,nd,nc);
+        IndScratchSpace::shmem_size(TeamSize,nd.value) +
+        KtnScratchSpace::shmem_size(TeamSize,nd.value,nc);
 
       Policy policy(N, TeamSize, VectorSize);
       Kokkos::parallel_for(
@@ -101,8 +239,8 @@ namespace Genten {
         generator_type gen = rand_pool.get_state();
         const unsigned team_rank = team.team_rank();
         const unsigned team_size = team.team_size();
-        IndScratchSpace team_ind(team.team_scratch(0), team_size, nd);
-        KtnScratchSpace team_ktn(team.team_scratch(0), team_size, nd, nc);
+        IndScratchSpace team_ind(team.team_scratch(0), team_size, nd.value);
+        KtnScratchSpace team_ktn(team.team_scratch(0), team_size, nd.value, nc);
 
         for (unsigned ii=0; ii<RowBlockSize; ++ii) {
 
@@ -121,7 +259,7 @@ namespace Genten {
             Kokkos::single( Kokkos::PerThread( team ), [&] (ttb_real& xv)
             {
               const ttb_indx i = Rand::draw(gen,0,nnz);
-              for (ttb_indx m=0; m<nd; ++m)
+              for (ttb_indx m=0; m<nd.value; ++m)
                 team_ind(team_rank,m) = X.subscript(i,m);
               xv = X.value(i);
             }, x_val);
@@ -132,7 +270,7 @@ namespace Genten {
             int sync = 0;
             Kokkos::single( Kokkos::PerThread( team ), [&] (int& s)
             {
-              for (ttb_indx m=0; m<nd; ++m)
+              for (ttb_indx m=0; m<nd.value; ++m)
                 team_ind(team_rank,m) = Rand::draw(gen,0,X.size(m));
               s = 1;
             }, sync);
@@ -140,7 +278,7 @@ namespace Genten {
           }
 
           // Read u
-          for (unsigned m=0; m<nd; ++m) {
+          for (unsigned m=0; m<nd.value; ++m) {
             const ttb_indx k = team_ind(team_rank,m);
             Kokkos::parallel_for(Kokkos::ThreadVectorRange(team,nc),
                                  [&] (const unsigned& j)
@@ -155,7 +293,7 @@ namespace Genten {
                                   [&] (const unsigned& j, ttb_real& mv)
           {
             ttb_real tmp = 1.0;
-            for (unsigned m=0; m<nd; ++m)
+            for (unsigned m=0; m<nd.value; ++m)
               tmp *= team_ktn(team_rank, m, j);
             mv += tmp;
           }, m_val);
@@ -169,13 +307,13 @@ namespace Genten {
              y_val = wz * f.deriv(ttb_real(0.0), m_val);
 
           // Compute gradient contribution
-          for (unsigned n=0; n<nd; ++n) {
+          for (unsigned n=0; n<nd.value; ++n) {
             const ttb_indx k = team_ind(team_rank,n);
             Kokkos::parallel_for(Kokkos::ThreadVectorRange(team,nc),
                                  [&] (const unsigned& j)
             {
               ttb_real tmp = y_val;
-              for (unsigned m=0; m<nd; ++m)
+              for (unsigned m=0; m<nd.value; ++m)
                 if (m != n)
                   tmp *= team_ktn(team_rank, m, j);
               stepper.eval_async(n,k,j,tmp,u);
@@ -231,24 +369,26 @@ namespace Genten {
           dynamic_cast<AdamStep<ExecSpace,LossFunction>*>(&stepper);
         AMSGradStep<ExecSpace,LossFunction>* amsgrad_step =
           dynamic_cast<AMSGradStep<ExecSpace,LossFunction>*>(&stepper);
-        if (sgd_step != nullptr)
-          gcp_sgd_iter_async_kernel(
-            X,this->ut,loss_func,nsz,nsnz,wz,wnz,rand_pool,*sgd_step,
-            this->algParams, total_iters);
-        else if (adagrad_step != nullptr)
-          gcp_sgd_iter_async_kernel(
-            X,this->ut,loss_func,nsz,nsnz,wz,wnz,rand_pool,*adagrad_step,
-            this->algParams, total_iters);
-        else if (adam_step != nullptr)
-          gcp_sgd_iter_async_kernel(
-            X,this->ut,loss_func,nsz,nsnz,wz,wnz,rand_pool,*adam_step,
-            this->algParams, total_iters);
-        else if (amsgrad_step != nullptr)
-          gcp_sgd_iter_async_kernel(
-            X,this->ut,loss_func,nsz,nsnz,wz,wnz,rand_pool,*amsgrad_step,
-            this->algParams, total_iters);
-        else
-          Genten::error("Unsupported GCP-SGD stepper!");
+        run_order_kernel(X.ndims(), [&](auto ND) {
+          if (sgd_step != nullptr)
+            gcp_sgd_iter_async_kernel<ND()>(
+              X,this->ut,loss_func,nsz,nsnz,wz,wnz,rand_pool,*sgd_step,
+              this->algParams, total_iters);
+          else if (adagrad_step != nullptr)
+            gcp_sgd_iter_async_kernel<ND()>(
+              X,this->ut,loss_func,nsz,nsnz,wz,wnz,rand_pool,*adagrad_step,
+              this->algParams, total_iters);
+          else if (adam_step != nullptr)
+            gcp_sgd_iter_async_kernel<ND()>(
+              X,this->ut,loss_func,nsz,nsnz,wz,wnz,rand_pool,*adam_step,
+              this->algParams, total_iters);
+          else if (amsgrad_step != nullptr)
+            gcp_sgd_iter_async_kernel<ND()>(
+              X,this->ut,loss_func,nsz,nsnz,wz,wnz,rand_pool,*amsgrad_step,
+              this->algParams, total_iters);
+          else
+            Genten::error("Unsupported GCP-SGD stepper!");
+        });
 
         this->timer.stop(this->timer_grad);
 
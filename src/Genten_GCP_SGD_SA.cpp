@@ -51,7 +51,7 @@
 
 #include "Genten_Sptensor.hpp"
 #include "Genten_SystemTimer.hpp"
-#include "Genten_RandomMT.hpp"
+#include "Genten_RandomPool.hpp"
 #include "Genten_MixedFormatOps.hpp"
 
 #ifdef HAVE_CALIPER
@@ -196,8 +196,7 @@ namespace Genten {
 
       // Initialize sampler (sorting, hashing, ...)
       timer.start(timer_sort);
-      RandomMT rng(seed);
-      Kokkos::Random_XorShift64_Pool<ExecSpace> rand_pool(rng.genrnd_int32());
+      RandomPoolT<ExecSpace> rand_pool = create_random_pool<ExecSpace>(seed);
       sampler.initialize(rand_pool, out);
       timer.stop(timer_sort);
 
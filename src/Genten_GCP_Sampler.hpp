@@ -47,8 +47,7 @@
 #include "Genten_SystemTimer.hpp"
 #include "Genten_GCP_SamplingKernels.hpp"
 #include "Genten_GCP_Hash.hpp"
-
-#include "Kokkos_Random.hpp"
+#include "Genten_RandomPool.hpp"
 
 namespace Genten {
 
@@ -56,7 +55,7 @@ namespace Genten {
   class Sampler {
   public:
 
-    typedef Kokkos::Random_XorShift64_Pool<ExecSpace> pool_type;
+    typedef RandomPoolT<ExecSpace> pool_type;
     typedef TensorHashMap<ExecSpace> map_type;
 
     Sampler() {}
@@ -147,10 +147,10 @@ namespace Genten {
       }, "Genten::GCP_SGD::Uniform_Sample");
     }
 
-    template <typename ExecSpace, typename LossFunction>
+    template <typename ExecSpace, typename MapType, typename LossFunction>
     void uniform_sample_tensor_hash(
       const SptensorT<ExecSpace>& X,
-      const TensorHashMap<ExecSpace>& hash,
+      const MapType& hash,
       const ttb_indx num_samples,
       const ttb_real weight,
       const KtensorT<ExecSpace>& u,
@@ -213,10 +213,8 @@ namespace Genten {
             for (ttb_indx m=0; m<nd; ++m)
               ind[m] = Rand::draw(gen,0,X.size(m));
             const auto hash_index = hash.find(ind);
-            if (hash.valid_at(hash_index)) {
-              const ttb_indx i = hash.value_at(hash_index);
-              xv = X.value(i);
-            }
+            if (hash.valid_at(hash_index))
+              xv = hash.value_at(hash_index);
             else
               xv = 0.0;
           }, x_val);
@@ -400,10 +398,10 @@ namespace Genten {
       }, "Genten::GCP_SGD::Stratified_Sample_Zeros");
     }
 
-    template <typename ExecSpace, typename LossFunction>
+    template <typename ExecSpace, typename MapType, typename LossFunction>
     void stratified_sample_tensor_hash(
       const SptensorT<ExecSpace>& X,
-      const TensorHashMap<ExecSpace>& hash,
+      const MapType& hash,
       const ttb_indx num_samples_nonzeros,
       const ttb_indx num_samples_zeros,
       const ttb_real weight_nonzeros,
@@ -1109,6 +1107,19 @@ namespace Genten {
     Kokkos::Random_XorShift64_Pool<SPACE>& rand_pool,                   \
     const AlgParams& algParams);                                        \
                                                                         \
+  template void Impl::uniform_sample_tensor_hash(                       \
+    const SptensorT<SPACE>& X,                                          \
+    const SptensorALTOT<SPACE>& hash,                                   \
+    const ttb_indx num_samples,                                         \
+    const ttb_real weight,                                              \
+    const KtensorT<SPACE>& u,                                           \
+    const LOSS& loss_func,                                              \
+    const bool compute_gradient,                                        \
+    SptensorT<SPACE>& Y,                                                \
+    ArrayT<SPACE>& w,                                                   \
+    Kokkos::Random_XorShift64_Pool<SPACE>& rand_pool,                   \
+    const AlgParams& algParams);                                        \
+                                                                        \
   template void Impl::stratified_sample_tensor(                         \
     const SptensorT<SPACE>& X,                                          \
     const ttb_indx num_samples_nonzeros,                                \
@@ -1138,6 +1149,21 @@ namespace Genten {
     Kokkos::Random_XorShift64_Pool<SPACE>& rand_pool,                   \
     const AlgParams& algParams);                                        \
                                                                         \
+  template void Impl::stratified_sample_tensor_hash(                    \
+    const SptensorT<SPACE>& X,                                          \
+    const SptensorALTOT<SPACE>& hash,                                   \
+    const ttb_indx num_samples_nonzeros,                                \
+    const ttb_indx num_samples_zeros,                                   \
+    const ttb_real weight_nonzeros,                                     \
+    const ttb_real weight_zeros,                                        \
+    const KtensorT<SPACE>& u,                                           \
+    const LOSS& loss_func,                                              \
+    const bool compute_gradient,                                        \
+    SptensorT<SPACE>& Y,                                                \
+    ArrayT<SPACE>& w,                                                   \
+    Kokkos::Random_XorShift64_Pool<SPACE>& rand_pool,                   \
+    const AlgParams& algParams);                                        \
+                                                                        \
   template void Impl::semi_stratified_sample_tensor(                    \
     const SptensorT<SPACE>& X,                                          \
     const ttb_indx num_samples_nonzeros,                                \
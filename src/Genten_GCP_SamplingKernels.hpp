@@ -43,6 +43,7 @@
 #include "Genten_Sptensor.hpp"
 #include "Genten_Ktensor.hpp"
 #include "Genten_AlgParams.hpp"
+#include "Genten_SptensorALTO.hpp"
 #include "Genten_GCP_Hash.hpp"
 
 #include "Kokkos_Random.hpp"
@@ -64,10 +65,10 @@ namespace Genten {
       Kokkos::Random_XorShift64_Pool<ExecSpace>& rand_pool,
       const AlgParams& algParams);
 
-    template <typename ExecSpace, typename LossFunction>
+    template <typename ExecSpace, typename MapType, typename LossFunction>
     void uniform_sample_tensor_hash(
       const SptensorT<ExecSpace>& X,
-      const TensorHashMap<ExecSpace>& hash,
+      const MapType& hash,
       const ttb_indx num_samples,
       const ttb_real weight,
       const KtensorT<ExecSpace>& u,
@@ -93,10 +94,10 @@ namespace Genten {
       Kokkos::Random_XorShift64_Pool<ExecSpace>& rand_pool,
       const AlgParams& algParams);
 
-    template <typename ExecSpace, typename LossFunction>
+    template <typename ExecSpace, typename MapType, typename LossFunction>
     void stratified_sample_tensor_hash(
       const SptensorT<ExecSpace>& X,
-      const TensorHashMap<ExecSpace>& hash,
+      const MapType& hash,
       const ttb_indx num_samples_nonzeros,
       const ttb_indx num_samples_zeros,
       const ttb_real weight_nonzeros,
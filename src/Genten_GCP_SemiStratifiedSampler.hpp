@@ -116,6 +116,8 @@ namespace Genten {
       if (algParams.printitn > 0) {
         if (algParams.hash)
           out << "Hashing tensor for faster sampling...";
+        else if (algParams.alto_lookup)
+          out << "Linearizing tensor for faster sampling...";
         else
           out << "Sorting tensor for faster sampling...";
       }
@@ -123,6 +125,8 @@ namespace Genten {
       timer.start(0);
       if (algParams.hash)
         hash_map = this->buildHashMap(X,out);
+      else if (algParams.alto_lookup)
+        x_alto = SptensorALTOT<ExecSpace>(X);
       else if (!X.isSorted())
         X.sort();
       timer.stop(0);
@@ -171,6 +175,13 @@ namespace Genten {
             this->weight_nonzeros_value, this->weight_zeros_value,
             u, loss_func, false,
             Xs, w, this->rand_pool, this->algParams);
+        else if (algParams.alto_lookup)
+          Impl::stratified_sample_tensor_hash(
+            this->X, x_alto,
+            this->num_samples_nonzeros_value, this->num_samples_zeros_value,
+            this->weight_nonzeros_value, this->weight_zeros_value,
+            u, loss_func, false,
+            Xs, w, this->rand_pool, this->algParams);
         else
           Impl::stratified_sample_tensor(
             X, num_samples_nonzeros_value, num_samples_zeros_value,
@@ -251,6 +262,7 @@ namespace Genten {
     ttb_real weight_nonzeros_grad;
     ttb_real weight_zeros_grad;
     map_type hash_map;
+    SptensorALTOT<ExecSpace> x_alto;
   };
 
 }
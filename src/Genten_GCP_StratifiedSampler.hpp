@@ -113,6 +113,8 @@ namespace Genten {
       if (algParams.printitn > 0) {
         if (algParams.hash)
           out << "Hashing tensor for faster sampling...";
+        else if (algParams.alto_lookup)
+          out << "Linearizing tensor for faster sampling...";
         else
           out << "Sorting tensor for faster sampling...";
       }
@@ -120,6 +122,8 @@ namespace Genten {
       timer.start(0);
       if (algParams.hash)
         hash_map = this->buildHashMap(X,out);
+      else if (algParams.alto_lookup)
+        x_alto = SptensorALTOT<ExecSpace>(X);
       else if (!X.isSorted())
         X.sort();
       timer.stop(0);
@@ -152,22 +156,10 @@ namespace Genten {
                               SptensorT<ExecSpace>& Xs,
                               ArrayT<ExecSpace>& w) override
     {
-      if (algParams.hash) {
-        if (gradient)
-          Impl::stratified_sample_tensor_hash(
-            this->X, hash_map,
-            this->num_samples_nonzeros_grad, this->num_samples_zeros_grad,
-            this->weight_nonzeros_grad, this->weight_zeros_grad,
-            u, loss_func, true,
-            Xs, w, this->rand_pool, this->algParams);
-        else
-          Impl::stratified_sample_tensor_hash(
-            this->X, hash_map,
-            this->num_samples_nonzeros_value, this->num_samples_zeros_value,
-            this->weight_nonzeros_value, this->weight_zeros_value,
-            u, loss_func, false,
-            Xs, w, this->rand_pool, this->algParams);
-      }
+      if (algParams.hash)
+        sampleTensorLookup(hash_map, gradient, u, loss_func, Xs, w);
+      else if (algParams.alto_lookup)
+        sampleTensorLookup(x_alto, gradient, u, loss_func, Xs, w);
       else {
         if (gradient) {
           Impl::stratified_sample_tensor(
@@ -185,6 +177,32 @@ namespace Genten {
       }
     }
 
+    // Sample using a lookup structure (TensorHashMap or SptensorALTOT) to
+    // reject zero samples that hit nonzeros
+    template <typename MapType>
+    void sampleTensorLookup(const MapType& map,
+                            const bool gradient,
+                            const KtensorT<ExecSpace>& u,
+                            const LossFunction& loss_func,
+                            SptensorT<ExecSpace>& Xs,
+                            ArrayT<ExecSpace>& w)
+    {
+      if (gradient)
+        Impl::stratified_sample_tensor_hash(
+          this->X, map,
+          this->num_samples_nonzeros_grad, this->num_samples_zeros_grad,
+          this->weight_nonzeros_grad, this->weight_zeros_grad,
+          u, loss_func, true,
+          Xs, w, this->rand_pool, this->algParams);
+      else
+        Impl::stratified_sample_tensor_hash(
+          this->X, map,
+          this->num_samples_nonzeros_value, this->num_samples_zeros_value,
+          this->weight_nonzeros_value, this->weight_zeros_value,
+          u, loss_func, false,
+          Xs, w, this->rand_pool, this->algParams);
+    }
+
     virtual void fusedGradient(const KtensorT<ExecSpace>& u,
                                const LossFunction& loss_func,
                                const KtensorT<ExecSpace>& g,
@@ -209,6 +227,7 @@ namespace Genten {
     ttb_real weight_nonzeros_grad;
     ttb_real weight_zeros_grad;
     map_type hash_map;
+    SptensorALTOT<ExecSpace> x_alto;
   };
 
 }
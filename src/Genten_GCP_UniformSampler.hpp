@@ -104,6 +104,8 @@ namespace Genten {
       if (algParams.printitn > 0) {
         if (algParams.hash)
           out << "Hashing tensor for faster sampling...";
+        else if (algParams.alto_lookup)
+          out << "Linearizing tensor for faster sampling...";
         else
           out << "Sorting tensor for faster sampling...";
       }
@@ -111,6 +113,8 @@ namespace Genten {
       timer.start(0);
       if (algParams.hash)
         hash_map = this->buildHashMap(X,out);
+      else if (algParams.alto_lookup)
+        x_alto = SptensorALTOT<ExecSpace>(X);
       else if (!X.isSorted())
         X.sort();
       timer.stop(0);
@@ -138,6 +142,10 @@ namespace Genten {
           Impl::uniform_sample_tensor_hash(
             X, hash_map, num_samples_grad, weight_grad, u, loss_func, false,
             Xs, w, this->rand_pool, this->algParams);
+        else if (algParams.alto_lookup)
+          Impl::uniform_sample_tensor_hash(
+            X, x_alto, num_samples_grad, weight_grad, u, loss_func, false,
+            Xs, w, this->rand_pool, this->algParams);
         else
           Impl::uniform_sample_tensor(
             X, num_samples_grad, weight_grad, u, loss_func, true,
@@ -151,6 +159,13 @@ namespace Genten {
             weight_nonzeros_value, weight_zeros_value,
             u, loss_func, false,
             Xs, w, rand_pool, algParams);
+        else if (algParams.alto_lookup)
+          Impl::stratified_sample_tensor_hash(
+            X, x_alto,
+            num_samples_nonzeros_value, num_samples_zeros_value,
+            weight_nonzeros_value, weight_zeros_value,
+            u, loss_func, false,
+            Xs, w, rand_pool, algParams);
         else
           Impl::stratified_sample_tensor(
             X, num_samples_nonzeros_value, num_samples_zeros_value,
@@ -182,6 +197,7 @@ namespace Genten {
     ttb_real weight_zeros_value;
     ttb_real weight_grad;
     map_type hash_map;
+    SptensorALTOT<ExecSpace> x_alto;
   };
 
 }
@@ -0,0 +1,390 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+/*!
+  @file Genten_IObinary.cpp
+  @brief Implement methods for binary I/O of Genten classes.
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Genten_IObinary.hpp"
+#include "Genten_Sptensor.hpp"
+#include "Genten_Util.hpp"
+
+//----------------------------------------------------------------------
+//  INTERNAL METHODS WITH FILE SCOPE
+//----------------------------------------------------------------------
+
+namespace {
+
+const char binary_sptensor_magic[8] = { 'G','T','S','P','T','B','I','N' };
+const uint32_t binary_sptensor_endian = 0x01020304;
+const size_t binary_sptensor_align = 64;
+
+//! Fixed-size portion of the binary sptensor header.
+struct BinarySptensorHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t endian;
+  uint32_t indx_bytes;
+  uint32_t real_bytes;
+  uint64_t ndims;
+  uint64_t nnz;
+  uint64_t flags;
+};
+
+const uint64_t binary_sptensor_sorted_flag = 1;
+
+size_t round_up(const size_t n)
+{
+  return (n + binary_sptensor_align - 1) / binary_sptensor_align *
+    binary_sptensor_align;
+}
+
+//! Offset of the subscripts array for a tensor with nd modes.
+size_t subs_offset(const uint64_t nd)
+{
+  return round_up(sizeof(BinarySptensorHeader) + nd*sizeof(uint64_t));
+}
+
+//! Offset of the values array.
+size_t vals_offset(const uint64_t nd, const uint64_t nz,
+                   const uint32_t indx_bytes)
+{
+  return round_up(subs_offset(nd) + nz*nd*indx_bytes);
+}
+
+//! Product a*b, returning false if it overflows.
+bool checked_mul(const uint64_t a, const uint64_t b, uint64_t& r)
+{
+  if (a != 0 && b > std::numeric_limits<uint64_t>::max() / a)
+    return false;
+  r = a*b;
+  return true;
+}
+
+//! Sum a+b, returning false if it overflows.
+bool checked_add(const uint64_t a, const uint64_t b, uint64_t& r)
+{
+  if (b > std::numeric_limits<uint64_t>::max() - a)
+    return false;
+  r = a+b;
+  return true;
+}
+
+//! File length required by a header, or false if it overflows.
+/*!
+ *  The header comes from the file, so every product is checked before it
+ *  is compared with the file length.  h.ndims must already be bounded by
+ *  the file length so subs_offset() itself can't overflow.
+ */
+bool required_length(const BinarySptensorHeader& h, uint64_t& len)
+{
+  uint64_t subs_bytes, vals_bytes, end;
+  if (!checked_mul(h.nnz, h.ndims, subs_bytes) ||
+      !checked_mul(subs_bytes, h.indx_bytes, subs_bytes) ||
+      !checked_add(subs_offset(h.ndims), subs_bytes, end) ||
+      end > std::numeric_limits<uint64_t>::max() - binary_sptensor_align ||
+      !checked_mul(h.nnz, h.real_bytes, vals_bytes) ||
+      !checked_add(round_up(end), vals_bytes, len))
+    return false;
+  return true;
+}
+
+//! Allocation record owning a file mapping.
+/*!
+ *  Zero-copy tensors hold views directly into the mapping.  Attaching this
+ *  record to those views makes them reference counted like any other
+ *  managed view, and the mapping is released when the last copy of the
+ *  tensor goes away.
+ */
+class MappingRecord :
+    public Kokkos::Impl::SharedAllocationRecord<void,void> {
+public:
+  typedef Kokkos::Impl::SharedAllocationRecord<void,void> base_type;
+
+  MappingRecord(void* addr, const size_t len) :
+    base_type(
+#ifdef KOKKOS_ENABLE_DEBUG
+      &root_record(),
+#endif
+      &m_header, len, &MappingRecord::deallocate),
+    m_header(), m_addr(addr), m_len(len) {}
+
+  virtual ~MappingRecord() { munmap(m_addr, m_len); }
+
+  virtual std::string get_label() const override {
+    return std::string("Genten::import_sptensor_binary::mapping");
+  }
+
+private:
+  static void deallocate(base_type* rec) {
+    delete static_cast<MappingRecord*>(rec);
+  }
+
+#ifdef KOKKOS_ENABLE_DEBUG
+  // Debug builds link every record into the list of its root
+  struct RootRecord : public base_type {};
+  static base_type& root_record() {
+    static RootRecord root;
+    return root;
+  }
+#endif
+
+  Kokkos::Impl::SharedAllocationHeader m_header;
+  void* m_addr;
+  size_t m_len;
+};
+
+void write_padding(std::ofstream& fOut, const size_t len)
+{
+  const size_t pos = static_cast<size_t>(fOut.tellp());
+  const size_t pad = round_up(pos) - pos;
+  const char zeros[binary_sptensor_align] = { 0 };
+  fOut.write(zeros, pad);
+  if (pos + pad != len)
+    Genten::error("Genten::export_sptensor_binary - file offset mismatch.");
+}
+
+template <typename IndxType, typename RealType>
+void convert_arrays(const char* base, const size_t so, const size_t vo,
+                    const Genten::Sptensor::subs_view_type& subs,
+                    const Genten::Sptensor::vals_view_type& vals)
+{
+  typedef Genten::DefaultHostExecutionSpace host_space;
+  const IndxType* s = reinterpret_cast<const IndxType*>(base+so);
+  const RealType* v = reinterpret_cast<const RealType*>(base+vo);
+  const ttb_indx nz = subs.extent(0);
+  const ttb_indx nd = subs.extent(1);
+  Kokkos::parallel_for("Genten::import_sptensor_binary::convert",
+                       Kokkos::RangePolicy<host_space>(0,nz),
+                       [=](const ttb_indx i)
+  {
+    for (ttb_indx j=0; j<nd; ++j)
+      subs(i,j) = static_cast<ttb_indx>(s[i*nd+j]);
+    vals(i) = static_cast<ttb_real>(v[i]);
+  });
+}
+
+}
+
+//----------------------------------------------------------------------
+//  METHODS FOR Sptensor
+//----------------------------------------------------------------------
+
+void Genten::import_sptensor_binary (const std::string& fName,
+                                     Genten::Sptensor& X,
+                                     const bool verbose)
+{
+  const int fd = open(fName.c_str(), O_RDONLY);
+  if (fd == -1)
+    Genten::error("Genten::import_sptensor_binary - cannot open input file.");
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    Genten::error("Genten::import_sptensor_binary - cannot stat input file.");
+  }
+  const size_t len = st.st_size;
+  if (len < sizeof(BinarySptensorHeader)) {
+    close(fd);
+    Genten::error("Genten::import_sptensor_binary - file too small.");
+  }
+
+  // Map privately and writable so that in-place operations on the tensor
+  // such as sort() work, with pages only copied if they are modified
+  void* addr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+    Genten::error("Genten::import_sptensor_binary - mmap failed.");
+  char* base = static_cast<char*>(addr);
+
+  // Validate the header
+  BinarySptensorHeader h;
+  std::memcpy(&h, base, sizeof(h));
+  std::string err;
+  if (std::memcmp(h.magic, binary_sptensor_magic, 8) != 0)
+    err = "not a binary sptensor file";
+  else if (h.endian != binary_sptensor_endian)
+    err = "file was written with a different byte order";
+  else if (h.version != binary_sptensor_version)
+    err = "unsupported file version";
+  else if ((h.indx_bytes != 4 && h.indx_bytes != 8) ||
+           (h.real_bytes != 4 && h.real_bytes != 8))
+    err = "unsupported subscript or value width";
+  else if (h.ndims == 0 ||
+           h.ndims > (len - sizeof(h)) / sizeof(uint64_t))
+    err = "file is truncated";
+  else {
+    uint64_t need = 0;
+    if (!required_length(h, need))
+      err = "header sizes overflow";
+    else if (len < need)
+      err = "file is truncated";
+  }
+  if (!err.empty()) {
+    munmap(addr, len);
+    Genten::error("Genten::import_sptensor_binary - " + err + ".");
+  }
+
+  const ttb_indx nd = h.ndims;
+  const ttb_indx nz = h.nnz;
+  const size_t so = subs_offset(nd);
+  const size_t vo = vals_offset(nd, nz, h.indx_bytes);
+  const uint64_t* dims = reinterpret_cast<const uint64_t*>(
+    base+sizeof(BinarySptensorHeader));
+  Genten::IndxArray sz(nd);
+  for (ttb_indx i=0; i<nd; ++i)
+    sz[i] = dims[i];
+  const bool sorted = (h.flags & binary_sptensor_sorted_flag) != 0;
+
+  typedef Genten::Sptensor::subs_view_type subs_view_type;
+  typedef Genten::Sptensor::vals_view_type vals_view_type;
+  const bool zero_copy =
+    h.indx_bytes == sizeof(ttb_indx) && h.real_bytes == sizeof(ttb_real);
+  if (zero_copy) {
+    // Views constructed from a pointer are unmanaged, so give them a
+    // record that unmaps the file when the last view is destroyed
+    Kokkos::Impl::SharedAllocationTracker track;
+    track.assign_allocated_record_to_uninitialized(
+      new MappingRecord(addr, len));
+    subs_view_type subs_map(reinterpret_cast<ttb_indx*>(base+so), nz, nd);
+    vals_view_type vals_map(reinterpret_cast<ttb_real*>(base+vo), nz);
+    subs_view_type subs(track, subs_map.impl_map());
+    vals_view_type vals(track, vals_map.impl_map());
+    X = Genten::Sptensor(sz, vals, subs, subs_view_type(), sorted);
+  }
+  else {
+    subs_view_type subs(
+      Kokkos::view_alloc(Kokkos::WithoutInitializing,"Genten::Sptensor::subs"),
+      nz, nd);
+    vals_view_type vals(
+      Kokkos::view_alloc(Kokkos::WithoutInitializing,"Genten::Sptensor::vals"),
+      nz);
+    if (h.indx_bytes == 4 && h.real_bytes == 4)
+      convert_arrays<uint32_t,float>(base, so, vo, subs, vals);
+    else if (h.indx_bytes == 4 && h.real_bytes == 8)
+      convert_arrays<uint32_t,double>(base, so, vo, subs, vals);
+    else if (h.indx_bytes == 8 && h.real_bytes == 4)
+      convert_arrays<uint64_t,float>(base, so, vo, subs, vals);
+    else
+      convert_arrays<uint64_t,double>(base, so, vo, subs, vals);
+    X = Genten::Sptensor(sz, vals, subs, subs_view_type(), sorted);
+    munmap(addr, len);
+  }
+
+  if (verbose) {
+    std::cout << "Read binary tensor with " << nz << " nonzeros, dimensions [ ";
+    for (ttb_indx i=0; i<nd; ++i)
+      std::cout << sz[i] << " ";
+    std::cout << "], and " << h.indx_bytes << "-byte subscripts ("
+              << (zero_copy ? "zero-copy" : "converted") << ")" << std::endl;
+  }
+}
+
+void Genten::export_sptensor_binary (const std::string& fName,
+                                     const Genten::Sptensor& X,
+                                     const unsigned indx_bytes)
+{
+  if (indx_bytes != 4 && indx_bytes != 8)
+    Genten::error("Genten::export_sptensor_binary - subscript width must be 4 or 8 bytes.");
+
+  const ttb_indx nd = X.ndims();
+  const ttb_indx nz = X.nnz();
+  if (indx_bytes == 4) {
+    for (ttb_indx i=0; i<nd; ++i)
+      if (X.size(i) > ttb_indx(UINT32_MAX)+1)
+        Genten::error("Genten::export_sptensor_binary - tensor dimensions do not fit in 4-byte subscripts.");
+  }
+
+  std::ofstream fOut(fName.c_str(), std::ios_base::out | std::ios_base::binary);
+  if (fOut.is_open() == false)
+    Genten::error("Genten::export_sptensor_binary - cannot create output file.");
+
+  BinarySptensorHeader h;
+  std::memcpy(h.magic, binary_sptensor_magic, 8);
+  h.version = binary_sptensor_version;
+  h.endian = binary_sptensor_endian;
+  h.indx_bytes = indx_bytes;
+  h.real_bytes = sizeof(ttb_real);
+  h.ndims = nd;
+  h.nnz = nz;
+  h.flags = X.isSorted() ? binary_sptensor_sorted_flag : 0;
+  fOut.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  for (ttb_indx i=0; i<nd; ++i) {
+    const uint64_t d = X.size(i);
+    fOut.write(reinterpret_cast<const char*>(&d), sizeof(d));
+  }
+  write_padding(fOut, subs_offset(nd));
+
+  // Subscripts are stored exactly as the row-major subs view
+  const Genten::Sptensor::subs_view_type subs = X.getSubscripts();
+  if (indx_bytes == sizeof(ttb_indx))
+    fOut.write(reinterpret_cast<const char*>(subs.data()),
+               nz*nd*sizeof(ttb_indx));
+  else {
+    std::vector<uint32_t> row(nd);
+    for (ttb_indx i=0; i<nz; ++i) {
+      for (ttb_indx j=0; j<nd; ++j)
+        row[j] = static_cast<uint32_t>(subs(i,j));
+      fOut.write(reinterpret_cast<const char*>(row.data()),
+                 nd*sizeof(uint32_t));
+    }
+  }
+  write_padding(fOut, vals_offset(nd, nz, indx_bytes));
+
+  const Genten::Sptensor::vals_view_type vals = X.getValues();
+  fOut.write(reinterpret_cast<const char*>(vals.data()), nz*sizeof(ttb_real));
+
+  if (!fOut)
+    Genten::error("Genten::export_sptensor_binary - error writing output file.");
+  fOut.close();
+}
@@ -0,0 +1,114 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+/*!
+  @file Genten_IObinary.hpp
+  @brief Declare methods providing binary I/O for Genten classes.
+*/
+
+#pragma once
+
+#include <string>
+
+#include "Genten_Sptensor.hpp"
+
+//! Namespace for the Genten C++ project.
+namespace Genten
+{
+
+  /** ----------------------------------------------------------------
+   *  @name Binary I/O Methods for Sptensor (sparse tensor)
+   *  @{
+   *  ---------------------------------------------------------------- */
+
+  //! Version of the binary sptensor layout written by export_sptensor_binary().
+  const unsigned binary_sptensor_version = 1;
+
+  //! Read a Sptensor from a binary file, matching export_sptensor_binary().
+  /*!
+   *  <pre>
+   *  The file consists of a fixed-size header followed by the arrays.
+   *    magic      8 bytes, "GTSPTBIN"
+   *    version    uint32
+   *    endian     uint32, 0x01020304 in the byte order of the writer
+   *    indx_bytes uint32, width of each subscript (4 or 8)
+   *    real_bytes uint32, width of each value (4 or 8)
+   *    ndims      uint64
+   *    nnz        uint64
+   *    flags      uint64, bit 0 set if the nonzeros are sorted
+   *    dims       uint64[ndims]
+   *  The subscripts follow as an nnz x ndims row-major array, and then the
+   *  nnz values.  Each array starts on a 64-byte boundary.
+   *  </pre>
+   *  Subscripts always start at zero.
+   *
+   *  The file is memory-mapped.  When the stored widths match ttb_indx and
+   *  ttb_real, the subscripts and values of X are unmanaged views directly
+   *  into the mapping, so nothing is parsed or copied.  The mapping is
+   *  private (modifications are not written back to the file) and is
+   *  released at Kokkos::finalize().  Otherwise the arrays are converted
+   *  into newly allocated views and the file is unmapped before returning.
+   *
+   *  @param[in] fName     Input filename.
+   *  @param[in,out] X     Sptensor filled with data.
+   *  @param[in] verbose   Print a summary of the tensor read.
+   *  @throws string       for any error.
+   */
+  void import_sptensor_binary (const std::string& fName,
+                               Genten::Sptensor& X,
+                               const bool verbose = false);
+
+  //! Write a Sptensor to a binary file, matching import_sptensor_binary().
+  /*!
+   *  @param[in] fName       Output filename.
+   *  @param[in] X           Sptensor to be exported.
+   *  @param[in] indx_bytes  Width of each stored subscript, 4 or 8.
+   *                         Storing 8 bytes (the width of ttb_indx) allows
+   *                         a zero-copy import.
+   *  @throws string         for any error, including subscripts that do
+   *                         not fit in indx_bytes.
+   */
+  void export_sptensor_binary (const std::string& fName,
+                               const Genten::Sptensor& X,
+                               const unsigned indx_bytes = sizeof(ttb_indx));
+
+  /** @} */
+
+}
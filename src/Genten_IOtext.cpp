@@ -43,6 +43,9 @@
   @brief Implement methods for I/O of Genten classes.
 */
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
@@ -50,6 +53,7 @@
 
 #include "Genten_FacMatrix.hpp"
 #include "Genten_IOtext.hpp"
+#include "Genten_Kokkos.hpp"
 #include "Genten_Ktensor.hpp"
 #include "Genten_Sptensor.hpp"
 #include "Genten_Tensor.hpp"
@@ -190,6 +194,319 @@ static void  verifyEOF (      std::istream &     fIn,
   return;
 }
 
+//! Read the remainder of a stream into a character buffer.
+/*!
+ *  @param[in] fIn   Input stream.  It is read until end-of-file.
+ *  @param[out] buf  Buffer holding the bytes read.
+ */
+static void  read_remaining (std::istream      & fIn,
+                             std::vector<char> & buf)
+{
+  buf.clear();
+
+  // Reserve the full size up-front when the stream is seekable
+  const std::streampos cur = fIn.tellg();
+  if (cur != std::streampos(-1))
+  {
+    fIn.seekg(0, std::ios_base::end);
+    const std::streampos last = fIn.tellg();
+    fIn.seekg(cur);
+    if (last != std::streampos(-1) && last > cur)
+      buf.reserve(static_cast<size_t>(last - cur));
+  }
+
+  const size_t block = 1 << 24;
+  size_t n = 0;
+  while (fIn)
+  {
+    buf.resize(n + block);
+    fIn.read(buf.data() + n, block);
+    n += fIn.gcount();
+  }
+  buf.resize(n);
+}
+
+static inline bool is_blank (const char c)
+{
+  return (c == ' ') || (c == '\t') || (c == '\r');
+}
+
+//! Advance to the start of the next line.
+static inline const char* next_line (const char* p, const char* end)
+{
+  while ((p < end) && (*p != '\n'))
+    ++p;
+  return (p < end) ? p+1 : end;
+}
+
+//! Determine if the line starting at p holds a nonzero.
+/*!
+ *  Comment lines (starting with '//') and blank lines are skipped.
+ */
+static inline bool is_content_line (const char* p, const char* end)
+{
+  if ((p+1 < end) && (p[0] == '/') && (p[1] == '/'))
+    return false;
+  while ((p < end) && is_blank(*p))
+    ++p;
+  return (p < end) && (*p != '\n');
+}
+
+//! Scan an unsigned integer, skipping leading blanks.
+/*!
+ *  @return  False if no digits were found.
+ */
+static inline bool scan_indx (const char*& p, const char* end, ttb_indx& v)
+{
+  while ((p < end) && is_blank(*p))
+    ++p;
+  if ((p < end) && (*p == '+'))
+    ++p;
+  const char* start = p;
+  ttb_indx r = 0;
+  while ((p < end) && (*p >= '0') && (*p <= '9'))
+  {
+    r = 10*r + ttb_indx(*p - '0');
+    ++p;
+  }
+  v = r;
+  return p != start;
+}
+
+//! Scan a floating-point value, skipping leading blanks.
+/*!
+ *  Plain decimal values whose significand fits in 53 bits and whose
+ *  decimal exponent is at most 22 in magnitude are converted exactly with
+ *  a single multiply or divide (both operands are then exact doubles).
+ *  Anything else (long significands, large exponents, inf/nan) is handed
+ *  to strtod() so the result always matches the serial parser.
+ *
+ *  @return  False if no value was found.
+ */
+static inline bool scan_real (const char*& p, const char* end, ttb_real& v)
+{
+  static const double pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+  const uint64_t max_exact = uint64_t(1) << 53;
+
+  while ((p < end) && is_blank(*p))
+    ++p;
+  const char* start = p;
+
+  bool neg = false;
+  if ((p < end) && ((*p == '-') || (*p == '+')))
+  {
+    neg = (*p == '-');
+    ++p;
+  }
+  uint64_t m = 0;
+  int exp10 = 0;
+  int ndigits = 0;
+  bool exact = true;
+  while ((p < end) && (*p >= '0') && (*p <= '9'))
+  {
+    if (m < max_exact)
+      m = 10*m + uint64_t(*p - '0');
+    else
+      exact = false;
+    ++ndigits;
+    ++p;
+  }
+  if ((p < end) && (*p == '.'))
+  {
+    ++p;
+    while ((p < end) && (*p >= '0') && (*p <= '9'))
+    {
+      if (m < max_exact)
+      {
+        m = 10*m + uint64_t(*p - '0');
+        --exp10;
+      }
+      else
+        exact = false;
+      ++ndigits;
+      ++p;
+    }
+  }
+  if (ndigits > 0 && (p < end) && ((*p == 'e') || (*p == 'E')))
+  {
+    const char* q = p+1;
+    bool eneg = false;
+    if ((q < end) && ((*q == '-') || (*q == '+')))
+    {
+      eneg = (*q == '-');
+      ++q;
+    }
+    if ((q < end) && (*q >= '0') && (*q <= '9'))
+    {
+      int e = 0;
+      while ((q < end) && (*q >= '0') && (*q <= '9'))
+      {
+        if (e < 10000)
+          e = 10*e + (*q - '0');
+        ++q;
+      }
+      exp10 += eneg ? -e : e;
+      p = q;
+    }
+  }
+
+  if ((ndigits > 0) && exact && (m <= max_exact) &&
+      (exp10 >= -22) && (exp10 <= 22))
+  {
+    double d = static_cast<double>(m);
+    d = (exp10 < 0) ? d / pow10[-exp10] : d * pow10[exp10];
+    v = static_cast<ttb_real>(neg ? -d : d);
+    return true;
+  }
+
+  // Slow path:  strtod() requires a null-terminated token
+  const char* tok_end = start;
+  while ((tok_end < end) && !is_blank(*tok_end) && (*tok_end != '\n'))
+    ++tok_end;
+  if (tok_end == start)
+    return false;
+  std::string tok(start, tok_end);
+  char* last = nullptr;
+  v = static_cast<ttb_real>(std::strtod(tok.c_str(), &last));
+  p = start + (last - tok.c_str());
+  return last != tok.c_str();
+}
+
+//! Parse nonzeros from a text buffer in parallel.
+/*!
+ *  The buffer is split into byte ranges aligned to line boundaries, one or
+ *  more per host thread.  A first pass counts the nonzeros in each range,
+ *  a prefix sum over those counts gives the position of each range's first
+ *  nonzero, and a second pass parses each range directly into the flat
+ *  subscript and value arrays.
+ *
+ *  @param[in] buf          Buffer of nonzero lines.
+ *  @param[in] len          Length of the buffer.
+ *  @param[in] nModes       Number of tensor modes.
+ *  @param[in] offset       Index base subtracted from each subscript.
+ *  @param[in] first        Number of leading nonzeros already stored in
+ *                          subs/vals (they are preserved).
+ *  @param[in,out] subs     Subscripts, resized to hold all nonzeros.
+ *  @param[in,out] vals     Values, resized to hold all nonzeros.
+ *  @param[in,out] dims     Tensor dimensions, grown to hold the largest
+ *                          subscript when compute_dims is true.
+ *  @param[in] compute_dims Whether to infer the tensor dimensions.
+ *  @throws string  If a line can't be parsed.
+ */
+static void  parse_nonzeros (const char* const buf,
+                             const size_t      len,
+                             const ttb_indx    nModes,
+                             const ttb_indx    offset,
+                             const ttb_indx    first,
+                             Genten::Sptensor::subs_view_type & subs,
+                             Genten::Sptensor::vals_view_type & vals,
+                             std::vector<ttb_indx> & dims,
+                             const bool        compute_dims)
+{
+  typedef Genten::DefaultHostExecutionSpace host_space;
+  typedef Kokkos::RangePolicy<host_space> policy_type;
+
+  const char* const end = buf + len;
+
+  // Split into newline-aligned chunks, with a few per thread for balance
+  const size_t min_chunk = 1 << 16;
+  size_t nc = Genten::SpaceProperties<host_space>::concurrency() * 4;
+  nc = std::max(size_t(1), std::min(nc, len / min_chunk));
+  std::vector<const char*> starts(nc+1);
+  starts[0] = buf;
+  for (size_t c=1; c<nc; ++c)
+  {
+    const char* q = buf + c*(len/nc);
+    q = (q > starts[c-1]) ? next_line(q-1, end) : starts[c-1];
+    starts[c] = q;
+  }
+  starts[nc] = end;
+
+  // Count nonzeros in each chunk
+  std::vector<ttb_indx> counts(nc+1, 0);
+  Kokkos::parallel_for("Genten::import_sptensor::count",
+                       policy_type(0,nc), [&](const size_t c)
+  {
+    ttb_indx n = 0;
+    for (const char* p = starts[c]; p < starts[c+1]; p = next_line(p,end))
+      if (is_content_line(p,end))
+        ++n;
+    counts[c+1] = n;
+  });
+
+  // Prefix sum gives the first nonzero in each chunk
+  counts[0] = first;
+  for (size_t c=0; c<nc; ++c)
+    counts[c+1] += counts[c];
+  const ttb_indx nnz = counts[nc];
+
+  // Allocate the full arrays, carrying over the leading nonzeros
+  Genten::Sptensor::subs_view_type subs_all(
+    Kokkos::view_alloc(Kokkos::WithoutInitializing, subs.label()),
+    nnz, nModes);
+  Genten::Sptensor::vals_view_type vals_all(
+    Kokkos::view_alloc(Kokkos::WithoutInitializing, vals.label()), nnz);
+  for (ttb_indx k=0; k<first; ++k)
+  {
+    for (ttb_indx i=0; i<nModes; ++i)
+      subs_all(k,i) = subs(k,i);
+    vals_all(k) = vals(k);
+  }
+  subs = subs_all;
+  vals = vals_all;
+
+  // Parse each chunk directly into its slice of the arrays
+  std::vector<ttb_indx> chunk_dims(compute_dims ? nc*nModes : 0, 0);
+  std::vector<const char*> bad_line(nc, nullptr);
+  Kokkos::parallel_for("Genten::import_sptensor::parse",
+                       policy_type(0,nc), [&](const size_t c)
+  {
+    ttb_indx k = counts[c];
+    for (const char* p = starts[c]; p < starts[c+1]; p = next_line(p,end))
+    {
+      if (!is_content_line(p,end))
+        continue;
+      const char* q = p;
+      bool ok = true;
+      for (ttb_indx i=0; i<nModes; ++i)
+      {
+        ttb_indx idx = 0;
+        ok = ok && scan_indx(q, end, idx);
+        subs(k,i) = idx - offset;
+        if (compute_dims)
+          chunk_dims[c*nModes+i] =
+            std::max(chunk_dims[c*nModes+i], idx - offset + 1);
+      }
+      ok = ok && scan_real(q, end, vals(k));
+      if (!ok && bad_line[c] == nullptr)
+        bad_line[c] = p;
+      ++k;
+    }
+  });
+
+  for (size_t c=0; c<nc; ++c)
+  {
+    if (bad_line[c] != nullptr)
+    {
+      const char* p = bad_line[c];
+      const char* q = next_line(p, end);
+      if ((q > p) && (q[-1] == '\n'))
+        --q;
+      std::ostringstream  sErrMsg;
+      sErrMsg << "Genten::import_sptensor - invalid line:  "
+              << std::string(p, q);
+      Genten::error(sErrMsg.str());
+    }
+  }
+
+  if (compute_dims)
+    for (size_t c=0; c<nc; ++c)
+      for (ttb_indx i=0; i<nModes; ++i)
+        dims[i] = std::max(dims[i], chunk_dims[c*nModes+i]);
+}
+
 //----------------------------------------------------------------------
 //  METHODS FOR Tensor (type "tensor")
 //----------------------------------------------------------------------
@@ -390,12 +707,10 @@ void Genten::import_sptensor (std::istream& fIn,
 
   ttb_indx offset = index_base;
   ttb_indx nModes = 0;
-  ttb_indx nnz = 0;
+  ttb_indx nFirst = 0;
   std::vector< ttb_indx> dims;
   std::vector< ttb_indx> sub_row;
   ttb_real val_row = 0.0;
-  std::vector< std::vector<ttb_indx> > subs;
-  std::vector< ttb_real > vals;
   bool compute_dims = true;
 
   // Get tensor dimensions and index base from header if we have one
@@ -429,15 +744,11 @@ void Genten::import_sptensor (std::istream& fIn,
     Genten::IndxArray  naNnz(1);
     read_positive_ints (fIn, naNnz, "Genten::import_sptensor, line 4");
 
-    // Reserve space based on the supplied tensor dimensions
     nModes = naModes[0];
-    sub_row.resize(nModes);
     dims.resize(nModes);
     for (ttb_indx i=0; i<nModes; ++i)
       dims[i] = naSizes[i];
     compute_dims = false;
-    subs.reserve(naNnz[0]);
-    vals.reserve(naNnz[0]);
   }
 
   // Otherwise this is the first nonzero and we compute the dimensions as we go
@@ -452,33 +763,36 @@ void Genten::import_sptensor (std::istream& fIn,
       dims[i] = sub_row[i]+1;
     }
     compute_dims = true;
-    subs.push_back(sub_row);
     val_row = std::stod(tokens[nModes]);
-    vals.push_back(val_row);
-    ++nnz;
+    nFirst = 1;
   }
 
-  while (getLineContent(fIn,s))
+  // Parse the remaining lines in parallel directly into the tensor arrays.
+  // Reading the whole stream up-front is much faster than getline() and
+  // lets us avoid storing each nonzero in its own vector.
+  std::vector<char> buf;
+  read_remaining(fIn, buf);
+
+  Genten::Sptensor::subs_view_type subs(
+    Kokkos::view_alloc(Kokkos::WithoutInitializing, "Genten::Sptensor::subs"),
+    nFirst, nModes);
+  Genten::Sptensor::vals_view_type vals(
+    Kokkos::view_alloc(Kokkos::WithoutInitializing, "Genten::Sptensor::vals"),
+    nFirst);
+  if (nFirst > 0)
   {
-    ++nnz;
-    // Don't use the above token parsing because it is too slow when
-    // reading large tensors.  Instead use strtol and strtod, which already
-    // handle white-space.
-    char *ss = const_cast<char*>(s.c_str());
     for (ttb_indx i=0; i<nModes; ++i)
-    {
-      sub_row[i] = std::strtol(ss, &ss, 10) - offset;
-      if (compute_dims)
-        dims[i] = std::max(dims[i], sub_row[i]+1);
-    }
-    val_row = std::strtod(ss, &ss);
-    subs.push_back(sub_row);
-    vals.push_back(val_row);
+      subs(0,i) = sub_row[i];
+    vals(0) = val_row;
   }
-
-  verifyEOF(fIn, "Genten::import_sptensor");
-
-  X = Sptensor(dims, vals, subs);
+  parse_nonzeros(buf.data(), buf.size(), nModes, offset, nFirst,
+                 subs, vals, dims, compute_dims);
+  const ttb_indx nnz = vals.extent(0);
+
+  Genten::IndxArray sz(nModes);
+  for (ttb_indx i=0; i<nModes; ++i)
+    sz[i] = dims[i];
+  X = Sptensor(sz, vals, subs);
 
   if (verbose) {
     std::cout << "Read tensor with " << nnz << " nonzeros, dimensions [ ";
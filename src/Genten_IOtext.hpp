@@ -149,7 +149,12 @@ namespace Genten
    *  </pre>
    *  Each subsequent line provides values for one nonzero element, with
    *  indices followed by the value.  Indices start numbering at zero.
-   *  The elements can be in any order.
+   *  The elements can be in any order.  If the header is omitted, the number
+   *  of modes is taken from the first line, the dimensions are inferred
+   *  from the largest subscripts, and indices start at index_base.
+   *
+   *  The nonzeros are parsed in parallel on the host execution space after
+   *  reading the remainder of the stream into memory.
    *
    *  @param[in] fName  Input filename.
    *  @param[in,out] X  Sptensor resized and filled with data.
@@ -0,0 +1,116 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+#include <assert.h>
+
+#include "Genten_KtensorNarrow.hpp"
+
+#ifdef HAVE_CALIPER
+#include <caliper/cali.h>
+#endif
+
+template <typename ExecSpace, typename ValueType>
+Genten::KtensorNarrowT<ExecSpace,ValueType>::
+KtensorNarrowT(const KtensorT<ExecSpace>& u) :
+  nNumDims(u.ndims()), nComps(u.ncomponents())
+{
+  offsets = offsets_view_type("Genten::KtensorNarrow::offsets", nNumDims+1);
+  offsets_host = create_mirror_view(offsets);
+  offsets_host(0) = 0;
+  for (ttb_indx n=0; n<nNumDims; ++n)
+    offsets_host(n+1) = offsets_host(n) + u[n].nRows();
+  deep_copy(offsets, offsets_host);
+
+  values = view_type(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                        "Genten::KtensorNarrow::values"),
+                     offsets_host(nNumDims), nComps);
+  lambda = weights_view_type(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                                "Genten::KtensorNarrow::weights"),
+                             nComps);
+  stale = stale_view_type("Genten::KtensorNarrow::stale", nNumDims);
+  Kokkos::deep_copy(stale, true);
+  update(u, nNumDims);
+}
+
+template <typename ExecSpace, typename ValueType>
+void
+Genten::KtensorNarrowT<ExecSpace,ValueType>::
+update(const KtensorT<ExecSpace>& u, const ttb_indx skip) const
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::KtensorNarrow::update");
+#endif
+
+  typedef Kokkos::RangePolicy<ExecSpace> Policy;
+
+  assert(u.ndims() == nNumDims);
+  assert(u.ncomponents() == nComps);
+
+  const ttb_indx nc = nComps;
+  const view_type vals = values;
+  const weights_view_type w = lambda;
+  const ArrayT<ExecSpace> uw = u.weights();
+  Kokkos::parallel_for("Genten::KtensorNarrow::convert_weights",
+                       Policy(0,nc), KOKKOS_LAMBDA(const ttb_indx j)
+  {
+    w(j) = ValueType(uw[j]);
+  });
+  for (ttb_indx n=0; n<nNumDims; ++n) {
+    if (n == skip || !stale(n))
+      continue;
+    stale(n) = false;
+    assert(u[n].nRows() == nRows(n));
+    const FacMatrixT<ExecSpace> A = u[n];
+    const ttb_indx off = offsets_host(n);
+    Kokkos::parallel_for("Genten::KtensorNarrow::convert_factors",
+                         Policy(0,A.nRows()), KOKKOS_LAMBDA(const ttb_indx i)
+    {
+      for (ttb_indx j=0; j<nc; ++j)
+        vals(off+i,j) = ValueType(A.entry(i,j));
+    });
+  }
+  if (skip < nNumDims)
+    stale(skip) = true;
+}
+
+#ifdef HAVE_MIXED_PRECISION
+#define INST_MACRO(SPACE) template class Genten::KtensorNarrowT<SPACE,float>;
+GENTEN_INST(INST_MACRO)
+#endif
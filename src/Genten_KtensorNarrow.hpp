@@ -0,0 +1,149 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+/*!
+  @file Genten_KtensorNarrow.hpp
+  @brief Ktensor with factor matrices stored in a narrower floating-point type.
+*/
+
+#pragma once
+
+#include "Genten_Util.hpp"
+#include "Genten_Ktensor.hpp"
+
+namespace Genten
+{
+
+// Copy of the weights and factor matrices of a KtensorT stored as ValueType.
+/* Used with SptensorNarrowT<ExecSpace,IndexType,float> for mixed-precision
+   MTTKRP, where the factor matrices are read as float to halve the memory
+   traffic of the gathers but products are accumulated in ttb_real.  The
+   factor matrices of all modes are packed into one view, and operator[]
+   returns a light-weight matrix providing entry(i,j) so kernels written
+   against the KtensorT interface work unchanged.
+*/
+template <typename ExecSpace, typename ValueType>
+class KtensorNarrowT
+{
+public:
+
+  typedef ExecSpace exec_space;
+  typedef ValueType value_type;
+  typedef Kokkos::View<ValueType**,Kokkos::LayoutRight,ExecSpace> view_type;
+  typedef Kokkos::View<ValueType*,Kokkos::LayoutRight,ExecSpace> weights_view_type;
+  typedef Kokkos::View<ttb_indx*,ExecSpace> offsets_view_type;
+  typedef Kokkos::View<bool*,Kokkos::HostSpace> stale_view_type;
+
+  // Factor matrix of one mode
+  struct FacMatrixNarrow {
+    const ValueType* data;
+    ttb_indx stride;
+
+    KOKKOS_INLINE_FUNCTION
+    const ValueType& entry(ttb_indx i, ttb_indx j) const {
+      return data[i*stride+j];
+    }
+  };
+
+  // Empty constructor
+  KtensorNarrowT() : nNumDims(0), nComps(0), values(), lambda(), offsets(),
+                     offsets_host(), stale() {}
+
+  // Allocate storage matching u and convert all of its factor matrices
+  KtensorNarrowT(const KtensorT<ExecSpace>& u);
+
+  KOKKOS_DEFAULTED_FUNCTION
+  KtensorNarrowT(const KtensorNarrowT&) = default;
+
+  KOKKOS_DEFAULTED_FUNCTION
+  KtensorNarrowT& operator=(const KtensorNarrowT&) = default;
+
+  KOKKOS_DEFAULTED_FUNCTION
+  ~KtensorNarrowT() = default;
+
+  // Convert the weights and the factor matrices of u that are stale, except
+  // mode skip, which is then marked stale since the caller is about to
+  // overwrite it (pass skip >= ndims() to convert all stale modes).  Only
+  // the mode skipped by the previous call is stale in the usual CP-ALS
+  // sweep, so each call converts one factor matrix.  u must have the same
+  // shape as the Ktensor this was constructed from.
+  void update(const KtensorT<ExecSpace>& u, const ttb_indx skip) const;
+
+  // Return the number of dimensions
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx ndims() const { return nNumDims; }
+
+  // Return the number of components
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx ncomponents() const { return nComps; }
+
+  // Return weight i
+  KOKKOS_INLINE_FUNCTION
+  const ValueType& weights(ttb_indx i) const { return lambda(i); }
+
+  // Return the factor matrix for mode n
+  KOKKOS_INLINE_FUNCTION
+  FacMatrixNarrow operator[](ttb_indx n) const {
+    return FacMatrixNarrow{ values.data() + offsets(n)*values.stride(0),
+                            values.stride(0) };
+  }
+
+  // Return the number of rows in the factor matrix for mode n
+  ttb_indx nRows(ttb_indx n) const {
+    return offsets_host(n+1)-offsets_host(n);
+  }
+
+  // Memory used by the weights and factor matrices in bytes
+  size_t memory() const {
+    return (values.span()+lambda.span())*sizeof(ValueType);
+  }
+
+private:
+
+  ttb_indx nNumDims;
+  ttb_indx nComps;
+  view_type values;
+  weights_view_type lambda;
+  offsets_view_type offsets;
+  typename offsets_view_type::HostMirror offsets_host;
+  stale_view_type stale;
+};
+
+}
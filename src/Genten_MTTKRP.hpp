@@ -43,12 +43,22 @@
 #include <assert.h>
 
 #include <type_traits>
+#include <chrono>
+#include <vector>
 
 #include "Genten_Util.hpp"
 #include "Genten_FacMatrix.hpp"
 #include "Genten_Ktensor.hpp"
 #include "Genten_MixedFormatOps.hpp"
 #include "Genten_Sptensor.hpp"
+#include "Genten_SptensorCSF.hpp"
+#include "Genten_SptensorHiCOO.hpp"
+#include "Genten_SptensorNarrow.hpp"
+#include "Genten_KtensorNarrow.hpp"
+#include "Genten_NUMA.hpp"
+#include "Genten_SptensorALTO.hpp"
+#include "Genten_SptensorHybrid.hpp"
+#include "Genten_SptensorDimTree.hpp"
 #include "Genten_TinyVec.hpp"
 #include "Genten_AlgParams.hpp"
 #include "Genten_SimdKernel.hpp"
@@ -68,15 +78,145 @@
 namespace Genten {
 namespace Impl {
 
-// MTTKRP kernel for Sptensor
-template <int Dupl, int Cont, unsigned FBS, unsigned VS, typename ExecSpace>
+// Team scratch in bytes mttkrp_kernel_rank_batched needs to hold the tile of
+// nonzeros of one team for a tensor of order nd
+template <unsigned VS, typename ExecSpace>
+size_t
+mttkrp_rank_batch_bytes(const unsigned nd, const AlgParams& algParams)
+{
+  static const bool is_cuda = Genten::is_cuda_space<ExecSpace>::value;
+  static const unsigned VectorSize = is_cuda ? VS : 1;
+  static const unsigned TeamSize = is_cuda ? 128/VectorSize : 1;
+  const unsigned RowsPerTeam = TeamSize * algParams.mttkrp_nnz_tile_size;
+
+  typedef Kokkos::View< ttb_indx**, Kokkos::LayoutRight, typename ExecSpace::scratch_memory_space , Kokkos::MemoryUnmanaged > IndxScratchSpace;
+  typedef Kokkos::View< ttb_real*, Kokkos::LayoutRight, typename ExecSpace::scratch_memory_space , Kokkos::MemoryUnmanaged > ValScratchSpace;
+  return IndxScratchSpace::shmem_size(RowsPerTeam,nd) +
+    ValScratchSpace::shmem_size(RowsPerTeam);
+}
+
+// MTTKRP kernel for large ranks, with the same requirements as
+// mttkrp_kernel below.  Each team loads the subscripts and values of a tile
+// of nonzeros into scratch once and reuses them for every block of
+// columns, rather than re-reading them (and for implicit tensors such as
+// GCP_GradTensor, re-evaluating the values) for each block.
+template <int Dupl, int Cont, unsigned FBS, unsigned VS, unsigned ND = 0,
+          typename SparseTensor, typename Ktensor, typename ExecSpace>
+void
+mttkrp_kernel_rank_batched(const SparseTensor& X,
+                           const Ktensor& u,
+                           const unsigned n,
+                           const FacMatrixT<ExecSpace>& v,
+                           const AlgParams& algParams)
+{
+  v = ttb_real(0.0);
+
+  using Kokkos::Experimental::create_scatter_view;
+  using Kokkos::Experimental::ScatterSum;
+
+  static const bool is_cuda = Genten::is_cuda_space<ExecSpace>::value;
+  static const unsigned FacBlockSize = FBS;
+  static const unsigned VectorSize = is_cuda ? VS : 1;
+  static const unsigned TeamSize = is_cuda ? 128/VectorSize : 1;
+  /*const*/ unsigned RowBlockSize = algParams.mttkrp_nnz_tile_size;
+  const unsigned RowsPerTeam = TeamSize * RowBlockSize;
+
+  const Kokkos::Impl::integral_nonzero_constant<unsigned,ND> nd(u.ndims());
+  /*const*/ unsigned nc = u.ncomponents();
+  /*const*/ ttb_indx nnz = X.nnz();
+  const ttb_indx N = (nnz+RowsPerTeam-1)/RowsPerTeam;
+
+  typedef Kokkos::TeamPolicy<ExecSpace> Policy;
+  typedef typename Policy::member_type TeamMember;
+  typedef Kokkos::View< ttb_indx**, Kokkos::LayoutRight, typename ExecSpace::scratch_memory_space , Kokkos::MemoryUnmanaged > IndxScratchSpace;
+  typedef Kokkos::View< ttb_real*, Kokkos::LayoutRight, typename ExecSpace::scratch_memory_space , Kokkos::MemoryUnmanaged > ValScratchSpace;
+  const size_t bytes =
+    mttkrp_rank_batch_bytes<VS,ExecSpace>(nd.value, algParams);
+  Policy policy(N, TeamSize, VectorSize);
+
+  auto vv = v.view();
+  auto sv = create_scatter_view<ScatterSum,Dupl,Cont>(vv);
+  Kokkos::parallel_for(policy.set_scratch_size(0,Kokkos::PerTeam(bytes)),
+                       KOKKOS_LAMBDA(const TeamMember& team)
+  {
+    auto va = sv.access();
+    const auto& uu = local_replica(u);
+    IndxScratchSpace subs(team.team_scratch(0), RowsPerTeam, nd.value);
+    ValScratchSpace vals(team.team_scratch(0), RowsPerTeam);
+
+    const ttb_indx i_beg = ttb_indx(team.league_rank())*RowsPerTeam;
+    const unsigned nt =
+      i_beg+RowsPerTeam <= nnz ? RowsPerTeam : unsigned(nnz-i_beg);
+
+    // All vector lanes evaluate the value, since implicit tensors compute
+    // it with a vector reduction
+    for (unsigned ii=team.team_rank(); ii<nt; ii+=TeamSize) {
+      const ttb_indx i = i_beg+ii;
+      const ttb_real x_val = X.value(i);
+      Kokkos::single(Kokkos::PerThread(team), [&]()
+      {
+        for (unsigned m=0; m<nd.value; ++m)
+          subs(ii,m) = X.subscript(i,m);
+        vals(ii) = x_val;
+      });
+    }
+    team.team_barrier();
+
+    auto row_func = [&](auto j, auto nj, auto Nj) {
+      typedef TinyVec<ExecSpace, ttb_real, unsigned, FacBlockSize, Nj(), VectorSize> TV;
+      for (unsigned ii=team.team_rank(); ii<nt; ii+=TeamSize) {
+        const ttb_indx k = subs(ii,n);
+        TV tmp(nj, vals(ii));
+        tmp *= &(uu.weights(j));
+        for (unsigned m=0; m<nd.value; ++m) {
+          if (m != n)
+            tmp *= &(uu[m].entry(subs(ii,m),j));
+        }
+        va(k,j) += tmp;
+      }
+    };
+
+    for (unsigned j=0; j<nc; j+=FacBlockSize) {
+      if (j+FacBlockSize <= nc) {
+        const unsigned nj = FacBlockSize;
+        row_func(j, nj, std::integral_constant<unsigned,nj>());
+      }
+      else {
+        const unsigned nj = nc-j;
+        row_func(j, nj, std::integral_constant<unsigned,0>());
+      }
+    }
+  }, "mttkrp_kernel_rank_batched");
+
+  sv.contribute_into(vv);
+}
+
+// MTTKRP kernel for Sptensor (or any coordinate-format sparse tensor
+// providing nnz(), subscript() and value(), e.g., SptensorNarrowT) and
+// any Ktensor type providing weights(j) and operator[](m).entry(i,j), e.g.,
+// KtensorNarrowT, or KtensorReplicatedT through local_replica().  The tensor
+// order is ND if ND > 0 and u.ndims() otherwise.
+template <int Dupl, int Cont, unsigned FBS, unsigned VS, unsigned ND = 0,
+          typename SparseTensor, typename Ktensor, typename ExecSpace>
 void
-mttkrp_kernel(const SptensorT<ExecSpace>& X,
-              const KtensorT<ExecSpace>& u,
+mttkrp_kernel(const SparseTensor& X,
+              const Ktensor& u,
               const unsigned n,
               const FacMatrixT<ExecSpace>& v,
               const AlgParams& algParams)
 {
+  // Batch the column blocks over scratch nonzero tiles for large ranks,
+  // unless the columns are tiled by the user or a tile doesn't fit in
+  // level 0 scratch (e.g., GPU shared memory with small vector sizes)
+  if (algParams.mttkrp_rank_batch > 0 &&
+      u.ncomponents() >= algParams.mttkrp_rank_batch &&
+      algParams.mttkrp_duplicated_factor_matrix_tile_size == 0 &&
+      mttkrp_rank_batch_bytes<VS,ExecSpace>(u.ndims(), algParams) <=
+      size_t(Kokkos::TeamPolicy<ExecSpace>::scratch_size_max(0))) {
+    mttkrp_kernel_rank_batched<Dupl,Cont,FBS,VS,ND>(X,u,n,v,algParams);
+    return;
+  }
+
   v = ttb_real(0.0);
 
   using Kokkos::Experimental::create_scatter_view;
@@ -90,7 +230,8 @@ mttkrp_kernel(const SptensorT<ExecSpace>& X,
   /*const*/ unsigned RowBlockSize = algParams.mttkrp_nnz_tile_size;
   const unsigned RowsPerTeam = TeamSize * RowBlockSize;
 
-  /*const*/ unsigned nd = u.ndims();
+  // nd.value == ND if ND > 0 and u.ndims() otherwise
+  const Kokkos::Impl::integral_nonzero_constant<unsigned,ND> nd(u.ndims());
   /*const*/ unsigned nc_total = u.ncomponents();
   /*const*/ ttb_indx nnz = X.nnz();
   const ttb_indx N = (nnz+RowsPerTeam-1)/RowsPerTeam;
@@ -113,6 +254,7 @@ mttkrp_kernel(const SptensorT<ExecSpace>& X,
     Kokkos::parallel_for(policy, KOKKOS_LAMBDA(const TeamMember& team)
     {
       auto va = sv.access();
+      const auto& uu = local_replica(u);
 
       // Loop over tensor non-zeros with a large stride on the GPU to
       // reduce atomic contention when the non-zeros are in a nearly sorted
@@ -143,10 +285,10 @@ mttkrp_kernel(const SptensorT<ExecSpace>& X,
 
           // MTTKRP for dimension n
           TV tmp(nj, x_val);
-          tmp *= &(u.weights(nc_beg+j));
-          for (unsigned m=0; m<nd; ++m) {
+          tmp *= &(uu.weights(nc_beg+j));
+          for (unsigned m=0; m<nd.value; ++m) {
             if (m != n)
-              tmp *= &(u[m].entry(X.subscript(i,m),nc_beg+j));
+              tmp *= &(uu[m].entry(X.subscript(i,m),nc_beg+j));
           }
           va(k,j) += tmp;
         }
@@ -168,6 +310,302 @@ mttkrp_kernel(const SptensorT<ExecSpace>& X,
   }
 }
 
+// Accumulates the time each host thread spends in MTTKRP kernels so the
+// balance across threads can be reported through mttkrp_thread_times().
+// Does nothing on the GPU or when disabled.
+template <typename ExecSpace>
+struct MTTKRP_ThreadTimer {
+  typedef Kokkos::Experimental::UniqueToken<
+    ExecSpace, Kokkos::Experimental::UniqueTokenScope::Global> token_type;
+  typedef Kokkos::View<double*,ExecSpace> times_type;
+
+  bool enabled;
+  token_type token;
+  times_type times;
+
+  MTTKRP_ThreadTimer(const bool enable) :
+    enabled(enable && !Genten::is_cuda_space<ExecSpace>::value)
+  {
+    if (enabled)
+      times = times_type("Genten::mttkrp_thread_times", token.size());
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  double start() const {
+#ifndef __CUDA_ARCH__
+    if (enabled)
+      return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    return 0.0;
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  void stop(const double t0) const {
+#ifndef __CUDA_ARCH__
+    if (enabled) {
+      const double t = start() - t0;
+      const int id = token.acquire();
+      times(id) += t;
+      token.release(id);
+    }
+#endif
+  }
+
+  // Add the times of this kernel to mttkrp_thread_times()
+  void finalize() const {
+    if (!enabled)
+      return;
+    auto times_host = create_mirror_view(times);
+    deep_copy(times_host, times);
+    std::vector<double>& t = mttkrp_thread_times();
+    if (t.size() < times_host.extent(0))
+      t.resize(times_host.extent(0), 0.0);
+    for (unsigned i=0; i<times_host.extent(0); ++i)
+      t[i] += times_host(i);
+  }
+};
+
+// Add the contributions of nonzeros [i_beg,i_end) of perm(:,n) to val
+template <typename TV, typename ExecSpace>
+KOKKOS_INLINE_FUNCTION
+void mttkrp_perm_add_nonzeros(TV& val, TV& tmp,
+                              const SptensorT<ExecSpace>& X,
+                              const KtensorT<ExecSpace>& u,
+                              const unsigned n, const unsigned j,
+                              const ttb_indx i_beg, const ttb_indx i_end)
+{
+  const unsigned nd = u.ndims();
+  for (ttb_indx i=i_beg; i<i_end; ++i) {
+    const ttb_indx p = X.getPerm(i,n);
+
+    // Start tmp equal to the weights.
+    tmp.load(&(u.weights(j)));
+    tmp *= X.value(p);
+
+    for (unsigned m=0; m<nd; ++m) {
+      if (m != n)
+        tmp *= &(u[m].entry(X.subscript(p,m),j));
+    }
+    val += tmp;
+  }
+}
+
+// MTTKRP kernel for Sptensor_perm using row pointers.  The rows are split
+// into groups holding roughly mttkrp_nnz_tile_size nonzeros each (rows are
+// never split), and each thread computes its rows in order.  Every row is
+// written by exactly one thread, so no atomics are needed and the result
+// is deterministic.
+//
+// For tensors with a few very long rows (slices), the thread owning such a
+// row would hold up all others.  So if mttkrp_heavy_row_tiles > 0, a
+// histogram pre-pass over the row pointers marks rows with more than that
+// many tiles of nonzeros as heavy.  The light rows are computed as above,
+// while each heavy row is split into tiles reduced privately by different
+// threads and then summed in order, which keeps the result deterministic.
+template <unsigned FBS, unsigned VS, typename ExecSpace>
+void
+mttkrp_kernel_perm_rowptr(const SptensorT<ExecSpace>& X,
+                          const KtensorT<ExecSpace>& u,
+                          const unsigned n,
+                          const FacMatrixT<ExecSpace>& v,
+                          const AlgParams& algParams)
+{
+  static const bool is_cuda = Genten::is_cuda_space<ExecSpace>::value;
+  static const unsigned FacBlockSize = FBS;
+  static const unsigned VectorSize = is_cuda ? VS : 1;
+  static const unsigned TeamSize = is_cuda ? 128/VectorSize : 1;
+  /*const*/ unsigned RowBlockSize = algParams.mttkrp_nnz_tile_size;
+  const unsigned RowsPerTeam = TeamSize * RowBlockSize;
+
+  /*const*/ unsigned nc = u.ncomponents();
+  /*const*/ ttb_indx nnz = X.nnz();
+  /*const*/ ttb_indx nrow = X.size(n);
+  /*const*/ ttb_indx ngroup = (nnz+RowBlockSize-1)/RowBlockSize;
+  if (ngroup == 0)
+    ngroup = 1;
+  const ttb_indx N = (ngroup*RowBlockSize+RowsPerTeam-1)/RowsPerTeam;
+
+  // Rows with more than heavy_nnz nonzeros are heavy
+  /*const*/ ttb_indx heavy_nnz = algParams.mttkrp_heavy_row_tiles > 0 ?
+    algParams.mttkrp_heavy_row_tiles*RowBlockSize : nnz;
+
+  typedef Kokkos::TeamPolicy<ExecSpace> Policy;
+  typedef typename Policy::member_type TeamMember;
+  typedef Kokkos::RangePolicy<ExecSpace> RangePolicy;
+  typedef Kokkos::View<ttb_indx*,ExecSpace> IndxView;
+
+  const MTTKRP_ThreadTimer<ExecSpace> timer(algParams.mttkrp_thread_timing);
+
+  Policy policy(N, TeamSize, VectorSize);
+  Kokkos::parallel_for(policy, KOKKOS_LAMBDA(const TeamMember& team)
+  {
+    const ttb_indx g = team.league_rank()*TeamSize + team.team_rank();
+    if (g >= ngroup)
+      return;
+
+    const double t0 = timer.start();
+
+    // Group g owns the rows whose first nonzero is in
+    // [g*RowBlockSize,(g+1)*RowBlockSize).  The last group also owns any
+    // trailing empty rows.
+    auto first_row = [&](const ttb_indx i) {
+      ttb_indx lo = 0;
+      ttb_indx hi = nrow;
+      while (lo < hi) {
+        const ttb_indx mid = lo + (hi-lo)/2;
+        if (X.getPermRowPtr(mid,n) < i)
+          lo = mid+1;
+        else
+          hi = mid;
+      }
+      return lo;
+    };
+    const ttb_indx row_beg = g == 0 ? 0 : first_row(g*RowBlockSize);
+    const ttb_indx row_end =
+      g == ngroup-1 ? nrow : first_row((g+1)*RowBlockSize);
+
+    auto row_func = [&](auto j, auto nj, auto Nj) {
+      typedef TinyVec<ExecSpace, ttb_real, unsigned, FacBlockSize, Nj(), VectorSize> TV;
+      TV val(nj, 0.0), tmp(nj, 0.0);
+
+      for (ttb_indx row=row_beg; row<row_end; ++row) {
+        const ttb_indx i_beg = X.getPermRowPtr(row,n);
+        const ttb_indx i_end = X.getPermRowPtr(row+1,n);
+        if (i_end-i_beg > heavy_nnz)
+          continue;
+        val.broadcast(0.0);
+        mttkrp_perm_add_nonzeros(val, tmp, X, u, n, j, i_beg, i_end);
+        val.store(&v.entry(row,j));
+      }
+    };
+
+    for (unsigned j=0; j<nc; j+=FacBlockSize) {
+      if (j+FacBlockSize <= nc) {
+        const unsigned nj = FacBlockSize;
+        row_func(j, nj, std::integral_constant<unsigned,nj>());
+      }
+      else {
+        const unsigned nj = nc-j;
+        row_func(j, nj, std::integral_constant<unsigned,0>());
+      }
+    }
+
+    timer.stop(t0);
+  }, "mttkrp_kernel_perm_rowptr");
+
+  // Split the heavy rows into tiles
+  ttb_indx ntile = 0;
+  if (heavy_nnz < nnz)
+    Kokkos::parallel_reduce("mttkrp_kernel_perm_rowptr_count_heavy",
+                            RangePolicy(0,nrow),
+                            KOKKOS_LAMBDA(const ttb_indx row, ttb_indx& nt)
+    {
+      const ttb_indx len =
+        X.getPermRowPtr(row+1,n) - X.getPermRowPtr(row,n);
+      if (len > heavy_nnz)
+        nt += (len+RowBlockSize-1)/RowBlockSize;
+    }, ntile);
+  if (ntile == 0) {
+    timer.finalize();
+    return;
+  }
+
+  IndxView tile_row(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                       "tile_row"), ntile);
+  IndxView tile_beg(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                       "tile_beg"), ntile);
+  Kokkos::parallel_scan("mttkrp_kernel_perm_rowptr_heavy_tiles",
+                        RangePolicy(0,nrow),
+                        KOKKOS_LAMBDA(const ttb_indx row, ttb_indx& offset,
+                                      const bool final)
+  {
+    const ttb_indx i_beg = X.getPermRowPtr(row,n);
+    const ttb_indx len = X.getPermRowPtr(row+1,n) - i_beg;
+    if (len > heavy_nnz) {
+      const ttb_indx nt = (len+RowBlockSize-1)/RowBlockSize;
+      if (final) {
+        for (ttb_indx k=0; k<nt; ++k) {
+          tile_row(offset+k) = row;
+          tile_beg(offset+k) = i_beg + k*RowBlockSize;
+        }
+      }
+      offset += nt;
+    }
+  });
+
+  // Private partial sums for each tile of the heavy rows
+  Kokkos::View<ttb_real**,Kokkos::LayoutRight,ExecSpace> partial(
+    Kokkos::view_alloc(Kokkos::WithoutInitializing,"partial"), ntile, nc);
+  const ttb_indx NT = (ntile+TeamSize-1)/TeamSize;
+  Policy tile_policy(NT, TeamSize, VectorSize);
+  Kokkos::parallel_for(tile_policy, KOKKOS_LAMBDA(const TeamMember& team)
+  {
+    const ttb_indx t = team.league_rank()*TeamSize + team.team_rank();
+    if (t >= ntile)
+      return;
+
+    const double t0 = timer.start();
+    const ttb_indx row = tile_row(t);
+    const ttb_indx i_beg = tile_beg(t);
+    const ttb_indx i_row_end = X.getPermRowPtr(row+1,n);
+    const ttb_indx i_end =
+      i_beg+RowBlockSize < i_row_end ? i_beg+RowBlockSize : i_row_end;
+
+    auto row_func = [&](auto j, auto nj, auto Nj) {
+      typedef TinyVec<ExecSpace, ttb_real, unsigned, FacBlockSize, Nj(), VectorSize> TV;
+      TV val(nj, 0.0), tmp(nj, 0.0);
+      mttkrp_perm_add_nonzeros(val, tmp, X, u, n, j, i_beg, i_end);
+      val.store(&partial(t,j));
+    };
+
+    for (unsigned j=0; j<nc; j+=FacBlockSize) {
+      if (j+FacBlockSize <= nc) {
+        const unsigned nj = FacBlockSize;
+        row_func(j, nj, std::integral_constant<unsigned,nj>());
+      }
+      else {
+        const unsigned nj = nc-j;
+        row_func(j, nj, std::integral_constant<unsigned,0>());
+      }
+    }
+
+    timer.stop(t0);
+  }, "mttkrp_kernel_perm_rowptr_heavy");
+
+  // Sum the partial sums of each heavy row in order
+  Kokkos::parallel_for(tile_policy, KOKKOS_LAMBDA(const TeamMember& team)
+  {
+    const ttb_indx t = team.league_rank()*TeamSize + team.team_rank();
+    if (t >= ntile || (t > 0 && tile_row(t-1) == tile_row(t)))
+      return;
+
+    const ttb_indx row = tile_row(t);
+    auto row_func = [&](auto j, auto nj, auto Nj) {
+      typedef TinyVec<ExecSpace, ttb_real, unsigned, FacBlockSize, Nj(), VectorSize> TV;
+      TV val(nj, 0.0), tmp(nj, 0.0);
+      for (ttb_indx k=t; k<ntile && tile_row(k) == row; ++k) {
+        tmp.load(&partial(k,j));
+        val += tmp;
+      }
+      val.store(&v.entry(row,j));
+    };
+
+    for (unsigned j=0; j<nc; j+=FacBlockSize) {
+      if (j+FacBlockSize <= nc) {
+        const unsigned nj = FacBlockSize;
+        row_func(j, nj, std::integral_constant<unsigned,nj>());
+      }
+      else {
+        const unsigned nj = nc-j;
+        row_func(j, nj, std::integral_constant<unsigned,0>());
+      }
+    }
+  }, "mttkrp_kernel_perm_rowptr_heavy_sum");
+
+  timer.finalize();
+}
+
 // MTTKRP kernel for Sptensor_perm
 template <unsigned FBS, unsigned VS, typename ExecSpace>
 void
@@ -177,6 +615,12 @@ mttkrp_kernel_perm(const SptensorT<ExecSpace>& X,
                    const FacMatrixT<ExecSpace>& v,
                    const AlgParams& algParams)
 {
+  // Use the deterministic algorithm if row pointers are available
+  if (X.havePermRowPtr()) {
+    mttkrp_kernel_perm_rowptr<FBS,VS>(X,u,n,v,algParams);
+    return;
+  }
+
   v = ttb_real(0.0);
 
   static const bool is_cuda = Genten::is_cuda_space<ExecSpace>::value;
@@ -249,9 +693,787 @@ mttkrp_kernel_perm(const SptensorT<ExecSpace>& X,
         }
       }
 
-      // Sum in last row
-      if (row != invalid_row) {
-        Kokkos::atomic_add(&v.entry(row,j), val);
+      // Sum in last row
+      if (row != invalid_row) {
+        Kokkos::atomic_add(&v.entry(row,j), val);
+      }
+    };
+
+    for (unsigned j=0; j<nc; j+=FacBlockSize) {
+      if (j+FacBlockSize <= nc) {
+        const unsigned nj = FacBlockSize;
+        row_func(j, nj, std::integral_constant<unsigned,nj>());
+      }
+      else {
+        const unsigned nj = nc-j;
+        row_func(j, nj, std::integral_constant<unsigned,0>());
+      }
+    }
+  }, "mttkrp_kernel");
+}
+
+// MTTKRP kernel for coordinate-format sparse tensors on the host that hides
+// the latency of the factor matrix row gathers, which the hardware
+// prefetcher cannot predict.  Each thread processes a tile of
+// mttkrp_nnz_tile_size nonzeros, one block of columns at a time.  The factor
+// rows of the tile are first gathered into scratch while prefetching the
+// rows mttkrp_prefetch_distance nonzeros ahead, and then multiplied and
+// added into the result, prefetching the result rows the same distance
+// ahead.
+template <int Dupl, int Cont, unsigned FBS, unsigned ND = 0,
+          typename SparseTensor, typename Ktensor, typename ExecSpace>
+void
+mttkrp_kernel_prefetch(const SparseTensor& X,
+                       const Ktensor& u,
+                       const unsigned n,
+                       const FacMatrixT<ExecSpace>& v,
+                       const AlgParams& algParams)
+{
+  v = ttb_real(0.0);
+
+  using Kokkos::Experimental::create_scatter_view;
+  using Kokkos::Experimental::ScatterSum;
+
+  // Limit the column block so the gathered rows of a tile stay in cache
+  static const unsigned FacBlockSize = FBS < 32 ? FBS : 32;
+  static const unsigned LineSize = GENTEN_MEMORY_ALIGNMENT/sizeof(ttb_real);
+  const unsigned TileSize = algParams.mttkrp_nnz_tile_size;
+  const ttb_indx dist = algParams.mttkrp_prefetch_distance;
+
+  const Kokkos::Impl::integral_nonzero_constant<unsigned,ND> nd(u.ndims());
+  /*const*/ unsigned nc = u.ncomponents();
+  /*const*/ ttb_indx nnz = X.nnz();
+  const ttb_indx N = (nnz+TileSize-1)/TileSize;
+
+  typedef Kokkos::TeamPolicy<ExecSpace> Policy;
+  typedef typename Policy::member_type TeamMember;
+  typedef Kokkos::View< ttb_real***, Kokkos::LayoutRight, typename ExecSpace::scratch_memory_space , Kokkos::MemoryUnmanaged > RowScratchSpace;
+  const size_t bytes =
+    RowScratchSpace::shmem_size(TileSize,nd.value,FacBlockSize);
+  Policy policy(N, 1, 1);
+
+  auto vv = v.view();
+  auto sv = create_scatter_view<ScatterSum,Dupl,Cont>(vv);
+  Kokkos::parallel_for(policy.set_scratch_size(0,Kokkos::PerThread(bytes)),
+                       KOKKOS_LAMBDA(const TeamMember& team)
+  {
+    auto va = sv.access();
+    const auto& uu = local_replica(u);
+    RowScratchSpace rows(team.thread_scratch(0), TileSize, nd.value,
+                         FacBlockSize);
+
+    const ttb_indx i_beg = ttb_indx(team.league_rank())*TileSize;
+    const unsigned nt =
+      i_beg+TileSize <= nnz ? TileSize : unsigned(nnz-i_beg);
+
+    for (unsigned j=0; j<nc; j+=FacBlockSize) {
+      const unsigned nj = j+FacBlockSize <= nc ? FacBlockSize : nc-j;
+
+      // Gather phase
+      for (unsigned ii=0; ii<nt; ++ii) {
+        const ttb_indx i = i_beg+ii;
+        if (dist > 0 && i+dist < nnz) {
+          for (unsigned m=0; m<nd.value; ++m) {
+            if (m != n) {
+              const ttb_indx k = X.subscript(i+dist,m);
+              for (unsigned l=0; l<nj; l+=LineSize)
+                GENTEN_PREFETCH(&(uu[m].entry(k,j+l)), 0);
+            }
+          }
+        }
+        for (unsigned m=0; m<nd.value; ++m) {
+          if (m != n) {
+            const ttb_indx k = X.subscript(i,m);
+            for (unsigned l=0; l<nj; ++l)
+              rows(ii,m,l) = uu[m].entry(k,j+l);
+          }
+        }
+      }
+
+      // Multiply phase
+      for (unsigned ii=0; ii<nt; ++ii) {
+        const ttb_indx i = i_beg+ii;
+        if (dist > 0 && i+dist < nnz) {
+          const ttb_indx k = X.subscript(i+dist,n);
+          for (unsigned l=0; l<nj; l+=LineSize)
+            GENTEN_PREFETCH(&(vv(k,j+l)), 1);
+        }
+        const ttb_indx k = X.subscript(i,n);
+        const ttb_real x_val = X.value(i);
+        ttb_real tmp[FacBlockSize];
+        for (unsigned l=0; l<nj; ++l)
+          tmp[l] = x_val*uu.weights(j+l);
+        for (unsigned m=0; m<nd.value; ++m) {
+          if (m != n)
+            for (unsigned l=0; l<nj; ++l)
+              tmp[l] *= rows(ii,m,l);
+        }
+        for (unsigned l=0; l<nj; ++l)
+          va(k,j+l) += tmp[l];
+      }
+    }
+  }, "mttkrp_kernel_prefetch");
+
+  sv.contribute_into(vv);
+}
+
+// MTTKRP for coordinate-format sparse tensors using the single, atomic,
+// duplicated or prefetch methods.  ND is the tensor order if known at
+// compile time and 0 otherwise.
+template <unsigned FBS, unsigned VS, unsigned ND = 0,
+          typename SparseTensor, typename Ktensor, typename ExecSpace>
+void
+mttkrp_coo(const MTTKRP_Method::type method,
+           const SparseTensor& X,
+           const Ktensor& u,
+           const unsigned n,
+           const FacMatrixT<ExecSpace>& v,
+           const AlgParams& algParams)
+{
+  using Kokkos::Experimental::ScatterDuplicated;
+  using Kokkos::Experimental::ScatterNonDuplicated;
+  using Kokkos::Experimental::ScatterAtomic;
+  using Kokkos::Experimental::ScatterNonAtomic;
+
+  if (method == MTTKRP_Method::Single)
+    mttkrp_kernel<ScatterNonDuplicated,ScatterNonAtomic,FBS,VS,ND>(
+      X,u,n,v,algParams);
+  else if (method == MTTKRP_Method::Atomic)
+    mttkrp_kernel<ScatterNonDuplicated,ScatterAtomic,FBS,VS,ND>(
+      X,u,n,v,algParams);
+  else if (method == MTTKRP_Method::Duplicated) {
+    // Only use "Duplicated" if the mode length * concurrency is sufficiently
+    // small.  Taken from "Sparse Tensor Factorization on Many-Core Processors
+    // with High-Bandwidth Memory" by Smith, Park and Karypis.  It's not
+    // clear this is really the right choice.  Seems like it should also take
+    // into account R = u.ncomponents() and last-level cache size.
+    const ttb_indx P = SpaceProperties<ExecSpace>::concurrency();
+    const ttb_indx nnz = X.nnz();
+    const ttb_indx N = X.size(n);
+    const ttb_real gamma = algParams.mttkrp_duplicated_threshold;
+    if (gamma < 0.0 || (static_cast<ttb_real>(N*P) <= gamma*nnz))
+      mttkrp_kernel<ScatterDuplicated,ScatterNonAtomic,FBS,VS,ND>(
+        X,u,n,v,algParams);
+    else
+      mttkrp_kernel<ScatterNonDuplicated,ScatterAtomic,FBS,VS,ND>(
+        X,u,n,v,algParams);
+  }
+  else if (method == MTTKRP_Method::Prefetch) {
+    if (SpaceProperties<ExecSpace>::concurrency() == 1)
+      mttkrp_kernel_prefetch<ScatterNonDuplicated,ScatterNonAtomic,FBS,ND>(
+        X,u,n,v,algParams);
+    else
+      mttkrp_kernel_prefetch<ScatterNonDuplicated,ScatterAtomic,FBS,ND>(
+        X,u,n,v,algParams);
+  }
+}
+
+template <typename ExecSpace>
+struct MTTKRP_Kernel {
+  const SptensorT<ExecSpace> X;
+  const KtensorT<ExecSpace> u;
+  const ttb_indx n;
+  const FacMatrixT<ExecSpace> v;
+  const AlgParams algParams;
+
+  MTTKRP_Kernel(const SptensorT<ExecSpace>& X_,
+                const KtensorT<ExecSpace>& u_,
+                const ttb_indx n_,
+                const FacMatrixT<ExecSpace>& v_,
+                const AlgParams& algParams_) :
+    X(X_), u(u_), n(n_), v(v_), algParams(algParams_) {}
+
+  template <unsigned FBS, unsigned VS>
+  void run() const {
+    typedef SpaceProperties<ExecSpace> space_prop;
+
+    MTTKRP_Method::type method = algParams.mttkrp_method;
+
+    if (space_prop::is_cuda &&
+        (method == MTTKRP_Method::Single ||
+         method == MTTKRP_Method::Duplicated ||
+         method == MTTKRP_Method::Prefetch))
+      Genten::error("Single, duplicated and prefetch MTTKRP methods are invalid on Cuda!");
+
+    // Check if Perm is selected, that perm is computed
+    if (method == MTTKRP_Method::Perm && !X.havePerm())
+      Genten::error("Perm MTTKRP method selected, but permutation array not computed!");
+
+    if (method == MTTKRP_Method::Perm)
+      mttkrp_kernel_perm<FBS,VS>(X,u,n,v,algParams);
+    else
+      run_order_kernel(X.ndims(), [&](auto ND) {
+        mttkrp_coo<FBS,VS,ND()>(method,X,u,n,v,algParams);
+      });
+  }
+};
+
+// Used for SptensorNarrowT with KtensorT, for mixed precision SptensorNarrowT
+// with float values and KtensorNarrowT, and for replicated factor matrices
+// any coordinate-format tensor with KtensorReplicatedT
+template <typename SparseTensor, typename Ktensor>
+struct MTTKRP_Narrow_Kernel {
+  typedef typename SparseTensor::exec_space ExecSpace;
+
+  const SparseTensor X;
+  const Ktensor u;
+  const ttb_indx n;
+  const FacMatrixT<ExecSpace> v;
+  const AlgParams algParams;
+
+  MTTKRP_Narrow_Kernel(const SparseTensor& X_,
+                       const Ktensor& u_,
+                       const ttb_indx n_,
+                       const FacMatrixT<ExecSpace>& v_,
+                       const AlgParams& algParams_) :
+    X(X_), u(u_), n(n_), v(v_), algParams(algParams_) {}
+
+  template <unsigned FBS, unsigned VS>
+  void run() const {
+    typedef SpaceProperties<ExecSpace> space_prop;
+
+    MTTKRP_Method::type method = algParams.mttkrp_method;
+
+    if (space_prop::is_cuda &&
+        (method == MTTKRP_Method::Single ||
+         method == MTTKRP_Method::Duplicated ||
+         method == MTTKRP_Method::Prefetch))
+      Genten::error("Single, duplicated and prefetch MTTKRP methods are invalid on Cuda!");
+
+    if (method != MTTKRP_Method::Single &&
+        method != MTTKRP_Method::Atomic &&
+        method != MTTKRP_Method::Duplicated &&
+        method != MTTKRP_Method::Prefetch)
+      Genten::error(std::string("MTTKRP method ") +
+                    MTTKRP_Method::names[method] +
+                    " is not supported for narrow subscripts, mixed precision or replicated factor matrices!");
+
+    mttkrp_coo<FBS,VS>(method,X,u,n,v,algParams);
+  }
+};
+
+// MTTKRP kernel for SptensorCSF
+/* Each thread traverses the subtree of one root node depth-first.  For
+   levels above the level d of the target mode, pre(l) holds the Hadamard
+   product of the weights and the factor rows along the path to the current
+   node.  For levels at or below d, acc(l) accumulates the contribution of
+   the subtree of the current node, which is folded into the parent when
+   the node is finished.  The result row is updated once per node at
+   level d, atomically unless d == 0.
+*/
+template <unsigned FBS, unsigned VS, typename ExecSpace>
+void
+mttkrp_kernel_csf(const CSFTreeT<ExecSpace>& tree,
+                  const KtensorT<ExecSpace>& u,
+                  const unsigned n,
+                  const FacMatrixT<ExecSpace>& v,
+                  const AlgParams&)
+{
+  v = ttb_real(0.0);
+
+  static const bool is_cuda = Genten::is_cuda_space<ExecSpace>::value;
+  static const unsigned FacBlockSize = FBS;
+  static const unsigned VectorSize = is_cuda ? VS : 1;
+  static const unsigned TeamSize = is_cuda ? 128/VectorSize : 1;
+
+  typedef Kokkos::TeamPolicy<ExecSpace, Kokkos::Schedule<Kokkos::Dynamic> > Policy;
+  typedef typename Policy::member_type TeamMember;
+  typedef Kokkos::View< ttb_real***, Kokkos::LayoutRight, typename ExecSpace::scratch_memory_space , Kokkos::MemoryUnmanaged > TmpScratchSpace;
+  typedef Kokkos::View< ttb_indx***, Kokkos::LayoutRight, typename ExecSpace::scratch_memory_space , Kokkos::MemoryUnmanaged > IndxScratchSpace;
+
+  /*const*/ unsigned nd = tree.nlevels();
+  /*const*/ unsigned nc = u.ncomponents();
+  /*const*/ unsigned d = tree.level_host(n);
+  /*const*/ unsigned L = nd-1;
+  /*const*/ ttb_indx nroot = tree.nnodes_host(0);
+  const ttb_indx N = (nroot+TeamSize-1)/TeamSize;
+  const size_t bytes =
+    TmpScratchSpace::shmem_size(TeamSize,2*nd,FacBlockSize) +
+    IndxScratchSpace::shmem_size(TeamSize,2,nd);
+
+  Policy policy(N, TeamSize, VectorSize);
+  Kokkos::parallel_for(policy.set_scratch_size(0,Kokkos::PerTeam(bytes)),
+                       KOKKOS_LAMBDA(const TeamMember& team)
+  {
+    const unsigned t = team.team_rank();
+    TmpScratchSpace tmp(team.team_scratch(0), TeamSize, 2*nd, FacBlockSize);
+    IndxScratchSpace stack(team.team_scratch(0), TeamSize, 2, nd);
+    const ttb_indx r = team.league_rank()*TeamSize + t;
+    if (r >= nroot)
+      return;
+
+    // acc(l,jj) = tmp(t,l,jj), pre(l,jj) = tmp(t,nd+l,jj)
+    // it(l) = stack(t,0,l) is the current node at level l and
+    // ed(l) = stack(t,1,l) is one past the last sibling
+    auto vec = [&](const unsigned nj, const auto& f) {
+      Kokkos::parallel_for(Kokkos::ThreadVectorRange(team,nj), f);
+    };
+
+    for (unsigned j=0; j<nc; j+=FacBlockSize) {
+      const unsigned nj = j+FacBlockSize <= nc ? FacBlockSize : nc-j;
+
+      // Initialize node it(l) at level l
+      auto start = [&](const unsigned l) {
+        const ttb_indx i = stack(t,0,l);
+        if (l >= d) {
+          vec(nj, [&](const unsigned& jj) { tmp(t,l,jj) = 0.0; });
+        }
+        else {
+          const ttb_real *row = &(u[tree.mode(l)].entry(tree.id(l,i),j));
+          if (l == 0)
+            vec(nj, [&](const unsigned& jj)
+            {
+              tmp(t,nd,jj) = u.weights(j+jj)*row[jj];
+            });
+          else
+            vec(nj, [&](const unsigned& jj)
+            {
+              tmp(t,nd+l,jj) = tmp(t,nd+l-1,jj)*row[jj];
+            });
+        }
+        if (l < L) {
+          stack(t,0,l+1) = tree.child_begin(l,i);
+          stack(t,1,l+1) = tree.child_end(l,i);
+        }
+      };
+
+      unsigned l = 0;
+      stack(t,0,0) = r;
+      stack(t,1,0) = r+1;
+      start(0);
+      bool done = false;
+      while (!done) {
+        if (l < L-1) {
+          ++l;
+          start(l);
+          continue;
+        }
+
+        // Process the nonzeros below the current node at level L-1
+        const ttb_indx i = stack(t,0,l);
+        const ttb_indx kb = tree.child_begin(l,i);
+        const ttb_indx ke = tree.child_end(l,i);
+        for (ttb_indx k=kb; k<ke; ++k) {
+          const ttb_real x_val = tree.value(k);
+          const ttb_indx row_idx = tree.id(L,k);
+          if (d == L) {
+            ttb_real *v_row = &(v.entry(row_idx,j));
+            vec(nj, [&](const unsigned& jj)
+            {
+              Kokkos::atomic_add(v_row+jj, x_val*tmp(t,nd+L-1,jj));
+            });
+          }
+          else {
+            const ttb_real *row = &(u[tree.mode(L)].entry(row_idx,j));
+            vec(nj, [&](const unsigned& jj)
+            {
+              tmp(t,L-1,jj) += x_val*row[jj];
+            });
+          }
+        }
+
+        // Finish nodes until one has a remaining sibling
+        while (true) {
+          const ttb_indx il = stack(t,0,l);
+          if (l == d) {
+            ttb_real *v_row = &(v.entry(tree.id(l,il),j));
+            if (d == 0)
+              vec(nj, [&](const unsigned& jj)
+              {
+                v_row[jj] = tmp(t,0,jj)*u.weights(j+jj);
+              });
+            else
+              vec(nj, [&](const unsigned& jj)
+              {
+                Kokkos::atomic_add(v_row+jj, tmp(t,d,jj)*tmp(t,nd+d-1,jj));
+              });
+          }
+          else if (l > d) {
+            const ttb_real *row = &(u[tree.mode(l)].entry(tree.id(l,il),j));
+            vec(nj, [&](const unsigned& jj)
+            {
+              tmp(t,l-1,jj) += tmp(t,l,jj)*row[jj];
+            });
+          }
+          if (l == 0) {
+            done = true;
+            break;
+          }
+          stack(t,0,l) = il+1;
+          if (il+1 < stack(t,1,l)) {
+            start(l);
+            break;
+          }
+          --l;
+        }
+      }
+    }
+  }, "mttkrp_kernel_csf");
+}
+
+template <typename ExecSpace>
+struct MTTKRP_CSF_Kernel {
+  const CSFTreeT<ExecSpace> tree;
+  const KtensorT<ExecSpace> u;
+  const ttb_indx n;
+  const FacMatrixT<ExecSpace> v;
+  const AlgParams algParams;
+
+  // Use the tree rooted at mode n if there is one, otherwise the first tree
+  static CSFTreeT<ExecSpace> choose_tree(const SptensorCSFT<ExecSpace>& X,
+                                         const ttb_indx n) {
+    const ttb_indx t = X.rootTree(n);
+    return X.tree(t == ttb_indx(-1) ? 0 : t);
+  }
+
+  MTTKRP_CSF_Kernel(const SptensorCSFT<ExecSpace>& X_,
+                    const KtensorT<ExecSpace>& u_,
+                    const ttb_indx n_,
+                    const FacMatrixT<ExecSpace>& v_,
+                    const AlgParams& algParams_) :
+    tree(choose_tree(X_,n_)), u(u_), n(n_), v(v_), algParams(algParams_) {}
+
+  template <unsigned FBS, unsigned VS>
+  void run() const {
+    mttkrp_kernel_csf<FBS,VS>(tree,u,n,v,algParams);
+  }
+};
+
+// MTTKRP kernel for SptensorHiCOO
+/* Each thread processes one block of nonzeros, so the factor matrix rows
+   it reads and the result rows it updates all lie within a 2^b row tile of
+   each matrix.  Consecutive nonzeros with the same row are summed before
+   the (atomic) update, which for the leading mode of the block ordering
+   removes most of the atomics.
+*/
+template <unsigned FBS, unsigned VS, typename ExecSpace>
+void
+mttkrp_kernel_hicoo(const SptensorHiCOOT<ExecSpace>& X,
+                    const KtensorT<ExecSpace>& u,
+                    const unsigned n,
+                    const FacMatrixT<ExecSpace>& v,
+                    const AlgParams&)
+{
+  v = ttb_real(0.0);
+
+  static const bool is_cuda = Genten::is_cuda_space<ExecSpace>::value;
+  static const unsigned FacBlockSize = FBS;
+  static const unsigned VectorSize = is_cuda ? VS : 1;
+  static const unsigned TeamSize = is_cuda ? 128/VectorSize : 1;
+
+  /*const*/ unsigned nd = u.ndims();
+  /*const*/ unsigned nc = u.ncomponents();
+  /*const*/ ttb_indx nb = X.nblocks();
+  const ttb_indx N = (nb+TeamSize-1)/TeamSize;
+
+  typedef Kokkos::TeamPolicy<ExecSpace, Kokkos::Schedule<Kokkos::Dynamic> > Policy;
+  typedef typename Policy::member_type TeamMember;
+  Policy policy(N, TeamSize, VectorSize);
+  Kokkos::parallel_for(policy, KOKKOS_LAMBDA(const TeamMember& team)
+  {
+    /*const*/ ttb_indx invalid_row = ttb_indx(-1);
+    /*const*/ ttb_indx blk = team.league_rank()*TeamSize + team.team_rank();
+    if (blk >= nb)
+      return;
+
+    const ttb_indx i_begin = X.block_begin(blk);
+    const ttb_indx i_end = X.block_end(blk);
+
+    auto row_func = [&](auto j, auto nj, auto Nj) {
+      typedef TinyVec<ExecSpace, ttb_real, unsigned, FacBlockSize, Nj(), VectorSize> TV;
+      TV val(nj, 0.0), tmp(nj, 0.0);
+
+      ttb_indx row_prev = invalid_row;
+      for (ttb_indx i=i_begin; i<i_end; ++i) {
+        const ttb_indx row = X.subscript(blk,i,n);
+
+        // If we got a different row index, add in result
+        if (row != row_prev) {
+          if (row_prev != invalid_row) {
+            Kokkos::atomic_add(&v.entry(row_prev,j), val);
+            val.broadcast(0.0);
+          }
+          row_prev = row;
+        }
+
+        // Start tmp equal to the weights.
+        tmp.load(&(u.weights(j)));
+        tmp *= X.value(i);
+
+        for (unsigned m=0; m<nd; ++m) {
+          if (m != n)
+            tmp *= &(u[m].entry(X.subscript(blk,i,m),j));
+        }
+        val += tmp;
+      }
+
+      // Sum in last row
+      if (row_prev != invalid_row)
+        Kokkos::atomic_add(&v.entry(row_prev,j), val);
+    };
+
+    for (unsigned j=0; j<nc; j+=FacBlockSize) {
+      if (j+FacBlockSize <= nc) {
+        const unsigned nj = FacBlockSize;
+        row_func(j, nj, std::integral_constant<unsigned,nj>());
+      }
+      else {
+        const unsigned nj = nc-j;
+        row_func(j, nj, std::integral_constant<unsigned,0>());
+      }
+    }
+  }, "mttkrp_kernel_hicoo");
+}
+
+template <typename ExecSpace>
+struct MTTKRP_HiCOO_Kernel {
+  const SptensorHiCOOT<ExecSpace> X;
+  const KtensorT<ExecSpace> u;
+  const ttb_indx n;
+  const FacMatrixT<ExecSpace> v;
+  const AlgParams algParams;
+
+  MTTKRP_HiCOO_Kernel(const SptensorHiCOOT<ExecSpace>& X_,
+                      const KtensorT<ExecSpace>& u_,
+                      const ttb_indx n_,
+                      const FacMatrixT<ExecSpace>& v_,
+                      const AlgParams& algParams_) :
+    X(X_), u(u_), n(n_), v(v_), algParams(algParams_) {}
+
+  template <unsigned FBS, unsigned VS>
+  void run() const {
+    mttkrp_kernel_hicoo<FBS,VS>(X,u,n,v,algParams);
+  }
+};
+
+template <typename ExecSpace>
+struct MTTKRP_ALTO_Kernel {
+  const SptensorALTOT<ExecSpace> X;
+  const KtensorT<ExecSpace> u;
+  const ttb_indx n;
+  const FacMatrixT<ExecSpace> v;
+  const AlgParams algParams;
+
+  MTTKRP_ALTO_Kernel(const SptensorALTOT<ExecSpace>& X_,
+                     const KtensorT<ExecSpace>& u_,
+                     const ttb_indx n_,
+                     const FacMatrixT<ExecSpace>& v_,
+                     const AlgParams& algParams_) :
+    X(X_), u(u_), n(n_), v(v_), algParams(algParams_) {}
+
+  template <unsigned FBS, unsigned VS>
+  void run() const {
+    // Nonzeros are ordered along the space-filling curve, so consecutive
+    // nonzeros rarely share a row in any mode and atomics see little
+    // contention.  This is the same kernel for every mode.
+    const MTTKRP_Method::type method =
+      SpaceProperties<ExecSpace>::concurrency() == 1 ?
+      MTTKRP_Method::Single : MTTKRP_Method::Atomic;
+    mttkrp_coo<FBS,VS>(method,X,u,n,v,algParams);
+  }
+};
+
+// MTTKRP kernel for SptensorHybrid.  Hot rows are accumulated into
+// per-thread buffers without atomics, which are then summed into v, while
+// cold rows are updated in v with atomics.
+template <unsigned FBS, unsigned VS, typename ExecSpace>
+void
+mttkrp_kernel_hybrid(const SptensorHybridT<ExecSpace>& XH,
+                     const KtensorT<ExecSpace>& u,
+                     const unsigned n,
+                     const FacMatrixT<ExecSpace>& v,
+                     const AlgParams& algParams)
+{
+  v = ttb_real(0.0);
+
+  typedef Kokkos::Experimental::UniqueToken<
+    ExecSpace, Kokkos::Experimental::UniqueTokenScope::Global> token_type;
+  typedef typename SptensorHybridT<ExecSpace>::buffer_view_type buffer_type;
+
+  static const bool is_cuda = Genten::is_cuda_space<ExecSpace>::value;
+  static const unsigned FacBlockSize = FBS;
+  static const unsigned VectorSize = is_cuda ? VS : 1;
+  static const unsigned TeamSize = is_cuda ? 128/VectorSize : 1;
+  /*const*/ unsigned RowBlockSize = algParams.mttkrp_nnz_tile_size;
+  const unsigned RowsPerTeam = TeamSize * RowBlockSize;
+
+  const SptensorT<ExecSpace> X = XH.tensor();
+  /*const*/ unsigned nd = u.ndims();
+  /*const*/ unsigned nc = u.ncomponents();
+  /*const*/ ttb_indx nnz = X.nnz();
+  /*const*/ ttb_indx H = XH.nhot(n);
+  const ttb_indx N = (nnz+RowsPerTeam-1)/RowsPerTeam;
+
+  const token_type token;
+  const ttb_indx P = token.size();
+  const buffer_type buf = XH.buffer(P*H, nc);
+
+  typedef Kokkos::TeamPolicy<ExecSpace> Policy;
+  typedef typename Policy::member_type TeamMember;
+  Policy policy(N, TeamSize, VectorSize);
+  Kokkos::parallel_for(policy, KOKKOS_LAMBDA(const TeamMember& team)
+  {
+    const ttb_indx offset =
+      (team.league_rank()*TeamSize+team.team_rank())*RowBlockSize;
+    const int t = token.acquire();
+    const ttb_indx buf_beg = t*H;
+
+    auto row_func = [&](auto j, auto nj, auto Nj) {
+      typedef TinyVec<ExecSpace, ttb_real, unsigned, FacBlockSize, Nj(), VectorSize> TV;
+      for (unsigned ii=0; ii<RowBlockSize; ++ii) {
+        const ttb_indx i = offset + ii;
+        if (i >= nnz)
+          continue;
+
+        const ttb_indx k = X.subscript(i,n);
+        const ttb_real x_val = X.value(i);
+
+        TV tmp(nj, x_val);
+        tmp *= &(u.weights(j));
+        for (unsigned m=0; m<nd; ++m) {
+          if (m != n)
+            tmp *= &(u[m].entry(X.subscript(i,m),j));
+        }
+        const int s = XH.slot(k,n);
+        if (s >= 0)
+          tmp.store_plus(&buf(buf_beg+s,j));
+        else
+          Kokkos::atomic_add(&v.entry(k,j), tmp);
+      }
+    };
+
+    for (unsigned j=0; j<nc; j+=FacBlockSize) {
+      if (j+FacBlockSize <= nc) {
+        const unsigned nj = FacBlockSize;
+        row_func(j, nj, std::integral_constant<unsigned,nj>());
+      }
+      else {
+        const unsigned nj = nc-j;
+        row_func(j, nj, std::integral_constant<unsigned,0>());
+      }
+    }
+    token.release(t);
+  }, "mttkrp_kernel_hybrid");
+
+  // Sum the thread buffers into the hot rows.  Hot rows received no atomic
+  // updates, so they can be stored directly.  The buffers are cleared as
+  // they are read, ready for the next MTTKRP.
+  Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(0,H),
+                       KOKKOS_LAMBDA(const ttb_indx s)
+  {
+    const ttb_indx k = XH.hotRow(s,n);
+    for (unsigned j=0; j<nc; ++j) {
+      ttb_real sum = 0.0;
+      for (ttb_indx t=0; t<P; ++t) {
+        sum += buf(t*H+s,j);
+        buf(t*H+s,j) = 0.0;
+      }
+      v.entry(k,j) = sum;
+    }
+  }, "mttkrp_kernel_hybrid_reduce");
+}
+
+template <typename ExecSpace>
+struct MTTKRP_Hybrid_Kernel {
+  const SptensorHybridT<ExecSpace> X;
+  const KtensorT<ExecSpace> u;
+  const ttb_indx n;
+  const FacMatrixT<ExecSpace> v;
+  const AlgParams algParams;
+
+  MTTKRP_Hybrid_Kernel(const SptensorHybridT<ExecSpace>& X_,
+                       const KtensorT<ExecSpace>& u_,
+                       const ttb_indx n_,
+                       const FacMatrixT<ExecSpace>& v_,
+                       const AlgParams& algParams_) :
+    X(X_), u(u_), n(n_), v(v_), algParams(algParams_) {}
+
+  template <unsigned FBS, unsigned VS>
+  void run() const {
+    // Per-thread buffers don't make sense with thousands of GPU threads, so
+    // just use atomics there
+    static const bool is_cuda = Genten::is_cuda_space<ExecSpace>::value;
+    if (is_cuda)
+      mttkrp_coo<FBS,VS>(MTTKRP_Method::Atomic,X.tensor(),u,n,v,algParams);
+    else
+      mttkrp_kernel_hybrid<FBS,VS>(X,u,n,v,algParams);
+  }
+};
+
+// Dimension tree kernel contracting the semi-sparse tensor vp of node p (the
+// nonzeros of the tensor if p is the root) into vc for its child c, by
+// multiplying in the factor rows of the modes of p that c doesn't hold.  If
+// c is a leaf, vc is the MTTKRP result and the weights are applied too.
+template <unsigned FBS, unsigned VS, typename ExecSpace>
+void
+mttkrp_kernel_dimtree(const SptensorDimTreeT<ExecSpace>& XT,
+                      const KtensorT<ExecSpace>& u,
+                      const ttb_indx p,
+                      const FacMatrixT<ExecSpace>& vp,
+                      const ttb_indx c,
+                      const FacMatrixT<ExecSpace>& vc,
+                      const AlgParams& algParams)
+{
+  vc = ttb_real(0.0);
+
+  static const bool is_cuda = Genten::is_cuda_space<ExecSpace>::value;
+  static const unsigned FacBlockSize = FBS;
+  static const unsigned VectorSize = is_cuda ? VS : 1;
+  static const unsigned TeamSize = is_cuda ? 128/VectorSize : 1;
+  /*const*/ unsigned RowBlockSize = algParams.mttkrp_nnz_tile_size;
+  const unsigned RowsPerTeam = TeamSize * RowBlockSize;
+
+  const SptensorT<ExecSpace> X = XT.tensor();
+  const typename SptensorDimTreeT<ExecSpace>::subs_view_type sp =
+    XT.subscripts(p);
+  const typename SptensorDimTreeT<ExecSpace>::map_view_type mc = XT.map(c);
+  const bool root = p == 0;
+  const bool leaf = XT.isLeaf(c);
+  /*const*/ unsigned pb = XT.nodeBegin(p);
+  /*const*/ unsigned pe = XT.nodeEnd(p);
+  /*const*/ unsigned cb = XT.nodeBegin(c);
+  /*const*/ unsigned ce = XT.nodeEnd(c);
+  /*const*/ unsigned nc = u.ncomponents();
+  /*const*/ ttb_indx nt = XT.ntuples(p);
+  const ttb_indx N = (nt+RowsPerTeam-1)/RowsPerTeam;
+
+  typedef Kokkos::TeamPolicy<ExecSpace> Policy;
+  typedef typename Policy::member_type TeamMember;
+  Policy policy(N, TeamSize, VectorSize);
+  Kokkos::parallel_for(policy, KOKKOS_LAMBDA(const TeamMember& team)
+  {
+    // Stride through the rows on the GPU as in mttkrp_kernel to reduce
+    // atomic contention
+    ttb_indx offset;
+    ttb_indx stride;
+    if (is_cuda) {
+      offset = team.league_rank()*TeamSize+team.team_rank();
+      stride = team.league_size()*TeamSize;
+    }
+    else {
+      offset =
+        (team.league_rank()*TeamSize+team.team_rank())*RowBlockSize;
+      stride = 1;
+    }
+
+    auto row_func = [&](auto j, auto nj, auto Nj) {
+      typedef TinyVec<ExecSpace, ttb_real, unsigned, FacBlockSize, Nj(), VectorSize> TV;
+      for (unsigned ii=0; ii<RowBlockSize; ++ii) {
+        const ttb_indx i = offset + ii*stride;
+        if (i >= nt)
+          continue;
+
+        const ttb_indx k = leaf ? sp(i,cb-pb) : mc(i);
+        TV tmp(nj, root ? X.value(i) : ttb_real(1.0));
+        if (!root)
+          tmp *= &(vp.entry(i,j));
+        for (unsigned m=pb; m<pe; ++m) {
+          if (m < cb || m >= ce)
+            tmp *= &(u[m].entry(sp(i,m-pb),j));
+        }
+        if (leaf)
+          tmp *= &(u.weights(j));
+        Kokkos::atomic_add(&vc.entry(k,j), tmp);
       }
     };
 
@@ -265,68 +1487,59 @@ mttkrp_kernel_perm(const SptensorT<ExecSpace>& X,
         row_func(j, nj, std::integral_constant<unsigned,0>());
       }
     }
-  }, "mttkrp_kernel");
+  }, "mttkrp_kernel_dimtree");
 }
 
 template <typename ExecSpace>
-struct MTTKRP_Kernel {
-  const SptensorT<ExecSpace> X;
+struct MTTKRP_DimTree_Kernel {
+  const SptensorDimTreeT<ExecSpace>& X;
   const KtensorT<ExecSpace> u;
   const ttb_indx n;
   const FacMatrixT<ExecSpace> v;
   const AlgParams algParams;
 
-  MTTKRP_Kernel(const SptensorT<ExecSpace>& X_,
-                const KtensorT<ExecSpace>& u_,
-                const ttb_indx n_,
-                const FacMatrixT<ExecSpace>& v_,
-                const AlgParams& algParams_) :
+  MTTKRP_DimTree_Kernel(const SptensorDimTreeT<ExecSpace>& X_,
+                        const KtensorT<ExecSpace>& u_,
+                        const ttb_indx n_,
+                        const FacMatrixT<ExecSpace>& v_,
+                        const AlgParams& algParams_) :
     X(X_), u(u_), n(n_), v(v_), algParams(algParams_) {}
 
   template <unsigned FBS, unsigned VS>
   void run() const {
-    using Kokkos::Experimental::ScatterDuplicated;
-    using Kokkos::Experimental::ScatterNonDuplicated;
-    using Kokkos::Experimental::ScatterAtomic;
-    using Kokkos::Experimental::ScatterNonAtomic;
-    typedef SpaceProperties<ExecSpace> space_prop;
-
-    MTTKRP_Method::type method = algParams.mttkrp_method;
-
-    if (space_prop::is_cuda &&
-        (method == MTTKRP_Method::Single ||
-         method == MTTKRP_Method::Duplicated))
-      Genten::error("Single and duplicated MTTKRP methods are invalid on Cuda!");
+    const ttb_indx nc = u.ncomponents();
+    const ttb_indx l = X.leaf(n);
 
-    // Check if Perm is selected, that perm is computed
-    if (method == MTTKRP_Method::Perm && !X.havePerm())
-      Genten::error("Perm MTTKRP method selected, but permutation array not computed!");
+    // The root is the only leaf of an order 1 tensor
+    if (l == 0) {
+      mttkrp_coo<FBS,VS>(MTTKRP_Method::Atomic,X.tensor(),u,n,v,algParams);
+      return;
+    }
 
-    if (method == MTTKRP_Method::Single)
-      mttkrp_kernel<ScatterNonDuplicated,ScatterNonAtomic,FBS,VS>(
-        X,u,n,v,algParams);
-    else if (method == MTTKRP_Method::Atomic)
-      mttkrp_kernel<ScatterNonDuplicated,ScatterAtomic,FBS,VS>(
-        X,u,n,v,algParams);
-    else if (method == MTTKRP_Method::Duplicated) {
-      // Only use "Duplicated" if the mode length * concurrency is sufficiently
-      // small.  Taken from "Sparse Tensor Factorization on Many-Core Processors
-      // with High-Bandwidth Memory" by Smith, Park and Karypis.  It's not
-      // clear this is really the right choice.  Seems like it should also take
-      // into account R = u.ncomponents() and last-level cache size.
-      const ttb_indx P = SpaceProperties<ExecSpace>::concurrency();
-      const ttb_indx nnz = X.nnz();
-      const ttb_indx N = X.size(n);
-      const ttb_real gamma = algParams.mttkrp_duplicated_threshold;
-      if (gamma < 0.0 || (static_cast<ttb_real>(N*P) <= gamma*nnz))
-        mttkrp_kernel<ScatterDuplicated,ScatterNonAtomic,FBS,VS>(
-          X,u,n,v,algParams);
-      else
-        mttkrp_kernel<ScatterNonDuplicated,ScatterAtomic,FBS,VS>(
-          X,u,n,v,algParams);
+    // Walk down from the root to leaf n, reusing cached semi-sparse tensors
+    // that are up to date and computing the rest from their parents
+    std::vector<ttb_indx> path;
+    for (ttb_indx k=l; k!=0; k=X.parent(k))
+      path.push_back(k);
+    ttb_indx p = 0;
+    FacMatrixT<ExecSpace> vp;
+    for (auto it=path.rbegin(); it!=path.rend(); ++it) {
+      const ttb_indx c = *it;
+      if (c == l)
+        mttkrp_kernel_dimtree<FBS,VS>(X,u,p,vp,c,v,algParams);
+      else {
+        const bool cached = X.cached(c,nc);
+        const FacMatrixT<ExecSpace> vc = cached ? X.values(c,nc) :
+          FacMatrixT<ExecSpace>(X.ntuples(c),nc);
+        if (!cached || !X.valid(c)) {
+          mttkrp_kernel_dimtree<FBS,VS>(X,u,p,vp,c,vc,algParams);
+          if (cached)
+            X.setValid(c);
+        }
+        vp = vc;
+      }
+      p = c;
     }
-    else if (method == MTTKRP_Method::Perm)
-      mttkrp_kernel_perm<FBS,VS>(X,u,n,v,algParams);
   }
 };
 
@@ -347,6 +1560,14 @@ struct MTTKRP_All_Kernel {
 
   template <unsigned FBS, unsigned VS>
   void run() const {
+    run_order_kernel(uu.ndims(), [&](auto ND) {
+      this->template run_order<FBS,VS,ND()>();
+    });
+  }
+
+  // Tensor order is ND if ND > 0 and uu.ndims() otherwise
+  template <unsigned FBS, unsigned VS, unsigned ND>
+  void run_order() const {
     const SptensorT<ExecSpace> X = XX;
     const KtensorT<ExecSpace> u = uu;
     const KtensorT<ExecSpace> v = vv;
@@ -366,7 +1587,7 @@ struct MTTKRP_All_Kernel {
 
     static_assert(!is_cuda, "Cannot call mttkrp_all_kernel for Cuda space!");
 
-    /*const*/ unsigned nd = u.ndims();
+    const Kokkos::Impl::integral_nonzero_constant<unsigned,ND> nd(u.ndims());
     /*const*/ unsigned nc_total = u.ncomponents();
     /*const*/ ttb_indx nnz = X.nnz();
     const ttb_indx N = (nnz+RowsPerTeam-1)/RowsPerTeam;
@@ -385,8 +1606,8 @@ struct MTTKRP_All_Kernel {
       const unsigned nc =
         nc_beg+FacTileSize <= nc_total ? FacTileSize : nc_total-nc_beg;
       const unsigned nc_end = nc_beg+nc;
-      ScatterViewType *sa = new ScatterViewType[nd];
-      for (unsigned n=0; n<nd; ++n) {
+      ScatterViewType *sa = new ScatterViewType[nd.value];
+      for (unsigned n=0; n<nd.value; ++n) {
         auto vv = Kokkos::subview(v[n].view(),Kokkos::ALL,
                                   std::make_pair(nc_beg,nc_end));
         sa[n] = ScatterViewType(vv);
@@ -420,12 +1641,12 @@ struct MTTKRP_All_Kernel {
             const ttb_real x_val = X.value(i);
 
             // MTTKRP for dimension n
-            for (unsigned n=0; n<nd; ++n) {
+            for (unsigned n=0; n<nd.value; ++n) {
               const ttb_indx k = X.subscript(i,n);
               auto va = sa[n].access();
               TV tmp(nj, x_val);
               tmp *= &(u.weights(nc_beg+j));
-              for (unsigned m=0; m<nd; ++m) {
+              for (unsigned m=0; m<nd.value; ++m) {
                 if (m != n)
                   tmp *= &(u[m].entry(X.subscript(i,m),nc_beg+j));
               }
@@ -446,7 +1667,7 @@ struct MTTKRP_All_Kernel {
         }
       }, "mttkrp_all_kernel");
 
-      for (unsigned n=0; n<nd; ++n) {
+      for (unsigned n=0; n<nd.value; ++n) {
         auto vv = Kokkos::subview(v[n].view(),Kokkos::ALL,
                                   std::make_pair(nc_beg,nc_end));
         sa[n].contribute_into(vv);
@@ -476,6 +1697,14 @@ struct MTTKRP_All_Kernel<Dupl,Cont,Kokkos::Cuda> {
 
   template <unsigned FBS, unsigned VS>
   void run() const {
+    run_order_kernel(uu.ndims(), [&](auto ND) {
+      this->template run_order<FBS,VS,ND()>();
+    });
+  }
+
+  // Tensor order is ND if ND > 0 and uu.ndims() otherwise
+  template <unsigned FBS, unsigned VS, unsigned ND>
+  void run_order() const {
     const SptensorT<ExecSpace> X = XX;
     const KtensorT<ExecSpace> u = uu;
     const KtensorT<ExecSpace> v = vv;
@@ -491,7 +1720,7 @@ struct MTTKRP_All_Kernel<Dupl,Cont,Kokkos::Cuda> {
     /*const*/ unsigned RowBlockSize = algParams.mttkrp_nnz_tile_size;
     const unsigned RowsPerTeam = TeamSize * RowBlockSize;
 
-    /*const*/ unsigned nd = u.ndims();
+    const Kokkos::Impl::integral_nonzero_constant<unsigned,ND> nd(u.ndims());
     /*const*/ unsigned nc = u.ncomponents();
     /*const*/ ttb_indx nnz = X.nnz();
     const ttb_indx N = (nnz+RowsPerTeam-1)/RowsPerTeam;
@@ -520,11 +1749,11 @@ struct MTTKRP_All_Kernel<Dupl,Cont,Kokkos::Cuda> {
           const ttb_real x_val = X.value(i);
 
           // MTTKRP for dimension n
-          for (unsigned n=0; n<nd; ++n) {
+          for (unsigned n=0; n<nd.value; ++n) {
             const ttb_indx k = X.subscript(i,n);
             TV tmp(nj, x_val);
             tmp *= &(u.weights(j));
-            for (unsigned m=0; m<nd; ++m) {
+            for (unsigned m=0; m<nd.value; ++m) {
               if (m != n)
                 tmp *= &(u[m].entry(X.subscript(i,m),j));
             }
@@ -740,6 +1969,39 @@ void mttkrp(const SptensorT<ExecSpace>& X,
   if (algParams.mttkrp_method == MTTKRP_Method::OrigKokkos) {
     Impl::orig_kokkos_mttkrp(X,u,n,v);
   }
+  else if (algParams.mttkrp_method == MTTKRP_Method::CSF) {
+    // Building the CSF tree costs more than the MTTKRP itself, so callers
+    // doing repeated MTTKRPs should construct SptensorCSFT once instead
+    SptensorCSFT<ExecSpace> Xcsf(X,n);
+    mttkrp(Xcsf,u,n,v,algParams);
+  }
+  else if (algParams.mttkrp_method == MTTKRP_Method::HiCOO) {
+    // As above, callers should construct SptensorHiCOOT once instead
+    SptensorHiCOOT<ExecSpace> Xhicoo(X,algParams);
+    mttkrp(Xhicoo,u,n,v,algParams);
+  }
+  else if (algParams.mttkrp_method == MTTKRP_Method::ALTO) {
+    // As above, callers should construct SptensorALTOT once instead
+    SptensorALTOT<ExecSpace> Xalto(X);
+    mttkrp(Xalto,u,n,v,algParams);
+  }
+  else if (algParams.mttkrp_method == MTTKRP_Method::Hybrid) {
+    // As above, callers should construct SptensorHybridT once instead
+    SptensorHybridT<ExecSpace> Xhybrid(X,algParams);
+    mttkrp(Xhybrid,u,n,v,algParams);
+  }
+  else if (algParams.mttkrp_method == MTTKRP_Method::DimTree) {
+    // A single MTTKRP gets nothing from the cache, so callers doing
+    // repeated MTTKRPs should construct SptensorDimTreeT once instead
+    SptensorDimTreeT<ExecSpace> Xdimtree(X,algParams);
+    mttkrp(Xdimtree,u,n,v,algParams);
+  }
+  else if (algParams.mttkrp_method == MTTKRP_Method::GEMM) {
+    Genten::error("GEMM MTTKRP method is only valid for dense tensors!");
+  }
+  else if (algParams.mttkrp_method == MTTKRP_Method::Auto) {
+    Genten::error("Auto MTTKRP method must be resolved by tune_mttkrp()!");
+  }
   else {
     Impl::MTTKRP_Kernel<ExecSpace> kernel(X,u,n,v,algParams);
     Impl::run_row_simd_kernel(kernel, nc);
@@ -781,7 +2043,14 @@ void mttkrp_all(const SptensorT<ExecSpace>& X,
        method == MTTKRP_All_Method::Duplicated))
     Genten::error("Single and duplicated MTTKRP-All methods are invalid on Cuda!");
 
-  if (algParams.mttkrp_all_method == MTTKRP_All_Method::Iterated) {
+  if (algParams.mttkrp_all_method == MTTKRP_All_Method::Iterated &&
+      algParams.mttkrp_method == MTTKRP_Method::DimTree) {
+    // u doesn't change between modes, so all of them can share one tree
+    SptensorDimTreeT<ExecSpace> Xdimtree(X,algParams);
+    for (ttb_indx n=0; n<nd; ++n)
+      mttkrp(Xdimtree, u, n, v[n], algParams);
+  }
+  else if (algParams.mttkrp_all_method == MTTKRP_All_Method::Iterated) {
     for (ttb_indx n=0; n<nd; ++n)
       mttkrp(X, u, n, v[n], algParams);
   }
@@ -799,4 +2068,248 @@ void mttkrp_all(const SptensorT<ExecSpace>& X,
   }
 }
 
+
+template <typename ExecSpace>
+void mttkrp(const SptensorCSFT<ExecSpace>& X,
+            const KtensorT<ExecSpace>& u,
+            const ttb_indx n,
+            const FacMatrixT<ExecSpace>& v,
+            const AlgParams& algParams)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::mttkrp");
+#endif
+
+  const ttb_indx nc = u.ncomponents();     // Number of components
+  const ttb_indx nd = u.ndims();           // Number of dimensions
+
+  assert(X.ndims() == nd);
+  assert(u.isConsistent());
+  for (ttb_indx i = 0; i < nd; i++)
+  {
+    if (i != n)
+      assert(u[i].nRows() == X.size(i));
+  }
+  assert( v.nRows() == X.size(n) );
+  assert( v.nCols() == nc );
+
+  Impl::MTTKRP_CSF_Kernel<ExecSpace> kernel(X,u,n,v,algParams);
+  Impl::run_row_simd_kernel(kernel, nc);
+}
+
+template <typename ExecSpace>
+void mttkrp_all(const SptensorCSFT<ExecSpace>& X,
+                const KtensorT<ExecSpace>& u,
+                const KtensorT<ExecSpace>& v,
+                const AlgParams& algParams)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::mttkrp_all");
+#endif
+
+  const ttb_indx nd = u.ndims();           // Number of dimensions
+
+  assert(X.ndims() == nd);
+  assert(v.ndims() == nd);
+  assert(v.ncomponents() == u.ncomponents());
+
+  for (ttb_indx n=0; n<nd; ++n)
+    mttkrp(X, u, n, v[n], algParams);
+}
+
+
+template <typename ExecSpace>
+void mttkrp(const SptensorHiCOOT<ExecSpace>& X,
+            const KtensorT<ExecSpace>& u,
+            const ttb_indx n,
+            const FacMatrixT<ExecSpace>& v,
+            const AlgParams& algParams)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::mttkrp");
+#endif
+
+  const ttb_indx nc = u.ncomponents();     // Number of components
+  const ttb_indx nd = u.ndims();           // Number of dimensions
+
+  assert(X.ndims() == nd);
+  assert(u.isConsistent());
+  for (ttb_indx i = 0; i < nd; i++)
+  {
+    if (i != n)
+      assert(u[i].nRows() == X.size(i));
+  }
+  assert( v.nRows() == X.size(n) );
+  assert( v.nCols() == nc );
+
+  Impl::MTTKRP_HiCOO_Kernel<ExecSpace> kernel(X,u,n,v,algParams);
+  Impl::run_row_simd_kernel(kernel, nc);
+}
+
+
+template <typename ExecSpace, typename IndexType>
+void mttkrp(const SptensorNarrowT<ExecSpace,IndexType>& X,
+            const KtensorT<ExecSpace>& u,
+            const ttb_indx n,
+            const FacMatrixT<ExecSpace>& v,
+            const AlgParams& algParams)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::mttkrp");
+#endif
+
+  const ttb_indx nc = u.ncomponents();     // Number of components
+  const ttb_indx nd = u.ndims();           // Number of dimensions
+
+  assert(X.ndims() == nd);
+  assert(u.isConsistent());
+  for (ttb_indx i = 0; i < nd; i++)
+  {
+    if (i != n)
+      assert(u[i].nRows() == X.size(i));
+  }
+  assert( v.nRows() == X.size(n) );
+  assert( v.nCols() == nc );
+
+  Impl::MTTKRP_Narrow_Kernel< SptensorNarrowT<ExecSpace,IndexType>,
+                              KtensorT<ExecSpace> > kernel(X,u,n,v,algParams);
+  Impl::run_row_simd_kernel(kernel, nc);
+}
+
+template <typename ExecSpace, typename IndexType, typename ValueType>
+void mttkrp(const SptensorNarrowT<ExecSpace,IndexType,ValueType>& X,
+            const KtensorNarrowT<ExecSpace,ValueType>& u,
+            const ttb_indx n,
+            const FacMatrixT<ExecSpace>& v,
+            const AlgParams& algParams)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::mttkrp");
+#endif
+
+  const ttb_indx nc = u.ncomponents();     // Number of components
+  const ttb_indx nd = u.ndims();           // Number of dimensions
+
+  assert(X.ndims() == nd);
+  for (ttb_indx i = 0; i < nd; i++)
+  {
+    if (i != n)
+      assert(u.nRows(i) == X.size(i));
+  }
+  assert( v.nRows() == X.size(n) );
+  assert( v.nCols() == nc );
+
+  Impl::MTTKRP_Narrow_Kernel< SptensorNarrowT<ExecSpace,IndexType,ValueType>,
+                              KtensorNarrowT<ExecSpace,ValueType> >
+    kernel(X,u,n,v,algParams);
+  Impl::run_row_simd_kernel(kernel, nc);
+}
+
+template <typename ExecSpace, typename SparseTensor>
+void mttkrp(const SparseTensor& X,
+            const KtensorReplicatedT<ExecSpace>& u,
+            const ttb_indx n,
+            const FacMatrixT<ExecSpace>& v,
+            const AlgParams& algParams)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::mttkrp");
+#endif
+
+  const ttb_indx nc = u.ncomponents();     // Number of components
+
+  assert(X.ndims() == u.ndims());
+  assert( v.nRows() == X.size(n) );
+  assert( v.nCols() == nc );
+
+  Impl::MTTKRP_Narrow_Kernel< SparseTensor, KtensorReplicatedT<ExecSpace> >
+    kernel(X,u,n,v,algParams);
+  Impl::run_row_simd_kernel(kernel, nc);
+}
+
+
+template <typename ExecSpace>
+void mttkrp(const SptensorALTOT<ExecSpace>& X,
+            const KtensorT<ExecSpace>& u,
+            const ttb_indx n,
+            const FacMatrixT<ExecSpace>& v,
+            const AlgParams& algParams)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::mttkrp");
+#endif
+
+  const ttb_indx nc = u.ncomponents();     // Number of components
+  const ttb_indx nd = u.ndims();           // Number of dimensions
+
+  assert(X.ndims() == nd);
+  assert(u.isConsistent());
+  for (ttb_indx i = 0; i < nd; i++)
+  {
+    if (i != n)
+      assert(u[i].nRows() == X.size(i));
+  }
+  assert( v.nRows() == X.size(n) );
+  assert( v.nCols() == nc );
+
+  Impl::MTTKRP_ALTO_Kernel<ExecSpace> kernel(X,u,n,v,algParams);
+  Impl::run_row_simd_kernel(kernel, nc);
+}
+
+template <typename ExecSpace>
+void mttkrp(const SptensorHybridT<ExecSpace>& X,
+            const KtensorT<ExecSpace>& u,
+            const ttb_indx n,
+            const FacMatrixT<ExecSpace>& v,
+            const AlgParams& algParams)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::mttkrp");
+#endif
+
+  const ttb_indx nc = u.ncomponents();     // Number of components
+  const ttb_indx nd = u.ndims();           // Number of dimensions
+
+  assert(X.ndims() == nd);
+  assert(u.isConsistent());
+  for (ttb_indx i = 0; i < nd; i++)
+  {
+    if (i != n)
+      assert(u[i].nRows() == X.size(i));
+  }
+  assert( v.nRows() == X.size(n) );
+  assert( v.nCols() == nc );
+
+  Impl::MTTKRP_Hybrid_Kernel<ExecSpace> kernel(X,u,n,v,algParams);
+  Impl::run_row_simd_kernel(kernel, nc);
+}
+
+template <typename ExecSpace>
+void mttkrp(const SptensorDimTreeT<ExecSpace>& X,
+            const KtensorT<ExecSpace>& u,
+            const ttb_indx n,
+            const FacMatrixT<ExecSpace>& v,
+            const AlgParams& algParams)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::mttkrp");
+#endif
+
+  const ttb_indx nc = u.ncomponents();     // Number of components
+  const ttb_indx nd = u.ndims();           // Number of dimensions
+
+  assert(X.ndims() == nd);
+  assert(u.isConsistent());
+  for (ttb_indx i = 0; i < nd; i++)
+  {
+    if (i != n)
+      assert(u[i].nRows() == X.size(i));
+  }
+  assert( v.nRows() == X.size(n) );
+  assert( v.nCols() == nc );
+
+  Impl::MTTKRP_DimTree_Kernel<ExecSpace> kernel(X,u,n,v,algParams);
+  Impl::run_row_simd_kernel(kernel, nc);
+}
+
 }
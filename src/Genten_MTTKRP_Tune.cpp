@@ -0,0 +1,272 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#include "Genten_MTTKRP_Tune.hpp"
+#include "Genten_MixedFormatOps.hpp"
+#include "Genten_SptensorCSF.hpp"
+#include "Genten_SptensorHiCOO.hpp"
+#include "Genten_SptensorALTO.hpp"
+#include "Genten_SptensorHybrid.hpp"
+#include "Genten_SptensorDimTree.hpp"
+#include "Genten_SystemTimer.hpp"
+
+#ifdef HAVE_CALIPER
+#include <caliper/cali.h>
+#endif
+
+namespace Genten {
+namespace Impl {
+
+// Called after the MTTKRP for mode n in a timed sweep
+template <typename TensorType>
+void tune_mode_done(const TensorType&, const ttb_indx) {}
+
+// CP-ALS overwrites u[n] after each MTTKRP, invalidating cached nodes
+template <typename ExecSpace>
+void tune_mode_done(SptensorDimTreeT<ExecSpace>& X, const ttb_indx n)
+{
+  X.factorUpdated(n);
+}
+
+// Average time for a sweep of MTTKRPs over all modes, after one untimed
+// warmup sweep
+template <typename TensorType, typename ExecSpace>
+ttb_real tune_time_sweep(TensorType& X, const KtensorT<ExecSpace>& u,
+                         const KtensorT<ExecSpace>& v,
+                         const AlgParams& algParams, const ttb_indx iters)
+{
+  const ttb_indx nd = u.ndims();
+  SystemTimer timer(1, true);
+  for (ttb_indx iter=0; iter<=iters; ++iter) {
+    if (iter == 1)
+      timer.start(0);
+    for (ttb_indx n=0; n<nd; ++n) {
+      mttkrp(X, u, n, v[n], algParams);
+      tune_mode_done(X, n);
+    }
+  }
+  timer.stop(0);
+  return timer.getTotalTime(0) / iters;
+}
+
+}
+}
+
+template <typename ExecSpace>
+void Genten::tune_mttkrp(SptensorT<ExecSpace>& X, const ttb_indx nc,
+                         AlgParams& algParams, std::ostream& out)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::tune_mttkrp");
+#endif
+
+  typedef SpaceProperties<ExecSpace> space_prop;
+
+  if (algParams.mttkrp_method != MTTKRP_Method::Auto)
+    return;
+
+  const ttb_indx nd = X.ndims();
+  const ttb_indx nnz = X.nnz();
+
+  // Key identifying this problem in the tuning cache
+  std::stringstream ss;
+  ss << Solver_Method::names[algParams.method] << " " << ExecSpace::name()
+     << " " << space_prop::concurrency() << " " << nc << " "
+     << (nnz > 0 ? ttb_indx(std::log2(ttb_real(nnz))) : 0) << " " << nd;
+  for (ttb_indx n=0; n<nd; ++n)
+    ss << " " << X.size(n);
+  const std::string key = ss.str();
+
+  // Look for the key in the cache, taking the last matching entry
+  const std::string& cache_file = algParams.mttkrp_tune_cache;
+  if (cache_file != "") {
+    std::ifstream in(cache_file);
+    std::string line;
+    bool found = false;
+    while (std::getline(in, line)) {
+      if (line.compare(0, key.size()+1, key+" ") != 0)
+        continue;
+      std::istringstream ls(line.substr(key.size()+1));
+      std::string name;
+      unsigned tile = 0;
+      if (!(ls >> name >> tile) || tile == 0)
+        continue;
+      for (unsigned i=0; i<MTTKRP_Method::num_types; ++i) {
+        if (name == MTTKRP_Method::names[i] &&
+            MTTKRP_Method::types[i] != MTTKRP_Method::Auto) {
+          algParams.mttkrp_method = MTTKRP_Method::types[i];
+          algParams.mttkrp_nnz_tile_size = tile;
+          found = true;
+        }
+      }
+    }
+    if (found) {
+      if (algParams.mttkrp_method == MTTKRP_Method::Perm && !X.havePerm())
+        X.createPermutation(algParams.mttkrp_perm_row_ptrs);
+      out << "Using cached MTTKRP method "
+          << MTTKRP_Method::names[algParams.mttkrp_method]
+          << " with nonzero tile size " << algParams.mttkrp_nnz_tile_size
+          << " from " << cache_file << std::endl;
+      return;
+    }
+  }
+
+  // Candidate methods.  The sampled tensors of GCP only use the
+  // coordinate-based kernels, while CP-ALS builds any format once.
+  std::vector<MTTKRP_Method::type> methods;
+  if (space_prop::concurrency() == 1)
+    methods.push_back(MTTKRP_Method::Single);
+  else {
+    methods.push_back(MTTKRP_Method::Atomic);
+    if (!space_prop::is_cuda)
+      methods.push_back(MTTKRP_Method::Duplicated);
+  }
+  if (algParams.method == Solver_Method::CP_ALS ||
+      algParams.method == Solver_Method::CP_HALS) {
+    methods.push_back(MTTKRP_Method::Perm);
+    if (!space_prop::is_cuda) {
+      methods.push_back(MTTKRP_Method::CSF);
+      methods.push_back(MTTKRP_Method::HiCOO);
+      methods.push_back(MTTKRP_Method::ALTO);
+      methods.push_back(MTTKRP_Method::Hybrid);
+      if (nd > 2)
+        methods.push_back(MTTKRP_Method::DimTree);
+      methods.push_back(MTTKRP_Method::Prefetch);
+    }
+  }
+
+  // Nonzero tile sizes to try for the methods that use them
+  std::vector<unsigned> tiles = { 32, 128, 512 };
+  std::vector<unsigned> no_tiles = { algParams.mttkrp_nnz_tile_size };
+
+  // Constant factor matrices suffice since values do not affect timings
+  KtensorT<ExecSpace> u(nc, nd, X.size());
+  KtensorT<ExecSpace> v(nc, nd, X.size());
+  u.setWeights(1.0);
+  u.setMatrices(1.0);
+
+  const ttb_indx iters = algParams.mttkrp_tune_iters;
+  MTTKRP_Method::type best_method = methods[0];
+  unsigned best_tile = algParams.mttkrp_nnz_tile_size;
+  ttb_real best_time = std::numeric_limits<ttb_real>::max();
+  SptensorT<ExecSpace> X_perm;
+  out << "Tuning MTTKRP method (" << iters << " sweeps per candidate):"
+      << std::endl;
+  auto run_candidate = [&](auto& XX, const MTTKRP_Method::type method,
+                           const std::vector<unsigned>& tile_sizes)
+  {
+    for (const unsigned tile : tile_sizes) {
+      AlgParams ap = algParams;
+      ap.mttkrp_method = method;
+      ap.mttkrp_nnz_tile_size = tile;
+      const ttb_real t = Impl::tune_time_sweep(XX, u, v, ap, iters);
+      out << "  " << std::setw(10) << MTTKRP_Method::names[method]
+          << "  tile " << std::setw(4) << tile << ":  " << t
+          << " seconds per sweep" << std::endl;
+      if (t < best_time) {
+        best_time = t;
+        best_method = method;
+        best_tile = tile;
+      }
+    }
+  };
+  for (const MTTKRP_Method::type method : methods) {
+    if (method == MTTKRP_Method::Perm) {
+      // Shallow copy so X only keeps the permutation if perm is chosen
+      X_perm = X;
+      if (!X_perm.havePerm())
+        X_perm.createPermutation(algParams.mttkrp_perm_row_ptrs);
+      run_candidate(X_perm, method, tiles);
+    }
+    else if (method == MTTKRP_Method::CSF) {
+      SptensorCSFT<ExecSpace> X_csf(X, algParams);
+      run_candidate(X_csf, method, no_tiles);
+    }
+    else if (method == MTTKRP_Method::HiCOO) {
+      SptensorHiCOOT<ExecSpace> X_hicoo(X, algParams);
+      run_candidate(X_hicoo, method, no_tiles);
+    }
+    else if (method == MTTKRP_Method::ALTO) {
+      SptensorALTOT<ExecSpace> X_alto(X);
+      run_candidate(X_alto, method, no_tiles);
+    }
+    else if (method == MTTKRP_Method::Hybrid) {
+      SptensorHybridT<ExecSpace> X_hybrid(X, algParams);
+      run_candidate(X_hybrid, method, tiles);
+    }
+    else if (method == MTTKRP_Method::DimTree) {
+      SptensorDimTreeT<ExecSpace> X_dimtree(X, algParams);
+      run_candidate(X_dimtree, method, tiles);
+    }
+    else
+      run_candidate(X, method, tiles);
+  }
+
+  algParams.mttkrp_method = best_method;
+  algParams.mttkrp_nnz_tile_size = best_tile;
+  if (best_method == MTTKRP_Method::Perm)
+    X = X_perm;
+  out << "Selected MTTKRP method " << MTTKRP_Method::names[best_method]
+      << " with nonzero tile size " << best_tile << std::endl;
+
+  if (cache_file != "") {
+    std::ofstream cache(cache_file, std::ios::app);
+    if (cache)
+      cache << key << " " << MTTKRP_Method::names[best_method] << " "
+            << best_tile << std::endl;
+    else
+      out << "Warning:  unable to write MTTKRP tuning cache "
+          << cache_file << std::endl;
+  }
+}
+
+#define INST_MACRO(SPACE)                                               \
+  template void Genten::tune_mttkrp<SPACE>(                             \
+    SptensorT<SPACE>& X, const ttb_indx nc, AlgParams& algParams,       \
+    std::ostream& out);
+
+GENTEN_INST(INST_MACRO)
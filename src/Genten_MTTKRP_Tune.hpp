@@ -0,0 +1,76 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+/*!
+  @file Genten_MTTKRP_Tune.hpp
+  @brief Benchmark-driven selection of the sparse MTTKRP method.
+*/
+
+#pragma once
+
+#include <ostream>
+
+#include "Genten_Sptensor.hpp"
+#include "Genten_AlgParams.hpp"
+
+namespace Genten {
+
+  //! Resolve MTTKRP_Method::Auto by timing the candidate methods on X.
+  /*!
+   * Each candidate MTTKRP method (and, for the coordinate-based methods,
+   * nonzero tile size) is timed for algParams.mttkrp_tune_iters sweeps over
+   * all modes with a rank nc Ktensor, and the fastest is stored in
+   * algParams.mttkrp_method and algParams.mttkrp_nnz_tile_size.  Format
+   * construction is not timed since CP-ALS builds it once.
+   *
+   * If algParams.mttkrp_tune_cache names a file, the choice is appended
+   * to it keyed by the solver method, execution space, thread count, rank,
+   * log2 of the number of nonzeros and the tensor dimensions, and later
+   * calls with a matching key use it without benchmarking.  The cache is
+   * off by default (empty file name).
+   *
+   * If the perm method is chosen, X is left with its permutation computed.
+   * Does nothing unless algParams.mttkrp_method is MTTKRP_Method::Auto.
+   */
+  template <typename ExecSpace>
+  void tune_mttkrp(SptensorT<ExecSpace>& X, const ttb_indx nc,
+                   AlgParams& algParams, std::ostream& out);
+
+}
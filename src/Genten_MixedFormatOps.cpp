@@ -53,8 +53,10 @@
 #include "Genten_Ktensor.hpp"
 #include "Genten_MixedFormatOps.hpp"
 #include "Genten_Sptensor.hpp"
+#include "Genten_SptensorNarrow.hpp"
 
 #include "Genten_MTTKRP.hpp"
+#include "Genten_MathLibs_Wpr.hpp"
 
 #ifdef HAVE_CALIPER
 #include <caliper/cali.h>
@@ -67,7 +69,7 @@
 namespace Genten {
 namespace Impl {
 
-template <typename ExecSpace,
+template <typename ExecSpace, typename SparseTensor,
           unsigned RowBlockSize, unsigned FacBlockSize,
           unsigned TeamSize, unsigned VectorSize>
 struct InnerProductKernel {
@@ -76,7 +78,7 @@ struct InnerProductKernel {
   typedef typename Policy::member_type TeamMember;
   typedef Kokkos::View< ttb_real**, Kokkos::LayoutRight, typename ExecSpace::scratch_memory_space , Kokkos::MemoryUnmanaged > TmpScratchSpace;
 
-  const Genten::SptensorT<ExecSpace>& s;
+  const SparseTensor& s;
   const Genten::KtensorT<ExecSpace>& u;
   const Genten::ArrayT<ExecSpace>& lambda;
   const ttb_indx nnz;
@@ -96,7 +98,7 @@ struct InnerProductKernel {
   }
 
   KOKKOS_INLINE_FUNCTION
-  InnerProductKernel(const Genten::SptensorT<ExecSpace>& s_,
+  InnerProductKernel(const SparseTensor& s_,
                      const Genten::KtensorT<ExecSpace>& u_,
                      const Genten::ArrayT<ExecSpace>& lambda_,
                      const TeamMember& team_) :
@@ -169,14 +171,14 @@ struct InnerProductKernel {
 // Specialization of InnerProductKernel to TeamSize == VectorSize == 1
 // (for, e.g., KNL).  Overall this is about 10% faster on KNL.  We could use a
 // RangePolicy here, but the TeamPolicy seems to be about 25% faster on KNL.
-template <typename ExecSpace,
+template <typename ExecSpace, typename SparseTensor,
           unsigned RowBlockSize, unsigned FacBlockSize>
-struct InnerProductKernel<ExecSpace,RowBlockSize,FacBlockSize,1,1> {
+struct InnerProductKernel<ExecSpace,SparseTensor,RowBlockSize,FacBlockSize,1,1> {
 
   typedef Kokkos::TeamPolicy<ExecSpace> Policy;
   typedef typename Policy::member_type TeamMember;
 
-  const Genten::SptensorT<ExecSpace>& s;
+  const SparseTensor& s;
   const Genten::KtensorT<ExecSpace>& u;
   const Genten::ArrayT<ExecSpace>& lambda;
   const ttb_indx nnz;
@@ -193,7 +195,7 @@ struct InnerProductKernel<ExecSpace,RowBlockSize,FacBlockSize,1,1> {
   }
 
   KOKKOS_INLINE_FUNCTION
-  InnerProductKernel(const Genten::SptensorT<ExecSpace>& s_,
+  InnerProductKernel(const SparseTensor& s_,
                      const Genten::KtensorT<ExecSpace>& u_,
                      const Genten::ArrayT<ExecSpace>& lambda_,
                      const TeamMember& team_) :
@@ -237,8 +239,8 @@ struct InnerProductKernel<ExecSpace,RowBlockSize,FacBlockSize,1,1> {
   }
 };
 
-template <typename ExecSpace, unsigned FacBlockSize>
-ttb_real innerprod_kernel(const Genten::SptensorT<ExecSpace>& s,
+template <typename ExecSpace, unsigned FacBlockSize, typename SparseTensor>
+ttb_real innerprod_kernel(const SparseTensor& s,
                           const Genten::KtensorT<ExecSpace>& u,
                           const Genten::ArrayT<ExecSpace>& lambda)
 {
@@ -252,7 +254,7 @@ ttb_real innerprod_kernel(const Genten::SptensorT<ExecSpace>& s,
   const unsigned RowBlockSize =
     is_cuda ? TeamSize : 32;
 
-  typedef InnerProductKernel<ExecSpace,RowBlockSize,FacBlockSize,TeamSize,VectorSize> Kernel;
+  typedef InnerProductKernel<ExecSpace,SparseTensor,RowBlockSize,FacBlockSize,TeamSize,VectorSize> Kernel;
   typedef typename Kernel::TeamMember TeamMember;
 
   // Do the inner product
@@ -263,7 +265,7 @@ ttb_real innerprod_kernel(const Genten::SptensorT<ExecSpace>& s,
   {
     // For some reason using the above typedef causes a really strange
     // compiler error with NVCC 8.0 + GCC 4.9.2
-    InnerProductKernel<ExecSpace,RowBlockSize,FacBlockSize,TeamSize,VectorSize> kernel(s,u,lambda,team);
+    InnerProductKernel<ExecSpace,SparseTensor,RowBlockSize,FacBlockSize,TeamSize,VectorSize> kernel(s,u,lambda,team);
 
     const unsigned nc = u.ncomponents();
     for (unsigned j=0; j<nc; j+=FacBlockSize) {
@@ -279,18 +281,12 @@ ttb_real innerprod_kernel(const Genten::SptensorT<ExecSpace>& s,
   return dTotal;
 }
 
-}
-}
-
-template <typename ExecSpace>
-ttb_real Genten::innerprod(const Genten::SptensorT<ExecSpace>& s,
-                           const Genten::KtensorT<ExecSpace>& u,
-                           const Genten::ArrayT<ExecSpace>& lambda)
+// Inner product between a coordinate-format sparse tensor and a Ktensor
+template <typename ExecSpace, typename SparseTensor>
+ttb_real innerprod_sparse(const SparseTensor& s,
+                          const Genten::KtensorT<ExecSpace>& u,
+                          const Genten::ArrayT<ExecSpace>& lambda)
 {
-#ifdef HAVE_CALIPER
-  cali::Function cali_func("Genten::innerprod");
-#endif
-
   const bool is_cuda = Genten::is_cuda_space<ExecSpace>::value;
 
   const ttb_indx nc = u.ncomponents();               // Number of components
@@ -321,6 +317,33 @@ ttb_real Genten::innerprod(const Genten::SptensorT<ExecSpace>& s,
   return d;
 }
 
+}
+}
+
+template <typename ExecSpace>
+ttb_real Genten::innerprod(const Genten::SptensorT<ExecSpace>& s,
+                           const Genten::KtensorT<ExecSpace>& u,
+                           const Genten::ArrayT<ExecSpace>& lambda)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::innerprod");
+#endif
+
+  return Impl::innerprod_sparse(s,u,lambda);
+}
+
+template <typename ExecSpace, typename IndexType>
+ttb_real Genten::innerprod(const Genten::SptensorNarrowT<ExecSpace,IndexType>& s,
+                           const Genten::KtensorT<ExecSpace>& u,
+                           const Genten::ArrayT<ExecSpace>& lambda)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::innerprod");
+#endif
+
+  return Impl::innerprod_sparse(s,u,lambda);
+}
+
 template <typename ExecSpace>
 ttb_real Genten::innerprod(const Genten::TensorT<ExecSpace>& x,
                            const Genten::KtensorT<ExecSpace>& u,
@@ -510,6 +533,120 @@ struct MTTKRP_Dense_Kernel {
 
 };
 
+#if defined(LAPACK_FOUND)
+
+// Row-wise Khatri-Rao product of the factor matrices for modes [b,e),
+// ordered so the first of these modes varies fastest (matching the
+// column-major layout of TensorT).  Row r is scaled by the weights if
+// requested.
+template <typename ExecSpace>
+Kokkos::View<ttb_real**,Kokkos::LayoutRight,ExecSpace>
+dense_mttkrp_krp(const KtensorT<ExecSpace>& u,
+                 const unsigned b, const unsigned e, const ttb_indx nrow,
+                 const bool scale)
+{
+  typedef Kokkos::View<ttb_real**,Kokkos::LayoutRight,ExecSpace> view_type;
+  const unsigned nc = u.ncomponents();
+  view_type K(Kokkos::view_alloc(Kokkos::WithoutInitializing,"dense_krp"),
+              nrow, nc);
+  Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(0,nrow),
+                       KOKKOS_LAMBDA(const ttb_indx r)
+  {
+    for (unsigned j=0; j<nc; ++j)
+      K(r,j) = scale ? u.weights(j) : ttb_real(1.0);
+    ttb_indx k = r;
+    for (unsigned m=b; m<e; ++m) {
+      const ttb_indx nr = u[m].nRows();
+      const ttb_indx s = k % nr;
+      k /= nr;
+      for (unsigned j=0; j<nc; ++j)
+        K(r,j) *= u[m].entry(s,j);
+    }
+  }, "Genten::mttkrp_dense_krp");
+  return K;
+}
+
+// MTTKRP for dense tensors using gemm() on the mode-n unfolding.  Viewing X
+// as an L x I_n x R column-major array, where L and R are the products of the
+// sizes of the modes before and after n, the Khatri-Rao products KL and KR of
+// the left and right factor matrices are formed explicitly and contracted
+// with X without permuting it.  For interior modes, X is first contracted
+// with whichever of KL and KR gives the smaller intermediate, followed by a
+// row-wise contraction with the other.  Since KL, KR and v are LayoutRight,
+// we compute their transposes as in gramianImpl().
+template <typename ExecSpace>
+void mttkrp_dense_gemm(const TensorT<ExecSpace>& X,
+                       const KtensorT<ExecSpace>& u,
+                       const unsigned n,
+                       const FacMatrixT<ExecSpace>& v)
+{
+  typedef Kokkos::View<ttb_real**,Kokkos::LayoutRight,ExecSpace> view_type;
+  typedef Kokkos::RangePolicy<ExecSpace> Policy;
+
+  const unsigned nd = u.ndims();
+  const unsigned nc = u.ncomponents();
+  const ttb_indx In = X.size(n);
+  ttb_indx L = 1, R = 1;
+  for (unsigned m=0; m<n; ++m)
+    L *= X.size(m);
+  for (unsigned m=n+1; m<nd; ++m)
+    R *= X.size(m);
+
+  const ttb_real *x = X.getValues().ptr();
+  const ttb_indx ldv = v.view().stride(0);
+
+  // Apply the weights to the left product unless it is empty
+  view_type KL = dense_mttkrp_krp(u, 0, n, L, n > 0);
+  view_type KR = dense_mttkrp_krp(u, n+1, nd, R, n == 0);
+
+  if (L == 1) {
+    // v = X_(n)*KR with X_(n) = X as I_n x R
+    Genten::gemm('N','T', nc, In, R, 1.0, KR.data(), nc, x, In,
+                 0.0, v.view().data(), ldv);
+  }
+  else if (R == 1) {
+    // v = X'*KL with X as L x I_n
+    Genten::gemm('N','N', nc, In, L, 1.0, KL.data(), nc, x, L,
+                 0.0, v.view().data(), ldv);
+  }
+  else if (L <= R) {
+    // W = X*KR with X as (L*I_n) x R,
+    // then v(i,:) = sum_l W(l+L*i,:).*KL(l,:)
+    view_type W(Kokkos::view_alloc(Kokkos::WithoutInitializing,"dense_W"),
+                L*In, nc);
+    Genten::gemm('N','T', nc, L*In, R, 1.0, KR.data(), nc, x, L*In,
+                 0.0, W.data(), nc);
+    Kokkos::parallel_for(Policy(0,In), KOKKOS_LAMBDA(const ttb_indx i)
+    {
+      for (unsigned j=0; j<nc; ++j) {
+        ttb_real val = 0.0;
+        for (ttb_indx l=0; l<L; ++l)
+          val += W(l+L*i,j)*KL(l,j);
+        v.entry(i,j) = val;
+      }
+    }, "Genten::mttkrp_dense_left");
+  }
+  else {
+    // Z = X'*KL with X as L x (I_n*R),
+    // then v(i,:) = sum_r Z(i+I_n*r,:).*KR(r,:)
+    view_type Z(Kokkos::view_alloc(Kokkos::WithoutInitializing,"dense_Z"),
+                In*R, nc);
+    Genten::gemm('N','N', nc, In*R, L, 1.0, KL.data(), nc, x, L,
+                 0.0, Z.data(), nc);
+    Kokkos::parallel_for(Policy(0,In), KOKKOS_LAMBDA(const ttb_indx i)
+    {
+      for (unsigned j=0; j<nc; ++j) {
+        ttb_real val = 0.0;
+        for (ttb_indx r=0; r<R; ++r)
+          val += Z(i+In*r,j)*KR(r,j);
+        v.entry(i,j) = val;
+      }
+    }, "Genten::mttkrp_dense_right");
+  }
+}
+
+#endif
+
 }
 }
 
@@ -537,12 +674,27 @@ void Genten::mttkrp(const Genten::TensorT<ExecSpace>& X,
   assert( v.nRows() == X.size(n) );
   assert( v.nCols() == nc );
 
+#if defined(LAPACK_FOUND)
+  // The gemm() wrapper is host-only, so use the element-wise kernel on Cuda
+  if (algParams.mttkrp_method == MTTKRP_Method::GEMM &&
+      !Genten::is_cuda_space<ExecSpace>::value) {
+    Genten::Impl::mttkrp_dense_gemm(X,u,n,v);
+    return;
+  }
+#endif
+
   v = ttb_real(0.0);
 
   Genten::Impl::MTTKRP_Dense_Kernel<ExecSpace> kernel(X,u,n,v,algParams);
   Genten::Impl::run_row_simd_kernel(kernel, nc);
 }
 
+std::vector<double>& Genten::mttkrp_thread_times()
+{
+  static std::vector<double> times;
+  return times;
+}
+
 #define INST_MACRO(SPACE)                                               \
   template                                                              \
   ttb_real innerprod<>(const Genten::SptensorT<SPACE>& s,               \
@@ -550,6 +702,16 @@ void Genten::mttkrp(const Genten::TensorT<ExecSpace>& X,
                        const Genten::ArrayT<SPACE>& lambda);            \
                                                                         \
   template                                                              \
+  ttb_real innerprod<>(const Genten::SptensorNarrowT<SPACE,uint16_t>& s, \
+                       const Genten::KtensorT<SPACE>& u,                \
+                       const Genten::ArrayT<SPACE>& lambda);            \
+                                                                        \
+  template                                                              \
+  ttb_real innerprod<>(const Genten::SptensorNarrowT<SPACE,uint32_t>& s, \
+                       const Genten::KtensorT<SPACE>& u,                \
+                       const Genten::ArrayT<SPACE>& lambda);            \
+                                                                        \
+  template                                                              \
   ttb_real innerprod<>(const Genten::TensorT<SPACE>& s,                 \
                        const Genten::KtensorT<SPACE>& u,                \
                        const Genten::ArrayT<SPACE>& lambda);            \
@@ -570,7 +732,102 @@ void Genten::mttkrp(const Genten::TensorT<ExecSpace>& X,
                                                                         \
   template                                                              \
   void mttkrp_all<>(const Genten::SptensorT<SPACE>& X,                  \
+                    const Genten::KtensorT<SPACE>& u,                   \
+                    const Genten::KtensorT<SPACE>& v,                   \
+                    const AlgParams& algParams);                        \
+                                                                        \
+  template                                                              \
+  void mttkrp<>(const Genten::SptensorCSFT<SPACE>& X,                   \
+                const Genten::KtensorT<SPACE>& u,                       \
+                const ttb_indx n,                                       \
+                const Genten::FacMatrixT<SPACE>& v,                     \
+                const AlgParams& algParams);                            \
+                                                                        \
+  template                                                              \
+  void mttkrp<>(const Genten::SptensorHiCOOT<SPACE>& X,                 \
+                const Genten::KtensorT<SPACE>& u,                       \
+                const ttb_indx n,                                       \
+                const Genten::FacMatrixT<SPACE>& v,                     \
+                const AlgParams& algParams);                            \
+                                                                        \
+  template                                                              \
+  void mttkrp<>(const Genten::SptensorNarrowT<SPACE,uint16_t>& X,       \
+                const Genten::KtensorT<SPACE>& u,                       \
+                const ttb_indx n,                                       \
+                const Genten::FacMatrixT<SPACE>& v,                     \
+                const AlgParams& algParams);                            \
+                                                                        \
+  template                                                              \
+  void mttkrp<>(const Genten::SptensorNarrowT<SPACE,uint32_t>& X,       \
+                const Genten::KtensorT<SPACE>& u,                       \
+                const ttb_indx n,                                       \
+                const Genten::FacMatrixT<SPACE>& v,                     \
+                const AlgParams& algParams);                            \
+                                                                        \
+  template                                                              \
+  void mttkrp<>(const Genten::SptensorALTOT<SPACE>& X,                  \
+                const Genten::KtensorT<SPACE>& u,                       \
+                const ttb_indx n,                                       \
+                const Genten::FacMatrixT<SPACE>& v,                     \
+                const AlgParams& algParams);                            \
+                                                                        \
+  template                                                              \
+  void mttkrp<>(const Genten::SptensorHybridT<SPACE>& X,                \
+                const Genten::KtensorT<SPACE>& u,                       \
+                const ttb_indx n,                                       \
+                const Genten::FacMatrixT<SPACE>& v,                     \
+                const AlgParams& algParams);                            \
+                                                                        \
+  template                                                              \
+  void mttkrp<>(const Genten::SptensorDimTreeT<SPACE>& X,               \
+                const Genten::KtensorT<SPACE>& u,                       \
+                const ttb_indx n,                                       \
+                const Genten::FacMatrixT<SPACE>& v,                     \
+                const AlgParams& algParams);                            \
+                                                                        \
+  template                                                              \
+  void mttkrp<>(const Genten::SptensorT<SPACE>& X,                      \
+                const Genten::KtensorReplicatedT<SPACE>& u,             \
+                const ttb_indx n,                                       \
+                const Genten::FacMatrixT<SPACE>& v,                     \
+                const AlgParams& algParams);                            \
+                                                                        \
+  template                                                              \
+  void mttkrp<>(const Genten::SptensorNarrowT<SPACE,uint16_t>& X,       \
+                const Genten::KtensorReplicatedT<SPACE>& u,             \
+                const ttb_indx n,                                       \
+                const Genten::FacMatrixT<SPACE>& v,                     \
+                const AlgParams& algParams);                            \
+                                                                        \
+  template                                                              \
+  void mttkrp<>(const Genten::SptensorNarrowT<SPACE,uint32_t>& X,       \
+                const Genten::KtensorReplicatedT<SPACE>& u,             \
+                const ttb_indx n,                                       \
+                const Genten::FacMatrixT<SPACE>& v,                     \
+                const AlgParams& algParams);                            \
+                                                                        \
+  template                                                              \
+  void mttkrp_all<>(const Genten::SptensorCSFT<SPACE>& X,               \
                     const Genten::KtensorT<SPACE>& u,                   \
                     const Genten::KtensorT<SPACE>& v,                   \
                     const AlgParams& algParams);
 GENTEN_INST(INST_MACRO)
+
+#ifdef HAVE_MIXED_PRECISION
+#undef INST_MACRO
+#define INST_MACRO(SPACE)                                               \
+  template                                                              \
+  void mttkrp<>(const Genten::SptensorNarrowT<SPACE,uint32_t,float>& X, \
+                const Genten::KtensorNarrowT<SPACE,float>& u,           \
+                const ttb_indx n,                                       \
+                const Genten::FacMatrixT<SPACE>& v,                     \
+                const AlgParams& algParams);                            \
+                                                                        \
+  template                                                              \
+  void mttkrp<>(const Genten::SptensorNarrowT<SPACE,uint64_t,float>& X, \
+                const Genten::KtensorNarrowT<SPACE,float>& u,           \
+                const ttb_indx n,                                       \
+                const Genten::FacMatrixT<SPACE>& v,                     \
+                const AlgParams& algParams);
+GENTEN_INST(INST_MACRO)
+#endif
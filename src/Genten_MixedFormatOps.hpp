@@ -45,9 +45,19 @@
 
 #pragma once
 
+#include <vector>
+
 #include "Genten_FacMatrix.hpp"
 #include "Genten_Ktensor.hpp"
 #include "Genten_Sptensor.hpp"
+#include "Genten_SptensorCSF.hpp"
+#include "Genten_SptensorHiCOO.hpp"
+#include "Genten_SptensorNarrow.hpp"
+#include "Genten_KtensorNarrow.hpp"
+#include "Genten_NUMA.hpp"
+#include "Genten_SptensorALTO.hpp"
+#include "Genten_SptensorHybrid.hpp"
+#include "Genten_SptensorDimTree.hpp"
 #include "Genten_Tensor.hpp"
 #include "Genten_Util.hpp"
 #include "Genten_AlgParams.hpp"
@@ -76,6 +86,13 @@ namespace Genten
                      const KtensorT<ExecSpace>& u,
                      const ArrayT<ExecSpace>& lambda);
 
+  // Inner product between a sparse tensor with narrow subscripts and a
+  // Ktensor with weights.
+  template <typename ExecSpace, typename IndexType>
+  ttb_real innerprod(const SptensorNarrowT<ExecSpace,IndexType>& s,
+                     const KtensorT<ExecSpace>& u,
+                     const ArrayT<ExecSpace>& lambda);
+
   // Inner product between a sparse tensor and a Ktensor.
   /* Compute the element-wise dot product of all elements.
    */
@@ -163,6 +180,95 @@ namespace Genten
     return;
   }
 
+  // Matricized sparse tensor times Khatri-Rao product using CSF format.
+  /* Same as above, but uses the CSF tree rooted at mode n if there is one,
+     and otherwise the first tree.
+  */
+  template <typename ExecSpace>
+  void mttkrp(const SptensorCSFT<ExecSpace>& X,
+              const KtensorT<ExecSpace>& u,
+              const ttb_indx n,
+              const FacMatrixT<ExecSpace>& v,
+              const AlgParams& algParams = AlgParams());
+
+  // Matricized sparse tensor times Khatri-Rao product using HiCOO format.
+  /* Same as above, but processes the nonzeros one block at a time.
+  */
+  template <typename ExecSpace>
+  void mttkrp(const SptensorHiCOOT<ExecSpace>& X,
+              const KtensorT<ExecSpace>& u,
+              const ttb_indx n,
+              const FacMatrixT<ExecSpace>& v,
+              const AlgParams& algParams = AlgParams());
+
+  // Matricized sparse tensor times Khatri-Rao product using narrow
+  // subscripts.
+  /* Same as above for the single, atomic and duplicated methods.
+  */
+  template <typename ExecSpace, typename IndexType>
+  void mttkrp(const SptensorNarrowT<ExecSpace,IndexType>& X,
+              const KtensorT<ExecSpace>& u,
+              const ttb_indx n,
+              const FacMatrixT<ExecSpace>& v,
+              const AlgParams& algParams = AlgParams());
+
+  // Mixed-precision matricized sparse tensor times Khatri-Rao product.
+  /* Same as above with the values and factor matrices stored as ValueType
+   * (float) and the products accumulated into v as ttb_real.  u[n] is not
+   * read.
+  */
+  template <typename ExecSpace, typename IndexType, typename ValueType>
+  void mttkrp(const SptensorNarrowT<ExecSpace,IndexType,ValueType>& X,
+              const KtensorNarrowT<ExecSpace,ValueType>& u,
+              const ttb_indx n,
+              const FacMatrixT<ExecSpace>& v,
+              const AlgParams& algParams = AlgParams());
+
+  // Matricized sparse tensor times Khatri-Rao product reading the factor
+  // matrices from the replica on each thread's NUMA node.
+  /* X is an SptensorT or SptensorNarrowT, and only the single, atomic and
+   * duplicated methods are supported.
+  */
+  template <typename ExecSpace, typename SparseTensor>
+  void mttkrp(const SparseTensor& X,
+              const KtensorReplicatedT<ExecSpace>& u,
+              const ttb_indx n,
+              const FacMatrixT<ExecSpace>& v,
+              const AlgParams& algParams = AlgParams());
+
+  // Matricized sparse tensor times Khatri-Rao product using ALTO format.
+  /* Same as above, decoding the subscripts of each nonzero from its
+   * linearized key.
+  */
+  template <typename ExecSpace>
+  void mttkrp(const SptensorALTOT<ExecSpace>& X,
+              const KtensorT<ExecSpace>& u,
+              const ttb_indx n,
+              const FacMatrixT<ExecSpace>& v,
+              const AlgParams& algParams = AlgParams());
+
+  // Matricized sparse tensor times Khatri-Rao product privatizing hot rows.
+  /* Same as above, accumulating the hot rows of mode n into per-thread
+   * buffers and updating the remaining rows with atomics.
+  */
+  template <typename ExecSpace>
+  void mttkrp(const SptensorHybridT<ExecSpace>& X,
+              const KtensorT<ExecSpace>& u,
+              const ttb_indx n,
+              const FacMatrixT<ExecSpace>& v,
+              const AlgParams& algParams = AlgParams());
+
+  // Matricized sparse tensor times Khatri-Rao product along a dimension tree.
+  /* Same as above, reusing the partial products cached in X that don't
+   * depend on factor matrices changed since (see SptensorDimTreeT).
+  */
+  template <typename ExecSpace>
+  void mttkrp(const SptensorDimTreeT<ExecSpace>& X,
+              const KtensorT<ExecSpace>& u,
+              const ttb_indx n,
+              const FacMatrixT<ExecSpace>& v,
+              const AlgParams& algParams = AlgParams());
+
   // Matricized sparse tensor times Khatri-Rao product.
   /*
    * Computes MTTKRP along all modes for direct optimization methods such
@@ -176,4 +282,18 @@ namespace Genten
                   const Genten::KtensorT<ExecSpace>& v,
                   const AlgParams& algParams);
 
+  // Matricized sparse tensor times Khatri-Rao product using CSF format.
+  /* Computes MTTKRP along all modes, one mode at a time.
+   */
+  template <typename ExecSpace>
+  void mttkrp_all(const Genten::SptensorCSFT<ExecSpace>& X,
+                  const Genten::KtensorT<ExecSpace>& u,
+                  const Genten::KtensorT<ExecSpace>& v,
+                  const AlgParams& algParams);
+
+  // Time in seconds each host thread has spent in perm MTTKRP kernels with
+  // row pointers, recorded when algParams.mttkrp_thread_timing is set.
+  // Times accumulate across calls until the vector is cleared.
+  std::vector<double>& mttkrp_thread_times();
+
 }     //-- namespace Genten
@@ -0,0 +1,436 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "Genten_NUMA.hpp"
+
+#ifdef HAVE_CALIPER
+#include <caliper/cali.h>
+#endif
+
+namespace Genten {
+namespace Impl {
+
+#ifdef __linux__
+// Parse a Linux cpu/node list such as "0-15,32-47"
+std::vector<unsigned> parse_sys_list(const std::string& list)
+{
+  std::vector<unsigned> ids;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty())
+      continue;
+    const std::size_t dash = range.find('-');
+    const unsigned beg = std::stoul(range.substr(0,dash));
+    const unsigned end =
+      dash == std::string::npos ? beg : std::stoul(range.substr(dash+1));
+    for (unsigned i=beg; i<=end; ++i)
+      ids.push_back(i);
+  }
+  return ids;
+}
+#endif
+
+// Size of the partition used when host threads claim work by node.  A
+// multiple of the thread count so every thread gets some with a static
+// schedule.
+inline ttb_indx numa_league_size(const unsigned nthreads) {
+  return 64*ttb_indx(nthreads);
+}
+
+// Re-allocate the subscripts and, if copy_vals, the values of a
+// coordinate-format tensor, first touching them by the nonzero tiles of
+// mttkrp_kernel on the host
+template <typename ExecSpace, typename SubsView, typename ValsView>
+void numa_first_touch_coo(SubsView& subs, ValsView& vals, const bool copy_vals,
+                          const AlgParams& algParams)
+{
+  typedef Kokkos::TeamPolicy<ExecSpace> Policy;
+  typedef typename Policy::member_type TeamMember;
+
+  const ttb_indx nnz = subs.extent(0);
+  const unsigned nd = subs.extent(1);
+  const SubsView subs_old = subs;
+  const ValsView vals_old = vals;
+  const SubsView subs_new(Kokkos::view_alloc(subs_old.label(),
+                                             Kokkos::WithoutInitializing),
+                          nnz, nd);
+  const ValsView vals_new = copy_vals ?
+    ValsView(Kokkos::view_alloc(vals_old.label(), Kokkos::WithoutInitializing),
+             nnz) : vals_old;
+
+  const ttb_indx RowBlockSize = algParams.mttkrp_nnz_tile_size;
+  const ttb_indx N = (nnz+RowBlockSize-1)/RowBlockSize;
+  Kokkos::parallel_for("Genten::numa_first_touch_sptensor",
+                       Policy(N,1,1), KOKKOS_LAMBDA(const TeamMember& team)
+  {
+    const ttb_indx i_beg = team.league_rank()*RowBlockSize;
+    const ttb_indx i_end = i_beg+RowBlockSize < nnz ? i_beg+RowBlockSize : nnz;
+    for (ttb_indx i=i_beg; i<i_end; ++i) {
+      for (unsigned m=0; m<nd; ++m)
+        subs_new(i,m) = subs_old(i,m);
+      if (copy_vals)
+        vals_new(i) = vals_old(i);
+    }
+  });
+
+  subs = subs_new;
+  vals = vals_new;
+}
+
+}
+}
+
+Genten::NumaTopology::
+NumaTopology() : num_nodes(1), threads_bound(false)
+{
+  typedef DefaultHostExecutionSpace host_space;
+  typedef Impl::NumaThreadRank<host_space> thread_rank;
+
+  const unsigned nt = thread_rank::size();
+  thread_node.assign(nt, 0);
+
+  const char* bind = std::getenv("OMP_PROC_BIND");
+  threads_bound = bind != nullptr && std::string(bind) != "false";
+
+#ifdef __linux__
+  // Node of each CPU
+  std::vector<int> cpu_node;
+  std::ifstream possible("/sys/devices/system/node/possible");
+  std::string nodes;
+  if (possible >> nodes) {
+    for (const unsigned k : Impl::parse_sys_list(nodes)) {
+      std::ifstream cpulist("/sys/devices/system/node/node" +
+                            std::to_string(k) + "/cpulist");
+      std::string cpus;
+      if (!(cpulist >> cpus))
+        continue;
+      for (const unsigned c : Impl::parse_sys_list(cpus)) {
+        if (c >= cpu_node.size())
+          cpu_node.resize(c+1, -1);
+        cpu_node[c] = k;
+      }
+      num_nodes = std::max(num_nodes, k+1);
+    }
+  }
+
+  // CPU each thread is running on
+  Kokkos::View<int*,Kokkos::HostSpace> thread_cpu(
+    "Genten::NumaTopology::thread_cpu", nt);
+  Kokkos::deep_copy(thread_cpu, -1);
+  Kokkos::parallel_for("Genten::NumaTopology::thread_cpu",
+                       Kokkos::RangePolicy<host_space>(
+                         0,Impl::numa_league_size(nt)),
+                       [=](const ttb_indx)
+  {
+    thread_cpu(thread_rank::rank()) = sched_getcpu();
+  });
+  for (unsigned t=0; t<nt; ++t) {
+    const int c = thread_cpu(t);
+    thread_node[t] =
+      c >= 0 && c < int(cpu_node.size()) && cpu_node[c] >= 0 ? cpu_node[c] : 0;
+  }
+#endif
+
+  node_threads.assign(num_nodes, 0);
+  for (unsigned t=0; t<nt; ++t)
+    ++node_threads[thread_node[t]];
+}
+
+const Genten::NumaTopology&
+Genten::NumaTopology::
+get()
+{
+  static const NumaTopology topology;
+  return topology;
+}
+
+template <typename ExecSpace>
+Genten::KtensorReplicatedT<ExecSpace>::
+KtensorReplicatedT(const KtensorT<ExecSpace>& u) :
+  nd(u.ndims()), nc(u.ncomponents())
+{
+  // One replica for each node with threads, numbered in node order
+  const NumaTopology& topology = NumaTopology::get();
+  std::vector<unsigned> node_replica(topology.nnodes(), 0);
+  unsigned nrep = 0;
+  for (unsigned k=0; k<topology.nnodes(); ++k) {
+    node_replica[k] = nrep;
+    if (topology.nthreads(k) > 0)
+      ++nrep;
+  }
+  nrep = std::max(nrep, 1u);
+  const unsigned nt = Impl::NumaThreadRank<ExecSpace>::size();
+  thread_node = thread_node_type(
+    "Genten::KtensorReplicated::thread_replica", nt);
+  for (unsigned t=0; t<nt; ++t)
+    thread_node(t) = t < topology.nthreads() ?
+      node_replica[topology.node(t)] : 0;
+
+  // Allocate without initializing so update() does the first touch
+  replicas = replicas_type("Genten::KtensorReplicated::replicas", nrep);
+  for (unsigned r=0; r<nrep; ++r) {
+    FacMatArrayT<ExecSpace> factors(nd);
+    for (ttb_indx m=0; m<nd; ++m) {
+      typename FacMatrixT<ExecSpace>::view_type v(
+        Kokkos::view_alloc("Genten::FacMatrix::data",
+                           Kokkos::WithoutInitializing,
+                           Kokkos::AllowPadding),
+        u[m].nRows(), nc);
+      factors.set_factor(m, FacMatrixT<ExecSpace>(v));
+    }
+    replicas(r) = KtensorT<ExecSpace>(ArrayT<ExecSpace>(nc), factors);
+  }
+  stale = stale_view_type("Genten::KtensorReplicated::stale", nd);
+  Kokkos::deep_copy(stale, true);
+  update(u, nd);
+}
+
+template <typename ExecSpace>
+void
+Genten::KtensorReplicatedT<ExecSpace>::
+update(const KtensorT<ExecSpace>& u, const ttb_indx skip) const
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::KtensorReplicated::update");
+#endif
+
+  typedef Kokkos::View<ttb_indx*,ExecSpace> next_type;
+
+  const unsigned nrep = replicas.extent(0);
+  for (unsigned r=0; r<nrep; ++r)
+    deep_copy(replicas(r).weights(), u.weights());
+
+  // Threads claim chunks of rows of the replica on their own node
+  const ttb_indx chunk = 64;
+  const replicas_type reps = replicas;
+  const thread_node_type map = thread_node;
+  const unsigned nt = Impl::NumaThreadRank<ExecSpace>::size();
+  for (ttb_indx m=0; m<nd; ++m) {
+    if (m == skip || !stale(m))
+      continue;
+    stale(m) = false;
+    const FacMatrixT<ExecSpace> src = u[m];
+    const ttb_indx nrows = src.nRows();
+    const unsigned ncol = nc;
+    next_type next("Genten::KtensorReplicated::next", nrep);
+    Kokkos::parallel_for("Genten::KtensorReplicated::update",
+                         Kokkos::RangePolicy<ExecSpace>(
+                           0,Impl::numa_league_size(nt)),
+                         KOKKOS_LAMBDA(const ttb_indx)
+    {
+      const unsigned r = map(Impl::NumaThreadRank<ExecSpace>::rank());
+      const FacMatrixT<ExecSpace>& dst = reps(r)[m];
+      for (ttb_indx c = Kokkos::atomic_fetch_add(&next(r), chunk);
+           c < nrows; c = Kokkos::atomic_fetch_add(&next(r), chunk)) {
+        const ttb_indx c_end = c+chunk < nrows ? c+chunk : nrows;
+        for (ttb_indx i=c; i<c_end; ++i)
+          for (unsigned j=0; j<ncol; ++j)
+            dst.entry(i,j) = src.entry(i,j);
+      }
+    });
+
+    // Replicas no thread claimed rows of are copied directly
+    auto next_host = create_mirror_view(next);
+    deep_copy(next_host, next);
+    for (unsigned r=0; r<nrep; ++r)
+      if (next_host(r) < nrows)
+        deep_copy(replicas(r)[m], src);
+  }
+  if (skip < nd)
+    stale(skip) = true;
+}
+
+template <typename ExecSpace>
+void
+Genten::numa_first_touch(SptensorT<ExecSpace>& X, const AlgParams& algParams)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::numa_first_touch");
+#endif
+
+  if (Genten::is_cuda_space<ExecSpace>::value)
+    return;
+
+  typedef SptensorT<ExecSpace> tensor_type;
+
+  typename tensor_type::subs_view_type subs = X.getSubscripts();
+  typename tensor_type::vals_view_type vals = X.getValues();
+  Impl::numa_first_touch_coo<ExecSpace>(subs, vals, true, algParams);
+  X = tensor_type(X.size(), vals, subs, X.getPerm(), X.isSorted());
+}
+
+template <typename ExecSpace, typename IndexType, typename ValueType>
+void
+Genten::numa_first_touch(SptensorNarrowT<ExecSpace,IndexType,ValueType>& X,
+                         const AlgParams& algParams)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::numa_first_touch");
+#endif
+
+  if (Genten::is_cuda_space<ExecSpace>::value)
+    return;
+
+  typedef SptensorNarrowT<ExecSpace,IndexType,ValueType> tensor_type;
+
+  typename tensor_type::subs_view_type subs = X.getSubscripts();
+  typename tensor_type::vals_view_type vals = X.getValues();
+
+  // ttb_real values are shared with the tensor the copy was made from,
+  // which is placed by its own first touch
+  const bool copy_vals = !std::is_same<ValueType,ttb_real>::value;
+  Impl::numa_first_touch_coo<ExecSpace>(subs, vals, copy_vals, algParams);
+  X = tensor_type(X.size(), X.size_host(), vals, subs);
+}
+
+template <typename ExecSpace>
+void
+Genten::numa_first_touch(KtensorT<ExecSpace>& u)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::numa_first_touch");
+#endif
+
+  if (Genten::is_cuda_space<ExecSpace>::value)
+    return;
+
+  const ttb_indx nd = u.ndims();
+  const ttb_indx nc = u.ncomponents();
+  for (ttb_indx m=0; m<nd; ++m) {
+    const FacMatrixT<ExecSpace> src = u[m];
+    const ttb_indx nrows = src.nRows();
+    const FacMatrixT<ExecSpace> dst(
+      typename FacMatrixT<ExecSpace>::view_type(
+        Kokkos::view_alloc("Genten::FacMatrix::data",
+                           Kokkos::WithoutInitializing,
+                           Kokkos::AllowPadding),
+        nrows, nc));
+    Kokkos::parallel_for("Genten::numa_first_touch_factor",
+                         Kokkos::RangePolicy<ExecSpace>(0,nrows),
+                         KOKKOS_LAMBDA(const ttb_indx i)
+    {
+      for (ttb_indx j=0; j<nc; ++j)
+        dst.entry(i,j) = src.entry(i,j);
+    });
+    u.set_factor(m, dst);
+  }
+}
+
+void
+Genten::print_numa_placement(const AlgParams& algParams, std::ostream& out)
+{
+  const NumaTopology& topology = NumaTopology::get();
+  out << "NUMA placement:" << std::endl;
+  out << "  nodes = " << topology.nnodes() << ", threads = "
+      << topology.nthreads() << " (";
+  for (unsigned k=0; k<topology.nnodes(); ++k) {
+    out << topology.nthreads(k) << " on node " << k;
+    if (k != topology.nnodes()-1)
+      out << ", ";
+  }
+  out << ")" << std::endl;
+  if (!topology.bound())
+    out << "  warning: OMP_PROC_BIND is not set, so threads may migrate "
+        << "between nodes" << std::endl;
+  out << "  sparse tensor: ";
+  if (algParams.numa_first_touch)
+    out << "first touch by tiles of " << algParams.mttkrp_nnz_tile_size
+        << " nonzeros" << std::endl;
+  else
+    out << "default allocation" << std::endl;
+  const MTTKRP_Method::type method = algParams.mttkrp_method;
+  if (algParams.numa_first_touch &&
+      method != MTTKRP_Method::Single &&
+      method != MTTKRP_Method::Atomic &&
+      method != MTTKRP_Method::Duplicated &&
+      method != MTTKRP_Method::Prefetch)
+    out << "  warning: the " << MTTKRP_Method::names[method]
+        << " mttkrp method does not read the nonzeros by these tiles"
+        << std::endl;
+  out << "  factor matrices: ";
+  if (algParams.numa_first_touch)
+    out << "first touch by rows";
+  else
+    out << "default allocation";
+  if (algParams.numa_replicate) {
+    unsigned nrep = 0;
+    for (unsigned k=0; k<topology.nnodes(); ++k)
+      if (topology.nthreads(k) > 0)
+        ++nrep;
+    out << ", " << std::max(nrep,1u)
+        << " read-only replicas in coordinate-format MTTKRP";
+  }
+  out << std::endl;
+}
+
+#define INST_NARROW_MACRO(SPACE,INDEX,VALUE)                            \
+  template void Genten::numa_first_touch<SPACE,INDEX,VALUE>(            \
+    SptensorNarrowT<SPACE,INDEX,VALUE>& X, const AlgParams& algParams);
+
+#ifdef HAVE_MIXED_PRECISION
+#define INST_MIXED_MACRO(SPACE)                                         \
+  INST_NARROW_MACRO(SPACE,uint32_t,float)                               \
+  INST_NARROW_MACRO(SPACE,uint64_t,float)
+#else
+#define INST_MIXED_MACRO(SPACE) /* */
+#endif
+
+#define INST_MACRO(SPACE)                                               \
+  template class Genten::KtensorReplicatedT<SPACE>;                     \
+  template void Genten::numa_first_touch<SPACE>(                        \
+    SptensorT<SPACE>& X, const AlgParams& algParams);                   \
+  template void Genten::numa_first_touch<SPACE>(KtensorT<SPACE>& u);    \
+  INST_NARROW_MACRO(SPACE,uint16_t,ttb_real)                            \
+  INST_NARROW_MACRO(SPACE,uint32_t,ttb_real)                            \
+  INST_MIXED_MACRO(SPACE)
+
+GENTEN_INST(INST_MACRO)
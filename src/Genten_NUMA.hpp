@@ -0,0 +1,208 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+/*!
+  @file Genten_NUMA.hpp
+  @brief NUMA-aware placement of sparse tensors and factor matrices.
+*/
+
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+#include "Genten_Sptensor.hpp"
+#include "Genten_SptensorNarrow.hpp"
+#include "Genten_Ktensor.hpp"
+#include "Genten_AlgParams.hpp"
+
+namespace Genten {
+
+  namespace Impl {
+
+    // Rank of the calling thread of a host execution space, which, unlike a
+    // UniqueToken id, stays the same for the thread for the whole kernel.
+    // There is a single rank on the GPU.
+    template <typename ExecSpace,
+              bool is_cuda = Genten::is_cuda_space<ExecSpace>::value>
+    struct NumaThreadRank {
+      static unsigned size() { return ExecSpace::impl_max_hardware_threads(); }
+
+      KOKKOS_INLINE_FUNCTION
+      static unsigned rank() { return ExecSpace::impl_hardware_thread_id(); }
+    };
+
+    template <typename ExecSpace>
+    struct NumaThreadRank<ExecSpace,true> {
+      static unsigned size() { return 1; }
+
+      KOKKOS_INLINE_FUNCTION
+      static unsigned rank() { return 0; }
+    };
+
+  }
+
+  //! NUMA nodes of the host and the node each host thread runs on.
+  /*!
+   * The nodes and their CPUs are read from /sys/devices/system/node on
+   * Linux, and the node of each thread of the default host execution space
+   * (indexed by its thread rank) from the CPU it is running on
+   * when first queried.  This is only meaningful when threads are bound
+   * (e.g., OMP_PROC_BIND=spread).  Elsewhere there is a single node.
+   */
+  class NumaTopology {
+  public:
+    //! Topology of this process, computed on first use.
+    static const NumaTopology& get();
+
+    //! Number of NUMA nodes
+    unsigned nnodes() const { return num_nodes; }
+
+    //! Number of host threads
+    unsigned nthreads() const { return thread_node.size(); }
+
+    //! Node of thread (rank) t
+    unsigned node(const unsigned t) const { return thread_node[t]; }
+
+    //! Number of threads on node k
+    unsigned nthreads(const unsigned k) const { return node_threads[k]; }
+
+    //! Whether the OpenMP threads appear to be bound to cores
+    bool bound() const { return threads_bound; }
+
+  private:
+    NumaTopology();
+
+    unsigned num_nodes;
+    std::vector<unsigned> thread_node;
+    std::vector<unsigned> node_threads;
+    bool threads_bound;
+  };
+
+  //! Copy a Ktensor with one replica per NUMA node.
+  /*!
+   * Each replica is first touched by threads running on its node, and
+   * kernels obtain the replica local to the calling thread through
+   * Impl::local_replica().  Only used with host execution spaces.
+   */
+  template <typename ExecSpace>
+  class KtensorReplicatedT {
+  public:
+    typedef ExecSpace exec_space;
+    typedef Kokkos::View<KtensorT<ExecSpace>*,Kokkos::HostSpace> replicas_type;
+    typedef Kokkos::View<unsigned*,Kokkos::HostSpace> thread_node_type;
+    typedef Kokkos::View<bool*,Kokkos::HostSpace> stale_view_type;
+
+    KtensorReplicatedT() = default;
+
+    //! Allocate a replica of u for each NUMA node and copy u into them
+    KtensorReplicatedT(const KtensorT<ExecSpace>& u);
+
+    //! Copy the weights and the factor matrices of u that are stale, except
+    //! mode skip, into each replica.  Mode skip is then marked stale since
+    //! the caller is about to overwrite it (pass skip >= ndims() to copy all
+    //! stale modes), so each call of the CP-ALS sweep copies one mode.
+    void update(const KtensorT<ExecSpace>& u, const ttb_indx skip) const;
+
+    ttb_indx ndims() const { return nd; }
+    ttb_indx ncomponents() const { return nc; }
+    unsigned nreplicas() const { return replicas.extent(0); }
+
+    //! Replica k
+    const KtensorT<ExecSpace>& replica(const unsigned k) const {
+      return replicas(k);
+    }
+
+    //! Replica on the NUMA node of the calling thread
+    KOKKOS_INLINE_FUNCTION
+    const KtensorT<ExecSpace>& local() const {
+      return replicas(thread_node(Impl::NumaThreadRank<ExecSpace>::rank()));
+    }
+
+  private:
+    ttb_indx nd = 0;
+    ttb_indx nc = 0;
+    replicas_type replicas;
+    thread_node_type thread_node;
+    stale_view_type stale;
+  };
+
+  //! Re-allocate the subscripts and values of X, first touching them with
+  //! the same partition of nonzeros into tiles of
+  //! algParams.mttkrp_nnz_tile_size as the coordinate-format MTTKRP.
+  /*!
+   * Does nothing on the GPU.
+   */
+  template <typename ExecSpace>
+  void numa_first_touch(SptensorT<ExecSpace>& X, const AlgParams& algParams);
+
+  //! Same for the narrow copy of a sparse tensor MTTKRP reads instead, whose
+  //! values are only re-allocated if they were converted.
+  template <typename ExecSpace, typename IndexType, typename ValueType>
+  void numa_first_touch(SptensorNarrowT<ExecSpace,IndexType,ValueType>& X,
+                        const AlgParams& algParams);
+
+  //! Re-allocate the factor matrices of u, first touching them by rows.
+  /*!
+   * Does nothing on the GPU.
+   */
+  template <typename ExecSpace>
+  void numa_first_touch(KtensorT<ExecSpace>& u);
+
+  //! Print the NUMA nodes, thread placement and the placement chosen by
+  //! algParams.numa_first_touch and algParams.numa_replicate.
+  void print_numa_placement(const AlgParams& algParams, std::ostream& out);
+
+  namespace Impl {
+
+    // Factor matrices a kernel thread should read.  For replicated Ktensors
+    // this is the replica on the thread's NUMA node.
+    template <typename Ktensor>
+    KOKKOS_INLINE_FUNCTION
+    const Ktensor& local_replica(const Ktensor& u) { return u; }
+
+    template <typename ExecSpace>
+    KOKKOS_INLINE_FUNCTION
+    const KtensorT<ExecSpace>&
+    local_replica(const KtensorReplicatedT<ExecSpace>& u) { return u.local(); }
+
+  }
+
+}
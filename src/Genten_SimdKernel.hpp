@@ -40,6 +40,8 @@
 
 #pragma once
 
+#include <type_traits>
+
 namespace Genten {
 namespace Impl {
 
@@ -78,5 +80,24 @@ void run_row_simd_kernel(Func& f, const unsigned nc)
     run_row_simd_kernel_impl<1>(f, nc);
 }
 
+// Call f(std::integral_constant<unsigned,ND>()) with the tensor order ND
+// known at compile time for the common orders 3 through 6, so loops over the
+// modes can be fully unrolled.  Any other order uses ND = 0, in which case
+// the kernel must fall back to the run-time order nd.
+template <typename Func>
+void run_order_kernel(const unsigned nd, const Func& f)
+{
+  if (nd == 3)
+    f(std::integral_constant<unsigned,3>());
+  else if (nd == 4)
+    f(std::integral_constant<unsigned,4>());
+  else if (nd == 5)
+    f(std::integral_constant<unsigned,5>());
+  else if (nd == 6)
+    f(std::integral_constant<unsigned,6>());
+  else
+    f(std::integral_constant<unsigned,0>());
+}
+
 }
 }
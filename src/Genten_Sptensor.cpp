@@ -229,85 +229,137 @@ divide(const Genten::KtensorT<ExecSpace> & K,
 
 namespace Genten {
 namespace Impl {
-// Implementation of createPermutation().  Has to be done as a
-// non-member function because lambda capture of *this doesn't work on Cuda.
-template <typename ExecSpace, typename subs_view_type, typename siz_type>
+// Stable LSD radix sort of the nonzeros by their subscript in mode n, which
+// lies in [0,dim).  The resulting permutation is stored in perm(:,n).  Each
+// pass sorts on a digit of at most max_radix_bits bits.  The nonzeros are
+// split into contiguous chunks, each with its own histogram, so no atomics
+// are needed and nonzeros with equal subscripts stay in their original order.
+// If rowptr is not empty, it is filled with the dim+1 offsets of the
+// first nonzero of each row in the permuted order.
+template <typename ExecSpace, typename subs_view_type, typename rowptr_type>
 void
-createPermutationImpl(const subs_view_type& perm, const subs_view_type& subs,
-                      const siz_type& siz)
+radixSortPermutation(const subs_view_type& perm, const subs_view_type& subs,
+                     const ttb_indx n, const ttb_indx dim,
+                     const rowptr_type& rowptr)
 {
-  const ttb_indx sz = subs.extent(0);
-  const ttb_indx nNumDims = subs.extent(1);
-
-  // Neither std::sort or the Kokkos sort will work with non-contiguous views,
-  // so we need to sort into temporary views
-  typedef Kokkos::View<ttb_indx*,typename subs_view_type::array_layout,ExecSpace> ViewType;
-  ViewType tmp(Kokkos::view_alloc(Kokkos::WithoutInitializing,"tmp_perm"),sz);
-
-  for (ttb_indx n = 0; n < nNumDims; ++n) {
+  typedef Kokkos::View<ttb_indx*,ExecSpace> ViewType;
+  typedef Kokkos::View<ttb_indx**,Kokkos::LayoutLeft,ExecSpace> HistType;
+  typedef Kokkos::RangePolicy<ExecSpace> Policy;
 
-// Whether to sort using Kokkos or device specific approaches
-// The Kokkos sort seems slower
-#define USE_KOKKOS_SORT 0
-#if USE_KOKKOS_SORT
-
-    typedef Kokkos::BinOp1D<ViewType> CompType;
-    // Kokkos::sort doesn't allow supplying a custom comparator, so we
-    // have to use its implementation to get the permutation vector
-    deep_copy( tmp, Kokkos::subview(subs, Kokkos::ALL(), n));
-    Kokkos::BinSort<ViewType, CompType> bin_sort(
-      tmp,CompType(sz/2,0,siz[n]),true);
-    bin_sort.create_permute_vector();
-    deep_copy( Kokkos::subview(perm, Kokkos::ALL(), n),
-               bin_sort.get_permute_vector() );
-
-#else
-
-    // Sort tmp=[1:sz] using subs(:,n) as a comparator
-    Kokkos::parallel_for(Kokkos::RangePolicy<ExecSpace>(0,sz),
-                         KOKKOS_LAMBDA(const ttb_indx i)
-    {
-      tmp(i) = i;
-    }, "Genten::Sptensor::createPermutationImpl_init_kernel");
+  const ttb_indx sz = subs.extent(0);
 
-#if defined(KOKKOS_ENABLE_CUDA)
-    if (std::is_same<ExecSpace, Kokkos::Cuda>::value) {
-      thrust::stable_sort(thrust::device_ptr<ttb_indx>(tmp.data()),
-                          thrust::device_ptr<ttb_indx>(tmp.data()+sz),
-                          KOKKOS_LAMBDA(const ttb_indx& a, const ttb_indx& b)
+  // Split the bits of the subscript into passes of roughly equal width
+  const unsigned max_radix_bits = 11;
+  unsigned nbits = 0;
+  while (nbits < 64 && (ttb_indx(1) << nbits) < dim)
+    ++nbits;
+  const unsigned npass = (nbits + max_radix_bits - 1) / max_radix_bits;
+  const unsigned radix_bits = npass == 0 ? 0 : (nbits + npass - 1) / npass;
+  const ttb_indx nbucket = ttb_indx(1) << radix_bits;
+  const ttb_indx mask = nbucket - 1;
+
+  // One chunk per thread on the host, small chunks on the GPU
+  const bool is_cuda = Genten::is_cuda_space<ExecSpace>::value;
+  const ttb_indx P = SpaceProperties<ExecSpace>::concurrency();
+  ttb_indx chunk_size = is_cuda ? 2048 : (sz + P - 1) / P;
+  if (chunk_size == 0)
+    chunk_size = 1;
+  const ttb_indx nchunk = (sz + chunk_size - 1) / chunk_size;
+
+  ViewType src(Kokkos::view_alloc(Kokkos::WithoutInitializing,"tmp_perm"),sz);
+  Kokkos::parallel_for(Policy(0,sz), KOKKOS_LAMBDA(const ttb_indx i)
+  {
+    src(i) = i;
+  }, "Genten::Sptensor::createPermutationImpl_init_kernel");
+
+  if (npass > 0) {
+    ViewType dst(Kokkos::view_alloc(Kokkos::WithoutInitializing,"tmp_perm2"),
+                 sz);
+    HistType hist("radix_hist", nchunk, nbucket);
+    for (unsigned pass = 0; pass < npass; ++pass) {
+      const unsigned shift = pass * radix_bits;
+      const ViewType s = src;
+      const ViewType d = dst;
+      if (pass > 0)
+        Kokkos::deep_copy(hist, ttb_indx(0));
+
+      // Count digits within each chunk
+      Kokkos::parallel_for(Policy(0,nchunk), KOKKOS_LAMBDA(const ttb_indx c)
+      {
+        const ttb_indx b = c * chunk_size;
+        const ttb_indx e = b + chunk_size < sz ? b + chunk_size : sz;
+        for (ttb_indx i = b; i < e; ++i)
+          ++hist(c, (subs(s(i),n) >> shift) & mask);
+      }, "Genten::Sptensor::createPermutationImpl_count_kernel");
+
+      // Exclusive scan in digit-major order gives each chunk the offset of
+      // its first nonzero for each digit
+      Kokkos::parallel_scan("Genten::Sptensor::createPermutationImpl_scan_kernel",
+                            Policy(0,nchunk*nbucket),
+                            KOKKOS_LAMBDA(const ttb_indx k, ttb_indx& sum,
+                                          const bool final)
       {
-        return (subs(a,n) < subs(b,n));
+        const ttb_indx c = k % nchunk;
+        const ttb_indx r = k / nchunk;
+        const ttb_indx h = hist(c,r);
+        if (final)
+          hist(c,r) = sum;
+        sum += h;
       });
-    }
-    else
-#endif
 
-#if defined(KOKKOS_ENABLE_OPENMP)
-    if (std::is_same<ExecSpace, Kokkos::OpenMP>::value) {
-      pss::parallel_stable_sort(tmp.data(), tmp.data()+sz,
-                                [&](const ttb_indx& a, const ttb_indx& b)
+      // Scatter each chunk in order
+      Kokkos::parallel_for(Policy(0,nchunk), KOKKOS_LAMBDA(const ttb_indx c)
       {
-        return (subs(a,n) < subs(b,n));
-      });
-    }
-    else
-#endif
+        const ttb_indx b = c * chunk_size;
+        const ttb_indx e = b + chunk_size < sz ? b + chunk_size : sz;
+        for (ttb_indx i = b; i < e; ++i) {
+          const ttb_indx j = s(i);
+          d(hist(c, (subs(j,n) >> shift) & mask)++) = j;
+        }
+      }, "Genten::Sptensor::createPermutationImpl_scatter_kernel");
 
-    std::stable_sort(tmp.data(), tmp.data()+sz,
-                     [&](const ttb_indx& a, const ttb_indx& b)
-    {
-      return (subs(a,n) < subs(b,n));
-    });
+      std::swap(src, dst);
+    }
+  }
 
+  deep_copy( Kokkos::subview(perm, Kokkos::ALL(), n), src );
 
-    deep_copy( Kokkos::subview(perm, Kokkos::ALL(), n), tmp );
+  // Row pointers:  rowptr(r) is the first position with subscript >= r
+  if (rowptr.extent(0) > 0) {
+    const ViewType p = src;
+    Kokkos::parallel_for(Policy(0,sz+1), KOKKOS_LAMBDA(const ttb_indx i)
+    {
+      const ttb_indx lo = i == 0 ? 0 : subs(p(i-1),n)+1;
+      const ttb_indx hi = i == sz ? dim : subs(p(i),n);
+      for (ttb_indx r = lo; r <= hi && r <= dim; ++r)
+        rowptr(r) = i;
+    }, "Genten::Sptensor::createPermutationImpl_rowptr_kernel");
+  }
+}
 
-#endif
+// Implementation of createPermutation().  Has to be done as a
+// non-member function because lambda capture of *this doesn't work on Cuda.
+// If rowptr is not empty, it is filled with the row pointers of each mode
+// one after the other, i.e., mode n occupies siz[n]+1 entries.
+template <typename ExecSpace, typename subs_view_type, typename siz_type,
+          typename rowptr_type>
+void
+createPermutationImpl(const subs_view_type& perm, const subs_view_type& subs,
+                      const siz_type& siz, const rowptr_type& rowptr)
+{
+  const ttb_indx sz = subs.extent(0);
+  const ttb_indx nNumDims = subs.extent(1);
 
+  ttb_indx offset = 0;
+  for (ttb_indx n = 0; n < nNumDims; ++n) {
+    rowptr_type rowptr_n;
+    if (rowptr.extent(0) > 0)
+      rowptr_n = Kokkos::subview(
+        rowptr, std::make_pair(offset, offset+siz[n]+1));
+    radixSortPermutation<ExecSpace>(perm, subs, n, siz[n], rowptr_n);
+    offset += siz[n]+1;
   }
 
-#undef USE_KOKKOS_SORT
-
   const bool check = false;
   if (check) {
     for (ttb_indx n = 0; n < nNumDims; ++n) {
@@ -402,7 +454,7 @@ sortImpl(vals_type& vals, subs_type& subs)
 
 template <typename ExecSpace>
 void Genten::SptensorT<ExecSpace>::
-createPermutation()
+createPermutation(const bool row_ptrs)
 {
 #ifdef HAVE_CALIPER
   cali::Function cali_func("Genten::Sptensor::createPermutation()");
@@ -416,7 +468,28 @@ createPermutation()
                                              "Genten::Sptensor_kokkos::perm"),
                           sz, nNumDims);
   }
-  Genten::Impl::createPermutationImpl<ExecSpace>(perm, subs, siz);
+
+  // Row pointers for mode n start at perm_rowptr_begin[n]
+  if (row_ptrs) {
+    IndxArrayT<host_mirror_space> begin_host(nNumDims+1);
+    begin_host[0] = 0;
+    for (ttb_indx n = 0; n < nNumDims; ++n)
+      begin_host[n+1] = begin_host[n] + siz_host[n] + 1;
+    perm_rowptr_begin = create_mirror_view(ExecSpace(), begin_host);
+    deep_copy(perm_rowptr_begin, begin_host);
+    if (perm_rowptr.extent(0) != begin_host[nNumDims])
+      perm_rowptr = Kokkos::View<ttb_indx*,ExecSpace>(
+        Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                           "Genten::Sptensor_kokkos::perm_rowptr"),
+        begin_host[nNumDims]);
+  }
+  else {
+    perm_rowptr = Kokkos::View<ttb_indx*,ExecSpace>();
+    perm_rowptr_begin = IndxArrayT<ExecSpace>();
+  }
+
+  Genten::Impl::createPermutationImpl<ExecSpace>(
+    perm, subs, siz_host, perm_rowptr);
 }
 
 template <typename ExecSpace>
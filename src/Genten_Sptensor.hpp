@@ -283,13 +283,26 @@ public:
   KOKKOS_INLINE_FUNCTION
   subs_view_type getPerm() const { return perm; }
 
-  // Create permutation array by sorting each column of subs
-  void createPermutation();
+  // Create permutation array by sorting each column of subs.  If row_ptrs
+  // is true, also compute the row pointers for each mode.
+  void createPermutation(const bool row_ptrs = false);
 
   // Whether permutation array is computed
   KOKKOS_INLINE_FUNCTION
   bool havePerm() const { return perm.span() == subs.span(); }
 
+  // Return position in perm(:,n) of the first nonzero with subscript >= r
+  // in mode n, for 0 <= r <= size(n)
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx getPermRowPtr(ttb_indx r, ttb_indx n) const
+  {
+    return perm_rowptr(perm_rowptr_begin[n]+r);
+  }
+
+  // Whether row pointers are computed along with the permutation array
+  KOKKOS_INLINE_FUNCTION
+  bool havePermRowPtr() const { return havePerm() && perm_rowptr.span() > 0; }
+
   // Sort tensor lexicographically
   void sort();
 
@@ -347,6 +360,11 @@ protected:
   // Permutation array for iterating over subs in non-decreasing fashion
   subs_view_type perm;
 
+  // Row pointers into perm for each mode, stored one mode after the other
+  // starting at perm_rowptr_begin[n].  Not copied by create_mirror_view().
+  Kokkos::View<ttb_indx*,ExecSpace> perm_rowptr;
+  IndxArrayT<ExecSpace> perm_rowptr_begin;
+
   // Whether tensor has been sorted
   bool is_sorted;
 
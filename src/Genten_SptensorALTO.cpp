@@ -0,0 +1,152 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+#include <algorithm>
+
+#include "Genten_SptensorALTO.hpp"
+#include "Genten_KokkosAlgs.hpp"
+
+#ifdef HAVE_CALIPER
+#include <caliper/cali.h>
+#endif
+
+template <typename ExecSpace>
+constexpr unsigned Genten::SptensorALTOT<ExecSpace>::max_words;
+
+template <typename ExecSpace>
+Genten::SptensorALTOT<ExecSpace>::
+SptensorALTOT(const SptensorT<ExecSpace>& X) :
+  siz(X.size()), siz_host(X.ndims()), nNumDims(X.ndims()), nWords(0)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::SptensorALTO::SptensorALTO");
+#endif
+
+  typedef typename SptensorT<ExecSpace>::subs_view_type subs_view_type;
+  typedef typename SptensorT<ExecSpace>::vals_view_type x_vals_view_type;
+  typedef Kokkos::RangePolicy<ExecSpace> Policy;
+
+  const ttb_indx nd = nNumDims;
+  const ttb_indx nz = X.nnz();
+
+  // Number of bits needed for each mode
+  std::vector<unsigned> nbits(nd);
+  unsigned total_bits = 0;
+  unsigned max_bits = 0;
+  for (ttb_indx m=0; m<nd; ++m) {
+    siz_host[m] = X.size_host()[m];
+    unsigned b = 0;
+    while (b < 64 && (ttb_indx(1) << b) < siz_host[m])
+      ++b;
+    nbits[m] = b;
+    total_bits += b;
+    max_bits = std::max(max_bits, b);
+  }
+  if (total_bits > 64*max_words)
+    Genten::error("Genten::SptensorALTO - subscripts need " +
+                  std::to_string(total_bits) + " bits, but at most " +
+                  std::to_string(64*max_words) + " are supported");
+  nWords = total_bits <= 64 ? 1 : 2;
+
+  // Interleave the bits of each mode round-robin from least significant
+  bits = bits_view_type("Genten::SptensorALTO::bits", nd);
+  pos = pos_view_type("Genten::SptensorALTO::pos", nd, std::max(max_bits,1u));
+  auto bits_host = create_mirror_view(bits);
+  auto pos_host = create_mirror_view(pos);
+  unsigned p = 0;
+  for (unsigned b=0; b<max_bits; ++b)
+    for (ttb_indx m=0; m<nd; ++m)
+      if (b < nbits[m])
+        pos_host(m,b) = p++;
+  for (ttb_indx m=0; m<nd; ++m)
+    bits_host(m) = nbits[m];
+  deep_copy(bits, bits_host);
+  deep_copy(pos, pos_host);
+
+  // Encode keys in the original order
+  const subs_view_type subs = X.getSubscripts();
+  const x_vals_view_type xvals = X.getValues();
+  keys_view_type unsorted_keys(
+    Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                       "Genten::SptensorALTO::unsorted_keys"), nz, nWords);
+  const SptensorALTOT alto = *this;
+  Kokkos::parallel_for("Genten::SptensorALTO::encode", Policy(0,nz),
+                       KOKKOS_LAMBDA(const ttb_indx i)
+  {
+    alto.encode(Kokkos::subview(subs,i,Kokkos::ALL),
+                &unsorted_keys(i,0));
+  });
+
+  // Sort by key
+  const unsigned nw = nWords;
+  Kokkos::View<ttb_indx*,ExecSpace> perm(
+    Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                       "Genten::SptensorALTO::perm"), nz);
+#if defined(KOKKOS_ENABLE_CUDA)
+  perm_sort_op(perm, KOKKOS_LAMBDA(const ttb_indx& a, const ttb_indx& b)
+#else
+  perm_sort_op(perm, [&](const ttb_indx& a, const ttb_indx& b)
+#endif
+  {
+    for (unsigned w=0; w<nw; ++w)
+      if (unsorted_keys(a,w) != unsorted_keys(b,w))
+        return unsorted_keys(a,w) < unsorted_keys(b,w);
+    return false;
+  });
+
+  keys = keys_view_type(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                           "Genten::SptensorALTO::keys"),
+                        nz, nWords);
+  vals = vals_view_type(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                           "Genten::SptensorALTO::vals"), nz);
+  const keys_view_type k = keys;
+  const vals_view_type v = vals;
+  Kokkos::parallel_for("Genten::SptensorALTO::permute", Policy(0,nz),
+                       KOKKOS_LAMBDA(const ttb_indx i)
+  {
+    const ttb_indx j = perm(i);
+    for (unsigned w=0; w<nw; ++w)
+      k(i,w) = unsorted_keys(j,w);
+    v(i) = xvals(j);
+  });
+}
+
+#define INST_MACRO(SPACE) template class Genten::SptensorALTOT<SPACE>;
+GENTEN_INST(INST_MACRO)
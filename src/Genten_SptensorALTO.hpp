@@ -0,0 +1,248 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+/*!
+  @file Genten_SptensorALTO.hpp
+  @brief Sparse tensor stored with linearized, bit-interleaved (ALTO) keys.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "Genten_Util.hpp"
+#include "Genten_IndxArray.hpp"
+#include "Genten_Sptensor.hpp"
+
+namespace Genten
+{
+
+template <typename ExecSpace> class SptensorALTOT;
+typedef SptensorALTOT<DefaultHostExecutionSpace> SptensorALTO;
+
+// Sparse tensor with all subscripts of a nonzero packed into one key.
+/* Mode m needs bits[m] = ceil(log2(size(m))) bits.  The bits of all modes
+   are interleaved round-robin starting from the least significant bit, so
+   bit b of mode m lands at position pos(m,b) in the key.  The keys are
+   64 bits if the bits of all modes fit, and 128 bits (two words, most
+   significant first) otherwise.  The nonzeros are sorted by key, which
+   orders them along a space-filling curve with good locality in every mode
+   at once, and lets a subscript be found with a binary search on integer
+   keys.
+
+   The subscript() method decodes a key, so the COO MTTKRP kernel computes
+   all modes from this one copy without per-mode permutations.  The find(),
+   valid_at() and value_at() methods provide the same lookup interface as
+   TensorHashMap for the GCP samplers.
+*/
+template <typename ExecSpace>
+class SptensorALTOT
+{
+public:
+
+  typedef ExecSpace exec_space;
+  typedef uint64_t word_type;
+  typedef Kokkos::View<word_type**,Kokkos::LayoutRight,ExecSpace> keys_view_type;
+  typedef Kokkos::View<ttb_real*,Kokkos::LayoutRight,ExecSpace> vals_view_type;
+  typedef Kokkos::View<unsigned**,Kokkos::LayoutRight,ExecSpace> pos_view_type;
+  typedef Kokkos::View<unsigned*,Kokkos::LayoutRight,ExecSpace> bits_view_type;
+  typedef ttb_indx size_type;
+
+  // Largest number of words in a key
+  static constexpr unsigned max_words = 2;
+
+  // Empty constructor
+  SptensorALTOT() : siz(), siz_host(), nNumDims(0), nWords(0), keys(),
+                    vals(), pos(), bits() {}
+
+  // Construct from sparse tensor.  Throws if the subscripts need more than
+  // 128 bits.
+  SptensorALTOT(const SptensorT<ExecSpace>& X);
+
+  KOKKOS_DEFAULTED_FUNCTION
+  SptensorALTOT(const SptensorALTOT&) = default;
+
+  KOKKOS_DEFAULTED_FUNCTION
+  SptensorALTOT& operator=(const SptensorALTOT&) = default;
+
+  KOKKOS_DEFAULTED_FUNCTION
+  ~SptensorALTOT() = default;
+
+  // Return the number of dimensions (i.e., the order).
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx ndims() const { return nNumDims; }
+
+  // Return size of dimension i.
+  ttb_indx size(ttb_indx i) const { return siz_host[i]; }
+
+  // Return the entire size array.
+  KOKKOS_INLINE_FUNCTION
+  const IndxArrayT<ExecSpace>& size() const { return siz; }
+
+  // Return the entire size array on the host.
+  const IndxArray& size_host() const { return siz_host; }
+
+  // Return the number of structural nonzeros.
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx nnz() const { return vals.extent(0); }
+
+  // Return the number of 64-bit words in each key (1 or 2).
+  KOKKOS_INLINE_FUNCTION
+  unsigned nwords() const { return nWords; }
+
+  // Get whole values array
+  KOKKOS_INLINE_FUNCTION
+  vals_view_type getValues() const { return vals; }
+
+  // Return value of nonzero i
+  KOKKOS_INLINE_FUNCTION
+  ttb_real value(ttb_indx i) const { return vals(i); }
+
+  // Return word w of the key for nonzero i
+  KOKKOS_INLINE_FUNCTION
+  word_type key(ttb_indx i, unsigned w) const { return keys(i,w); }
+
+  // Return subscript of nonzero i in dimension m, decoded from its key
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx subscript(ttb_indx i, ttb_indx m) const {
+    const unsigned nb = bits(m);
+    ttb_indx s = 0;
+    for (unsigned b=0; b<nb; ++b) {
+      const unsigned p = pos(m,b);
+      const word_type w = keys(i, nWords-1-p/64);
+      s |= ttb_indx((w >> (p%64)) & 1) << b;
+    }
+    return s;
+  }
+
+  // Encode subscripts ind into key k (of length nwords())
+  template <typename ind_type>
+  KOKKOS_INLINE_FUNCTION
+  void encode(const ind_type& ind, word_type* k) const {
+    for (unsigned w=0; w<nWords; ++w)
+      k[w] = 0;
+    for (ttb_indx m=0; m<nNumDims; ++m) {
+      const unsigned nb = bits(m);
+      const ttb_indx s = ind[m];
+      for (unsigned b=0; b<nb; ++b) {
+        const unsigned p = pos(m,b);
+        k[nWords-1-p/64] |= word_type((s >> b) & 1) << (p%64);
+      }
+    }
+  }
+
+  // Return smallest i such that key(i) >= k
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx lower_bound(const word_type* k) const {
+    ttb_indx first = 0;
+    ttb_indx count = nnz();
+    while (count > 0) {
+      const ttb_indx step = count / 2;
+      const ttb_indx i = first + step;
+      if (key_less(i, k)) {
+        first = i + 1;
+        count -= step + 1;
+      }
+      else
+        count = step;
+    }
+    return first;
+  }
+
+  // Return position of the nonzero with subscripts ind, or nnz() if there
+  // is none
+  template <typename ind_type>
+  KOKKOS_INLINE_FUNCTION
+  size_type find(const ind_type& ind) const {
+    word_type k[max_words];
+    encode(ind, k);
+    const ttb_indx i = lower_bound(k);
+    if (i < nnz() && key_equal(i, k))
+      return i;
+    return nnz();
+  }
+
+  // Return whether there is a nonzero with subscripts ind
+  template <typename ind_type>
+  KOKKOS_INLINE_FUNCTION
+  bool exists(const ind_type& ind) const { return find(ind) < nnz(); }
+
+  // Return whether the position returned by find() is a nonzero
+  KOKKOS_INLINE_FUNCTION
+  bool valid_at(const size_type i) const { return i < nnz(); }
+
+  // Return the value at the position returned by find()
+  KOKKOS_INLINE_FUNCTION
+  ttb_real value_at(const size_type i) const { return vals(i); }
+
+  // Memory used by the keys and values in bytes
+  size_t memory() const {
+    return keys.span()*sizeof(word_type) + vals.span()*sizeof(ttb_real);
+  }
+
+private:
+
+  KOKKOS_INLINE_FUNCTION
+  bool key_less(const ttb_indx i, const word_type* k) const {
+    for (unsigned w=0; w<nWords; ++w)
+      if (keys(i,w) != k[w])
+        return keys(i,w) < k[w];
+    return false;
+  }
+
+  KOKKOS_INLINE_FUNCTION
+  bool key_equal(const ttb_indx i, const word_type* k) const {
+    for (unsigned w=0; w<nWords; ++w)
+      if (keys(i,w) != k[w])
+        return false;
+    return true;
+  }
+
+  IndxArrayT<ExecSpace> siz;
+  IndxArray siz_host;
+  ttb_indx nNumDims;
+  unsigned nWords;
+  keys_view_type keys;
+  vals_view_type vals;
+  pos_view_type pos;
+  bits_view_type bits;
+};
+
+}
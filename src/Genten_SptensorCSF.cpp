@@ -0,0 +1,310 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+#include <algorithm>
+#include <numeric>
+
+#include "Genten_SptensorCSF.hpp"
+#include "Genten_KokkosAlgs.hpp"
+
+#ifdef HAVE_CALIPER
+#include <caliper/cali.h>
+#endif
+
+template <typename ExecSpace>
+Genten::CSFTreeT<ExecSpace>::
+CSFTreeT(const SptensorT<ExecSpace>& X, const IndxArray& order_)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::CSFTree::CSFTree");
+#endif
+
+  typedef typename SptensorT<ExecSpace>::subs_view_type subs_view_type;
+  typedef typename SptensorT<ExecSpace>::vals_view_type x_vals_view_type;
+  typedef Kokkos::RangePolicy<ExecSpace> Policy;
+
+  const ttb_indx nd = X.ndims();
+  const ttb_indx nz = X.nnz();
+  if (nd < 2)
+    Genten::error("Genten::CSFTree - CSF format requires at least 2 modes");
+  if (order_.size() != nd)
+    Genten::error("Genten::CSFTree - mode ordering has the wrong length");
+
+  order_host = order_.clone();
+  order = create_mirror_view(ExecSpace(), order_host);
+  deep_copy(order, order_host);
+
+  const subs_view_type subs = X.getSubscripts();
+  const x_vals_view_type xvals = X.getValues();
+  const IndxArrayT<ExecSpace> ord = order;
+
+  // Sort nonzeros lexicographically by the mode ordering
+  indx_view_type perm(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                         "Genten::CSFTree::perm"), nz);
+#if defined(KOKKOS_ENABLE_CUDA)
+  perm_sort_op(perm, KOKKOS_LAMBDA(const ttb_indx& a, const ttb_indx& b)
+#else
+  perm_sort_op(perm, [&](const ttb_indx& a, const ttb_indx& b)
+#endif
+  {
+    for (ttb_indx l=0; l<nd; ++l) {
+      const ttb_indx ia = subs(a,ord[l]);
+      const ttb_indx ib = subs(b,ord[l]);
+      if (ia != ib)
+        return ia < ib;
+    }
+    return false;
+  });
+
+  // Compute the first level at which the subscripts of each nonzero differ
+  // from the previous one.  Nonzero k starts a new node at level l if and
+  // only if depth(k) <= l (and it is always a new leaf).
+  indx_view_type depth(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                          "Genten::CSFTree::depth"), nz);
+  Kokkos::parallel_for("Genten::CSFTree::depth", Policy(0,nz),
+                       KOKKOS_LAMBDA(const ttb_indx k)
+  {
+    ttb_indx l = 0;
+    if (k > 0) {
+      const ttb_indx p = perm(k);
+      const ttb_indx q = perm(k-1);
+      while (l < nd-1 && subs(p,ord[l]) == subs(q,ord[l]))
+        ++l;
+    }
+    depth(k) = l;
+  });
+
+  // Count the nodes at each level
+  std::vector<ttb_indx> nnodes(nd);
+  for (ttb_indx l=0; l<nd-1; ++l) {
+    ttb_indx cnt = 0;
+    Kokkos::parallel_reduce("Genten::CSFTree::count", Policy(0,nz),
+                            KOKKOS_LAMBDA(const ttb_indx k, ttb_indx& c)
+    {
+      if (depth(k) <= l)
+        ++c;
+    }, cnt);
+    nnodes[l] = cnt;
+  }
+  nnodes[nd-1] = nz;
+
+  id_off_host = IndxArray(nd+1);
+  IndxArray ptr_off_host(nd);
+  id_off_host[0] = 0;
+  ptr_off_host[0] = 0;
+  for (ttb_indx l=0; l<nd; ++l) {
+    id_off_host[l+1] = id_off_host[l] + nnodes[l];
+    if (l < nd-1)
+      ptr_off_host[l+1] = ptr_off_host[l] + nnodes[l] + 1;
+  }
+  id_off = create_mirror_view(ExecSpace(), id_off_host);
+  deep_copy(id_off, id_off_host);
+  ptr_off = create_mirror_view(ExecSpace(), ptr_off_host);
+  deep_copy(ptr_off, ptr_off_host);
+
+  ids = indx_view_type(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                          "Genten::CSFTree::ids"),
+                       id_off_host[nd]);
+  ptr = indx_view_type(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                          "Genten::CSFTree::ptr"),
+                       ptr_off_host[nd-1]);
+  vals = vals_view_type(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                           "Genten::CSFTree::vals"), nz);
+
+  // Fill in each level.  The node number of each nonzero at level l is the
+  // number of nodes started before it, which is an exclusive scan.  The
+  // first child of a node at level l-1 is the node at level l started by
+  // the same nonzero.  Only nonzeros starting a node at level l-1 have a
+  // valid node number there, so only they set child pointers.
+  indx_view_type nid_prev(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                             "Genten::CSFTree::nid_prev"), nz);
+  indx_view_type nid(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                        "Genten::CSFTree::nid"), nz);
+  const indx_view_type ids_ = ids;
+  const indx_view_type ptr_ = ptr;
+  for (ttb_indx l=0; l<nd; ++l) {
+    Kokkos::parallel_scan("Genten::CSFTree::node_ids", Policy(0,nz),
+                          KOKKOS_LAMBDA(const ttb_indx k, ttb_indx& update,
+                                        const bool final)
+    {
+      if (final)
+        nid(k) = update;
+      if (depth(k) <= l)
+        ++update;
+    });
+
+    const ttb_indx ioff = id_off_host[l];
+    const ttb_indx poff = l > 0 ? ptr_off_host[l-1] : 0;
+    Kokkos::parallel_for("Genten::CSFTree::fill", Policy(0,nz),
+                         KOKKOS_LAMBDA(const ttb_indx k)
+    {
+      if (depth(k) <= l) {
+        ids_(ioff+nid(k)) = subs(perm(k),ord[l]);
+        if (l > 0 && depth(k) < l)
+          ptr_(poff+nid_prev(k)) = nid(k);
+      }
+    });
+    if (l > 0)
+      Kokkos::deep_copy(Kokkos::subview(ptr, poff+nnodes[l-1]), nnodes[l]);
+
+    std::swap(nid, nid_prev);
+  }
+
+  const vals_view_type vals_ = vals;
+  Kokkos::parallel_for("Genten::CSFTree::vals", Policy(0,nz),
+                       KOKKOS_LAMBDA(const ttb_indx k)
+  {
+    vals_(k) = xvals(perm(k));
+  });
+}
+
+template <typename ExecSpace>
+ttb_indx
+Genten::CSFTreeT<ExecSpace>::
+level_host(const ttb_indx n) const
+{
+  const ttb_indx nd = order_host.size();
+  for (ttb_indx l=0; l<nd; ++l)
+    if (order_host[l] == n)
+      return l;
+  Genten::error("Genten::CSFTree::level_host - mode not found");
+  return nd;
+}
+
+template <typename ExecSpace>
+Genten::SptensorCSFT<ExecSpace>::
+SptensorCSFT(const SptensorT<ExecSpace>& X,
+             const std::vector<IndxArray>& orders) :
+  siz(X.size()), siz_host(X.ndims()), nNumDims(X.ndims()), nNonz(X.nnz())
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::SptensorCSF::SptensorCSF");
+#endif
+
+  for (ttb_indx i=0; i<nNumDims; ++i)
+    siz_host[i] = X.size_host()[i];
+  for (const auto& order : orders)
+    trees.push_back(tree_type(X, order));
+}
+
+template <typename ExecSpace>
+Genten::SptensorCSFT<ExecSpace>::
+SptensorCSFT(const SptensorT<ExecSpace>& X, const AlgParams& algParams) :
+  SptensorCSFT()
+{
+  IndxArray sz(X.ndims());
+  for (ttb_indx i=0; i<X.ndims(); ++i)
+    sz[i] = X.size_host()[i];
+
+  std::vector<IndxArray> orders;
+  if (algParams.mttkrp_csf_all_modes) {
+    for (ttb_indx n=0; n<X.ndims(); ++n)
+      orders.push_back(mode_order(sz, n));
+  }
+  else {
+    // Root the tree at the shortest mode
+    ttb_indx n = 0;
+    for (ttb_indx i=1; i<X.ndims(); ++i)
+      if (sz[i] < sz[n])
+        n = i;
+    orders.push_back(mode_order(sz, n));
+  }
+  *this = SptensorCSFT(X, orders);
+}
+
+template <typename ExecSpace>
+Genten::SptensorCSFT<ExecSpace>::
+SptensorCSFT(const SptensorT<ExecSpace>& X, const ttb_indx n) :
+  SptensorCSFT()
+{
+  IndxArray sz(X.ndims());
+  for (ttb_indx i=0; i<X.ndims(); ++i)
+    sz[i] = X.size_host()[i];
+  *this = SptensorCSFT(X, std::vector<IndxArray>(1, mode_order(sz, n)));
+}
+
+template <typename ExecSpace>
+Genten::IndxArray
+Genten::SptensorCSFT<ExecSpace>::
+mode_order(const IndxArray& sz, const ttb_indx n)
+{
+  const ttb_indx nd = sz.size();
+  std::vector<ttb_indx> modes;
+  for (ttb_indx i=0; i<nd; ++i)
+    if (i != n)
+      modes.push_back(i);
+  std::stable_sort(modes.begin(), modes.end(),
+                   [&](const ttb_indx a, const ttb_indx b)
+  {
+    return sz[a] < sz[b];
+  });
+  IndxArray order(nd);
+  order[0] = n;
+  for (ttb_indx i=1; i<nd; ++i)
+    order[i] = modes[i-1];
+  return order;
+}
+
+template <typename ExecSpace>
+ttb_indx
+Genten::SptensorCSFT<ExecSpace>::
+rootTree(const ttb_indx n) const
+{
+  for (ttb_indx t=0; t<trees.size(); ++t)
+    if (trees[t].mode_host(0) == n)
+      return t;
+  return ttb_indx(-1);
+}
+
+template <typename ExecSpace>
+size_t
+Genten::SptensorCSFT<ExecSpace>::
+memory() const
+{
+  size_t bytes = 0;
+  for (const auto& tree : trees)
+    bytes += tree.memory();
+  return bytes;
+}
+
+#define INST_MACRO(SPACE)                                               \
+  template class Genten::CSFTreeT<SPACE>;                               \
+  template class Genten::SptensorCSFT<SPACE>;
+GENTEN_INST(INST_MACRO)
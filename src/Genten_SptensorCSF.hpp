@@ -0,0 +1,231 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+/*!
+  @file Genten_SptensorCSF.hpp
+  @brief Sparse tensor stored in compressed sparse fiber (CSF) format.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "Genten_Util.hpp"
+#include "Genten_IndxArray.hpp"
+#include "Genten_Sptensor.hpp"
+#include "Genten_AlgParams.hpp"
+
+namespace Genten
+{
+
+template <typename ExecSpace> class SptensorCSFT;
+typedef SptensorCSFT<DefaultHostExecutionSpace> SptensorCSF;
+
+// One CSF tree:  the nonzeros sorted lexicographically by a mode ordering
+// and compressed into a forest of fibers.
+/* Level l of the tree corresponds to mode order[l].  Each node at level l
+   stores its index in that mode, and (for l < nd-1) the range of its
+   children at level l+1.  The leaves (level nd-1) are the nonzeros
+   themselves.  The levels are stored concatenated in single arrays, with
+   offsets giving the start of each level:
+     ids(id_off[l]+i)       index of node i at level l
+     ptr(ptr_off[l]+i)      first child (at level l+1) of node i at level l
+     ptr(ptr_off[l]+i+1)    one past its last child
+*/
+template <typename ExecSpace>
+class CSFTreeT
+{
+public:
+
+  typedef ExecSpace exec_space;
+  typedef Kokkos::View<ttb_indx*,Kokkos::LayoutRight,ExecSpace> indx_view_type;
+  typedef Kokkos::View<ttb_real*,Kokkos::LayoutRight,ExecSpace> vals_view_type;
+
+  KOKKOS_DEFAULTED_FUNCTION
+  CSFTreeT() = default;
+
+  // Build tree from a sparse tensor using the given mode ordering
+  CSFTreeT(const SptensorT<ExecSpace>& X, const IndxArray& order);
+
+  KOKKOS_DEFAULTED_FUNCTION
+  CSFTreeT(const CSFTreeT&) = default;
+
+  KOKKOS_DEFAULTED_FUNCTION
+  CSFTreeT& operator=(const CSFTreeT&) = default;
+
+  KOKKOS_DEFAULTED_FUNCTION
+  ~CSFTreeT() = default;
+
+  // Number of levels (equal to the number of tensor dimensions)
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx nlevels() const { return order.size(); }
+
+  // Mode at level l
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx mode(const ttb_indx l) const { return order[l]; }
+
+  // Mode at level l (host)
+  ttb_indx mode_host(const ttb_indx l) const { return order_host[l]; }
+
+  // Level at which mode n appears (host)
+  ttb_indx level_host(const ttb_indx n) const;
+
+  // Number of nodes at level l (host)
+  ttb_indx nnodes_host(const ttb_indx l) const {
+    return id_off_host[l+1]-id_off_host[l];
+  }
+
+  // Index of node i at level l
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx id(const ttb_indx l, const ttb_indx i) const {
+    return ids(id_off[l]+i);
+  }
+
+  // First child of node i at level l
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx child_begin(const ttb_indx l, const ttb_indx i) const {
+    return ptr(ptr_off[l]+i);
+  }
+
+  // One past the last child of node i at level l
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx child_end(const ttb_indx l, const ttb_indx i) const {
+    return ptr(ptr_off[l]+i+1);
+  }
+
+  // Value of leaf i
+  KOKKOS_INLINE_FUNCTION
+  ttb_real value(const ttb_indx i) const { return vals(i); }
+
+  // Total memory used by the tree in bytes
+  size_t memory() const {
+    return ids.span()*sizeof(ttb_indx) + ptr.span()*sizeof(ttb_indx) +
+      vals.span()*sizeof(ttb_real);
+  }
+
+private:
+
+  IndxArrayT<ExecSpace> order;
+  IndxArray order_host;
+  IndxArrayT<ExecSpace> id_off;
+  IndxArray id_off_host;
+  IndxArrayT<ExecSpace> ptr_off;
+  indx_view_type ids;
+  indx_view_type ptr;
+  vals_view_type vals;
+};
+
+// Sparse tensor in compressed sparse fiber format.
+/* Holds one or more CSF trees of the same tensor, each with a different
+   mode ordering.  MTTKRP for a mode that is the root of one of the trees
+   needs no atomics; other modes use the first tree and atomically update
+   the result.  Subscripts shared by nonzeros along a fiber are stored once,
+   and MTTKRP reuses the partial Hadamard products at each level of the
+   tree, reducing memory traffic relative to the coordinate format.
+*/
+template <typename ExecSpace>
+class SptensorCSFT
+{
+public:
+
+  typedef ExecSpace exec_space;
+  typedef CSFTreeT<ExecSpace> tree_type;
+
+  // Empty constructor
+  SptensorCSFT() : siz(), siz_host(), nNumDims(0), nNonz(0), trees() {}
+
+  // Construct from sparse tensor using the supplied mode orderings, one for
+  // each tree
+  SptensorCSFT(const SptensorT<ExecSpace>& X,
+               const std::vector<IndxArray>& orders);
+
+  // Construct from sparse tensor, choosing trees based on algParams:
+  // one tree with the shortest mode as the root, or one tree rooted at each
+  // mode if algParams.mttkrp_csf_all_modes is true.
+  SptensorCSFT(const SptensorT<ExecSpace>& X, const AlgParams& algParams);
+
+  // Construct from sparse tensor with a single tree rooted at mode n
+  SptensorCSFT(const SptensorT<ExecSpace>& X, const ttb_indx n);
+
+  ~SptensorCSFT() = default;
+  SptensorCSFT(const SptensorCSFT&) = default;
+  SptensorCSFT& operator=(const SptensorCSFT&) = default;
+
+  // Mode ordering rooted at mode n with the remaining modes ordered from
+  // shortest to longest (which minimizes the number of fibers)
+  static IndxArray mode_order(const IndxArray& sz, const ttb_indx n);
+
+  // Return the number of dimensions (i.e., the order).
+  ttb_indx ndims() const { return nNumDims; }
+
+  // Return size of dimension i.
+  ttb_indx size(ttb_indx i) const { return siz_host[i]; }
+
+  // Return the entire size array.
+  const IndxArrayT<ExecSpace>& size() const { return siz; }
+
+  // Return the entire size array on the host.
+  const IndxArray& size_host() const { return siz_host; }
+
+  // Return the number of structural nonzeros.
+  ttb_indx nnz() const { return nNonz; }
+
+  // Return the number of trees
+  ttb_indx ntrees() const { return trees.size(); }
+
+  // Return tree t
+  const tree_type& tree(const ttb_indx t) const { return trees[t]; }
+
+  // Return the tree rooted at mode n, or -1 if there is none
+  ttb_indx rootTree(const ttb_indx n) const;
+
+  // Total memory used by all trees in bytes
+  size_t memory() const;
+
+private:
+
+  IndxArrayT<ExecSpace> siz;
+  IndxArray siz_host;
+  ttb_indx nNumDims;
+  ttb_indx nNonz;
+  std::vector<tree_type> trees;
+};
+
+}
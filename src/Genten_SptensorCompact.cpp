@@ -0,0 +1,208 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+
+#include "Genten_SptensorCompact.hpp"
+
+#ifdef KOKKOS_ENABLE_OPENMP
+#include "parallel_stable_sort.hpp"
+#endif
+
+#ifdef HAVE_CALIPER
+#include <caliper/cali.h>
+#endif
+
+Genten::SptensorIndexMap
+Genten::compact_sptensor(Sptensor& X)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::compact_sptensor");
+#endif
+
+  typedef DefaultHostExecutionSpace host_space;
+  typedef Kokkos::RangePolicy<host_space> Policy;
+  typedef Kokkos::View<ttb_indx*,Kokkos::HostSpace> keys_type;
+
+  const ttb_indx nd = X.ndims();
+  const ttb_indx nnz = X.nnz();
+  auto subs = X.getSubscripts();
+
+  IndxArray orig_sz(nd);
+  IndxArray new_sz(nd);
+  std::vector<IndxArray> new_to_old(nd);
+  for (ttb_indx n=0; n<nd; ++n) {
+    const ttb_indx sz = X.size(n);
+    orig_sz[n] = sz;
+
+    // Sort a copy of the subscripts, so memory scales with the number of
+    // nonzeros rather than the size of the mode
+    keys_type keys(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                      "Genten::compact_sptensor::keys"), nnz);
+    Kokkos::parallel_for("Genten::compact_sptensor::copy", Policy(0,nnz),
+                         KOKKOS_LAMBDA(const ttb_indx i)
+    {
+      keys(i) = subs(i,n);
+    });
+#ifdef KOKKOS_ENABLE_OPENMP
+    if (std::is_same<host_space, Kokkos::OpenMP>::value)
+      pss::parallel_stable_sort(keys.data(), keys.data()+nnz,
+                                std::less<ttb_indx>());
+    else
+#endif
+      std::sort(keys.data(), keys.data()+nnz);
+
+    // The distinct subscripts in increasing order are the new-to-old map
+    ttb_indx cnt = 0;
+    Kokkos::parallel_reduce("Genten::compact_sptensor::count", Policy(0,nnz),
+                            KOKKOS_LAMBDA(const ttb_indx i, ttb_indx& c)
+    {
+      if (i == 0 || keys(i) != keys(i-1))
+        ++c;
+    }, cnt);
+    new_sz[n] = cnt;
+    new_to_old[n] = IndxArray(cnt);
+    auto n2o = new_to_old[n].values();
+    Kokkos::parallel_scan("Genten::compact_sptensor::unique", Policy(0,nnz),
+                          KOKKOS_LAMBDA(const ttb_indx i, ttb_indx& c,
+                                        const bool final)
+    {
+      if (i == 0 || keys(i) != keys(i-1)) {
+        if (final)
+          n2o(c) = keys(i);
+        ++c;
+      }
+    });
+
+    // Relabel each subscript by its position in the map
+    Kokkos::parallel_for("Genten::compact_sptensor::relabel", Policy(0,nnz),
+                         KOKKOS_LAMBDA(const ttb_indx i)
+    {
+      const ttb_indx r = subs(i,n);
+      ttb_indx lo = 0;
+      ttb_indx hi = cnt;
+      while (hi-lo > 1) {
+        const ttb_indx mid = lo + (hi-lo)/2;
+        if (n2o(mid) <= r)
+          lo = mid;
+        else
+          hi = mid;
+      }
+      subs(i,n) = lo;
+    });
+  }
+
+  // Relabeling is monotone in each mode, so the sorted order and the
+  // permutation are unchanged
+  X = Sptensor(new_sz, X.getValues(), subs, X.getPerm(), X.isSorted());
+
+  return SptensorIndexMap(orig_sz, new_to_old);
+}
+
+Genten::Ktensor
+Genten::compact_ktensor(const Ktensor& u, const SptensorIndexMap& map)
+{
+  const ttb_indx nd = u.ndims();
+  const ttb_indx nc = u.ncomponents();
+  if (nd != map.ndims())
+    Genten::error("Genten::compact_ktensor - number of modes does not match index map");
+
+  IndxArray sz(nd);
+  for (ttb_indx n=0; n<nd; ++n) {
+    if (u[n].nRows() != map.orig_size(n))
+      Genten::error("Genten::compact_ktensor - Ktensor size does not match original tensor size");
+    sz[n] = map.size(n);
+  }
+
+  Ktensor v(nc, nd, sz);
+  deep_copy(v.weights(), u.weights());
+  for (ttb_indx n=0; n<nd; ++n) {
+    const IndxArray& old_ind = map.old_index(n);
+    for (ttb_indx i=0; i<sz[n]; ++i)
+      for (ttb_indx j=0; j<nc; ++j)
+        v[n].entry(i,j) = u[n].entry(old_ind[i],j);
+  }
+  return v;
+}
+
+Genten::Ktensor
+Genten::expand_ktensor(const Ktensor& u, const SptensorIndexMap& map)
+{
+  const ttb_indx nd = u.ndims();
+  const ttb_indx nc = u.ncomponents();
+  if (nd != map.ndims())
+    Genten::error("Genten::expand_ktensor - number of modes does not match index map");
+
+  for (ttb_indx n=0; n<nd; ++n)
+    if (u[n].nRows() != map.size(n))
+      Genten::error("Genten::expand_ktensor - Ktensor size does not match compacted tensor size");
+
+  // Factor matrices are zero-initialized
+  Ktensor v(nc, nd, map.orig_size());
+  deep_copy(v.weights(), u.weights());
+  for (ttb_indx n=0; n<nd; ++n) {
+    const IndxArray& old_ind = map.old_index(n);
+    for (ttb_indx i=0; i<map.size(n); ++i)
+      for (ttb_indx j=0; j<nc; ++j)
+        v[n].entry(old_ind[i],j) = u[n].entry(i,j);
+  }
+  return v;
+}
+
+void
+Genten::export_index_map(const std::string& fName, const SptensorIndexMap& map,
+                         const ttb_indx index_base)
+{
+  std::ofstream fOut(fName.c_str());
+  if (fOut.is_open() == false)
+    Genten::error("Genten::export_index_map - cannot create output file.");
+
+  fOut << "indexmap" << std::endl;
+  fOut << map.ndims() << std::endl;
+  for (ttb_indx n=0; n<map.ndims(); ++n) {
+    fOut << map.orig_size(n) << " " << map.size(n) << std::endl;
+    const IndxArray& old_ind = map.old_index(n);
+    for (ttb_indx i=0; i<map.size(n); ++i)
+      fOut << old_ind[i] + index_base << std::endl;
+  }
+  fOut.close();
+}
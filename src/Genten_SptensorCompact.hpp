@@ -0,0 +1,131 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+/*!
+  @file Genten_SptensorCompact.hpp
+  @brief Compaction of sparse tensor modes to their observed indices.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Genten_IndxArray.hpp"
+#include "Genten_Sptensor.hpp"
+#include "Genten_Ktensor.hpp"
+
+namespace Genten {
+
+  //! Map from the subscripts of a compacted sparse tensor to the original.
+  /*!
+   * For each mode n, old_index(n) holds the original subscript of each
+   * compacted subscript in increasing order, so compacted subscript i
+   * corresponds to original subscript old_index(n)[i].
+   */
+  class SptensorIndexMap {
+  public:
+    SptensorIndexMap() = default;
+
+    SptensorIndexMap(const IndxArray& orig_sz,
+                     const std::vector<IndxArray>& new_to_old) :
+      orig_siz(orig_sz), old_ind(new_to_old) {}
+
+    //! Number of modes
+    ttb_indx ndims() const { return old_ind.size(); }
+
+    //! Whether the map is empty (tensor not compacted)
+    bool empty() const { return old_ind.size() == 0; }
+
+    //! Original size of mode n
+    ttb_indx orig_size(const ttb_indx n) const { return orig_siz[n]; }
+
+    //! Original sizes of all modes
+    const IndxArray& orig_size() const { return orig_siz; }
+
+    //! Compacted size of mode n
+    ttb_indx size(const ttb_indx n) const { return old_ind[n].size(); }
+
+    //! Original subscripts of mode n, indexed by compacted subscript
+    const IndxArray& old_index(const ttb_indx n) const { return old_ind[n]; }
+
+  private:
+    IndxArray orig_siz;
+    std::vector<IndxArray> old_ind;
+  };
+
+  //! Compact each mode of X to the subscripts that appear in a nonzero.
+  /*!
+   * The subscripts of X are relabeled in place, preserving their order, and
+   * the size of each mode shrinks to the number of distinct subscripts, so
+   * factor matrices computed from X have no rows for empty slices.  The
+   * returned map recovers the original subscripts.  The sorted flag and
+   * permutation of X remain valid, row pointers do not.
+   */
+  SptensorIndexMap compact_sptensor(Sptensor& X);
+
+  //! Select the rows of u that correspond to the compacted subscripts
+  //! (e.g., to compact an initial guess of the original size).
+  Ktensor compact_ktensor(const Ktensor& u, const SptensorIndexMap& map);
+
+  //! Expand u computed from a compacted tensor to the original size,
+  //! with zero rows for the empty slices.
+  Ktensor expand_ktensor(const Ktensor& u, const SptensorIndexMap& map);
+
+  //! Write the index map to a text file.
+  /*!
+   *  <pre>
+   *  The file has two header lines followed by the map of each mode.
+   *    1st line is the keyword 'indexmap'.
+   *    2nd line is the number of modes.
+   *  For each mode, a line with the original and compacted sizes is followed
+   *  by one line per compacted subscript with the original subscript.
+   *  </pre>
+   *
+   *  @param[in] fName       Output filename.
+   *  @param[in] map         Index map to export.
+   *  @param[in] index_base  Value added to every subscript (e.g., 1 to match
+   *                         a one-based tensor file).
+   *  @throws string         for any error.
+   */
+  void export_index_map(const std::string& fName, const SptensorIndexMap& map,
+                        const ttb_indx index_base = 0);
+
+}
@@ -0,0 +1,224 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+#include <algorithm>
+#include <numeric>
+
+#include "Genten_SptensorDimTree.hpp"
+
+#ifdef HAVE_CALIPER
+#include <caliper/cali.h>
+#endif
+
+template <typename ExecSpace>
+Genten::SptensorDimTreeT<ExecSpace>::
+SptensorDimTreeT(const SptensorT<ExecSpace>& X_, const AlgParams& algParams) :
+  X(X_), max_bytes(algParams.mttkrp_dimtree_memory*1024.0*1024.0)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::SptensorDimTree::SptensorDimTree");
+#endif
+
+  typedef typename subs_view_type::HostMirror subs_host_type;
+  typedef typename map_view_type::HostMirror map_host_type;
+
+  const ttb_indx nd = X.ndims();
+
+  // Build the tree breadth-first, splitting the modes of each node in half
+  leaf_node.resize(nd);
+  node_begin.push_back(0);
+  node_end.push_back(nd);
+  node_parent.push_back(0);
+  for (ttb_indx k=0; k<node_begin.size(); ++k) {
+    const ttb_indx b = node_begin[k];
+    const ttb_indx e = node_end[k];
+    if (e-b == 1) {
+      leaf_node[b] = k;
+      continue;
+    }
+    const ttb_indx mid = b + (e-b+1)/2;
+    node_begin.push_back(b);
+    node_end.push_back(mid);
+    node_parent.push_back(k);
+    node_begin.push_back(mid);
+    node_end.push_back(e);
+    node_parent.push_back(k);
+  }
+
+  // Find the distinct subscript tuples of each non-leaf node by sorting the
+  // tuples of its parent on the modes of the node.  The rows of a leaf are
+  // just the rows of the factor matrix.
+  const ttb_indx nn = nnodes();
+  node_ntuples.resize(nn);
+  node_subs.resize(nn);
+  node_map.resize(nn);
+  node_values.resize(nn);
+  node_valid.resize(nn, false);
+  std::vector<subs_host_type> subs_host(nn);
+  node_ntuples[0] = X.nnz();
+  node_subs[0] = X.getSubscripts();
+  subs_host[0] = create_mirror_view(node_subs[0]);
+  deep_copy(subs_host[0], node_subs[0]);
+  for (ttb_indx k=1; k<nn; ++k) {
+    if (isLeaf(k)) {
+      node_ntuples[k] = X.size(node_begin[k]);
+      continue;
+    }
+
+    const ttb_indx p = node_parent[k];
+    const ttb_indx np = node_ntuples[p];
+    const ttb_indx off = node_begin[k]-node_begin[p];
+    const ttb_indx nm = node_end[k]-node_begin[k];
+    const subs_host_type ps = subs_host[p];
+    auto less = [&](const ttb_indx i, const ttb_indx j) {
+      for (ttb_indx m=off; m<off+nm; ++m)
+        if (ps(i,m) != ps(j,m))
+          return ps(i,m) < ps(j,m);
+      return false;
+    };
+    std::vector<ttb_indx> perm(np);
+    std::iota(perm.begin(), perm.end(), ttb_indx(0));
+    std::sort(perm.begin(), perm.end(), less);
+
+    ttb_indx nt = 0;
+    for (ttb_indx i=0; i<np; ++i)
+      if (i == 0 || less(perm[i-1],perm[i]))
+        ++nt;
+
+    subs_host_type s(
+      Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                         "Genten::SptensorDimTree::subs"), nt, nm);
+    map_host_type mp(
+      Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                         "Genten::SptensorDimTree::map"), np);
+    ttb_indx t = 0;
+    for (ttb_indx i=0; i<np; ++i) {
+      const bool first = i == 0 || less(perm[i-1],perm[i]);
+      if (i > 0 && first)
+        ++t;
+      if (first)
+        for (ttb_indx m=0; m<nm; ++m)
+          s(t,m) = ps(perm[i],off+m);
+      mp(perm[i]) = t;
+    }
+
+    node_ntuples[k] = nt;
+    subs_host[k] = s;
+    node_subs[k] = create_mirror_view(ExecSpace(), s);
+    deep_copy(node_subs[k], s);
+    node_map[k] = create_mirror_view(ExecSpace(), mp);
+    deep_copy(node_map[k], mp);
+  }
+}
+
+template <typename ExecSpace>
+bool
+Genten::SptensorDimTreeT<ExecSpace>::
+cached(ttb_indx k, ttb_indx nc) const
+{
+  if (k == 0 || isLeaf(k))
+    return false;
+  if (max_bytes < 0.0)
+    return true;
+
+  // Nodes are cached in breadth-first order until the budget is exhausted
+  ttb_real bytes = 0.0;
+  for (ttb_indx j=1; j<=k; ++j)
+    if (!isLeaf(j))
+      bytes += ttb_real(node_ntuples[j])*nc*sizeof(ttb_real);
+  return bytes <= max_bytes;
+}
+
+template <typename ExecSpace>
+Genten::FacMatrixT<ExecSpace>
+Genten::SptensorDimTreeT<ExecSpace>::
+values(ttb_indx k, ttb_indx nc) const
+{
+  if (node_values[k].nRows() != node_ntuples[k] ||
+      node_values[k].nCols() != nc) {
+    node_values[k] = FacMatrixT<ExecSpace>(node_ntuples[k], nc);
+    node_valid[k] = false;
+  }
+  return node_values[k];
+}
+
+template <typename ExecSpace>
+void
+Genten::SptensorDimTreeT<ExecSpace>::
+factorUpdated(ttb_indx n) const
+{
+  for (ttb_indx k=0; k<nnodes(); ++k)
+    if (n < node_begin[k] || n >= node_end[k])
+      node_valid[k] = false;
+}
+
+template <typename ExecSpace>
+void
+Genten::SptensorDimTreeT<ExecSpace>::
+reset() const
+{
+  std::fill(node_valid.begin(), node_valid.end(), false);
+}
+
+template <typename ExecSpace>
+size_t
+Genten::SptensorDimTreeT<ExecSpace>::
+memory() const
+{
+  size_t bytes = 0;
+  for (ttb_indx k=1; k<nnodes(); ++k)
+    bytes += (node_subs[k].span()+node_map[k].span())*sizeof(ttb_indx);
+  return bytes;
+}
+
+template <typename ExecSpace>
+size_t
+Genten::SptensorDimTreeT<ExecSpace>::
+cacheMemory(ttb_indx nc) const
+{
+  size_t bytes = 0;
+  for (ttb_indx k=1; k<nnodes(); ++k)
+    if (cached(k,nc))
+      bytes += node_ntuples[k]*nc*sizeof(ttb_real);
+  return bytes;
+}
+
+#define INST_MACRO(SPACE) template class Genten::SptensorDimTreeT<SPACE>;
+GENTEN_INST(INST_MACRO)
@@ -0,0 +1,186 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+/*!
+  @file Genten_SptensorDimTree.hpp
+  @brief Sparse tensor with a dimension tree for memoized MTTKRP sweeps.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "Genten_Util.hpp"
+#include "Genten_Sptensor.hpp"
+#include "Genten_FacMatrix.hpp"
+#include "Genten_AlgParams.hpp"
+
+namespace Genten
+{
+
+template <typename ExecSpace> class SptensorDimTreeT;
+typedef SptensorDimTreeT<DefaultHostExecutionSpace> SptensorDimTree;
+
+// Sparse tensor with a binary dimension tree over its modes for computing
+// the MTTKRPs of all modes while reusing partial products.
+/* The root of the tree holds all modes and each node splits its modes
+   [begin,end) into two halves, down to one leaf per mode.  The semi-sparse
+   tensor of a node has one row for each distinct subscript tuple of its
+   modes among the nonzeros, holding the sum over those nonzeros of the
+   value times the Hadamard product of the factor rows of all other modes.
+   It is computed from its parent by multiplying in the factor rows of the
+   modes the parent has but the node does not, and the MTTKRP for mode n is
+   the semi-sparse tensor of leaf n (times the weights).  Following
+   "Parallel CANDECOMP/PARAFAC Decomposition of Sparse Tensors Using
+   Dimension Trees" by Kaya and Ucar.
+
+   The semi-sparse tensor of a node only depends on the factor matrices of
+   the modes it does not hold, so it can be cached and reused until one of
+   them changes.  Callers must call factorUpdated(n) whenever u[n] changes
+   (CP-ALS does so after each mode).  In a CP-ALS sweep over the modes in
+   order, the two children of the root are each computed once, which
+   roughly halves the MTTKRP work per iteration for order 4 and 5 tensors.
+   Cached semi-sparse tensors are kept for nodes in breadth-first order
+   while they fit in mttkrp_dimtree_memory MB (no limit if negative).
+   Nodes that don't fit are recomputed from their parents each time they
+   are needed.
+
+   The subscript tuples of each node and the map from the tuples of its
+   parent are computed once here.  The cache is mutable state shared by all
+   MTTKRPs with this object.
+*/
+template <typename ExecSpace>
+class SptensorDimTreeT
+{
+public:
+
+  typedef ExecSpace exec_space;
+  typedef typename SptensorT<ExecSpace>::subs_view_type subs_view_type;
+  typedef Kokkos::View<ttb_indx*,ExecSpace> map_view_type;
+
+  // Empty constructor
+  SptensorDimTreeT() : X(), max_bytes(-1.0) {}
+
+  // Construct from sparse tensor, building the tree and the subscripts of
+  // each node
+  SptensorDimTreeT(const SptensorT<ExecSpace>& X,
+                   const AlgParams& algParams);
+
+  // Return the underlying coordinate tensor
+  const SptensorT<ExecSpace>& tensor() const { return X; }
+
+  // Return the number of dimensions (i.e., the order).
+  ttb_indx ndims() const { return X.ndims(); }
+
+  // Return size of dimension i.
+  ttb_indx size(ttb_indx i) const { return X.size(i); }
+
+  // Return the number of structural nonzeros.
+  ttb_indx nnz() const { return X.nnz(); }
+
+  // Return the number of nodes in the tree.  Node 0 is the root.
+  ttb_indx nnodes() const { return node_begin.size(); }
+
+  // Return the first mode of node k
+  ttb_indx nodeBegin(ttb_indx k) const { return node_begin[k]; }
+
+  // Return one past the last mode of node k
+  ttb_indx nodeEnd(ttb_indx k) const { return node_end[k]; }
+
+  // Return the parent of node k > 0
+  ttb_indx parent(ttb_indx k) const { return node_parent[k]; }
+
+  // Return whether node k is a leaf (holds a single mode)
+  bool isLeaf(ttb_indx k) const { return node_end[k]-node_begin[k] == 1; }
+
+  // Return the leaf node for mode n
+  ttb_indx leaf(ttb_indx n) const { return leaf_node[n]; }
+
+  // Return the number of rows of the semi-sparse tensor of node k
+  ttb_indx ntuples(ttb_indx k) const { return node_ntuples[k]; }
+
+  // Return the subscripts of the modes of non-leaf node k for each row
+  const subs_view_type& subscripts(ttb_indx k) const { return node_subs[k]; }
+
+  // Return the row of non-root, non-leaf node k for each row of its parent
+  const map_view_type& map(ttb_indx k) const { return node_map[k]; }
+
+  // Return whether the semi-sparse tensor of node k is cached for nc
+  // components
+  bool cached(ttb_indx k, ttb_indx nc) const;
+
+  // Return the cached semi-sparse tensor of node k, allocating it for nc
+  // components if necessary
+  FacMatrixT<ExecSpace> values(ttb_indx k, ttb_indx nc) const;
+
+  // Return whether the cached semi-sparse tensor of node k is up to date
+  bool valid(ttb_indx k) const { return node_valid[k]; }
+
+  // Mark the cached semi-sparse tensor of node k as up to date
+  void setValid(ttb_indx k) const { node_valid[k] = true; }
+
+  // Invalidate the cached semi-sparse tensors depending on factor matrix n
+  void factorUpdated(ttb_indx n) const;
+
+  // Invalidate all cached semi-sparse tensors
+  void reset() const;
+
+  // Memory used by the subscripts and maps of the tree in bytes
+  size_t memory() const;
+
+  // Memory used by the cached semi-sparse tensors for nc components in bytes
+  size_t cacheMemory(ttb_indx nc) const;
+
+private:
+
+  SptensorT<ExecSpace> X;
+  ttb_real max_bytes;
+  std::vector<ttb_indx> node_begin;
+  std::vector<ttb_indx> node_end;
+  std::vector<ttb_indx> node_parent;
+  std::vector<ttb_indx> node_ntuples;
+  std::vector<ttb_indx> leaf_node;
+  std::vector<subs_view_type> node_subs;
+  std::vector<map_view_type> node_map;
+  mutable std::vector< FacMatrixT<ExecSpace> > node_values;
+  mutable std::vector<bool> node_valid;
+};
+
+}
@@ -0,0 +1,161 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+#include "Genten_SptensorHiCOO.hpp"
+#include "Genten_KokkosAlgs.hpp"
+
+#ifdef HAVE_CALIPER
+#include <caliper/cali.h>
+#endif
+
+template <typename ExecSpace>
+constexpr unsigned Genten::SptensorHiCOOT<ExecSpace>::max_block_bits;
+
+template <typename ExecSpace>
+Genten::SptensorHiCOOT<ExecSpace>::
+SptensorHiCOOT(const SptensorT<ExecSpace>& X, const unsigned block_bits) :
+  siz(X.size()), siz_host(X.ndims()), nNumDims(X.ndims()), nNonz(X.nnz()),
+  nBlocks(0), bits(block_bits)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::SptensorHiCOO::SptensorHiCOO");
+#endif
+
+  typedef typename SptensorT<ExecSpace>::subs_view_type subs_view_type;
+  typedef typename SptensorT<ExecSpace>::vals_view_type x_vals_view_type;
+  typedef Kokkos::RangePolicy<ExecSpace> Policy;
+
+  if (bits < 1 || bits > max_block_bits)
+    Genten::error("Genten::SptensorHiCOO - block bits must be between 1 and " +
+                  std::to_string(max_block_bits));
+
+  for (ttb_indx i=0; i<nNumDims; ++i)
+    siz_host[i] = X.size_host()[i];
+
+  const ttb_indx nd = nNumDims;
+  const ttb_indx nz = nNonz;
+  const unsigned b = bits;
+  const subs_view_type subs = X.getSubscripts();
+  const x_vals_view_type xvals = X.getValues();
+
+  // Sort nonzeros by block coordinates, then by subscripts within the block
+  bptr_view_type perm(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                         "Genten::SptensorHiCOO::perm"), nz);
+#if defined(KOKKOS_ENABLE_CUDA)
+  perm_sort_op(perm, KOKKOS_LAMBDA(const ttb_indx& i, const ttb_indx& j)
+#else
+  perm_sort_op(perm, [&](const ttb_indx& i, const ttb_indx& j)
+#endif
+  {
+    for (ttb_indx m=0; m<nd; ++m) {
+      const ttb_indx bi = subs(i,m) >> b;
+      const ttb_indx bj = subs(j,m) >> b;
+      if (bi != bj)
+        return bi < bj;
+    }
+    for (ttb_indx m=0; m<nd; ++m) {
+      if (subs(i,m) != subs(j,m))
+        return subs(i,m) < subs(j,m);
+    }
+    return false;
+  });
+
+  // Number each nonzero by the block it belongs to
+  bptr_view_type block_id(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                             "Genten::SptensorHiCOO::block_id"),
+                          nz);
+  Kokkos::parallel_scan("Genten::SptensorHiCOO::block_id", Policy(0,nz),
+                        KOKKOS_LAMBDA(const ttb_indx k, ttb_indx& update,
+                                      const bool final)
+  {
+    bool new_block = (k == 0);
+    if (k > 0) {
+      const ttb_indx p = perm(k);
+      const ttb_indx q = perm(k-1);
+      for (ttb_indx m=0; m<nd; ++m)
+        if ((subs(p,m) >> b) != (subs(q,m) >> b))
+          new_block = true;
+    }
+    if (new_block)
+      ++update;
+    if (final)
+      block_id(k) = update-1;
+  }, nBlocks);
+
+  bptr = bptr_view_type(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                           "Genten::SptensorHiCOO::bptr"),
+                        nBlocks+1);
+  binds = binds_view_type(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                             "Genten::SptensorHiCOO::binds"),
+                          nBlocks, nd);
+  einds = einds_view_type(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                             "Genten::SptensorHiCOO::einds"),
+                          nz, nd);
+  vals = vals_view_type(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                           "Genten::SptensorHiCOO::vals"), nz);
+
+  const bptr_view_type bptr_ = bptr;
+  const binds_view_type binds_ = binds;
+  const einds_view_type einds_ = einds;
+  const vals_view_type vals_ = vals;
+  const ttb_indx mask = (ttb_indx(1) << b) - 1;
+  const ttb_indx nb = nBlocks;
+  Kokkos::parallel_for("Genten::SptensorHiCOO::fill", Policy(0,nz),
+                       KOKKOS_LAMBDA(const ttb_indx k)
+  {
+    const ttb_indx p = perm(k);
+    const ttb_indx blk = block_id(k);
+    if (k == 0 || block_id(k-1) != blk) {
+      bptr_(blk) = k;
+      for (ttb_indx m=0; m<nd; ++m)
+        binds_(blk,m) = subs(p,m) >> b;
+    }
+    if (k == nz-1)
+      bptr_(nb) = nz;
+    for (ttb_indx m=0; m<nd; ++m)
+      einds_(k,m) = offset_type(subs(p,m) & mask);
+    vals_(k) = xvals(p);
+  });
+  if (nz == 0)
+    Kokkos::deep_copy(bptr, ttb_indx(0));
+}
+
+#define INST_MACRO(SPACE) template class Genten::SptensorHiCOOT<SPACE>;
+GENTEN_INST(INST_MACRO)
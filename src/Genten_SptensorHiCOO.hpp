@@ -0,0 +1,185 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+/*!
+  @file Genten_SptensorHiCOO.hpp
+  @brief Sparse tensor stored in hierarchical coordinate (HiCOO) format.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "Genten_Util.hpp"
+#include "Genten_IndxArray.hpp"
+#include "Genten_Sptensor.hpp"
+#include "Genten_AlgParams.hpp"
+
+namespace Genten
+{
+
+template <typename ExecSpace> class SptensorHiCOOT;
+typedef SptensorHiCOOT<DefaultHostExecutionSpace> SptensorHiCOO;
+
+// Sparse tensor in hierarchical coordinate format.
+/* The index space is tiled into blocks of 2^b entries along each mode, and
+   the nonzeros are grouped by block.  Each block stores its block
+   coordinates once, and each nonzero stores only its 8-bit offset within
+   the block along each mode:
+     subscript(i,m) = (block_index(b,m) << b) + offset(i,m)
+   for nonzero i in block b, i.e., block_begin(b) <= i < block_begin(b+1).
+   Within a block the nonzeros are sorted lexicographically, and the blocks
+   are ordered lexicographically by block coordinates.
+
+   Processing one block at a time keeps the touched rows of each factor
+   matrix (2^b rows per mode) resident in cache.
+*/
+template <typename ExecSpace>
+class SptensorHiCOOT
+{
+public:
+
+  typedef ExecSpace exec_space;
+  typedef uint8_t offset_type;
+  typedef Kokkos::View<ttb_indx*,Kokkos::LayoutRight,ExecSpace> bptr_view_type;
+  typedef Kokkos::View<ttb_indx**,Kokkos::LayoutRight,ExecSpace> binds_view_type;
+  typedef Kokkos::View<offset_type**,Kokkos::LayoutRight,ExecSpace> einds_view_type;
+  typedef Kokkos::View<ttb_real*,Kokkos::LayoutRight,ExecSpace> vals_view_type;
+
+  // Largest supported block size is 2^max_block_bits
+  static constexpr unsigned max_block_bits = 8*sizeof(offset_type);
+
+  // Empty constructor
+  SptensorHiCOOT() : siz(), siz_host(), nNumDims(0), nNonz(0), nBlocks(0),
+                     bits(0), bptr(), binds(), einds(), vals() {}
+
+  // Construct from sparse tensor with block size 2^block_bits
+  SptensorHiCOOT(const SptensorT<ExecSpace>& X, const unsigned block_bits);
+
+  // Construct from sparse tensor with block size from algParams
+  SptensorHiCOOT(const SptensorT<ExecSpace>& X, const AlgParams& algParams) :
+    SptensorHiCOOT(X, algParams.mttkrp_hicoo_block_bits) {}
+
+  KOKKOS_DEFAULTED_FUNCTION
+  SptensorHiCOOT(const SptensorHiCOOT&) = default;
+
+  KOKKOS_DEFAULTED_FUNCTION
+  SptensorHiCOOT& operator=(const SptensorHiCOOT&) = default;
+
+  KOKKOS_DEFAULTED_FUNCTION
+  ~SptensorHiCOOT() = default;
+
+  // Return the number of dimensions (i.e., the order).
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx ndims() const { return nNumDims; }
+
+  // Return size of dimension i.
+  ttb_indx size(ttb_indx i) const { return siz_host[i]; }
+
+  // Return the entire size array.
+  const IndxArrayT<ExecSpace>& size() const { return siz; }
+
+  // Return the entire size array on the host.
+  const IndxArray& size_host() const { return siz_host; }
+
+  // Return the number of structural nonzeros.
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx nnz() const { return nNonz; }
+
+  // Return the number of nonempty blocks.
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx nblocks() const { return nBlocks; }
+
+  // Return log2 of the block size.
+  KOKKOS_INLINE_FUNCTION
+  unsigned block_bits() const { return bits; }
+
+  // Return the first nonzero in block b
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx block_begin(const ttb_indx b) const { return bptr(b); }
+
+  // Return one past the last nonzero in block b
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx block_end(const ttb_indx b) const { return bptr(b+1); }
+
+  // Return the block coordinate of block b in mode m
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx block_index(const ttb_indx b, const ttb_indx m) const {
+    return binds(b,m);
+  }
+
+  // Return the offset within its block of nonzero i in mode m
+  KOKKOS_INLINE_FUNCTION
+  offset_type offset(const ttb_indx i, const ttb_indx m) const {
+    return einds(i,m);
+  }
+
+  // Return the full subscript of nonzero i in block b along mode m
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx subscript(const ttb_indx b, const ttb_indx i,
+                     const ttb_indx m) const {
+    return (binds(b,m) << bits) + einds(i,m);
+  }
+
+  // Return value of nonzero i
+  KOKKOS_INLINE_FUNCTION
+  ttb_real value(const ttb_indx i) const { return vals(i); }
+
+  // Total memory used by the tensor in bytes
+  size_t memory() const {
+    return bptr.span()*sizeof(ttb_indx) + binds.span()*sizeof(ttb_indx) +
+      einds.span()*sizeof(offset_type) + vals.span()*sizeof(ttb_real);
+  }
+
+private:
+
+  IndxArrayT<ExecSpace> siz;
+  IndxArray siz_host;
+  ttb_indx nNumDims;
+  ttb_indx nNonz;
+  ttb_indx nBlocks;
+  unsigned bits;
+  bptr_view_type bptr;
+  binds_view_type binds;
+  einds_view_type einds;
+  vals_view_type vals;
+};
+
+}
@@ -0,0 +1,156 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include "Genten_SptensorHybrid.hpp"
+
+#ifdef HAVE_CALIPER
+#include <caliper/cali.h>
+#endif
+
+template <typename ExecSpace>
+Genten::SptensorHybridT<ExecSpace>::
+SptensorHybridT(const SptensorT<ExecSpace>& X_, const AlgParams& algParams) :
+  X(X_), hot_begin_host(X_.ndims()+1),
+  buffer_cache("Genten::SptensorHybrid::buffer_cache", 1)
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::SptensorHybrid::SptensorHybrid");
+#endif
+
+  typedef typename SptensorT<ExecSpace>::subs_view_type subs_view_type;
+  typedef Kokkos::View<ttb_indx*,ExecSpace> count_view_type;
+  typedef Kokkos::RangePolicy<ExecSpace> Policy;
+
+  const ttb_indx nd = X.ndims();
+  const ttb_indx nz = X.nnz();
+  const ttb_indx P = SpaceProperties<ExecSpace>::concurrency();
+
+  // Slots (and counts) for mode n start at slot_begin[n]
+  IndxArrayT<host_mirror_space> slot_begin_host(nd+1);
+  slot_begin_host[0] = 0;
+  for (ttb_indx n=0; n<nd; ++n)
+    slot_begin_host[n+1] = slot_begin_host[n] + X.size(n);
+  const ttb_indx total_rows = slot_begin_host[nd];
+
+  // Count the nonzeros in each row of every mode
+  const subs_view_type subs = X.getSubscripts();
+  const IndxArrayT<ExecSpace> sb =
+    create_mirror_view(ExecSpace(), slot_begin_host);
+  deep_copy(sb, slot_begin_host);
+  count_view_type counts("Genten::SptensorHybrid::counts", total_rows);
+  Kokkos::parallel_for("Genten::SptensorHybrid::count", Policy(0,nz),
+                       KOKKOS_LAMBDA(const ttb_indx i)
+  {
+    for (ttb_indx n=0; n<nd; ++n)
+      Kokkos::atomic_add(&counts(sb[n]+subs(i,n)), ttb_indx(1));
+  });
+
+  // Rows with at least thresh nonzeros are hot.  Raise the threshold until
+  // there are at most size(n)/P hot rows.
+  slots = slot_view_type(
+    Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                       "Genten::SptensorHybrid::slots"), total_rows);
+  const slot_view_type sl = slots;
+  hot_begin_host[0] = 0;
+  for (ttb_indx n=0; n<nd; ++n) {
+    const ttb_indx beg = slot_begin_host[n];
+    const ttb_indx dim = X.size(n);
+    const ttb_indx max_hot = std::min(dim/P, ttb_indx(INT_MAX));
+    ttb_indx thresh = std::max(
+      ttb_indx(1),
+      ttb_indx(std::ceil(algParams.mttkrp_hybrid_threshold*P)));
+    ttb_indx nhot = 0;
+    while (true) {
+      Kokkos::parallel_reduce("Genten::SptensorHybrid::count_hot",
+                              Policy(0,dim),
+                              KOKKOS_LAMBDA(const ttb_indx r, ttb_indx& h)
+      {
+        if (counts(beg+r) >= thresh)
+          ++h;
+      }, nhot);
+      if (nhot <= max_hot)
+        break;
+      thresh *= 2;
+    }
+
+    Kokkos::parallel_scan("Genten::SptensorHybrid::assign_slots",
+                          Policy(0,dim),
+                          KOKKOS_LAMBDA(const ttb_indx r, ttb_indx& s,
+                                        const bool final)
+    {
+      const bool hot = counts(beg+r) >= thresh;
+      if (final)
+        sl(beg+r) = hot ? int(s) : -1;
+      if (hot)
+        ++s;
+    });
+    hot_begin_host[n+1] = hot_begin_host[n] + nhot;
+  }
+
+  // List the row in each slot
+  hot_rows = row_view_type(
+    Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                       "Genten::SptensorHybrid::hot_rows"),
+    hot_begin_host[nd]);
+  const row_view_type hr = hot_rows;
+  for (ttb_indx n=0; n<nd; ++n) {
+    const ttb_indx beg = slot_begin_host[n];
+    const ttb_indx hbeg = hot_begin_host[n];
+    Kokkos::parallel_for("Genten::SptensorHybrid::hot_rows",
+                         Policy(0,X.size(n)),
+                         KOKKOS_LAMBDA(const ttb_indx r)
+    {
+      const int s = sl(beg+r);
+      if (s >= 0)
+        hr(hbeg+s) = r;
+    });
+  }
+
+  slot_begin = sb;
+  hot_begin = create_mirror_view(ExecSpace(), hot_begin_host);
+  deep_copy(hot_begin, hot_begin_host);
+}
+
+#define INST_MACRO(SPACE) template class Genten::SptensorHybridT<SPACE>;
+GENTEN_INST(INST_MACRO)
@@ -0,0 +1,171 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+/*!
+  @file Genten_SptensorHybrid.hpp
+  @brief Sparse tensor with per-mode hot-row maps for hybrid MTTKRP.
+*/
+
+#pragma once
+
+#include <algorithm>
+
+#include "Genten_Util.hpp"
+#include "Genten_IndxArray.hpp"
+#include "Genten_Sptensor.hpp"
+#include "Genten_AlgParams.hpp"
+
+namespace Genten
+{
+
+template <typename ExecSpace> class SptensorHybridT;
+typedef SptensorHybridT<DefaultHostExecutionSpace> SptensorHybrid;
+
+// Sparse tensor with the rows of each mode split into hot and cold rows.
+/* Rows of mode n with at least mttkrp_hybrid_threshold * P nonzeros, where
+   P is the number of threads, are hot.  Each hot row is given a slot
+   0 <= s < nhot(n), and the hybrid MTTKRP accumulates hot rows into
+   compact per-thread buffers of nhot(n) rows without atomics, and updates
+   the remaining (cold) rows with atomics.  Hot rows are where atomics
+   contend, while the long tail of cold rows is rarely touched by two
+   threads at once, so the buffers stay much smaller than duplicating the
+   whole factor matrix.
+
+   The number of hot rows in each mode is capped at size(n)/P by raising
+   the threshold, so the buffers for a mode never take more memory than
+   the factor matrix itself.  The row counts are computed once here, and
+   the same object is reused for every MTTKRP.
+*/
+template <typename ExecSpace>
+class SptensorHybridT
+{
+public:
+
+  typedef ExecSpace exec_space;
+  typedef typename IndxArrayT<ExecSpace>::host_mirror_space host_mirror_space;
+  typedef Kokkos::View<int*,ExecSpace> slot_view_type;
+  typedef Kokkos::View<ttb_indx*,ExecSpace> row_view_type;
+  typedef Kokkos::View<ttb_real**,Kokkos::LayoutRight,ExecSpace> buffer_view_type;
+  typedef Kokkos::View<buffer_view_type*,Kokkos::HostSpace> buffer_cache_type;
+
+  // Empty constructor
+  SptensorHybridT() : X(), slots(), hot_rows(), slot_begin(), hot_begin(),
+                      hot_begin_host(), buffer_cache() {}
+
+  // Construct from sparse tensor, selecting the hot rows of each mode
+  SptensorHybridT(const SptensorT<ExecSpace>& X,
+                  const AlgParams& algParams);
+
+  KOKKOS_DEFAULTED_FUNCTION
+  SptensorHybridT(const SptensorHybridT&) = default;
+
+  KOKKOS_DEFAULTED_FUNCTION
+  SptensorHybridT& operator=(const SptensorHybridT&) = default;
+
+  KOKKOS_DEFAULTED_FUNCTION
+  ~SptensorHybridT() = default;
+
+  // Return the underlying coordinate tensor
+  KOKKOS_INLINE_FUNCTION
+  const SptensorT<ExecSpace>& tensor() const { return X; }
+
+  // Return the number of dimensions (i.e., the order).
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx ndims() const { return X.ndims(); }
+
+  // Return size of dimension i.
+  ttb_indx size(ttb_indx i) const { return X.size(i); }
+
+  // Return the number of structural nonzeros.
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx nnz() const { return X.nnz(); }
+
+  // Return the number of hot rows in mode n
+  ttb_indx nhot(ttb_indx n) const {
+    return hot_begin_host[n+1]-hot_begin_host[n];
+  }
+
+  // Return the buffer slot of row r in mode n, or -1 if the row is cold
+  KOKKOS_INLINE_FUNCTION
+  int slot(ttb_indx r, ttb_indx n) const { return slots(slot_begin[n]+r); }
+
+  // Return the row of the tensor in slot s of mode n
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx hotRow(ttb_indx s, ttb_indx n) const {
+    return hot_rows(hot_begin[n]+s);
+  }
+
+  // Memory used by the slot maps and hot row lists in bytes
+  size_t memory() const {
+    return slots.span()*sizeof(int) + hot_rows.span()*sizeof(ttb_indx);
+  }
+
+  // Memory used by the per-thread buffers for an MTTKRP in mode n with nc
+  // components in bytes
+  size_t bufferMemory(ttb_indx n, ttb_indx nc) const {
+    return SpaceProperties<ExecSpace>::concurrency()*nhot(n)*nc*
+      sizeof(ttb_real);
+  }
+
+  // Per-thread buffers for the hybrid MTTKRP with at least nrows rows and nc
+  // columns.  They are allocated zero-filled on first use, shared by all
+  // copies of this tensor and reused by every MTTKRP, which must leave the
+  // entries it used zero again.
+  buffer_view_type buffer(ttb_indx nrows, ttb_indx nc) const {
+    buffer_view_type& buf = buffer_cache(0);
+    if (buf.extent(0) < nrows || buf.extent(1) < nc)
+      buf = buffer_view_type("Genten::SptensorHybrid::buffer",
+                             std::max(nrows, ttb_indx(buf.extent(0))),
+                             std::max(nc, ttb_indx(buf.extent(1))));
+    return buf;
+  }
+
+private:
+
+  SptensorT<ExecSpace> X;
+  slot_view_type slots;
+  row_view_type hot_rows;
+  IndxArrayT<ExecSpace> slot_begin;
+  IndxArrayT<ExecSpace> hot_begin;
+  IndxArrayT<host_mirror_space> hot_begin_host;
+  buffer_cache_type buffer_cache;
+};
+
+}
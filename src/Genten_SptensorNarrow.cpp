@@ -0,0 +1,128 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+#include <limits>
+
+#include "Genten_SptensorNarrow.hpp"
+
+#ifdef HAVE_CALIPER
+#include <caliper/cali.h>
+#endif
+
+namespace Genten {
+namespace Impl {
+
+// Share the values when no conversion is needed
+template <typename ExecSpace>
+Kokkos::View<ttb_real*,Kokkos::LayoutRight,ExecSpace>
+narrow_values(const Kokkos::View<ttb_real*,Kokkos::LayoutRight,ExecSpace>& x,
+              ttb_real)
+{
+  return x;
+}
+
+template <typename ExecSpace, typename ValueType>
+Kokkos::View<ValueType*,Kokkos::LayoutRight,ExecSpace>
+narrow_values(const Kokkos::View<ttb_real*,Kokkos::LayoutRight,ExecSpace>& x,
+              ValueType)
+{
+  Kokkos::View<ValueType*,Kokkos::LayoutRight,ExecSpace> y(
+    Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                       "Genten::SptensorNarrow::values"), x.extent(0));
+  Kokkos::parallel_for("Genten::SptensorNarrow::convert_values",
+                       Kokkos::RangePolicy<ExecSpace>(0,x.extent(0)),
+                       KOKKOS_LAMBDA(const ttb_indx i)
+  {
+    y(i) = ValueType(x(i));
+  });
+  return y;
+}
+
+}
+}
+
+template <typename ExecSpace, typename IndexType, typename ValueType>
+Genten::SptensorNarrowT<ExecSpace,IndexType,ValueType>::
+SptensorNarrowT(const SptensorT<ExecSpace>& X) :
+  siz(X.size()), siz_host(X.ndims()), nNumDims(X.ndims()),
+  values(Impl::narrow_values(X.getValues(), ValueType()))
+{
+#ifdef HAVE_CALIPER
+  cali::Function cali_func("Genten::SptensorNarrow::SptensorNarrow");
+#endif
+
+  // Largest subscript, so this does not overflow when IndexType is as wide
+  // as ttb_indx
+  const ttb_indx max_sub = std::numeric_limits<IndexType>::max();
+  for (ttb_indx i=0; i<nNumDims; ++i) {
+    siz_host[i] = X.size_host()[i];
+    if (siz_host[i] > 0 && siz_host[i]-1 > max_sub)
+      Genten::error("Genten::SptensorNarrow - dimension " + std::to_string(i) +
+                    " is too large for the index type");
+  }
+
+  const ttb_indx nz = X.nnz();
+  const ttb_indx nd = nNumDims;
+  subs = subs_view_type(Kokkos::view_alloc(Kokkos::WithoutInitializing,
+                                           "Genten::SptensorNarrow::subs"),
+                        nz, nd);
+  const subs_view_type s = subs;
+  const typename SptensorT<ExecSpace>::subs_view_type xs = X.getSubscripts();
+  Kokkos::parallel_for("Genten::SptensorNarrow::convert",
+                       Kokkos::RangePolicy<ExecSpace>(0,nz),
+                       KOKKOS_LAMBDA(const ttb_indx i)
+  {
+    for (ttb_indx m=0; m<nd; ++m)
+      s(i,m) = IndexType(xs(i,m));
+  });
+}
+
+#ifdef HAVE_MIXED_PRECISION
+#define INST_MACRO(SPACE)                                               \
+  template class Genten::SptensorNarrowT<SPACE,uint16_t>;               \
+  template class Genten::SptensorNarrowT<SPACE,uint32_t>;               \
+  template class Genten::SptensorNarrowT<SPACE,uint32_t,float>;         \
+  template class Genten::SptensorNarrowT<SPACE,uint64_t,float>;
+#else
+#define INST_MACRO(SPACE)                                               \
+  template class Genten::SptensorNarrowT<SPACE,uint16_t>;               \
+  template class Genten::SptensorNarrowT<SPACE,uint32_t>;
+#endif
+GENTEN_INST(INST_MACRO)
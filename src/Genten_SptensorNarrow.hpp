@@ -0,0 +1,165 @@
+//@HEADER
+// ************************************************************************
+//     Genten: Software for Generalized Tensor Decompositions
+//     by Sandia National Laboratories
+//
+// Sandia National Laboratories is a multimission laboratory managed
+// and operated by National Technology and Engineering Solutions of Sandia,
+// LLC, a wholly owned subsidiary of Honeywell International, Inc., for the
+// U.S. Department of Energy's National Nuclear Security Administration under
+// contract DE-NA0003525.
+//
+// Copyright 2017 National Technology & Engineering Solutions of Sandia, LLC
+// (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+// Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ************************************************************************
+//@HEADER
+
+/*!
+  @file Genten_SptensorNarrow.hpp
+  @brief Sparse tensor in coordinate format with narrow subscripts.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "Genten_Util.hpp"
+#include "Genten_IndxArray.hpp"
+#include "Genten_Sptensor.hpp"
+
+namespace Genten
+{
+
+// Smallest number of bytes (2, 4, or 8) that can hold every subscript of a
+// tensor with the given dimensions
+inline unsigned narrow_index_bytes(const IndxArray& sz)
+{
+  ttb_indx max_sz = 0;
+  for (ttb_indx i=0; i<sz.size(); ++i)
+    if (sz[i] > max_sz)
+      max_sz = sz[i];
+  if (max_sz <= ttb_indx(UINT16_MAX)+1)
+    return 2;
+  if (max_sz <= ttb_indx(UINT32_MAX)+1)
+    return 4;
+  return sizeof(ttb_indx);
+}
+
+// Sparse tensor in coordinate format storing subscripts as IndexType and
+// values as ValueType.
+/* A read-only copy of an SptensorT whose subscripts are stored in a
+   narrower integer type (uint16_t or uint32_t), which reduces the index
+   data moved by bandwidth-bound kernels such as MTTKRP and innerprod by a
+   factor of 4 or 2.  Values may likewise be stored as float for
+   mixed-precision MTTKRP.  Subscripts are returned as ttb_indx and values
+   as ttb_real, so kernels written against the SptensorT interface work
+   unchanged.
+*/
+template <typename ExecSpace, typename IndexType,
+          typename ValueType = ttb_real>
+class SptensorNarrowT
+{
+public:
+
+  typedef ExecSpace exec_space;
+  typedef IndexType index_type;
+  typedef ValueType value_type;
+  typedef Kokkos::View<IndexType**,Kokkos::LayoutRight,ExecSpace> subs_view_type;
+  typedef Kokkos::View<ValueType*,Kokkos::LayoutRight,ExecSpace> vals_view_type;
+
+  // Empty constructor
+  SptensorNarrowT() : siz(), siz_host(), nNumDims(0), values(), subs() {}
+
+  // Construct from sparse tensor, converting the subscripts.  Throws if a
+  // dimension is too large for IndexType.  The values are shared with X
+  // if ValueType is ttb_real and converted otherwise.
+  SptensorNarrowT(const SptensorT<ExecSpace>& X);
+
+  // Construct from dimensions and already converted values and subscripts
+  SptensorNarrowT(const IndxArrayT<ExecSpace>& sz, const IndxArray& sz_host,
+                  const vals_view_type& vals, const subs_view_type& s) :
+    siz(sz), siz_host(sz_host), nNumDims(sz_host.size()), values(vals),
+    subs(s) {}
+
+  KOKKOS_DEFAULTED_FUNCTION
+  SptensorNarrowT(const SptensorNarrowT&) = default;
+
+  KOKKOS_DEFAULTED_FUNCTION
+  SptensorNarrowT& operator=(const SptensorNarrowT&) = default;
+
+  KOKKOS_DEFAULTED_FUNCTION
+  ~SptensorNarrowT() = default;
+
+  // Return the number of dimensions (i.e., the order).
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx ndims() const { return nNumDims; }
+
+  // Return size of dimension i.
+  ttb_indx size(ttb_indx i) const { return siz_host[i]; }
+
+  // Return the entire size array.
+  KOKKOS_INLINE_FUNCTION
+  const IndxArrayT<ExecSpace>& size() const { return siz; }
+
+  // Return the entire size array on the host.
+  const IndxArray& size_host() const { return siz_host; }
+
+  // Return the number of structural nonzeros.
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx nnz() const { return values.extent(0); }
+
+  // Get whole values array
+  KOKKOS_INLINE_FUNCTION
+  vals_view_type getValues() const { return values; }
+
+  // Return value of nonzero i
+  KOKKOS_INLINE_FUNCTION
+  ttb_real value(ttb_indx i) const { return ttb_real(values[i]); }
+
+  // Get subscripts of i-th nonzero
+  KOKKOS_INLINE_FUNCTION
+  subs_view_type getSubscripts() const { return subs; }
+
+  // Return subscript of nonzero i in dimension n
+  KOKKOS_INLINE_FUNCTION
+  ttb_indx subscript(ttb_indx i, ttb_indx n) const { return subs(i,n); }
+
+  // Memory used by the subscripts and values in bytes
+  size_t memory() const {
+    return subs.span()*sizeof(IndexType) + values.span()*sizeof(ValueType);
+  }
+
+private:
+
+  IndxArrayT<ExecSpace> siz;
+  IndxArray siz_host;
+  ttb_indx nNumDims;
+  vals_view_type values;
+  subs_view_type subs;
+};
+
+}
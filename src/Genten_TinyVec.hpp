@@ -384,6 +384,23 @@ namespace Genten {
       return *this;
     }
 
+    // Multiply by values stored in a narrower type (e.g., float factor
+    // matrices with a double accumulator)
+    template <typename T>
+    KOKKOS_INLINE_FUNCTION
+    typename std::enable_if<!std::is_same<T,scalar_type>::value,
+                            TinyVec&>::type
+    operator*=(const T* x) {
+#ifdef __CUDA_ARCH__
+      for (ordinal_type i=0; i<sz.value; ++i)
+        v[i] *= x[i*WarpDim+threadIdx.x];
+#else
+      for (ordinal_type i=0; i<sz.value; ++i)
+        v[i] *= x[i];
+#endif
+      return *this;
+    }
+
     KOKKOS_INLINE_FUNCTION
     TinyVec& operator/=(const scalar_type* x) {
 #ifdef __CUDA_ARCH__
@@ -640,6 +657,15 @@ namespace Genten {
       return *this;
     }
 
+    template <typename T>
+    __device__ inline
+    typename std::enable_if<!std::is_same<T,scalar_type>::value,
+                            TinyVec&>::type
+    operator*=(const T* x) {
+      if (sz.value > 0) v0 *= x[threadIdx.x];
+      return *this;
+    }
+
     __device__ inline
     TinyVec& operator/=(const scalar_type* x) {
       if (sz.value > 0) v0 /= x[threadIdx.x];
@@ -910,6 +936,16 @@ namespace Genten {
       return *this;
     }
 
+    template <typename T>
+    __device__ inline
+    typename std::enable_if<!std::is_same<T,scalar_type>::value,
+                            TinyVec&>::type
+    operator*=(const T* x) {
+      if (sz.value > 0) v0 *= x[threadIdx.x];
+      if (sz.value > 1) v1 *= x[WarpDim + threadIdx.x];
+      return *this;
+    }
+
     __device__ inline
     TinyVec& operator/=(const scalar_type* x) {
       if (sz.value > 0) v0 /= x[threadIdx.x];
@@ -1210,6 +1246,17 @@ namespace Genten {
       return *this;
     }
 
+    template <typename T>
+    __device__ inline
+    typename std::enable_if<!std::is_same<T,scalar_type>::value,
+                            TinyVec&>::type
+    operator*=(const T* x) {
+      if (sz.value > 0) v0 *= x[threadIdx.x];
+      if (sz.value > 1) v1 *= x[WarpDim + threadIdx.x];
+      if (sz.value > 2) v2 *= x[2*WarpDim + threadIdx.x];
+      return *this;
+    }
+
     __device__ inline
     TinyVec& operator/=(const scalar_type* x) {
       if (sz.value > 0) v0 /= x[threadIdx.x];
@@ -1540,6 +1587,18 @@ namespace Genten {
       return *this;
     }
 
+    template <typename T>
+    __device__ inline
+    typename std::enable_if<!std::is_same<T,scalar_type>::value,
+                            TinyVec&>::type
+    operator*=(const T* x) {
+      if (sz.value > 0) v0 *= x[threadIdx.x];
+      if (sz.value > 1) v1 *= x[WarpDim + threadIdx.x];
+      if (sz.value > 2) v2 *= x[2*WarpDim + threadIdx.x];
+      if (sz.value > 3) v3 *= x[3*WarpDim + threadIdx.x];
+      return *this;
+    }
+
     __device__ inline
     TinyVec& operator/=(const scalar_type* x) {
       if (sz.value > 0) v0 /= x[threadIdx.x];
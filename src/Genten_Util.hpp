@@ -93,6 +93,14 @@ namespace Genten {                              \
 // What we align memory to (in bytes)
 #define GENTEN_MEMORY_ALIGNMENT 64
 
+// Software prefetch of the cache line containing addr, for reading (rw = 0)
+// or writing (rw = 1).  Does nothing on the GPU.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(__CUDA_ARCH__)
+#define GENTEN_PREFETCH(addr,rw) __builtin_prefetch((addr),(rw))
+#else
+#define GENTEN_PREFETCH(addr,rw) /* */
+#endif
+
 /* ----- Typedefs ----- */
 /* We use typedefs to make the code portable, especially for
    varying sizes of integers, etc.
@@ -118,14 +126,16 @@ namespace Genten {
     enum type {
       CP_ALS,
       GCP_SGD,
-      GCP_OPT
+      GCP_OPT,
+      CP_ARLS_LEV,
+      CP_HALS
     };
-    static constexpr unsigned num_types = 3;
+    static constexpr unsigned num_types = 5;
     static constexpr type types[] = {
-      CP_ALS, GCP_SGD, GCP_OPT
+      CP_ALS, GCP_SGD, GCP_OPT, CP_ARLS_LEV, CP_HALS
     };
     static constexpr const char* names[] = {
-      "cp-als", "gcp-sgd", "gcp-opt"
+      "cp-als", "gcp-sgd", "gcp-opt", "cp-arls-lev", "cp-hals"
     };
     static constexpr type default_type = CP_ALS;
   };
@@ -138,19 +148,36 @@ namespace Genten {
       Atomic,      // Use atomics factor matrix update
       Duplicated,  // Duplicate factor matrix then inter-thread reduce
       Single,      // Single-thread algorithm (no atomics or duplication)
-      Perm         // Permutation-based algorithm
+      Perm,        // Permutation-based algorithm
+      CSF,         // Compressed sparse fiber algorithm
+      HiCOO,       // Hierarchical (blocked) coordinate algorithm
+      ALTO,        // Linearized (bit-interleaved) coordinate algorithm
+      Hybrid,      // Privatize hot rows, atomics for the rest
+      DimTree,     // Reuse partial products along a dimension tree
+      Prefetch,    // Software prefetching of factor rows (host only)
+      GEMM,        // Khatri-Rao product and gemm (dense tensors only)
+      Auto         // Benchmark candidate methods and pick the fastest
     };
-    static constexpr unsigned num_types = 6;
+    static constexpr unsigned num_types = 14;
     static constexpr type types[] = {
       Default,
       OrigKokkos,
       Atomic,
       Duplicated,
       Single,
-      Perm
+      Perm,
+      CSF,
+      HiCOO,
+      ALTO,
+      Hybrid,
+      DimTree,
+      Prefetch,
+      GEMM,
+      Auto
     };
     static constexpr const char* names[] = {
-      "default", "orig-kokkos", "atomic", "duplicated", "single", "perm"
+      "default", "orig-kokkos", "atomic", "duplicated", "single", "perm", "csf",
+      "hicoo", "alto", "hybrid", "dimtree", "prefetch", "gemm", "auto"
     };
     static constexpr type default_type = Default;
   };
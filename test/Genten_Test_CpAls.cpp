@@ -39,9 +39,11 @@
 //@HEADER
 
 
+#include <cmath>
 #include <sstream>
 
 #include "Genten_CpAls.hpp"
+#include "Genten_CpArls.hpp"
 #include "Genten_IndxArray.hpp"
 #include "Genten_IOtext.hpp"
 #include "Genten_Ktensor.hpp"
@@ -329,6 +331,124 @@ void Genten_Test_CpAls_Type (Genten::MTTKRP_Method::type mttkrp_method,
 
   evaluateResult(infolevel, itersCompleted, algParams.tol, result);
 
+  // Repeat with line search extrapolation
+  MESSAGE("Factorizing with line search");
+  try
+  {
+    algParams.line_search = true;
+    algParams.line_search_start = 2;
+    deep_copy(result_dev, initialBasis_dev);
+    Genten::cpals_core(X_dev, result_dev, algParams, itersCompleted, resNorm,
+                       0, NULL);
+    algParams.line_search = false;
+  }
+  catch(std::string sExc)
+  {
+    // Should not happen.
+    MESSAGE(sExc);
+    ASSERT( true, "Call to cpals_core threw an exception." );
+    return;
+  }
+  deep_copy(result, result_dev);
+  evaluateResult(infolevel, itersCompleted, algParams.tol, result);
+
+  // Repeat with the known initial guess as one of several starts
+  MESSAGE("Factorizing with multiple starts");
+  try
+  {
+    algParams.num_starts = 3;
+    Genten::CpAlsPerfInfo startInfo[3];
+    deep_copy(result_dev, initialBasis_dev);
+    Genten::cpals_multistart(X_dev, result_dev, algParams, itersCompleted,
+                             resNorm, startInfo, std::cout);
+    algParams.num_starts = 1;
+    // The known guess converges, and the best start is returned
+    bool  bIsOK = (startInfo[0].dFit >= 0.99);
+    for (ttb_indx  i = 0; i < 3; i++)
+    {
+      if ((startInfo[i].nIter <= 0) || (startInfo[i].dFit > 1.00) ||
+          (startInfo[i].dResNorm < resNorm))
+        bIsOK = false;
+    }
+    ASSERT( bIsOK, "Start info from cpals_multistart is reasonable." );
+  }
+  catch(std::string sExc)
+  {
+    // Should not happen.
+    MESSAGE(sExc);
+    ASSERT( true, "Call to cpals_multistart threw an exception." );
+    return;
+  }
+  deep_copy(result, result_dev);
+  evaluateResult(infolevel, itersCompleted, algParams.tol, result);
+
+  // Repeat as a rank sweep starting from the known guess
+  MESSAGE("Factorizing with a rank sweep");
+  try
+  {
+    algParams.rank_sweep_max = nNumComponents + 1;
+    std::vector<Genten::CpAlsRankInfo> rankInfo;
+    deep_copy(result_dev, initialBasis_dev);
+    Genten::cpals_rank_sweep(X_dev, result_dev, algParams, rankInfo,
+                             std::cout);
+    algParams.rank_sweep_max = 0;
+    // The exact rank is selected since the next one does not improve the fit
+    const bool bIsOK = (rankInfo.size() == 2) &&
+      (rankInfo[0].nRank == nNumComponents) &&
+      (rankInfo[0].dFit >= 0.99) &&
+      (rankInfo[0].dCoreConsistency >= 90.0) &&
+      (result_dev.ncomponents() == nNumComponents);
+    ASSERT( bIsOK, "Rank info from cpals_rank_sweep is reasonable." );
+
+    // The core consistency diagnostic can be turned off
+    algParams.rank_sweep_max = nNumComponents;
+    algParams.rank_sweep_core_consistency = false;
+    deep_copy(result_dev, initialBasis_dev);
+    Genten::cpals_rank_sweep(X_dev, result_dev, algParams, rankInfo,
+                             std::cout);
+    algParams.rank_sweep_max = 0;
+    algParams.rank_sweep_core_consistency = true;
+    ASSERT( (rankInfo.size() == 1) &&
+            std::isnan(rankInfo[0].dCoreConsistency),
+            "Core consistency is skipped when turned off." );
+  }
+  catch(std::string sExc)
+  {
+    // Should not happen.
+    MESSAGE(sExc);
+    ASSERT( true, "Call to cpals_rank_sweep threw an exception." );
+    return;
+  }
+  deep_copy(result, result_dev);
+  evaluateResult(infolevel, itersCompleted, algParams.tol, result);
+
+  // Repeat with nonnegative HALS updates, since the solution is nonnegative
+  MESSAGE("Factorizing with CP-HALS");
+  try
+  {
+    algParams.method = Genten::Solver_Method::CP_HALS;
+    deep_copy(result_dev, initialBasis_dev);
+    Genten::cpals_core(X_dev, result_dev, algParams, itersCompleted, resNorm,
+                       0, NULL);
+    algParams.method = Genten::Solver_Method::CP_ALS;
+  }
+  catch(std::string sExc)
+  {
+    // Should not happen.
+    MESSAGE(sExc);
+    ASSERT( true, "Call to cpals_core with CP-HALS threw an exception." );
+    return;
+  }
+  deep_copy(result, result_dev);
+  bool bIsNonneg = true;
+  for (ttb_indx  n = 0; n < result.ndims(); n++)
+    for (ttb_indx  i = 0; i < result[n].nRows(); i++)
+      for (ttb_indx  j = 0; j < result[n].nCols(); j++)
+        if (result[n].entry(i,j) < 0.0)
+          bIsNonneg = false;
+  ASSERT( bIsNonneg, "CP-HALS factors are nonnegative" );
+  evaluateResult(infolevel, itersCompleted, algParams.tol, result);
+
   // Test factorization from a bad initial guess.
   MESSAGE("Creating a ktensor with initial guess all zero");
   Genten::Ktensor  initialZero (nNumComponents, dims.size(), dims);
@@ -383,6 +503,91 @@ void Genten_Test_CpAls_Type (Genten::MTTKRP_Method::type mttkrp_method,
   return;
 }
 
+/*!
+ *  Factor the same 2x3x4 tensor with CP-ARLS-LEV from the same start point.
+ *  Since the tensor is exactly rank 2, any sample that makes the sampled
+ *  least-squares problems full rank gives the same solution as CP-ALS.
+ */
+void Genten_Test_CpArls (int infolevel)
+{
+  typedef Genten::DefaultExecutionSpace exec_space;
+  typedef Genten::DefaultHostExecutionSpace host_exec_space;
+  typedef Genten::SptensorT<exec_space> Sptensor_type;
+  typedef Genten::SptensorT<host_exec_space> Sptensor_host_type;
+
+  initialize("Test of Genten::CpArls", infolevel);
+
+  MESSAGE("Creating a sparse tensor with data to model");
+  const ttb_indx subs[11][3] = {
+    {0,0,0}, {1,0,0}, {0,1,0}, {1,1,0}, {0,2,0}, {0,0,1}, {0,2,1},
+    {0,0,3}, {1,0,3}, {0,1,3}, {1,1,3} };
+  Genten::IndxArray  dims(3);
+  dims[0] = 2;  dims[1] = 3;  dims[2] = 4;
+  Sptensor_host_type  X(dims,11);
+  for (ttb_indx i=0; i<11; ++i) {
+    for (ttb_indx j=0; j<3; ++j)
+      X.subscript(i,j) = subs[i][j];
+    X.value(i) = i == 0 ? 2.0 : 1.0;
+  }
+  Sptensor_type X_dev = create_mirror_view( exec_space(), X );
+  deep_copy( X_dev, X );
+
+  MESSAGE("Creating a ktensor with initial guess of lin indep basis vectors");
+  ttb_indx  nNumComponents = 2;
+  const ttb_real A0[2][2] = { {0.8, 0.5}, {0.2, 0.5} };
+  const ttb_real B0[3][2] = { {0.5, 0.5}, {0.1, 0.5}, {0.5, 0.1} };
+  const ttb_real C0[4][2] = { {0.7, 0.7}, {0.7, 0.1}, {0.1, 0.1}, {0.1, 0.7} };
+  Genten::Ktensor  initialBasis (nNumComponents, dims.size(), dims);
+  initialBasis.setWeights(1.0);
+  for (ttb_indx j=0; j<nNumComponents; ++j) {
+    for (ttb_indx i=0; i<2; ++i)
+      initialBasis[0].entry(i,j) = A0[i][j];
+    for (ttb_indx i=0; i<3; ++i)
+      initialBasis[1].entry(i,j) = B0[i][j];
+    for (ttb_indx i=0; i<4; ++i)
+      initialBasis[2].entry(i,j) = C0[i][j];
+  }
+  initialBasis.weights(0) = 2.0;
+
+  Genten::AlgParams algParams;
+  algParams.method = Genten::Solver_Method::CP_ARLS_LEV;
+  algParams.rank = nNumComponents;
+  algParams.tol = 1.0e-6;
+  algParams.maxiters = 100;
+  algParams.maxsecs = -1.0;
+  algParams.printitn = infolevel;
+  algParams.arls_num_samples = 1024;
+  algParams.arls_epoch_iters = 5;
+  Genten::Ktensor result(nNumComponents, dims.size(), dims);
+  Genten::KtensorT<exec_space> result_dev =
+    create_mirror_view( exec_space(), result );
+  ttb_indx  itersCompleted;
+  ttb_real  resNorm;
+  for (int dedup=0; dedup<2; ++dedup) {
+    algParams.arls_dedup = dedup != 0;
+    try
+    {
+      deep_copy(result_dev, initialBasis);
+      Genten::cparls_lev(X_dev, result_dev, algParams, itersCompleted,
+                         resNorm, std::cout);
+    }
+    catch(std::string sExc)
+    {
+      // Should not happen.
+      MESSAGE(sExc);
+      ASSERT( true, "Call to cparls_lev threw an exception." );
+      return;
+    }
+    ASSERT( resNorm <= 0.03, "Residual norm from cparls_lev is small" );
+
+    deep_copy(result, result_dev);
+    evaluateResult(infolevel, itersCompleted, algParams.tol, result);
+  }
+
+  finalize();
+  return;
+}
+
 void Genten_Test_CpAls (int infolevel)
 {
   typedef Genten::DefaultExecutionSpace exec_space;
@@ -395,4 +600,15 @@ void Genten_Test_CpAls (int infolevel)
                            "Duplicated");
   Genten_Test_CpAls_Type(Genten::MTTKRP_Method::Perm,infolevel,
                          "Perm");
+  Genten_Test_CpAls_Type(Genten::MTTKRP_Method::CSF,infolevel,
+                         "CSF");
+  Genten_Test_CpAls_Type(Genten::MTTKRP_Method::HiCOO,infolevel,
+                         "HiCOO");
+  Genten_Test_CpAls_Type(Genten::MTTKRP_Method::ALTO,infolevel,
+                         "ALTO");
+  Genten_Test_CpAls_Type(Genten::MTTKRP_Method::Hybrid,infolevel,
+                         "Hybrid");
+  Genten_Test_CpAls_Type(Genten::MTTKRP_Method::DimTree,infolevel,
+                         "DimTree");
+  Genten_Test_CpArls(infolevel);
 }
@@ -43,7 +43,14 @@
   @brief Unit tests for methods in Genten_IOtext.
 */
 
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
 #include "Genten_IndxArray.hpp"
+#include "Genten_IObinary.hpp"
 #include "Genten_IOtext.hpp"
 #include "Genten_Ktensor.hpp"
 #include "Genten_Sptensor.hpp"
@@ -91,6 +98,105 @@ void Genten_Test_IO(int            infolevel,
          "Sptensor unchanged after write and read");
   ASSERT(remove (fname.c_str()) == 0, "Temp file for export_sptensor deleted");
 
+  MESSAGE("Writing Sptensor to temporary binary file");
+  fname = "tmp_Test_IObinary.bin";
+  Genten::export_sptensor_binary (fname, oSpt);
+  Genten::Sptensor oSpt3;
+  Genten::import_sptensor_binary (fname, oSpt3);
+  ASSERT(oSpt.isEqual(oSpt3, MACHINE_EPSILON),
+         "Sptensor unchanged after binary write and read");
+  Genten::export_sptensor_binary (fname, oSpt, 4);
+  Genten::Sptensor oSpt4;
+  Genten::import_sptensor_binary (fname, oSpt4);
+  ASSERT(oSpt.isEqual(oSpt4, MACHINE_EPSILON),
+         "Sptensor unchanged after binary write and read with 4-byte indices");
+  {
+    // Corrupt the nonzero count so the size arithmetic overflows
+    std::fstream f(fname.c_str(),
+                   std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+    const uint64_t huge_nnz = uint64_t(1) << 62;
+    f.seekp(32);
+    f.write(reinterpret_cast<const char*>(&huge_nnz), sizeof(huge_nnz));
+  }
+  bool threw = false;
+  try {
+    Genten::Sptensor oSpt5;
+    Genten::import_sptensor_binary (fname, oSpt5);
+  }
+  catch(std::string sExc) {
+    threw = true;
+  }
+  ASSERT(threw, "Binary import rejects a header whose sizes overflow");
+  ASSERT(remove (fname.c_str()) == 0,
+         "Temp file for export_sptensor_binary deleted");
+
+  MESSAGE("Parsing a sparse tensor split across several chunks");
+  {
+    // Headerless, with varying line widths, comments, blank lines and
+    // values that need the strtod() fallback
+    const char* vals_fmt[] = { "1.5", "-2.25e-3", "3", "1e-300",
+                               "0.12345678901234567890", "7.0E+2" };
+    std::ostringstream os;
+    const ttb_indx nlines = 20000;
+    for (ttb_indx i=0; i<nlines; ++i) {
+      if (i % 997 == 5)
+        os << "// comment " << i << "\n";
+      if (i % 1499 == 7)
+        os << "\n";
+      os << i % 97 << " " << (i*31) % 1000 << "  " << (i*7) % 12345
+         << "\t" << vals_fmt[i % 6] << "\n";
+    }
+    const std::string text = os.str();
+
+    // Reference result from a line-by-line serial parse
+    std::vector< std::vector<ttb_indx> > ref_subs;
+    std::vector<ttb_real> ref_vals;
+    std::vector<ttb_indx> ref_dims(3, 0);
+    {
+      std::istringstream is(text);
+      std::string line;
+      while (std::getline(is, line)) {
+        if (line.empty() || line.compare(0, 2, "//") == 0)
+          continue;
+        std::istringstream ls(line);
+        std::vector<ttb_indx> sub(3);
+        ttb_real v;
+        ls >> sub[0] >> sub[1] >> sub[2] >> v;
+        for (ttb_indx j=0; j<3; ++j)
+          ref_dims[j] = std::max(ref_dims[j], sub[j]+1);
+        ref_subs.push_back(sub);
+        ref_vals.push_back(v);
+      }
+    }
+
+    // The parallel parser reads everything after the first line and
+    // splits it the same way; make sure some nonzero straddles a split
+    const size_t body = text.find('\n') + 1;
+    const size_t len = text.size() - body;
+    size_t nc = Genten::SpaceProperties<
+      Genten::DefaultHostExecutionSpace>::concurrency() * 4;
+    nc = std::max(size_t(1), std::min(nc, len / (size_t(1) << 16)));
+    bool straddles = false;
+    for (size_t c=1; c<nc; ++c)
+      if (text[body + c*(len/nc) - 1] != '\n')
+        straddles = true;
+    ASSERT(nc > 1 && straddles,
+           "Input is split into several chunks mid-line");
+
+    std::istringstream is(text);
+    Genten::Sptensor oSpt5;
+    Genten::import_sptensor (is, oSpt5);
+    bIsOK = (oSpt5.ndims() == 3) && (oSpt5.nnz() == ref_vals.size());
+    for (ttb_indx j=0; bIsOK && j<3; ++j)
+      bIsOK = (oSpt5.size(j) == ref_dims[j]);
+    for (ttb_indx i=0; bIsOK && i<ref_vals.size(); ++i) {
+      for (ttb_indx j=0; j<3; ++j)
+        bIsOK = bIsOK && (oSpt5.subscript(i,j) == ref_subs[i][j]);
+      bIsOK = bIsOK && (oSpt5.value(i) == ref_vals[i]);
+    }
+    ASSERT(bIsOK, "Parallel parse matches a serial line-by-line parse");
+  }
+
 
   // Test I/O methods for FacMatrix.
 
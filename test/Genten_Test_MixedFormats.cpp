@@ -41,20 +41,66 @@
 
 #include "Genten_Array.hpp"
 #include "Genten_FacMatrix.hpp"
+#include "Genten_GCP_GradientKernels.hpp"
+#include "Genten_GCP_LossFunctions.hpp"
 #include "Genten_IOtext.hpp"             // In case debug lines are uncommented
 #include "Genten_Ktensor.hpp"
 #include "Genten_MixedFormatOps.hpp"
+#include "Genten_MTTKRP_Tune.hpp"
 #include "Genten_Sptensor.hpp"
+#include "Genten_SptensorCSF.hpp"
+#include "Genten_SptensorHiCOO.hpp"
+#include "Genten_SptensorALTO.hpp"
+#include "Genten_SptensorHybrid.hpp"
+#include "Genten_SptensorDimTree.hpp"
+#include "Genten_SptensorNarrow.hpp"
+#include "Genten_KtensorNarrow.hpp"
 #include "Genten_Tensor.hpp"
 #include "Genten_Test_Utils.hpp"
 #include "Genten_Util.hpp"
 
+#include <cstdio>
+#include <sstream>
+
 using namespace Genten::Test;
 
 
 /* This file contains unit tests for operations involving mixed tensor formats.
  */
 
+// Sparse tensor with nnz nonzeros spread over the given dimensions (with
+// repeated subscripts) and values 1 + i%7 + shift
+Genten::Sptensor mttkrp_test_sptensor(const Genten::IndxArray& dims,
+                                      const ttb_indx nnz,
+                                      const ttb_real shift = 0.0)
+{
+  const ttb_indx nd = dims.size();
+  Genten::Sptensor a(dims,nnz);
+  for (ttb_indx i=0; i<nnz; ++i) {
+    for (ttb_indx m=0; m<nd; ++m)
+      a.subscript(i,m) = (i*(m+1)+i/(m+2)) % dims[m];
+    a.value(i) = 1.0 + i % 7 + shift;
+  }
+  return a;
+}
+
+// Ktensor with weights 1 + j%3 and factor matrix entries
+// 0.1*(r+1) + scale*(j+1)*(m+1)
+Genten::Ktensor mttkrp_test_ktensor(const ttb_indx nc,
+                                    const Genten::IndxArray& dims,
+                                    const ttb_real scale = 0.01)
+{
+  const ttb_indx nd = dims.size();
+  Genten::Ktensor u(nc, nd, dims);
+  for (ttb_indx j=0; j<nc; ++j)
+    u.weights(j) = 1.0 + j % 3;
+  for (ttb_indx m=0; m<nd; ++m)
+    for (ttb_indx r=0; r<dims[m]; ++r)
+      for (ttb_indx j=0; j<nc; ++j)
+        u[m].entry(r,j) = 0.1*(r+1) + scale*(j+1)*(m+1);
+  return u;
+}
+
 void Genten_Test_MixedFormats_Impl(int infolevel)
 {
   typedef Genten::DefaultExecutionSpace exec_space;
@@ -132,6 +178,9 @@ void Genten_Test_MixedFormats_Impl(int infolevel)
   ASSERT( EQ(d, 3.081), "Inner product with alternate lambda is correct");
   d = innerprod(t_dev, oKtens_dev, altLambda_dev);
   ASSERT( EQ(d, 3.081), "Inner product with alternate lambda is correct");
+  Genten::SptensorNarrowT<exec_space,uint16_t> a_16_dev(a_dev);
+  d = innerprod(a_16_dev, oKtens_dev, altLambda_dev);
+  ASSERT( EQ(d, 3.081), "Inner product with 16-bit subscripts is correct");
 
 
   //----------------------------------------------------------------------
@@ -446,6 +495,138 @@ void Genten_Test_MTTKRP_Type(Genten::MTTKRP_Method::type mttkrp_method,
   ASSERT( EQ(oFM.entry(0,0), 120.0) && EQ(oFM.entry(3,0), 154.0),
           "mttkrp result values correct for index [0], 2 sparse nnz");
 
+  // Check perm mttkrp using row pointers
+  if (mttkrp_method == Genten::MTTKRP_Method::Perm) {
+    a_dev.createPermutation(true);
+    oFM = Genten::FacMatrix(a.size(1), oKtens.ncomponents());
+    oFM_dev = create_mirror_view( exec_space(), oFM );
+    mttkrp (a_dev, oKtens_dev, 1, oFM_dev, algParams);
+    deep_copy( oFM, oFM_dev );
+    ASSERT( EQ(oFM.entry(0,0), 150.0) && EQ(oFM.entry(1,0), 0.0) &&
+            EQ(oFM.entry(2,0), 198.0),
+            "perm mttkrp result values correct with row pointers");
+
+    // Add a third nonzero in row 1 of mode 0 and split that row into
+    // single-nonzero tiles
+    Sptensor_host_type b(dims,3);
+    for (ttb_indx i=0; i<2; ++i) {
+      for (ttb_indx m=0; m<3; ++m)
+        b.subscript(i,m) = a.subscript(i,m);
+      b.value(i) = a.value(i);
+    }
+    b.subscript(2,0) = 1;  b.subscript(2,1) = 0;  b.subscript(2,2) = 0;
+    b.value(2) = 1.0;
+    Sptensor_type b_dev = create_mirror_view( exec_space(), b );
+    deep_copy( b_dev, b );
+    b_dev.createPermutation(true);
+    Genten::AlgParams heavyParams = algParams;
+    heavyParams.mttkrp_nnz_tile_size = 1;
+    heavyParams.mttkrp_heavy_row_tiles = 1;
+    oFM = Genten::FacMatrix(b.size(0), oKtens.ncomponents());
+    oFM_dev = create_mirror_view( exec_space(), oFM );
+    mttkrp (b_dev, oKtens_dev, 0, oFM_dev, heavyParams);
+    deep_copy( oFM, oFM_dev );
+    ASSERT( EQ(oFM.entry(0,0), 180.0) && EQ(oFM.entry(1,0), 432.0),
+            "perm mttkrp result values correct with heavy rows split");
+  }
+
+  // Check CSF mttkrp for modes that are not the root of the tree
+  if (mttkrp_method == Genten::MTTKRP_Method::CSF) {
+    Genten::SptensorCSFT<exec_space> a_csf(a_dev, 0);
+    oFM = Genten::FacMatrix(a.size(1), oKtens.ncomponents());
+    oFM_dev = create_mirror_view( exec_space(), oFM );
+    mttkrp (a_csf, oKtens_dev, 1, oFM_dev, algParams);
+    deep_copy( oFM, oFM_dev );
+    ASSERT( EQ(oFM.entry(0,0), 150.0) && EQ(oFM.entry(2,0), 198.0),
+            "CSF mttkrp result values correct for interior level");
+    oFM = Genten::FacMatrix(a.size(2), oKtens.ncomponents());
+    oFM_dev = create_mirror_view( exec_space(), oFM );
+    mttkrp (a_csf, oKtens_dev, 2, oFM_dev, algParams);
+    deep_copy( oFM, oFM_dev );
+    ASSERT( EQ(oFM.entry(0,0), 120.0) && EQ(oFM.entry(3,0), 154.0),
+            "CSF mttkrp result values correct for leaf level");
+  }
+
+  // Check mttkrp with narrow subscripts
+  if (mttkrp_method == Genten::MTTKRP_Method::Atomic ||
+      mttkrp_method == Genten::MTTKRP_Method::Duplicated ||
+      mttkrp_method == Genten::MTTKRP_Method::Prefetch) {
+    Genten::SptensorNarrowT<exec_space,uint16_t> a_16(a_dev);
+    oFM = Genten::FacMatrix(a.size(1), oKtens.ncomponents());
+    oFM_dev = create_mirror_view( exec_space(), oFM );
+    mttkrp (a_16, oKtens_dev, 1, oFM_dev, algParams);
+    deep_copy( oFM, oFM_dev );
+    ASSERT( EQ(oFM.entry(0,0), 150.0) && EQ(oFM.entry(2,0), 198.0),
+            "mttkrp result values correct with 16-bit subscripts");
+    Genten::SptensorNarrowT<exec_space,uint32_t> a_32(a_dev);
+    oFM = Genten::FacMatrix(a.size(2), oKtens.ncomponents());
+    oFM_dev = create_mirror_view( exec_space(), oFM );
+    mttkrp (a_32, oKtens_dev, 2, oFM_dev, algParams);
+    deep_copy( oFM, oFM_dev );
+    ASSERT( EQ(oFM.entry(0,0), 120.0) && EQ(oFM.entry(3,0), 154.0),
+            "mttkrp result values correct with 32-bit subscripts");
+  }
+
+  // Check HiCOO mttkrp with the nonzeros in different blocks
+  if (mttkrp_method == Genten::MTTKRP_Method::HiCOO) {
+    Genten::SptensorHiCOOT<exec_space> a_hicoo(a_dev, 1);
+    ASSERT( a_hicoo.nblocks() == 2, "HiCOO tensor has 2 blocks");
+    oFM = Genten::FacMatrix(a.size(1), oKtens.ncomponents());
+    oFM_dev = create_mirror_view( exec_space(), oFM );
+    mttkrp (a_hicoo, oKtens_dev, 1, oFM_dev, algParams);
+    deep_copy( oFM, oFM_dev );
+    ASSERT( EQ(oFM.entry(0,0), 150.0) && EQ(oFM.entry(2,0), 198.0),
+            "HiCOO mttkrp result values correct with 2 blocks");
+  }
+
+  // Check hybrid mttkrp with every row cold, and with rows privatized
+  if (mttkrp_method == Genten::MTTKRP_Method::Hybrid) {
+    Genten::AlgParams hybridParams = algParams;
+    hybridParams.mttkrp_hybrid_threshold = 1.0e6;
+    Genten::SptensorHybridT<exec_space> a_cold(a_dev, hybridParams);
+    ASSERT( a_cold.nhot(2) == 0, "hybrid tensor has no hot rows");
+    oFM = Genten::FacMatrix(a.size(2), oKtens.ncomponents());
+    oFM_dev = create_mirror_view( exec_space(), oFM );
+    mttkrp (a_cold, oKtens_dev, 2, oFM_dev, hybridParams);
+    deep_copy( oFM, oFM_dev );
+    ASSERT( EQ(oFM.entry(0,0), 120.0) && EQ(oFM.entry(3,0), 154.0),
+            "hybrid mttkrp result values correct with no hot rows");
+
+    hybridParams.mttkrp_hybrid_threshold = 0.0;
+    Genten::SptensorHybridT<exec_space> a_hot(a_dev, hybridParams);
+    const ttb_indx P = Genten::SpaceProperties<exec_space>::concurrency();
+    ASSERT( a_hot.nhot(2) <= a.size(2)/P && (P > 1 || a_hot.nhot(2) == 2),
+            "hybrid tensor hot rows capped by threads");
+    oFM = Genten::FacMatrix(a.size(2), oKtens.ncomponents());
+    oFM_dev = create_mirror_view( exec_space(), oFM );
+    mttkrp (a_hot, oKtens_dev, 2, oFM_dev, hybridParams);
+    deep_copy( oFM, oFM_dev );
+    ASSERT( EQ(oFM.entry(0,0), 120.0) && EQ(oFM.entry(1,0), 0.0) &&
+            EQ(oFM.entry(3,0), 154.0),
+            "hybrid mttkrp result values correct with hot rows");
+  }
+
+  // Check ALTO key lookups used by the GCP samplers
+  if (mttkrp_method == Genten::MTTKRP_Method::ALTO) {
+    const Genten::SptensorALTOT<exec_space> a_alto(a_dev);
+    ASSERT( a_alto.nwords() == 1, "ALTO tensor uses 64-bit keys");
+    int ncorrect = 0;
+    Kokkos::parallel_reduce("Genten_Test_ALTO_find",
+                            Kokkos::RangePolicy<exec_space>(0,1),
+                            KOKKOS_LAMBDA(const int, int& nc)
+    {
+      ttb_indx ind[3] = { 1, 2, 3 };
+      const auto p = a_alto.find(ind);
+      if (a_alto.valid_at(p) && a_alto.value_at(p) == 1.0)
+        ++nc;
+      ind[1] = 0;
+      if (!a_alto.exists(ind))
+        ++nc;
+    }, ncorrect);
+    ASSERT( ncorrect == 2,
+            "ALTO lookup finds nonzeros and rejects zeros");
+  }
+
   finalize();
   return;
 }
@@ -565,6 +746,570 @@ void Genten_Test_MTTKRP_All_Type(Genten::MTTKRP_All_Method::type mttkrp_method,
   return;
 }
 
+void Genten_Test_MTTKRP_Order(int infolevel)
+{
+  typedef Genten::DefaultExecutionSpace exec_space;
+  typedef Genten::DefaultHostExecutionSpace host_exec_space;
+  typedef Genten::SptensorT<exec_space> Sptensor_type;
+  typedef Genten::SptensorT<host_exec_space> Sptensor_host_type;
+  typedef Genten::KtensorT<exec_space> Ktensor_type;
+
+  initialize("MTTKRP tests for tensor orders 2 through 7", infolevel);
+
+  // Orders 3 through 6 use kernels specialized on the tensor order, the
+  // others use the generic kernels.  Each tensor has a single nonzero at
+  // (1,...,1) and factor matrix m has entry(1,j) = m+2, so mttkrp along
+  // mode n is the product of m+2 over m != n in row 1 and zero in row 0.
+  Genten::AlgParams algParams;
+  algParams.mttkrp_method = Genten::MTTKRP_Method::Atomic;
+  algParams.mttkrp_all_method = Genten::MTTKRP_All_Method::Atomic;
+  const ttb_indx nc = 3;
+  for (ttb_indx nd=2; nd<=7; ++nd) {
+    Genten::IndxArray dims(nd, 2);
+    Sptensor_host_type a(dims,1);
+    for (ttb_indx m=0; m<nd; ++m)
+      a.subscript(0,m) = 1;
+    a.value(0) = 1.0;
+
+    Genten::Ktensor u(nc, nd, dims);
+    u.setWeights(1.0);
+    for (ttb_indx m=0; m<nd; ++m) {
+      u[m] = 0.0;
+      for (ttb_indx j=0; j<nc; ++j)
+        u[m].entry(1,j) = m+2.0;
+    }
+
+    Sptensor_type a_dev = create_mirror_view( exec_space(), a );
+    deep_copy( a_dev, a );
+    Ktensor_type u_dev = create_mirror_view( exec_space(), u );
+    deep_copy( u_dev, u );
+
+    Genten::Ktensor v(nc, nd, dims);
+    Ktensor_type v_dev = create_mirror_view( exec_space(), v );
+    deep_copy( v_dev, v );
+
+    for (ttb_indx n=0; n<nd; ++n)
+      mttkrp(a_dev, u_dev, n, v_dev[n], algParams);
+    deep_copy( v, v_dev );
+    bool correct = true;
+    for (ttb_indx n=0; n<nd; ++n) {
+      ttb_real expected = 1.0;
+      for (ttb_indx m=0; m<nd; ++m)
+        if (m != n)
+          expected *= m+2.0;
+      for (ttb_indx j=0; j<nc; ++j)
+        correct = correct && EQ(v[n].entry(0,j), 0.0) &&
+          EQ(v[n].entry(1,j), expected);
+    }
+    ASSERT(correct, "mttkrp result values correct for order " +
+           std::to_string(nd));
+
+    mttkrp_all(a_dev, u_dev, v_dev, algParams);
+    deep_copy( v, v_dev );
+    correct = true;
+    for (ttb_indx n=0; n<nd; ++n) {
+      ttb_real expected = 1.0;
+      for (ttb_indx m=0; m<nd; ++m)
+        if (m != n)
+          expected *= m+2.0;
+      for (ttb_indx j=0; j<nc; ++j)
+        correct = correct && EQ(v[n].entry(0,j), 0.0) &&
+          EQ(v[n].entry(1,j), expected);
+    }
+    ASSERT(correct, "mttkrp_all result values correct for order " +
+           std::to_string(nd));
+  }
+
+  finalize();
+  return;
+}
+
+void Genten_Test_MTTKRP_DimTree(int infolevel)
+{
+  typedef Genten::DefaultExecutionSpace exec_space;
+  typedef Genten::DefaultHostExecutionSpace host_exec_space;
+  typedef Genten::SptensorT<exec_space> Sptensor_type;
+  typedef Genten::SptensorT<host_exec_space> Sptensor_host_type;
+  typedef Genten::KtensorT<exec_space> Ktensor_type;
+
+  initialize("MTTKRP tests for dimension tree sweeps", infolevel);
+
+  // Run two CP-ALS-like sweeps over the modes of order 3 to 5 tensors,
+  // changing u[n] after each MTTKRP, and compare against atomic MTTKRP.
+  // Memory limits of -1, 0 and 2e-3 MB cache all, none and (for orders 4
+  // and 5) only the first of the internal nodes.
+  const ttb_indx nc = 5;
+  const ttb_indx nnz = 50;
+  const ttb_real budgets[] = { -1.0, 0.0, 2.0e-3 };
+  for (ttb_indx nd=3; nd<=5; ++nd) {
+    Genten::IndxArray dims(nd);
+    for (ttb_indx m=0; m<nd; ++m)
+      dims[m] = 3+m;
+    Sptensor_host_type a = mttkrp_test_sptensor(dims, nnz);
+    Sptensor_type a_dev = create_mirror_view( exec_space(), a );
+    deep_copy( a_dev, a );
+
+    for (const ttb_real budget : budgets) {
+      Genten::AlgParams algParams;
+      algParams.mttkrp_method = Genten::MTTKRP_Method::Atomic;
+      algParams.mttkrp_dimtree_memory = budget;
+      Genten::SptensorDimTreeT<exec_space> a_tree(a_dev, algParams);
+
+      Genten::Ktensor u = mttkrp_test_ktensor(nc, dims);
+      Ktensor_type u_dev = create_mirror_view( exec_space(), u );
+      deep_copy( u_dev, u );
+
+      bool correct = true;
+      for (ttb_indx sweep=0; sweep<2; ++sweep) {
+        for (ttb_indx n=0; n<nd; ++n) {
+          Genten::FacMatrixT<exec_space> v_tree(dims[n], nc);
+          Genten::FacMatrixT<exec_space> v_atomic(dims[n], nc);
+          mttkrp(a_tree, u_dev, n, v_tree, algParams);
+          mttkrp(a_dev, u_dev, n, v_atomic, algParams);
+          correct = correct && v_tree.isEqual(v_atomic, 1.0e-12);
+
+          // Update u[n] like CP-ALS would
+          u[n].times(ttb_real(0.5) + sweep);
+          deep_copy( u_dev[n], u[n] );
+          a_tree.factorUpdated(n);
+        }
+      }
+      ASSERT(correct, "dimtree mttkrp sweep correct for order " +
+             std::to_string(nd) + ", memory " + std::to_string(budget) +
+             " MB");
+    }
+  }
+
+  finalize();
+  return;
+}
+
+void Genten_Test_MTTKRP_Dense(int infolevel)
+{
+  typedef Genten::DefaultExecutionSpace exec_space;
+  typedef Genten::DefaultHostExecutionSpace host_exec_space;
+  typedef Genten::TensorT<exec_space> Tensor_type;
+  typedef Genten::TensorT<host_exec_space> Tensor_host_type;
+  typedef Genten::KtensorT<exec_space> Ktensor_type;
+
+  initialize("Dense MTTKRP tests for GEMM method", infolevel);
+
+  // Compare the GEMM method against the element-wise kernel along every
+  // mode of order 1 through 4 tensors, covering the first, last and
+  // interior cases.  With dims 5 x 2 x 3 x 4, mode 1 contracts the right
+  // Khatri-Rao product first and mode 2 the left.
+  const ttb_indx nc = 5;
+  for (ttb_indx nd=1; nd<=4; ++nd) {
+    Genten::IndxArray dims(nd);
+    for (ttb_indx m=0; m<nd; ++m)
+      dims[m] = m == 0 ? 5 : m+1;
+    Tensor_host_type a(dims);
+    for (ttb_indx i=0; i<a.numel(); ++i)
+      a[i] = 0.5 + (i*7) % 11;
+    Tensor_type a_dev = create_mirror_view( exec_space(), a );
+    deep_copy( a_dev, a );
+
+    Genten::Ktensor u(nc, nd, dims);
+    for (ttb_indx j=0; j<nc; ++j)
+      u.weights(j) = 1.0 + j;
+    for (ttb_indx m=0; m<nd; ++m)
+      for (ttb_indx r=0; r<dims[m]; ++r)
+        for (ttb_indx j=0; j<nc; ++j)
+          u[m].entry(r,j) = 0.1*(r+1) + 0.01*(j+1)*(m+1);
+    Ktensor_type u_dev = create_mirror_view( exec_space(), u );
+    deep_copy( u_dev, u );
+
+    Genten::AlgParams ap_gemm, ap_elem;
+    ap_gemm.mttkrp_method = Genten::MTTKRP_Method::GEMM;
+    ap_elem.mttkrp_method = Genten::MTTKRP_Method::Atomic;
+    bool correct = true;
+    for (ttb_indx n=0; n<nd; ++n) {
+      Genten::FacMatrixT<exec_space> v_gemm(dims[n], nc);
+      Genten::FacMatrixT<exec_space> v_elem(dims[n], nc);
+      v_gemm = 1.0;
+      mttkrp(a_dev, u_dev, n, v_gemm, ap_gemm);
+      mttkrp(a_dev, u_dev, n, v_elem, ap_elem);
+      correct = correct && v_gemm.isEqual(v_elem, 1.0e-12);
+    }
+    ASSERT(correct, "dense gemm mttkrp correct for order " +
+           std::to_string(nd));
+  }
+
+  finalize();
+  return;
+}
+
+void Genten_Test_MTTKRP_Tune(int infolevel)
+{
+  typedef Genten::DefaultExecutionSpace exec_space;
+  typedef Genten::DefaultHostExecutionSpace host_exec_space;
+  typedef Genten::SptensorT<exec_space> Sptensor_type;
+  typedef Genten::SptensorT<host_exec_space> Sptensor_host_type;
+  typedef Genten::KtensorT<exec_space> Ktensor_type;
+
+  initialize("MTTKRP auto tuning tests", infolevel);
+
+  const ttb_indx nd = 3;
+  const ttb_indx nc = 4;
+  const ttb_indx nnz = 200;
+  Genten::IndxArray dims = { 10, 20, 30 };
+  Sptensor_host_type a = mttkrp_test_sptensor(dims, nnz);
+  Sptensor_type a_dev = create_mirror_view( exec_space(), a );
+  deep_copy( a_dev, a );
+
+  const std::string cache_file = "genten_test_mttkrp_tune.txt";
+  std::remove(cache_file.c_str());
+  Genten::AlgParams algParams;
+  algParams.mttkrp_method = Genten::MTTKRP_Method::Auto;
+  algParams.mttkrp_tune_iters = 1;
+  algParams.mttkrp_tune_cache = cache_file;
+
+  // First call benchmarks and writes the cache
+  std::stringstream out1;
+  Genten::AlgParams ap1 = algParams;
+  Genten::tune_mttkrp(a_dev, nc, ap1, out1);
+  ASSERT(ap1.mttkrp_method != Genten::MTTKRP_Method::Auto &&
+         out1.str().find("Selected MTTKRP method") != std::string::npos,
+         "auto mttkrp method selected by benchmarking");
+
+  // Second call uses the cache
+  std::stringstream out2;
+  Genten::AlgParams ap2 = algParams;
+  Genten::tune_mttkrp(a_dev, nc, ap2, out2);
+  ASSERT(ap2.mttkrp_method == ap1.mttkrp_method &&
+         ap2.mttkrp_nnz_tile_size == ap1.mttkrp_nnz_tile_size &&
+         out2.str().find("Using cached") != std::string::npos,
+         "auto mttkrp method read from tuning cache");
+
+  // A different rank misses the cache
+  std::stringstream out3;
+  Genten::AlgParams ap3 = algParams;
+  Genten::tune_mttkrp(a_dev, nc+1, ap3, out3);
+  ASSERT(out3.str().find("Selected MTTKRP method") != std::string::npos,
+         "auto mttkrp tuning cache keyed on rank");
+  std::remove(cache_file.c_str());
+
+  // The selected method computes the right answer
+  Genten::Ktensor u = mttkrp_test_ktensor(nc, dims);
+  Ktensor_type u_dev = create_mirror_view( exec_space(), u );
+  deep_copy( u_dev, u );
+  Genten::AlgParams ap_atomic;
+  ap_atomic.mttkrp_method = Genten::MTTKRP_Method::Atomic;
+  bool correct = true;
+  for (ttb_indx n=0; n<nd; ++n) {
+    Genten::FacMatrixT<exec_space> v_tuned(dims[n], nc);
+    Genten::FacMatrixT<exec_space> v_atomic(dims[n], nc);
+    mttkrp(a_dev, u_dev, n, v_tuned, ap1);
+    mttkrp(a_dev, u_dev, n, v_atomic, ap_atomic);
+    correct = correct && v_tuned.isEqual(v_atomic, 1.0e-12);
+  }
+  ASSERT(correct, std::string("mttkrp correct for selected method ") +
+         Genten::MTTKRP_Method::names[ap1.mttkrp_method]);
+
+  finalize();
+  return;
+}
+
+void Genten_Test_MTTKRP_RankBatch(int infolevel)
+{
+  typedef Genten::DefaultExecutionSpace exec_space;
+  typedef Genten::DefaultHostExecutionSpace host_exec_space;
+  typedef Genten::SpaceProperties<exec_space> space_prop;
+  typedef Genten::SptensorT<exec_space> Sptensor_type;
+  typedef Genten::SptensorT<host_exec_space> Sptensor_host_type;
+  typedef Genten::KtensorT<exec_space> Ktensor_type;
+
+  initialize("MTTKRP tests for rank batching", infolevel);
+
+  // With 150 components the columns are processed in 2 blocks.  Compare
+  // loading the nonzero tiles into scratch once against re-reading them
+  // for each block, for MTTKRP and the GCP gradient, which evaluates the
+  // gradient tensor values on the fly.
+  const ttb_indx nd = 3;
+  const ttb_indx nc = 150;
+  const ttb_indx nnz = 300;
+  Genten::IndxArray dims = { 7, 9, 11 };
+  Sptensor_host_type a = mttkrp_test_sptensor(dims, nnz);
+  Sptensor_type a_dev = create_mirror_view( exec_space(), a );
+  deep_copy( a_dev, a );
+
+  Genten::Ktensor u = mttkrp_test_ktensor(nc, dims, 0.001);
+  Ktensor_type u_dev = create_mirror_view( exec_space(), u );
+  deep_copy( u_dev, u );
+
+  std::vector<Genten::MTTKRP_Method::type> methods =
+    { Genten::MTTKRP_Method::Atomic };
+  if (!space_prop::is_cuda)
+    methods.push_back(Genten::MTTKRP_Method::Duplicated);
+  for (const auto method : methods) {
+    Genten::AlgParams ap_batch, ap_block;
+    ap_batch.mttkrp_method = method;
+    ap_batch.mttkrp_rank_batch = 1;
+    ap_batch.mttkrp_nnz_tile_size = 16;
+    ap_block.mttkrp_method = method;
+    ap_block.mttkrp_rank_batch = 0;
+
+    bool correct = true;
+    for (ttb_indx n=0; n<nd; ++n) {
+      Genten::FacMatrixT<exec_space> v_batch(dims[n], nc);
+      Genten::FacMatrixT<exec_space> v_block(dims[n], nc);
+      mttkrp(a_dev, u_dev, n, v_batch, ap_batch);
+      mttkrp(a_dev, u_dev, n, v_block, ap_block);
+      correct = correct && v_batch.isEqual(v_block, 1.0e-12);
+    }
+    ASSERT(correct, std::string("rank batched mttkrp correct for method ") +
+           Genten::MTTKRP_Method::names[method]);
+
+    Genten::ArrayT<exec_space> w(nnz, 1.0);
+    Genten::GaussianLossFunction f(0.0);
+    Ktensor_type g_batch(nc, nd, dims);
+    Ktensor_type g_block(nc, nd, dims);
+    Sptensor_type y;
+    Genten::Impl::gcp_gradient(a_dev, y, u_dev, w, f, g_batch, ap_batch);
+    Genten::Impl::gcp_gradient(a_dev, y, u_dev, w, f, g_block, ap_block);
+    correct = true;
+    for (ttb_indx n=0; n<nd; ++n)
+      correct = correct && g_batch[n].isEqual(g_block[n], 1.0e-12);
+    ASSERT(correct,
+           std::string("rank batched gcp gradient correct for method ") +
+           Genten::MTTKRP_Method::names[method]);
+  }
+
+  finalize();
+  return;
+}
+
+void Genten_Test_MTTKRP_Prefetch(int infolevel)
+{
+  typedef Genten::DefaultExecutionSpace exec_space;
+  typedef Genten::DefaultHostExecutionSpace host_exec_space;
+  typedef Genten::SptensorT<exec_space> Sptensor_type;
+  typedef Genten::SptensorT<host_exec_space> Sptensor_host_type;
+  typedef Genten::KtensorT<exec_space> Ktensor_type;
+
+  initialize("MTTKRP tests for prefetching", infolevel);
+
+  // Compare against atomic for prefetch distances within and beyond a
+  // tile, with a partial tile and a partial block of columns
+  const ttb_indx nc = 40;
+  const ttb_indx nnz = 301;
+  for (ttb_indx nd : { 3, 4 }) {
+    Genten::IndxArray dims(nd);
+    for (ttb_indx m=0; m<nd; ++m)
+      dims[m] = 7 + 2*m;
+    Sptensor_host_type a = mttkrp_test_sptensor(dims, nnz);
+    Sptensor_type a_dev = create_mirror_view( exec_space(), a );
+    deep_copy( a_dev, a );
+
+    Genten::Ktensor u = mttkrp_test_ktensor(nc, dims);
+    Ktensor_type u_dev = create_mirror_view( exec_space(), u );
+    deep_copy( u_dev, u );
+
+    Genten::AlgParams ap_atomic;
+    ap_atomic.mttkrp_method = Genten::MTTKRP_Method::Atomic;
+    bool correct = true;
+    for (ttb_indx dist : { 0, 1, 16, 500 }) {
+      Genten::AlgParams ap_prefetch;
+      ap_prefetch.mttkrp_method = Genten::MTTKRP_Method::Prefetch;
+      ap_prefetch.mttkrp_prefetch_distance = dist;
+      ap_prefetch.mttkrp_nnz_tile_size = 32;
+      for (ttb_indx n=0; n<nd; ++n) {
+        Genten::FacMatrixT<exec_space> v_prefetch(dims[n], nc);
+        Genten::FacMatrixT<exec_space> v_atomic(dims[n], nc);
+        v_prefetch = 1.0;
+        mttkrp(a_dev, u_dev, n, v_prefetch, ap_prefetch);
+        mttkrp(a_dev, u_dev, n, v_atomic, ap_atomic);
+        correct = correct && v_prefetch.isEqual(v_atomic, 1.0e-12);
+      }
+    }
+    ASSERT(correct, "prefetch mttkrp correct for order " +
+           std::to_string(nd));
+  }
+
+  finalize();
+  return;
+}
+
+void Genten_Test_MTTKRP_NUMA(int infolevel)
+{
+  typedef Genten::DefaultExecutionSpace exec_space;
+  typedef Genten::DefaultHostExecutionSpace host_exec_space;
+  typedef Genten::SpaceProperties<exec_space> space_prop;
+  typedef Genten::SptensorT<exec_space> Sptensor_type;
+  typedef Genten::SptensorT<host_exec_space> Sptensor_host_type;
+  typedef Genten::KtensorT<exec_space> Ktensor_type;
+  typedef Genten::KtensorReplicatedT<exec_space> Ktensor_replicated_type;
+
+  initialize("MTTKRP tests for NUMA placement", infolevel);
+
+  const ttb_indx nd = 3;
+  const ttb_indx nc = 6;
+  const ttb_indx nnz = 300;
+  Genten::IndxArray dims = { 7, 9, 11 };
+  Sptensor_host_type a = mttkrp_test_sptensor(dims, nnz);
+  Sptensor_type a_dev = create_mirror_view( exec_space(), a );
+  deep_copy( a_dev, a );
+
+  Genten::Ktensor u = mttkrp_test_ktensor(nc, dims);
+  Ktensor_type u_dev = create_mirror_view( exec_space(), u );
+  deep_copy( u_dev, u );
+
+  // Replicated factor matrices give the same result, with and without
+  // rank batching
+  Ktensor_replicated_type u_rep(u_dev);
+  const Genten::NumaTopology& topo = Genten::NumaTopology::get();
+  ASSERT(u_rep.nreplicas() >= 1 && u_rep.nreplicas() <= topo.nnodes(),
+         "one factor matrix replica per NUMA node");
+  std::vector<Genten::MTTKRP_Method::type> methods =
+    { Genten::MTTKRP_Method::Atomic };
+  if (!space_prop::is_cuda)
+    methods.push_back(Genten::MTTKRP_Method::Duplicated);
+  for (const auto method : methods) {
+    for (ttb_indx rank_batch : { 0, 1 }) {
+      Genten::AlgParams algParams;
+      algParams.mttkrp_method = method;
+      algParams.mttkrp_rank_batch = rank_batch;
+      bool correct = true;
+      for (ttb_indx n=0; n<nd; ++n) {
+        Genten::FacMatrixT<exec_space> v(dims[n], nc);
+        Genten::FacMatrixT<exec_space> v_rep(dims[n], nc);
+        mttkrp(a_dev, u_dev, n, v, algParams);
+        mttkrp(a_dev, u_rep, n, v_rep, algParams);
+        correct = correct && v_rep.isEqual(v, 1.0e-12);
+      }
+      ASSERT(correct, std::string("replicated mttkrp correct for method ") +
+             Genten::MTTKRP_Method::names[method] +
+             (rank_batch > 0 ? " with rank batching" : ""));
+    }
+  }
+
+  // Overwrite mode 0 after the update skipping it and update the others
+  // like CP-ALS would
+  u_rep.update(u_dev, 0);
+  u[0].times(2.0);
+  u.weights(1) = 0.5;
+  deep_copy( u_dev, u );
+  u_rep.update(u_dev, 1);
+  Genten::AlgParams algParams;
+  algParams.mttkrp_method = Genten::MTTKRP_Method::Atomic;
+  {
+    Genten::FacMatrixT<exec_space> v(dims[1], nc);
+    Genten::FacMatrixT<exec_space> v_rep(dims[1], nc);
+    mttkrp(a_dev, u_dev, 1, v, algParams);
+    mttkrp(a_dev, u_rep, 1, v_rep, algParams);
+    ASSERT(v_rep.isEqual(v, 1.0e-12),
+           "replicated mttkrp correct after factor update");
+  }
+
+  // First-touch placement copies the tensor and factor matrices
+  Sptensor_type b_dev = create_mirror_view( exec_space(), a );
+  deep_copy( b_dev, a );
+  Ktensor_type w_dev(nc, nd, dims);
+  deep_copy( w_dev, u_dev );
+  Genten::SptensorNarrowT<exec_space,uint16_t> b_16(b_dev);
+  Genten::numa_first_touch(b_dev, algParams);
+  Genten::numa_first_touch(b_16, algParams);
+  Genten::numa_first_touch(w_dev);
+  bool correct = b_dev.nnz() == nnz && b_dev.ndims() == nd &&
+    b_16.nnz() == nnz && b_16.ndims() == nd;
+  for (ttb_indx n=0; n<nd; ++n) {
+    Genten::FacMatrixT<exec_space> v(dims[n], nc);
+    Genten::FacMatrixT<exec_space> v_ft(dims[n], nc);
+    Genten::FacMatrixT<exec_space> v_16(dims[n], nc);
+    mttkrp(a_dev, u_dev, n, v, algParams);
+    mttkrp(b_dev, w_dev, n, v_ft, algParams);
+    mttkrp(b_16, w_dev, n, v_16, algParams);
+    correct = correct && v_ft.isEqual(v, 1.0e-12) && v_16.isEqual(v, 1.0e-12);
+  }
+  ASSERT(correct, "mttkrp correct after first-touch placement");
+
+  std::stringstream out;
+  Genten::print_numa_placement(algParams, out);
+  ASSERT(out.str().find("NUMA placement") != std::string::npos,
+         "NUMA placement report printed");
+
+  finalize();
+  return;
+}
+
+#ifdef HAVE_MIXED_PRECISION
+void Genten_Test_MTTKRP_Mixed(int infolevel)
+{
+  typedef Genten::DefaultExecutionSpace exec_space;
+  typedef Genten::DefaultHostExecutionSpace host_exec_space;
+  typedef Genten::SpaceProperties<exec_space> space_prop;
+  typedef Genten::SptensorT<exec_space> Sptensor_type;
+  typedef Genten::SptensorT<host_exec_space> Sptensor_host_type;
+  typedef Genten::KtensorT<exec_space> Ktensor_type;
+  typedef Genten::KtensorNarrowT<exec_space,float> Ktensor_float_type;
+
+  initialize("Mixed-precision MTTKRP tests", infolevel);
+
+  // Compare float values and factor matrices against full precision for
+  // each mode, with a float tolerance
+  const ttb_indx nd = 3;
+  const ttb_indx nc = 5;
+  const ttb_indx nnz = 50;
+  Genten::IndxArray dims = { 3, 4, 5 };
+  Sptensor_host_type a = mttkrp_test_sptensor(dims, nnz, 1.0/3.0);
+  Sptensor_type a_dev = create_mirror_view( exec_space(), a );
+  deep_copy( a_dev, a );
+
+  Genten::Ktensor u = mttkrp_test_ktensor(nc, dims, 0.01/3.0);
+  for (ttb_indx j=0; j<nc; ++j)
+    u.weights(j) = 1.0 + j/3.0;
+  Ktensor_type u_dev = create_mirror_view( exec_space(), u );
+  deep_copy( u_dev, u );
+
+  Genten::SptensorNarrowT<exec_space,uint32_t,float> a_32f(a_dev);
+  Genten::SptensorNarrowT<exec_space,uint64_t,float> a_64f(a_dev);
+  Ktensor_float_type u_f(u_dev);
+  ASSERT(a_32f.memory() == nnz*(nd*sizeof(uint32_t)+sizeof(float)) &&
+         u_f.memory() == (3+4+5+1)*nc*sizeof(float),
+         "mixed-precision tensor and factor matrices stored as float");
+
+  std::vector<Genten::MTTKRP_Method::type> methods =
+    { Genten::MTTKRP_Method::Atomic };
+  if (!space_prop::is_cuda)
+    methods.push_back(Genten::MTTKRP_Method::Duplicated);
+  for (const auto method : methods) {
+    Genten::AlgParams algParams;
+    algParams.mttkrp_method = method;
+    bool correct = true;
+    for (ttb_indx n=0; n<nd; ++n) {
+      Genten::FacMatrixT<exec_space> v(dims[n], nc);
+      Genten::FacMatrixT<exec_space> v_32f(dims[n], nc);
+      Genten::FacMatrixT<exec_space> v_64f(dims[n], nc);
+      mttkrp(a_dev, u_dev, n, v, algParams);
+      mttkrp(a_32f, u_f, n, v_32f, algParams);
+      mttkrp(a_64f, u_f, n, v_64f, algParams);
+      correct = correct && v_32f.isEqual(v, 1.0e-5) && v_64f.isEqual(v, 1.0e-5);
+    }
+    ASSERT(correct, std::string("mixed-precision mttkrp correct for method ") +
+           Genten::MTTKRP_Method::names[method]);
+  }
+
+  // Overwrite mode 0 after the update skipping it and update the others
+  // like CP-ALS would
+  u_f.update(u_dev, 0);
+  u[0].times(2.0);
+  u.weights(1) = 0.5;
+  deep_copy( u_dev, u );
+  u_f.update(u_dev, 1);
+  Genten::AlgParams algParams;
+  algParams.mttkrp_method = Genten::MTTKRP_Method::Atomic;
+  Genten::FacMatrixT<exec_space> v(dims[1], nc);
+  Genten::FacMatrixT<exec_space> v_f(dims[1], nc);
+  mttkrp(a_dev, u_dev, 1, v, algParams);
+  mttkrp(a_32f, u_f, 1, v_f, algParams);
+  ASSERT(v_f.isEqual(v, 1.0e-5),
+         "mixed-precision mttkrp correct after factor update");
+
+  finalize();
+  return;
+}
+#endif
+
 void Genten_Test_MixedFormats(int infolevel)
 {
   typedef Genten::DefaultExecutionSpace exec_space;
@@ -579,6 +1324,37 @@ void Genten_Test_MixedFormats(int infolevel)
                             "Duplicated");
   Genten_Test_MTTKRP_Type(Genten::MTTKRP_Method::Perm, infolevel,
                           "Perm");
+  Genten_Test_MTTKRP_Type(Genten::MTTKRP_Method::CSF, infolevel,
+                          "CSF");
+  Genten_Test_MTTKRP_Type(Genten::MTTKRP_Method::HiCOO, infolevel,
+                          "HiCOO");
+  Genten_Test_MTTKRP_Type(Genten::MTTKRP_Method::ALTO, infolevel,
+                          "ALTO");
+  Genten_Test_MTTKRP_Type(Genten::MTTKRP_Method::Hybrid, infolevel,
+                          "Hybrid");
+  Genten_Test_MTTKRP_Type(Genten::MTTKRP_Method::DimTree, infolevel,
+                          "DimTree");
+  if (!space_prop::is_cuda)
+    Genten_Test_MTTKRP_Type(Genten::MTTKRP_Method::Prefetch, infolevel,
+                            "Prefetch");
+  Genten_Test_MTTKRP_DimTree(infolevel);
+
+  Genten_Test_MTTKRP_Order(infolevel);
+
+  Genten_Test_MTTKRP_Dense(infolevel);
+
+  Genten_Test_MTTKRP_Tune(infolevel);
+
+  Genten_Test_MTTKRP_RankBatch(infolevel);
+
+  Genten_Test_MTTKRP_NUMA(infolevel);
+
+  if (!space_prop::is_cuda)
+    Genten_Test_MTTKRP_Prefetch(infolevel);
+
+#ifdef HAVE_MIXED_PRECISION
+  Genten_Test_MTTKRP_Mixed(infolevel);
+#endif
 
   Genten_Test_MTTKRP_All_Type(Genten::MTTKRP_All_Method::Iterated, infolevel,
                               "Iterated");
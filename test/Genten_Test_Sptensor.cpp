@@ -43,6 +43,7 @@
 #include <cmath>
 #include <time.h>
 #include "Genten_Sptensor.hpp"
+#include "Genten_SptensorCompact.hpp"
 #include "Genten_Test_Utils.hpp"
 #include "Genten_IOtext.hpp"
 
@@ -205,6 +206,33 @@ void Genten_Test_Sptensor(int infolevel)
   ASSERT(X.index(1, 2, 3) == 10, "Index not found");
   ASSERT(X.index(3, 0, 0) == 10, "Index not found");
 
+  // PERMUTATION
+  MESSAGE("Testing permutation creation");
+  X.createPermutation();
+  const ttb_indx perm0[] = { 1, 3, 4, 5, 6, 8, 0, 2, 7, 9 };
+  const ttb_indx perm1[] = { 0, 4, 6, 7, 1, 2, 8, 9, 3, 5 };
+  tf = true;
+  for (ttb_indx i = 0; i < X.nnz(); ++i) {
+    if (X.getPerm(i,0) != perm0[i] || X.getPerm(i,1) != perm1[i] ||
+        X.getPerm(i,2) != i)
+      tf = false;
+  }
+  ASSERT(tf, "Permutation is sorted and stable in each mode");
+  ASSERT(!X.havePermRowPtr(), "Row pointers not computed by default");
+
+  X.createPermutation(true);
+  ASSERT(X.havePermRowPtr(), "Row pointers computed");
+  const ttb_indx rowptr1[] = { 0, 4, 8, 10 };
+  const ttb_indx rowptr2[] = { 0, 4, 6, 6, 10 };
+  tf = true;
+  for (ttb_indx r = 0; r <= X.size(1); ++r)
+    if (X.getPermRowPtr(r,1) != rowptr1[r])
+      tf = false;
+  for (ttb_indx r = 0; r <= X.size(2); ++r)
+    if (X.getPermRowPtr(r,2) != rowptr2[r])
+      tf = false;
+  ASSERT(tf, "Row pointers correct, including empty rows");
+
   X.sort();
   MESSAGE("Testing sorted tensor search");
   //std::cout << std::endl;
@@ -224,5 +252,74 @@ void Genten_Test_Sptensor(int infolevel)
   ASSERT(X.index(1, 2, 3) == 10, "Index not found");
   ASSERT(X.index(3, 0, 0) == 10, "Index not found");
 
+  MESSAGE("Testing compaction of empty slices");
+  // Y = X with modes of size 5, 6 and 8 where slices 0, 2 and 4 of the
+  // first, 1, 3 and 5 of the second and 1, 3 and 7 of the third are used
+  const ttb_indx old0[] = { 0, 2, 4 };
+  const ttb_indx old1[] = { 1, 3, 5 };
+  const ttb_indx old2[] = { 1, 2, 3, 7 };
+  Genten::IndxArray ydims = { 5, 6, 8 };
+  Genten::Sptensor Y(ydims, X.nnz());
+  for (ttb_indx i = 0; i < X.nnz(); ++i) {
+    Y.subscript(i,0) = old0[X.subscript(i,0)];
+    Y.subscript(i,1) = old1[X.subscript(i,1)];
+    Y.subscript(i,2) = old2[X.subscript(i,2)];
+    Y.value(i) = X.value(i);
+  }
+  Y.setIsSorted(true);
+  Genten::SptensorIndexMap map = Genten::compact_sptensor(Y);
+  ASSERT(Y.size(0) == 2 && Y.size(1) == 3 && Y.size(2) == 3,
+         "Compacted sizes are the number of nonempty slices");
+  ASSERT(map.orig_size(0) == 5 && map.orig_size(1) == 6 &&
+         map.orig_size(2) == 8, "Index map has original sizes");
+  tf = map.old_index(0)[0] == 0 && map.old_index(0)[1] == 2 &&
+    map.old_index(1)[0] == 1 && map.old_index(1)[1] == 3 &&
+    map.old_index(1)[2] == 5 && map.old_index(2)[0] == 1 &&
+    map.old_index(2)[1] == 2 && map.old_index(2)[2] == 7;
+  ASSERT(tf, "Index map lists nonempty slices in order");
+  const ttb_indx *old[] = { old0, old1, old2 };
+  tf = Y.isSorted();
+  for (ttb_indx i = 0; i < X.nnz(); ++i)
+    for (ttb_indx n = 0; n < 3; ++n)
+      if (map.old_index(n)[Y.subscript(i,n)] != old[n][X.subscript(i,n)])
+        tf = false;
+  ASSERT(tf, "Compacted subscripts map back to original subscripts");
+
+  Genten::Ktensor K(2, 3, ydims);
+  for (ttb_indx n = 0; n < 3; ++n)
+    for (ttb_indx r = 0; r < ydims[n]; ++r)
+      for (ttb_indx j = 0; j < 2; ++j)
+        K[n].entry(r,j) = 10.0*n + r + 0.5*j;
+  Genten::Ktensor Kc = Genten::compact_ktensor(K, map);
+  Genten::Ktensor Ke = Genten::expand_ktensor(Kc, map);
+  tf = Kc[2].nRows() == 3 && Kc[2].entry(2,1) == K[2].entry(7,1);
+  for (ttb_indx n = 0; n < 3; ++n)
+    for (ttb_indx r = 0; r < ydims[n]; ++r) {
+      bool used = false;
+      for (ttb_indx i = 0; i < map.size(n); ++i)
+        used = used || map.old_index(n)[i] == r;
+      for (ttb_indx j = 0; j < 2; ++j)
+        if (Ke[n].entry(r,j) != (used ? K[n].entry(r,j) : 0.0))
+          tf = false;
+    }
+  ASSERT(tf, "Compacted Ktensor expands to original with zero empty rows");
+
+  // Compaction does not allocate anything the size of the original modes
+  const ttb_indx big = ttb_indx(1) << (sizeof(ttb_indx) > 4 ? 40 : 30);
+  Genten::IndxArray zdims = { big, ttb_indx(4) };
+  Genten::Sptensor Z(zdims, 3);
+  const ttb_indx zsubs[][2] = { { big-1, 3 }, { 5, 0 }, { big-1, 1 } };
+  for (ttb_indx i = 0; i < 3; ++i) {
+    Z.subscript(i,0) = zsubs[i][0];
+    Z.subscript(i,1) = zsubs[i][1];
+    Z.value(i) = 1.0;
+  }
+  map = Genten::compact_sptensor(Z);
+  tf = Z.size(0) == 2 && Z.size(1) == 3 && map.orig_size(0) == big &&
+    map.old_index(0)[0] == 5 && map.old_index(0)[1] == big-1 &&
+    Z.subscript(0,0) == 1 && Z.subscript(1,0) == 0 && Z.subscript(2,0) == 1 &&
+    Z.subscript(0,1) == 2 && Z.subscript(1,1) == 0 && Z.subscript(2,1) == 1;
+  ASSERT(tf, "Compaction of a mode much larger than the nonzeros");
+
   finalize();
 }